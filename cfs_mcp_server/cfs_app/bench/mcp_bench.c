@@ -0,0 +1,489 @@
+/*
+** MCP Interface Host Benchmark
+**
+** Runs the request path of the MCP interface app on a development host,
+** linked against the cFE shim, and reports the cost of each piece:
+**
+**   parse_json_request     ParseJSONRequest over a mix of requests
+**   format_json_response   BeginJSONResponse, a small result, EndJSONResponse
+**   is_safe_command        IsSafeCommand over the same mix
+**   process_request        parse, admit, execute and format in process,
+**                          under the data mutex as the socket task does
+**   socket_round_trip      one request at a time over the Unix socket
+**
+** With --check the safety regression cases are run through the request
+** path instead, and the exit status is the number that failed.
+**
+** With --serve the app is left running for the given number of seconds
+** (forever when none is given) so mcp_loadgen can drive it; the
+** dictionary's housekeeping packets are fed in once a second so
+** telemetry requests have something to return.
+**
+** Usage: mcp_bench [--iterations N] [--check] [--serve [seconds]]
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+/*
+** Benchmark defines
+*/
+#define MCP_BENCH_DEFAULT_ITERATIONS          200000
+#define MCP_BENCH_SOCKET_DIVISOR              20      /* round trips are this much rarer */
+#define MCP_BENCH_HK_PACKET_LEN               64
+
+/*
+** Default tables, compiled in from tables/
+*/
+extern MCP_INTERFACE_CmdTbl_t MCP_INTERFACE_CmdTbl;
+extern MCP_INTERFACE_SafetyTbl_t MCP_INTERFACE_SafetyTbl;
+
+/*
+** Request mix; every request type handled without a worker or the file system
+*/
+static const char *const MCP_BENCH_Requests[] = {
+    "{\"id\":1,\"type\":1,\"app_name\":\"ADCS_APP\",\"command\":\"\",\"params\":\"\"}",
+    "{\"id\":2,\"type\":0,\"app_name\":\"ADCS_APP\",\"command\":\"NOOP\",\"params\":\"\"}",
+    "{\"id\":3,\"type\":0,\"app_name\":\"ADCS_APP\",\"command\":\"SAFE_MODE\",\"params\":\"\"}",
+    "{\"id\":4,\"type\":2,\"app_name\":\"\",\"command\":\"\",\"params\":\"\"}",
+    "{\"id\":5,\"type\":1,\"app_name\":\"RWA_APP\",\"command\":\"\",\"params\":\"\"}",
+    "{\"id\":6,\"type\":7,\"app_name\":\"\",\"command\":\"\",\"params\":\"{\\\"since_seq\\\": 0, \\\"max\\\": 8}\"}",
+    "{\"id\":7,\"type\":0,\"app_name\":\"HK\",\"command\":\"NOOP\",\"params\":\"\"}",
+    "{\"id\":8,\"type\":12,\"app_name\":\"\",\"command\":\"\",\"params\":\"\"}"
+};
+
+#define MCP_BENCH_REQUEST_COUNT (sizeof(MCP_BENCH_Requests) / sizeof(MCP_BENCH_Requests[0]))
+
+/*
+** Safety regression cases, run with safety mode on; Blocked is whether
+** the safety system must refuse the request, or the batch item or
+** sequence step it carries
+*/
+typedef struct {
+    const char *Name;
+    const char *Request;
+    boolean Blocked;
+} MCP_BENCH_Check_t;
+
+static const MCP_BENCH_Check_t MCP_BENCH_Checks[] = {
+    { "read_file system path",
+      "{\"id\":1,\"type\":5,\"app_name\":\"\",\"command\":\"\",\"params\":\"\\\"/etc/hostname\\\"\"}",
+      TRUE },
+    { "read_file escaped system path",
+      "{\"id\":2,\"type\":5,\"app_name\":\"\",\"command\":\"\",\"params\":\"\\\"/\\\\u0065tc/hostname\\\"\"}",
+      TRUE },
+    { "read_file escaped system path in object",
+      "{\"id\":3,\"type\":5,\"app_name\":\"\",\"command\":\"\","
+      "\"params\":\"{\\\"path\\\": \\\"/\\\\u0065tc/hostname\\\"}\"}",
+      TRUE },
+    { "read_file allowed path",
+      "{\"id\":4,\"type\":5,\"app_name\":\"\",\"command\":\"\",\"params\":\"\\\"/tmp/mcp_bench_none\\\"\"}",
+      FALSE },
+    { "dictionary critical command unconfirmed",
+      "{\"id\":5,\"type\":0,\"app_name\":\"ADCS_APP\",\"command\":\"SET_ATTITUDE_MODE\",\"params\":\"\"}",
+      TRUE },
+    { "dictionary critical command confirmed",
+      "{\"id\":6,\"type\":0,\"app_name\":\"ADCS_APP\",\"command\":\"SET_ATTITUDE_MODE\",\"params\":\"\","
+      "\"require_confirmation\":true}",
+      FALSE },
+    { "dictionary critical command in batch",
+      "{\"id\":7,\"type\":9,\"requests\":[{\"id\":1,\"type\":0,\"app_name\":\"THRUSTER_APP\","
+      "\"command\":\"FIRE_THRUSTERS\"}]}",
+      TRUE },
+    { "dictionary critical command in sequence",
+      "{\"id\":8,\"type\":14,\"app_name\":\"\",\"command\":\"\",\"params\":\"{\\\"steps\\\": [{\\\"app\\\": "
+      "\\\"THRUSTER_APP\\\", \\\"command\\\": \\\"FIRE_THRUSTERS\\\"}]}\"}",
+      TRUE }
+};
+
+#define MCP_BENCH_CHECK_COUNT (sizeof(MCP_BENCH_Checks) / sizeof(MCP_BENCH_Checks[0]))
+
+/*
+** Housekeeping packets of the command dictionary's telemetry
+*/
+static const CFE_SB_MsgId_t MCP_BENCH_TlmMids[] = {
+    0x0800, 0x0801, 0x088A, 0x089B, 0x0890, 0x0891, 0x0892
+};
+
+static char MCP_BENCH_ParseBuffer[MCP_MAX_JSON_SIZE];
+static char MCP_BENCH_OutputBuffer[MCP_MAX_JSON_SIZE];
+static volatile uint32 MCP_BENCH_Sink;
+
+/*
+** Local function prototypes
+*/
+static uint64 MCP_BENCH_NowNs(void);
+static void MCP_BENCH_Report(const char *name, uint32 ops, uint64 elapsed_ns);
+static void MCP_BENCH_InjectTelemetry(void);
+static int32 MCP_BENCH_Parse(uint32 index, MCP_Request_t *request);
+static void MCP_BENCH_ParseJSONRequest(uint32 iterations);
+static void MCP_BENCH_FormatJSONResponse(uint32 iterations);
+static void MCP_BENCH_IsSafeCommand(uint32 iterations);
+static void MCP_BENCH_ProcessRequest(uint32 iterations);
+static void MCP_BENCH_SocketRoundTrip(uint32 iterations);
+static void MCP_BENCH_Serve(int32 seconds);
+static uint32 MCP_BENCH_RunChecks(void);
+
+int main(int argc, char *argv[])
+{
+    uint32 iterations = MCP_BENCH_DEFAULT_ITERATIONS;
+    boolean serve = FALSE;
+    boolean check = FALSE;
+    uint32 failed = 0;
+    int32 seconds = -1;
+    int32 status;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (strcmp(argv[i], "--iterations") == 0 && i + 1 < argc)
+        {
+            iterations = (uint32)strtoul(argv[++i], NULL, 10);
+        }
+        else if (strcmp(argv[i], "--check") == 0)
+        {
+            check = TRUE;
+        }
+        else if (strcmp(argv[i], "--serve") == 0)
+        {
+            serve = TRUE;
+            if (i + 1 < argc && argv[i + 1][0] != '-')
+            {
+                seconds = (int32)strtol(argv[++i], NULL, 10);
+            }
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--iterations N] [--check] [--serve [seconds]]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    CFE_SHIM_AddTableImage(MCP_CMD_TBL_FILENAME, &MCP_INTERFACE_CmdTbl, sizeof(MCP_INTERFACE_CmdTbl));
+    CFE_SHIM_AddTableImage(MCP_SAFETY_TBL_FILENAME, &MCP_INTERFACE_SafetyTbl, sizeof(MCP_INTERFACE_SafetyTbl));
+
+    status = MCP_INTERFACE_AppInit();
+    if (status != CFE_SUCCESS)
+    {
+        fprintf(stderr, "MCP_INTERFACE_AppInit failed, RC = 0x%08X\n", (unsigned int)status);
+        return 1;
+    }
+
+    MCP_BENCH_InjectTelemetry();
+
+    if (check)
+    {
+        failed = MCP_BENCH_RunChecks();
+    }
+    else if (serve)
+    {
+        MCP_BENCH_Serve(seconds);
+    }
+    else
+    {
+        printf("%-24s %10s %12s %12s\n", "benchmark", "ops", "ns/op", "ops/s");
+        MCP_BENCH_ParseJSONRequest(iterations);
+        MCP_BENCH_FormatJSONResponse(iterations);
+        MCP_BENCH_IsSafeCommand(iterations);
+        MCP_BENCH_ProcessRequest(iterations);
+        MCP_BENCH_SocketRoundTrip(iterations / MCP_BENCH_SOCKET_DIVISOR);
+    }
+
+    MCP_INTERFACE_AppData.RunStatus = CFE_ES_APP_EXIT;
+
+    return (int)failed;
+
+} /* End main */
+
+static uint64 MCP_BENCH_NowNs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64)now.tv_sec * 1000000000 + (uint64)now.tv_nsec;
+
+} /* End MCP_BENCH_NowNs */
+
+static void MCP_BENCH_Report(const char *name, uint32 ops, uint64 elapsed_ns)
+{
+    double ns_per_op = (ops > 0) ? (double)elapsed_ns / ops : 0.0;
+    double ops_per_s = (elapsed_ns > 0) ? (double)ops * 1e9 / (double)elapsed_ns : 0.0;
+
+    printf("%-24s %10u %12.1f %12.0f\n", name, (unsigned int)ops, ns_per_op, ops_per_s);
+
+} /* End MCP_BENCH_Report */
+
+/*
+** Hand the app one housekeeping packet per cached telemetry MID, as the
+** main task would on receiving them
+*/
+static void MCP_BENCH_InjectTelemetry(void)
+{
+    uint8 packet[MCP_BENCH_HK_PACKET_LEN];
+    uint32 i;
+    uint32 j;
+
+    for (i = 0; i < sizeof(MCP_BENCH_TlmMids) / sizeof(MCP_BENCH_TlmMids[0]); i++)
+    {
+        CFE_SB_InitMsg(packet, MCP_BENCH_TlmMids[i], sizeof(packet), TRUE);
+        CFE_SB_TimeStampMsg((CFE_SB_MsgPtr_t)packet);
+        for (j = CFE_SB_TLM_HDR_SIZE; j < sizeof(packet); j++)
+        {
+            packet[j] = (uint8)(i + j);
+        }
+
+        OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+        MCP_INTERFACE_AppData.MsgPtr = (CFE_SB_MsgPtr_t)packet;
+        MCP_INTERFACE_ProcessCommandPacket();
+        OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+    }
+
+} /* End MCP_BENCH_InjectTelemetry */
+
+/*
+** Parse one request of the mix; parsing decodes in place, so each parse
+** works on a fresh copy as a receive buffer would be
+*/
+static int32 MCP_BENCH_Parse(uint32 index, MCP_Request_t *request)
+{
+    const char *text = MCP_BENCH_Requests[index % MCP_BENCH_REQUEST_COUNT];
+    uint32 length = (uint32)strlen(text);
+
+    memcpy(MCP_BENCH_ParseBuffer, text, length + 1);
+
+    return MCP_INTERFACE_ParseJSONRequest(MCP_BENCH_ParseBuffer, length, request);
+
+} /* End MCP_BENCH_Parse */
+
+static void MCP_BENCH_ParseJSONRequest(uint32 iterations)
+{
+    MCP_Request_t request;
+    uint64 start;
+    uint32 i;
+
+    start = MCP_BENCH_NowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        if (MCP_BENCH_Parse(i, &request) != CFE_SUCCESS)
+        {
+            fprintf(stderr, "request %u of the mix does not parse\n",
+                    (unsigned int)(i % MCP_BENCH_REQUEST_COUNT));
+            return;
+        }
+        MCP_BENCH_Sink += request.id;
+    }
+    MCP_BENCH_Report("parse_json_request", iterations, MCP_BENCH_NowNs() - start);
+
+} /* End MCP_BENCH_ParseJSONRequest */
+
+static void MCP_BENCH_FormatJSONResponse(uint32 iterations)
+{
+    MCP_JSON_Writer_t json;
+    MCP_Response_t response;
+    uint64 start;
+    uint32 i;
+
+    start = MCP_BENCH_NowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        MCP_JSON_Init(&json, MCP_BENCH_OutputBuffer, sizeof(MCP_BENCH_OutputBuffer));
+        MCP_INTERFACE_BeginJSONResponse(&response, &json, i);
+        MCP_JSON_BeginObject(&json);
+        MCP_JSON_KeyString(&json, "app_name", "ADCS_APP");
+        MCP_JSON_KeyUint(&json, "msg_id", 0x0890);
+        MCP_JSON_KeyUint(&json, "count", i);
+        MCP_JSON_KeyBool(&json, "stale", FALSE);
+        MCP_JSON_EndObject(&json);
+        MCP_INTERFACE_EndJSONResponse(&response);
+        MCP_BENCH_Sink += json.Length;
+    }
+    MCP_BENCH_Report("format_json_response", iterations, MCP_BENCH_NowNs() - start);
+
+} /* End MCP_BENCH_FormatJSONResponse */
+
+static void MCP_BENCH_IsSafeCommand(uint32 iterations)
+{
+    MCP_Request_t requests[MCP_BENCH_REQUEST_COUNT];
+    char buffers[MCP_BENCH_REQUEST_COUNT][512];
+    uint64 start;
+    uint32 i;
+
+    for (i = 0; i < MCP_BENCH_REQUEST_COUNT; i++)
+    {
+        strncpy(buffers[i], MCP_BENCH_Requests[i], sizeof(buffers[i]) - 1);
+        buffers[i][sizeof(buffers[i]) - 1] = '\0';
+        MCP_INTERFACE_ParseJSONRequest(buffers[i], (uint32)strlen(buffers[i]), &requests[i]);
+    }
+
+    start = MCP_BENCH_NowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        MCP_BENCH_Sink += MCP_INTERFACE_IsSafeCommand(&requests[i % MCP_BENCH_REQUEST_COUNT]);
+    }
+    MCP_BENCH_Report("is_safe_command", iterations, MCP_BENCH_NowNs() - start);
+
+} /* End MCP_BENCH_IsSafeCommand */
+
+static void MCP_BENCH_ProcessRequest(uint32 iterations)
+{
+    MCP_Request_t request;
+    MCP_JSON_Writer_t json;
+    MCP_Response_t response;
+    uint64 start;
+    uint32 i;
+
+    start = MCP_BENCH_NowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        MCP_BENCH_Parse(i, &request);
+        request.client_slot = 0;
+
+        OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+        MCP_JSON_Init(&json, MCP_BENCH_OutputBuffer, sizeof(MCP_BENCH_OutputBuffer));
+        MCP_INTERFACE_BeginJSONResponse(&response, &json, request.id);
+        MCP_INTERFACE_ProcessRequest(&request, &response);
+        MCP_INTERFACE_EndJSONResponse(&response);
+        OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+
+        MCP_BENCH_Sink += json.Length;
+    }
+    MCP_BENCH_Report("process_request", iterations, MCP_BENCH_NowNs() - start);
+
+} /* End MCP_BENCH_ProcessRequest */
+
+static void MCP_BENCH_SocketRoundTrip(uint32 iterations)
+{
+    struct sockaddr_un addr;
+    char reply[MCP_MAX_JSON_SIZE];
+    char line[512];
+    uint64 start;
+    uint32 i;
+    ssize_t length;
+    int fd;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, MCP_INTERFACE_SOCKET_PATH, sizeof(addr.sun_path) - 1);
+    if (fd < 0 || connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        fprintf(stderr, "cannot connect to %s\n", MCP_INTERFACE_SOCKET_PATH);
+        if (fd >= 0)
+        {
+            close(fd);
+        }
+        return;
+    }
+
+    start = MCP_BENCH_NowNs();
+    for (i = 0; i < iterations; i++)
+    {
+        length = snprintf(line, sizeof(line), "%s\n", MCP_BENCH_Requests[i % MCP_BENCH_REQUEST_COUNT]);
+        if (write(fd, line, (size_t)length) != length)
+        {
+            break;
+        }
+
+        /* One request in flight, so the reply ends at the first newline */
+        do
+        {
+            length = read(fd, reply, sizeof(reply));
+        } while (length > 0 && reply[length - 1] != '\n');
+
+        if (length <= 0)
+        {
+            break;
+        }
+    }
+    MCP_BENCH_Report("socket_round_trip", i, MCP_BENCH_NowNs() - start);
+
+    close(fd);
+
+} /* End MCP_BENCH_SocketRoundTrip */
+
+/*
+** Keep the socket task and workers serving, with fresh telemetry every second
+*/
+static void MCP_BENCH_Serve(int32 seconds)
+{
+    int32 elapsed = 0;
+
+    printf("serving on %s%s\n", MCP_INTERFACE_SOCKET_PATH, (seconds < 0) ? " until killed" : "");
+    fflush(stdout);
+
+    while (seconds < 0 || elapsed < seconds)
+    {
+        OS_TaskDelay(1000);
+        MCP_BENCH_InjectTelemetry();
+        elapsed++;
+    }
+
+    printf("served %u requests, %u SB messages sent\n",
+           (unsigned int)MCP_INTERFACE_AppData.RequestCounter,
+           (unsigned int)CFE_SHIM_SentMessageCount());
+
+} /* End MCP_BENCH_Serve */
+
+/*
+** Run each regression case through the request path and report whether
+** the safety system refused it as expected; returns the failures
+*/
+static uint32 MCP_BENCH_RunChecks(void)
+{
+    MCP_Request_t request;
+    MCP_JSON_Writer_t json;
+    MCP_Response_t response;
+    boolean blocked;
+    uint32 failed = 0;
+    uint32 i;
+
+    for (i = 0; i < MCP_BENCH_CHECK_COUNT; i++)
+    {
+        strncpy(MCP_BENCH_ParseBuffer, MCP_BENCH_Checks[i].Request, sizeof(MCP_BENCH_ParseBuffer) - 1);
+        MCP_BENCH_ParseBuffer[sizeof(MCP_BENCH_ParseBuffer) - 1] = '\0';
+
+        OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+        MCP_JSON_Init(&json, MCP_BENCH_OutputBuffer, sizeof(MCP_BENCH_OutputBuffer));
+        if (MCP_INTERFACE_ParseJSONRequest(MCP_BENCH_ParseBuffer, (uint32)strlen(MCP_BENCH_ParseBuffer),
+                                           &request) != CFE_SUCCESS)
+        {
+            OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+            printf("FAIL %s: does not parse\n", MCP_BENCH_Checks[i].Name);
+            failed++;
+            continue;
+        }
+        request.client_slot = 0;
+        MCP_INTERFACE_BeginJSONResponse(&response, &json, request.id);
+        MCP_INTERFACE_ProcessRequest(&request, &response);
+        MCP_INTERFACE_EndJSONResponse(&response);
+        OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+
+        /* Batch items and sequence steps report the block inside the result */
+        blocked = (strstr(MCP_BENCH_OutputBuffer, "blocked by safety") != NULL);
+        if (blocked != MCP_BENCH_Checks[i].Blocked)
+        {
+            printf("FAIL %s: %s\n", MCP_BENCH_Checks[i].Name, MCP_BENCH_OutputBuffer);
+            failed++;
+        }
+        else
+        {
+            printf("ok   %s\n", MCP_BENCH_Checks[i].Name);
+        }
+    }
+
+    printf("%u of %u checks failed\n", (unsigned int)failed, (unsigned int)MCP_BENCH_CHECK_COUNT);
+
+    return failed;
+
+} /* End MCP_BENCH_RunChecks */
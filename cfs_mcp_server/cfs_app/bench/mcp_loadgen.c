@@ -0,0 +1,549 @@
+/*
+** MCP Interface Socket Load Generator
+**
+** Replays a recorded request mix against a running MCP interface app
+** (on a target, or mcp_bench --serve on a host) from a growing number of
+** clients, and reports the request rate and latency percentiles at each
+** client count. Each client is a connection with a fixed number of
+** requests in flight; a new request goes out as soon as a response comes
+** back. Requests cycle through the mix with their ids rewritten so every
+** request in flight has its own.
+**
+** A mix is a file of JSON requests, one per line, as the MCP server sends
+** them, with the id, if any, as the first member; blank lines and
+** lines starting with '#' are skipped. Raw file
+** reads do not belong in a mix, as their file data follows the response
+** outside the line framing.
+**
+** Usage: mcp_loadgen [--mix file] [--clients 1,2,4,8] [--duration seconds]
+**                    [--depth n] [--socket path]
+**
+** This program only talks to the socket and needs no cFE.
+*/
+
+/*
+** Include Files
+*/
+#include <errno.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/un.h>
+
+/*
+** Load generator defines
+*/
+#define MCP_LOADGEN_DEFAULT_SOCKET            "/tmp/cfs_mcp.sock"
+#define MCP_LOADGEN_DEFAULT_CLIENTS           "1,2,4,8"
+#define MCP_LOADGEN_DEFAULT_DURATION          5
+#define MCP_LOADGEN_MAX_CLIENT_COUNTS         16
+#define MCP_LOADGEN_MAX_CLIENTS               256
+#define MCP_LOADGEN_MAX_DEPTH                 64
+#define MCP_LOADGEN_MAX_LINE                  4096
+#define MCP_LOADGEN_RX_SIZE                   65536
+#define MCP_LOADGEN_DRAIN_TIMEOUT_S           5
+
+#ifndef MCP_LOADGEN_DEFAULT_MIX
+#define MCP_LOADGEN_DEFAULT_MIX               "mixes/default.jsonl"
+#endif
+
+/*
+** A request of the mix, held as the text after its id
+*/
+typedef struct {
+    char *Body;                     /* the request from just after "{" and any id member */
+    uint32_t Length;
+} MCP_LOADGEN_Request_t;
+
+typedef struct {
+    uint32_t Id;
+    uint64_t SentUs;
+} MCP_LOADGEN_InFlight_t;
+
+/*
+** One client's connection, progress and latency samples
+*/
+typedef struct {
+    pthread_t Thread;
+    uint32_t Index;
+    uint32_t NextId;
+    uint32_t NextRequest;
+    uint32_t *Samples;
+    uint32_t SampleCount;
+    uint32_t SampleSize;
+    uint32_t Errors;
+    uint32_t Failed;
+    MCP_LOADGEN_InFlight_t InFlight[MCP_LOADGEN_MAX_DEPTH];
+    uint32_t InFlightCount;
+    char Rx[MCP_LOADGEN_RX_SIZE];
+    uint32_t RxLength;
+} MCP_LOADGEN_Client_t;
+
+static MCP_LOADGEN_Request_t *MCP_LOADGEN_Mix;
+static uint32_t MCP_LOADGEN_MixCount;
+static const char *MCP_LOADGEN_SocketPath = MCP_LOADGEN_DEFAULT_SOCKET;
+static uint32_t MCP_LOADGEN_Depth = 1;
+static uint64_t MCP_LOADGEN_StopUs;
+
+/*
+** Local function prototypes
+*/
+static uint64_t MCP_LOADGEN_NowUs(void);
+static int MCP_LOADGEN_LoadMix(const char *filename);
+static int MCP_LOADGEN_Connect(void);
+static int MCP_LOADGEN_SendNext(MCP_LOADGEN_Client_t *client, int fd);
+static void MCP_LOADGEN_TakeResponse(MCP_LOADGEN_Client_t *client, const char *line, uint32_t length);
+static void *MCP_LOADGEN_ClientTask(void *arg);
+static void MCP_LOADGEN_RunStep(uint32_t clients, uint32_t duration);
+static int MCP_LOADGEN_CompareSamples(const void *a, const void *b);
+static uint32_t MCP_LOADGEN_Percentile(const uint32_t *sorted, uint32_t count, uint32_t per_mille);
+
+int main(int argc, char *argv[])
+{
+    const char *mix = MCP_LOADGEN_DEFAULT_MIX;
+    const char *clients = MCP_LOADGEN_DEFAULT_CLIENTS;
+    uint32_t duration = MCP_LOADGEN_DEFAULT_DURATION;
+    uint32_t counts[MCP_LOADGEN_MAX_CLIENT_COUNTS];
+    uint32_t count_total = 0;
+    const char *p;
+    char *end;
+    int i;
+
+    for (i = 1; i < argc; i++)
+    {
+        if (i + 1 < argc && strcmp(argv[i], "--mix") == 0)
+        {
+            mix = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--clients") == 0)
+        {
+            clients = argv[++i];
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--duration") == 0)
+        {
+            duration = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--depth") == 0)
+        {
+            MCP_LOADGEN_Depth = (uint32_t)strtoul(argv[++i], NULL, 10);
+        }
+        else if (i + 1 < argc && strcmp(argv[i], "--socket") == 0)
+        {
+            MCP_LOADGEN_SocketPath = argv[++i];
+        }
+        else
+        {
+            fprintf(stderr, "usage: %s [--mix file] [--clients 1,2,4,8] [--duration seconds] "
+                    "[--depth n] [--socket path]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    if (MCP_LOADGEN_Depth < 1 || MCP_LOADGEN_Depth > MCP_LOADGEN_MAX_DEPTH)
+    {
+        fprintf(stderr, "depth must be between 1 and %d\n", MCP_LOADGEN_MAX_DEPTH);
+        return 2;
+    }
+
+    for (p = clients; *p != '\0' && count_total < MCP_LOADGEN_MAX_CLIENT_COUNTS; p = end)
+    {
+        counts[count_total] = (uint32_t)strtoul(p, &end, 10);
+        if (end == p || counts[count_total] < 1 || counts[count_total] > MCP_LOADGEN_MAX_CLIENTS)
+        {
+            fprintf(stderr, "client counts must be a list of numbers from 1 to %d\n",
+                    MCP_LOADGEN_MAX_CLIENTS);
+            return 2;
+        }
+        count_total++;
+        if (*end == ',')
+        {
+            end++;
+        }
+    }
+
+    if (MCP_LOADGEN_LoadMix(mix) != 0)
+    {
+        return 1;
+    }
+
+    printf("mix %s: %u requests, depth %u, %u s per step\n",
+           mix, MCP_LOADGEN_MixCount, MCP_LOADGEN_Depth, duration);
+    printf("%8s %10s %8s %10s %8s %8s %8s\n",
+           "clients", "requests", "errors", "req/s", "p50_us", "p99_us", "p999_us");
+
+    for (i = 0; i < (int)count_total; i++)
+    {
+        MCP_LOADGEN_RunStep(counts[i], duration);
+    }
+
+    return 0;
+
+} /* End main */
+
+static uint64_t MCP_LOADGEN_NowUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint64_t)now.tv_sec * 1000000 + (uint64_t)now.tv_nsec / 1000;
+
+} /* End MCP_LOADGEN_NowUs */
+
+/*
+** Read the mix, keeping each request without its opening brace and id
+*/
+static int MCP_LOADGEN_LoadMix(const char *filename)
+{
+    char line[MCP_LOADGEN_MAX_LINE];
+    uint32_t size = 0;
+    uint32_t length;
+    char *body;
+    FILE *file;
+
+    file = fopen(filename, "r");
+    if (file == NULL)
+    {
+        fprintf(stderr, "cannot open mix %s: %s\n", filename, strerror(errno));
+        return -1;
+    }
+
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        length = (uint32_t)strcspn(line, "\r\n");
+        line[length] = '\0';
+
+        body = line;
+        while (*body == ' ' || *body == '\t')
+        {
+            body++;
+        }
+        if (*body == '\0' || *body == '#')
+        {
+            continue;
+        }
+        if (*body != '{')
+        {
+            fprintf(stderr, "%s: not a JSON object: %s\n", filename, line);
+            fclose(file);
+            return -1;
+        }
+
+        /* Drop a leading id member; the load generator numbers the requests itself */
+        body++;
+        while (*body == ' ')
+        {
+            body++;
+        }
+        if (strncmp(body, "\"id\"", 4) == 0)
+        {
+            body = strchr(body, ',');
+            if (body == NULL)
+            {
+                fprintf(stderr, "%s: request has nothing but an id: %s\n", filename, line);
+                fclose(file);
+                return -1;
+            }
+            body++;
+        }
+
+        if (MCP_LOADGEN_MixCount == size)
+        {
+            size = (size == 0) ? 16 : size * 2;
+            MCP_LOADGEN_Mix = realloc(MCP_LOADGEN_Mix, size * sizeof(MCP_LOADGEN_Request_t));
+            if (MCP_LOADGEN_Mix == NULL)
+            {
+                fclose(file);
+                return -1;
+            }
+        }
+
+        MCP_LOADGEN_Mix[MCP_LOADGEN_MixCount].Body = strdup(body);
+        MCP_LOADGEN_Mix[MCP_LOADGEN_MixCount].Length = (uint32_t)strlen(body);
+        MCP_LOADGEN_MixCount++;
+    }
+
+    fclose(file);
+
+    if (MCP_LOADGEN_MixCount == 0)
+    {
+        fprintf(stderr, "%s: no requests\n", filename);
+        return -1;
+    }
+
+    return 0;
+
+} /* End MCP_LOADGEN_LoadMix */
+
+static int MCP_LOADGEN_Connect(void)
+{
+    struct sockaddr_un addr;
+    struct timeval timeout;
+    int fd;
+
+    fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        return -1;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, MCP_LOADGEN_SocketPath, sizeof(addr.sun_path) - 1);
+    if (connect(fd, (struct sockaddr *)&addr, sizeof(addr)) != 0)
+    {
+        close(fd);
+        return -1;
+    }
+
+    /* A server that stops answering ends the step instead of hanging it */
+    timeout.tv_sec = MCP_LOADGEN_DRAIN_TIMEOUT_S;
+    timeout.tv_usec = 0;
+    setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+    return fd;
+
+} /* End MCP_LOADGEN_Connect */
+
+/*
+** Send the client's next request of the mix under a fresh id
+*/
+static int MCP_LOADGEN_SendNext(MCP_LOADGEN_Client_t *client, int fd)
+{
+    const MCP_LOADGEN_Request_t *request = &MCP_LOADGEN_Mix[client->NextRequest];
+    char line[MCP_LOADGEN_MAX_LINE + 32];
+    MCP_LOADGEN_InFlight_t *entry;
+    int length;
+
+    client->NextRequest = (client->NextRequest + 1) % MCP_LOADGEN_MixCount;
+
+    entry = &client->InFlight[client->InFlightCount++];
+    entry->Id = client->NextId++;
+    length = snprintf(line, sizeof(line), "{\"id\":%u,%s\n", entry->Id, request->Body);
+    entry->SentUs = MCP_LOADGEN_NowUs();
+
+    return (write(fd, line, (size_t)length) == length) ? 0 : -1;
+
+} /* End MCP_LOADGEN_SendNext */
+
+/*
+** Match a response line to its request and record the latency
+**
+** Lines that are not responses to this client's requests, such as
+** pushed telemetry, are ignored.
+*/
+static void MCP_LOADGEN_TakeResponse(MCP_LOADGEN_Client_t *client, const char *line, uint32_t length)
+{
+    uint64_t now = MCP_LOADGEN_NowUs();
+    const char *status;
+    const char *match;
+    uint32_t id;
+    uint32_t i;
+
+    if (length < 7 || strncmp(line, "{\"id\":", 6) != 0)
+    {
+        return;
+    }
+    id = (uint32_t)strtoul(&line[6], NULL, 10);
+
+    for (i = 0; i < client->InFlightCount; i++)
+    {
+        if (client->InFlight[i].Id == id)
+        {
+            break;
+        }
+    }
+    if (i == client->InFlightCount)
+    {
+        return;
+    }
+
+    if (client->SampleCount == client->SampleSize)
+    {
+        client->SampleSize = (client->SampleSize == 0) ? 4096 : client->SampleSize * 2;
+        client->Samples = realloc(client->Samples, client->SampleSize * sizeof(uint32_t));
+    }
+    client->Samples[client->SampleCount++] = (uint32_t)(now - client->InFlight[i].SentUs);
+
+    /* The response's own status follows any "status" in its result */
+    status = NULL;
+    for (match = strstr(line, "\"status\":"); match != NULL; match = strstr(match + 1, "\"status\":"))
+    {
+        status = match;
+    }
+    if (status == NULL || strncmp(status + 9, "0,", 2) != 0)
+    {
+        client->Errors++;
+    }
+
+    client->InFlight[i] = client->InFlight[--client->InFlightCount];
+
+} /* End MCP_LOADGEN_TakeResponse */
+
+/*
+** One client: keep depth requests in flight until the step ends, then
+** wait for the last responses
+*/
+static void *MCP_LOADGEN_ClientTask(void *arg)
+{
+    MCP_LOADGEN_Client_t *client = arg;
+    ssize_t received;
+    char *line;
+    char *newline;
+    int fd;
+
+    fd = MCP_LOADGEN_Connect();
+    if (fd < 0)
+    {
+        client->Failed = 1;
+        return NULL;
+    }
+
+    client->NextRequest = (client->Index * 7) % MCP_LOADGEN_MixCount;
+
+    while (client->InFlightCount > 0 || MCP_LOADGEN_NowUs() < MCP_LOADGEN_StopUs)
+    {
+        while (client->InFlightCount < MCP_LOADGEN_Depth && MCP_LOADGEN_NowUs() < MCP_LOADGEN_StopUs)
+        {
+            if (MCP_LOADGEN_SendNext(client, fd) != 0)
+            {
+                client->Failed = 1;
+                close(fd);
+                return NULL;
+            }
+        }
+
+        if (client->InFlightCount == 0)
+        {
+            break;
+        }
+
+        if (client->RxLength == sizeof(client->Rx))
+        {
+            /* A line longer than the buffer is no response of ours */
+            client->RxLength = 0;
+        }
+
+        received = read(fd, &client->Rx[client->RxLength], sizeof(client->Rx) - client->RxLength);
+        if (received <= 0)
+        {
+            client->Failed = 1;
+            break;
+        }
+        client->RxLength += (uint32_t)received;
+
+        line = client->Rx;
+        while ((newline = memchr(line, '\n', client->RxLength - (uint32_t)(line - client->Rx))) != NULL)
+        {
+            *newline = '\0';
+            MCP_LOADGEN_TakeResponse(client, line, (uint32_t)(newline - line));
+            line = newline + 1;
+        }
+        client->RxLength -= (uint32_t)(line - client->Rx);
+        memmove(client->Rx, line, client->RxLength);
+    }
+
+    close(fd);
+
+    return NULL;
+
+} /* End MCP_LOADGEN_ClientTask */
+
+/*
+** Run one step of the load at a client count and print its row
+*/
+static void MCP_LOADGEN_RunStep(uint32_t clients, uint32_t duration)
+{
+    MCP_LOADGEN_Client_t *client;
+    uint32_t *samples;
+    uint32_t total = 0;
+    uint32_t errors = 0;
+    uint32_t failed = 0;
+    uint64_t start;
+    uint64_t elapsed;
+    uint32_t i;
+
+    client = calloc(clients, sizeof(MCP_LOADGEN_Client_t));
+    if (client == NULL)
+    {
+        return;
+    }
+
+    start = MCP_LOADGEN_NowUs();
+    MCP_LOADGEN_StopUs = start + (uint64_t)duration * 1000000;
+
+    for (i = 0; i < clients; i++)
+    {
+        client[i].Index = i;
+        client[i].NextId = 1;
+        pthread_create(&client[i].Thread, NULL, MCP_LOADGEN_ClientTask, &client[i]);
+    }
+    for (i = 0; i < clients; i++)
+    {
+        pthread_join(client[i].Thread, NULL);
+        total += client[i].SampleCount;
+        errors += client[i].Errors;
+        failed += client[i].Failed;
+    }
+    elapsed = MCP_LOADGEN_NowUs() - start;
+
+    samples = malloc(((total > 0) ? total : 1) * sizeof(uint32_t));
+    total = 0;
+    for (i = 0; i < clients; i++)
+    {
+        memcpy(&samples[total], client[i].Samples, client[i].SampleCount * sizeof(uint32_t));
+        total += client[i].SampleCount;
+        free(client[i].Samples);
+    }
+    qsort(samples, total, sizeof(uint32_t), MCP_LOADGEN_CompareSamples);
+
+    printf("%8u %10u %8u %10.0f %8u %8u %8u",
+           clients, total, errors,
+           (elapsed > 0) ? (double)total * 1e6 / (double)elapsed : 0.0,
+           MCP_LOADGEN_Percentile(samples, total, 500),
+           MCP_LOADGEN_Percentile(samples, total, 990),
+           MCP_LOADGEN_Percentile(samples, total, 999));
+    if (failed > 0)
+    {
+        printf("  (%u clients lost their connection)", failed);
+    }
+    printf("\n");
+    fflush(stdout);
+
+    free(samples);
+    free(client);
+
+} /* End MCP_LOADGEN_RunStep */
+
+static int MCP_LOADGEN_CompareSamples(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t *)a;
+    uint32_t y = *(const uint32_t *)b;
+
+    return (x > y) - (x < y);
+
+} /* End MCP_LOADGEN_CompareSamples */
+
+/*
+** The smallest latency at or above per_mille of the samples
+*/
+static uint32_t MCP_LOADGEN_Percentile(const uint32_t *sorted, uint32_t count, uint32_t per_mille)
+{
+    uint64_t rank;
+
+    if (count == 0)
+    {
+        return 0;
+    }
+
+    rank = ((uint64_t)count * per_mille + 999) / 1000;
+
+    return sorted[(rank > 0) ? rank - 1 : 0];
+
+} /* End MCP_LOADGEN_Percentile */
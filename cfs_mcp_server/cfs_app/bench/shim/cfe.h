@@ -0,0 +1,247 @@
+/*
+** MCP Interface Host Benchmark cFE Shim
+**
+** The subset of the cFE 6.5 API the MCP interface app uses, declared
+** with the same names, types and values so the app sources build
+** unchanged on a development host. The implementations in cfe_shim.c
+** run the app's tasks on pthreads and accept and drop everything sent
+** on the software bus.
+**
+** This is not flight code and must never be on a mission include path.
+*/
+
+#ifndef CFE_SHIM_H
+#define CFE_SHIM_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#include "osapi.h"
+
+/*
+** Common types
+*/
+typedef uint8_t  uint8;
+typedef uint16_t uint16;
+typedef uint32_t uint32;
+typedef uint64_t uint64;
+typedef int8_t   int8;
+typedef int16_t  int16;
+typedef int32_t  int32;
+typedef int64_t  int64;
+typedef uint8    boolean;
+
+#ifndef TRUE
+#define TRUE  1
+#define FALSE 0
+#endif
+
+#define CFE_MAJOR_VERSION                  6
+#define CFE_MINOR_VERSION                  5
+
+/*
+** Status codes
+*/
+#define CFE_SUCCESS                        0
+#define CFE_SB_TIME_OUT                    ((int32)0xca000001)
+#define CFE_SB_NO_MESSAGE                  ((int32)0xca000002)
+#define CFE_SB_BAD_ARGUMENT                ((int32)0xca000003)
+#define CFE_SB_BUF_ALOC_ERR                ((int32)0xca000006)
+#define CFE_ES_ERR_APPID                   ((int32)0xc4000001)
+#define CFE_ES_ERR_APPNAME                 ((int32)0xc4000002)
+#define CFE_ES_ERR_APP_CREATE              ((int32)0xc4000004)
+#define CFE_ES_ERR_CHILD_TASK_CREATE       ((int32)0xc4000014)
+#define CFE_TBL_ERR_INVALID_HANDLE         ((int32)0xcc000001)
+#define CFE_TBL_ERR_NO_ACCESS              ((int32)0xcc000007)
+#define CFE_TBL_ERR_FILE_NOT_FOUND         ((int32)0xcc00002e)
+#define CFE_TBL_INFO_UPDATED               ((int32)0x4c000007)
+
+/*
+** Executive services
+*/
+#define CFE_ES_APP_RUN                     1
+#define CFE_ES_APP_EXIT                    2
+#define CFE_ES_APP_ERROR                   3
+#define CFE_ES_APP_TYPE_CORE               1
+#define CFE_ES_APP_TYPE_EXTERNAL           2
+
+typedef void (*CFE_ES_ChildTaskMainFuncPtr_t)(void);
+
+typedef struct {
+    uint32 Type;
+    uint32 AppId;
+    uint32 StackSize;
+    uint32 ExecutionCounter;
+    uint32 AddressSpaceId;
+    uint32 MainTaskId;
+    uint32 NumOfChildTasks;
+    uint32 Priority;
+    uint32 AppState;
+    char Name[OS_MAX_API_NAME];
+    char MainTaskName[OS_MAX_API_NAME];
+} CFE_ES_AppInfo_t;
+
+int32 CFE_ES_RegisterApp(void);
+int32 CFE_ES_RunLoop(uint32 *RunStatus);
+void CFE_ES_ExitApp(uint32 ExitStatus);
+int32 CFE_ES_CreateChildTask(uint32 *TaskIdPtr, const char *TaskName,
+                             CFE_ES_ChildTaskMainFuncPtr_t FunctionPtr, uint32 *StackPtr,
+                             uint32 StackSize, uint32 Priority, uint32 Flags);
+int32 CFE_ES_RegisterChildTask(void);
+void CFE_ES_ExitChildTask(void);
+int32 CFE_ES_GetAppInfo(CFE_ES_AppInfo_t *AppInfo, uint32 AppId);
+int32 CFE_ES_GetAppID(uint32 *AppIdPtr);
+int32 CFE_ES_GetAppIDByName(uint32 *AppIdPtr, const char *AppName);
+int32 CFE_ES_WriteToSysLog(const char *SpecStringPtr, ...);
+void CFE_ES_PerfLogEntry(uint32 Marker);
+void CFE_ES_PerfLogExit(uint32 Marker);
+
+/*
+** Event services
+*/
+#define CFE_EVS_DEBUG                      1
+#define CFE_EVS_INFORMATION                2
+#define CFE_EVS_ERROR                      3
+#define CFE_EVS_CRITICAL                   4
+#define CFE_EVS_BINARY_FILTER              0
+#define CFE_EVS_MAX_MESSAGE_LENGTH         122
+#define CFE_EVS_EVENT_MSG_MID              0x0808
+
+int32 CFE_EVS_Register(void *Filters, uint16 NumFilteredEvents, uint16 FilterScheme);
+int32 CFE_EVS_SendEvent(uint16 EventID, uint16 EventType, const char *Spec, ...);
+
+/*
+** Time services
+*/
+typedef struct {
+    uint32 Seconds;
+    uint32 Subseconds;
+} CFE_TIME_SysTime_t;
+
+CFE_TIME_SysTime_t CFE_TIME_GetTime(void);
+uint32 CFE_TIME_Sub2MicroSecs(uint32 SubSeconds);
+
+/*
+** Software bus; headers are CCSDS, big-endian
+*/
+#define CFE_SB_PEND_FOREVER                (-1)
+#define CFE_SB_POLL                        0
+
+typedef uint16 CFE_SB_MsgId_t;
+typedef uint32 CFE_SB_PipeId_t;
+typedef void *CFE_SB_ZeroCopyHandle_t;
+
+typedef struct {
+    uint8 StreamId[2];
+    uint8 Sequence[2];
+    uint8 Length[2];
+} CCSDS_PriHdr_t;
+
+typedef struct {
+    CCSDS_PriHdr_t Pri;
+    uint8 Sec[2];                       /* function code, checksum */
+} CFE_SB_CmdHdr_t;
+
+typedef struct {
+    CCSDS_PriHdr_t Pri;
+    uint8 Sec[6];                       /* seconds, subseconds */
+} CFE_SB_TlmHdr_t;
+
+typedef union {
+    CCSDS_PriHdr_t Hdr;
+    uint32 Dword;
+    uint8 Byte[4];
+} CFE_SB_Msg_t;
+
+typedef CFE_SB_Msg_t *CFE_SB_MsgPtr_t;
+
+typedef struct {
+    uint8 Priority;
+    uint8 Reliability;
+} CFE_SB_Qos_t;
+
+extern CFE_SB_Qos_t CFE_SB_Default_Qos;
+
+#define CFE_SB_CMD_HDR_SIZE                sizeof(CFE_SB_CmdHdr_t)
+#define CFE_SB_TLM_HDR_SIZE                sizeof(CFE_SB_TlmHdr_t)
+
+typedef struct {
+    char AppName[OS_MAX_API_NAME];
+    uint16 EventID;
+    uint16 EventType;
+    uint32 SpacecraftID;
+    uint32 ProcessorID;
+} CFE_EVS_PacketID_t;
+
+typedef struct {
+    CFE_SB_TlmHdr_t TlmHeader;
+    CFE_EVS_PacketID_t PacketID;
+    char Message[CFE_EVS_MAX_MESSAGE_LENGTH];
+    uint8 Spare1;
+    uint8 Spare2;
+} CFE_EVS_Packet_t;
+
+int32 CFE_SB_CreatePipe(CFE_SB_PipeId_t *PipeIdPtr, uint16 Depth, const char *PipeName);
+int32 CFE_SB_Subscribe(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId);
+int32 CFE_SB_SubscribeEx(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId, CFE_SB_Qos_t Quality, uint16 MsgLim);
+int32 CFE_SB_Unsubscribe(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId);
+int32 CFE_SB_RcvMsg(CFE_SB_MsgPtr_t *BufPtr, CFE_SB_PipeId_t PipeId, int32 TimeOut);
+int32 CFE_SB_SendMsg(CFE_SB_Msg_t *MsgPtr);
+CFE_SB_Msg_t *CFE_SB_ZeroCopyGetPtr(uint16 MsgSize, CFE_SB_ZeroCopyHandle_t *BufferHandle);
+int32 CFE_SB_ZeroCopyReleasePtr(CFE_SB_Msg_t *Ptr2Release, CFE_SB_ZeroCopyHandle_t BufferHandle);
+int32 CFE_SB_ZeroCopySend(CFE_SB_Msg_t *MsgPtr, CFE_SB_ZeroCopyHandle_t BufferHandle);
+void CFE_SB_InitMsg(void *MsgPtr, CFE_SB_MsgId_t MsgId, uint16 Length, boolean Clear);
+CFE_SB_MsgId_t CFE_SB_GetMsgId(CFE_SB_MsgPtr_t MsgPtr);
+uint16 CFE_SB_GetCmdCode(CFE_SB_MsgPtr_t MsgPtr);
+int32 CFE_SB_SetCmdCode(CFE_SB_MsgPtr_t MsgPtr, uint16 CmdCode);
+uint16 CFE_SB_GetTotalMsgLength(CFE_SB_MsgPtr_t MsgPtr);
+void CFE_SB_SetTotalMsgLength(CFE_SB_MsgPtr_t MsgPtr, uint16 TotalLength);
+void CFE_SB_TimeStampMsg(CFE_SB_MsgPtr_t MsgPtr);
+CFE_TIME_SysTime_t CFE_SB_GetMsgTime(CFE_SB_MsgPtr_t MsgPtr);
+void CFE_SB_GenerateChecksum(CFE_SB_MsgPtr_t MsgPtr);
+
+/*
+** Table services
+*/
+#define CFE_TBL_OPT_DEFAULT                0
+#define CFE_TBL_SRC_FILE                   0
+#define CFE_TBL_SRC_ADDRESS                1
+
+typedef int16 CFE_TBL_Handle_t;
+typedef int32 (*CFE_TBL_CallbackFuncPtr_t)(void *TblPtr);
+
+int32 CFE_TBL_Register(CFE_TBL_Handle_t *TblHandlePtr, const char *Name, uint32 Size,
+                       uint16 TblOptionFlags, CFE_TBL_CallbackFuncPtr_t TblValidationFuncPtr);
+int32 CFE_TBL_Load(CFE_TBL_Handle_t TblHandle, uint32 SrcType, const void *SrcDataPtr);
+int32 CFE_TBL_GetAddress(void **TblPtr, CFE_TBL_Handle_t TblHandle);
+int32 CFE_TBL_ReleaseAddress(CFE_TBL_Handle_t TblHandle);
+int32 CFE_TBL_Manage(CFE_TBL_Handle_t TblHandle);
+
+/*
+** File services
+*/
+typedef struct {
+    uint32 ContentType;
+    uint32 SubType;
+    uint32 Length;
+    uint32 SpacecraftID;
+    uint32 ProcessorID;
+    uint32 ApplicationID;
+    uint32 TimeSeconds;
+    uint32 TimeSubSeconds;
+    char Description[32];
+} CFE_FS_Header_t;
+
+void CFE_FS_InitHeader(CFE_FS_Header_t *Hdr, const char *Description, uint32 SubType);
+int32 CFE_FS_WriteHeader(int32 FileDes, CFE_FS_Header_t *Hdr);
+
+/*
+** Shim controls
+**
+** A table loaded from a file is copied from the image registered under
+** that file name, standing in for the table files of a real target.
+*/
+void CFE_SHIM_AddTableImage(const char *Filename, const void *Image, uint32 Size);
+uint32 CFE_SHIM_SentMessageCount(void);
+
+#endif /* CFE_SHIM_H */
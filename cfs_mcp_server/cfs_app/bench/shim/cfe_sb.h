@@ -0,0 +1,4 @@
+/*
+** MCP Interface Host Benchmark cFE Shim; everything is declared in cfe.h
+*/
+#include "cfe.h"
@@ -0,0 +1,778 @@
+/*
+** MCP Interface Host Benchmark cFE Shim
+**
+** Just enough of cFE and OSAL for the MCP interface app to initialize
+** and serve requests on a development host. Tasks are pthreads, mutexes
+** are recursive pthread mutexes as in the POSIX OSAL, and messages are
+** CCSDS packets built and read in place. Nothing sent on the software
+** bus goes anywhere; it is only counted. Events are printed when
+** MCP_BENCH_EVENTS is set in the environment.
+*/
+
+/*
+** Include Files
+*/
+#include "cfe.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <malloc.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+/*
+** Shim limits
+*/
+#define CFE_SHIM_MAX_MUTEXES               8
+#define CFE_SHIM_MAX_COUNT_SEMS            8
+#define CFE_SHIM_MAX_TABLES                8
+#define CFE_SHIM_OWN_APP_ID                5
+
+/*
+** Registered tables and the images standing in for their files
+*/
+typedef struct {
+    char Name[OS_MAX_API_NAME * 2];
+    uint32 Size;
+    uint8 *Buffer;
+    uint8 *Staging;
+    CFE_TBL_CallbackFuncPtr_t Validate;
+    boolean Loaded;
+    boolean Updated;
+} CFE_SHIM_Table_t;
+
+typedef struct {
+    char Filename[OS_MAX_PATH_LEN];
+    const void *Image;
+    uint32 Size;
+} CFE_SHIM_TableImage_t;
+
+static pthread_mutex_t CFE_SHIM_Mutexes[CFE_SHIM_MAX_MUTEXES];
+static uint32 CFE_SHIM_MutexCount;
+static sem_t CFE_SHIM_CountSems[CFE_SHIM_MAX_COUNT_SEMS];
+static uint32 CFE_SHIM_CountSemCount;
+static CFE_SHIM_Table_t CFE_SHIM_Tables[CFE_SHIM_MAX_TABLES];
+static uint32 CFE_SHIM_TableCount;
+static CFE_SHIM_TableImage_t CFE_SHIM_TableImages[CFE_SHIM_MAX_TABLES];
+static uint32 CFE_SHIM_TableImageCount;
+static uint32 CFE_SHIM_TaskCount;
+static uint32 CFE_SHIM_SentMessages;
+
+/*
+** Registered apps, indexed by app ID; the others run at 100 Hz over
+** their ID plus one and the app itself counts once
+*/
+static const char *CFE_SHIM_AppNames[] = {
+    "CFE_ES", "CFE_EVS", "CFE_SB", "CFE_TBL", "CFE_TIME", "MCP_INTERFACE", "HK", "FM"
+};
+
+CFE_SB_Qos_t CFE_SB_Default_Qos = { 0, 0 };
+
+/*
+** Local function prototypes
+*/
+static void *CFE_SHIM_TaskEntry(void *arg);
+static uint32 CFE_SHIM_GetBig(const uint8 *bytes, uint32 count);
+static void CFE_SHIM_PutBig(uint8 *bytes, uint32 count, uint32 value);
+
+/*
+** Shim controls
+*/
+void CFE_SHIM_AddTableImage(const char *Filename, const void *Image, uint32 Size)
+{
+    CFE_SHIM_TableImage_t *entry;
+
+    if (CFE_SHIM_TableImageCount >= CFE_SHIM_MAX_TABLES)
+    {
+        return;
+    }
+
+    entry = &CFE_SHIM_TableImages[CFE_SHIM_TableImageCount++];
+    strncpy(entry->Filename, Filename, sizeof(entry->Filename) - 1);
+    entry->Image = Image;
+    entry->Size = Size;
+
+} /* End CFE_SHIM_AddTableImage */
+
+uint32 CFE_SHIM_SentMessageCount(void)
+{
+    return __atomic_load_n(&CFE_SHIM_SentMessages, __ATOMIC_RELAXED);
+
+} /* End CFE_SHIM_SentMessageCount */
+
+/*
+** Executive services
+*/
+int32 CFE_ES_RegisterApp(void)
+{
+    return CFE_SUCCESS;
+}
+
+int32 CFE_ES_RunLoop(uint32 *RunStatus)
+{
+    return (*RunStatus == CFE_ES_APP_RUN);
+}
+
+void CFE_ES_ExitApp(uint32 ExitStatus)
+{
+    (void)ExitStatus;
+}
+
+int32 CFE_ES_CreateChildTask(uint32 *TaskIdPtr, const char *TaskName,
+                             CFE_ES_ChildTaskMainFuncPtr_t FunctionPtr, uint32 *StackPtr,
+                             uint32 StackSize, uint32 Priority, uint32 Flags)
+{
+    CFE_ES_ChildTaskMainFuncPtr_t *entry;
+    pthread_t thread;
+
+    (void)TaskName;
+    (void)StackPtr;
+    (void)StackSize;
+    (void)Priority;
+    (void)Flags;
+
+    /* The entry point travels through a heap cell; function and object pointers do not convert */
+    entry = malloc(sizeof(*entry));
+    if (entry == NULL)
+    {
+        return CFE_ES_ERR_CHILD_TASK_CREATE;
+    }
+    *entry = FunctionPtr;
+
+    if (pthread_create(&thread, NULL, CFE_SHIM_TaskEntry, entry) != 0)
+    {
+        free(entry);
+        return CFE_ES_ERR_CHILD_TASK_CREATE;
+    }
+    pthread_detach(thread);
+
+    *TaskIdPtr = __atomic_add_fetch(&CFE_SHIM_TaskCount, 1, __ATOMIC_RELAXED);
+
+    return CFE_SUCCESS;
+
+} /* End CFE_ES_CreateChildTask */
+
+static void *CFE_SHIM_TaskEntry(void *arg)
+{
+    CFE_ES_ChildTaskMainFuncPtr_t function = *(CFE_ES_ChildTaskMainFuncPtr_t *)arg;
+
+    free(arg);
+    function();
+
+    return NULL;
+
+} /* End CFE_SHIM_TaskEntry */
+
+int32 CFE_ES_RegisterChildTask(void)
+{
+    return CFE_SUCCESS;
+}
+
+void CFE_ES_ExitChildTask(void)
+{
+}
+
+int32 CFE_ES_GetAppInfo(CFE_ES_AppInfo_t *AppInfo, uint32 AppId)
+{
+    struct timespec now;
+
+    if (AppId >= sizeof(CFE_SHIM_AppNames) / sizeof(CFE_SHIM_AppNames[0]))
+    {
+        return CFE_ES_ERR_APPID;
+    }
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    memset(AppInfo, 0, sizeof(*AppInfo));
+    AppInfo->Type = (AppId < CFE_SHIM_OWN_APP_ID) ? CFE_ES_APP_TYPE_CORE : CFE_ES_APP_TYPE_EXTERNAL;
+    AppInfo->AppId = AppId;
+    AppInfo->StackSize = 16384;
+    AppInfo->ExecutionCounter = (AppId == CFE_SHIM_OWN_APP_ID) ? 1 :
+        (uint32)(now.tv_sec * 100 + now.tv_nsec / 10000000) / (AppId + 1);
+    AppInfo->MainTaskId = AppId;
+    AppInfo->NumOfChildTasks = (AppId == CFE_SHIM_OWN_APP_ID) ? CFE_SHIM_TaskCount : 0;
+    AppInfo->Priority = 50 + AppId;
+    AppInfo->AppState = CFE_ES_APP_RUN;
+    strncpy(AppInfo->Name, CFE_SHIM_AppNames[AppId], sizeof(AppInfo->Name) - 1);
+    strncpy(AppInfo->MainTaskName, CFE_SHIM_AppNames[AppId], sizeof(AppInfo->MainTaskName) - 1);
+
+    return CFE_SUCCESS;
+
+} /* End CFE_ES_GetAppInfo */
+
+int32 CFE_ES_GetAppID(uint32 *AppIdPtr)
+{
+    *AppIdPtr = CFE_SHIM_OWN_APP_ID;
+
+    return CFE_SUCCESS;
+
+} /* End CFE_ES_GetAppID */
+
+int32 CFE_ES_GetAppIDByName(uint32 *AppIdPtr, const char *AppName)
+{
+    uint32 i;
+
+    for (i = 0; i < sizeof(CFE_SHIM_AppNames) / sizeof(CFE_SHIM_AppNames[0]); i++)
+    {
+        if (strcmp(CFE_SHIM_AppNames[i], AppName) == 0)
+        {
+            *AppIdPtr = i;
+            return CFE_SUCCESS;
+        }
+    }
+
+    return CFE_ES_ERR_APPNAME;
+
+} /* End CFE_ES_GetAppIDByName */
+
+int32 CFE_ES_WriteToSysLog(const char *SpecStringPtr, ...)
+{
+    va_list args;
+
+    va_start(args, SpecStringPtr);
+    vfprintf(stderr, SpecStringPtr, args);
+    va_end(args);
+
+    return CFE_SUCCESS;
+
+} /* End CFE_ES_WriteToSysLog */
+
+void CFE_ES_PerfLogEntry(uint32 Marker)
+{
+    (void)Marker;
+}
+
+void CFE_ES_PerfLogExit(uint32 Marker)
+{
+    (void)Marker;
+}
+
+/*
+** Event services
+*/
+int32 CFE_EVS_Register(void *Filters, uint16 NumFilteredEvents, uint16 FilterScheme)
+{
+    (void)Filters;
+    (void)NumFilteredEvents;
+    (void)FilterScheme;
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_EVS_SendEvent(uint16 EventID, uint16 EventType, const char *Spec, ...)
+{
+    va_list args;
+
+    if (getenv("MCP_BENCH_EVENTS") == NULL)
+    {
+        return CFE_SUCCESS;
+    }
+
+    va_start(args, Spec);
+    fprintf(stderr, "EVS %u/%u: ", (unsigned int)EventID, (unsigned int)EventType);
+    vfprintf(stderr, Spec, args);
+    fprintf(stderr, "\n");
+    va_end(args);
+
+    return CFE_SUCCESS;
+
+} /* End CFE_EVS_SendEvent */
+
+/*
+** Time services
+*/
+CFE_TIME_SysTime_t CFE_TIME_GetTime(void)
+{
+    CFE_TIME_SysTime_t time;
+    struct timespec now;
+
+    clock_gettime(CLOCK_REALTIME, &now);
+    time.Seconds = (uint32)now.tv_sec;
+    time.Subseconds = (uint32)(((uint64)now.tv_nsec << 32) / 1000000000);
+
+    return time;
+
+} /* End CFE_TIME_GetTime */
+
+uint32 CFE_TIME_Sub2MicroSecs(uint32 SubSeconds)
+{
+    return (uint32)(((uint64)SubSeconds * 1000000) >> 32);
+}
+
+/*
+** Software bus
+*/
+int32 CFE_SB_CreatePipe(CFE_SB_PipeId_t *PipeIdPtr, uint16 Depth, const char *PipeName)
+{
+    (void)Depth;
+    (void)PipeName;
+    *PipeIdPtr = 0;
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_SB_Subscribe(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId)
+{
+    (void)MsgId;
+    (void)PipeId;
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_SB_SubscribeEx(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId, CFE_SB_Qos_t Quality, uint16 MsgLim)
+{
+    (void)Quality;
+    (void)MsgLim;
+
+    return CFE_SB_Subscribe(MsgId, PipeId);
+}
+
+int32 CFE_SB_Unsubscribe(CFE_SB_MsgId_t MsgId, CFE_SB_PipeId_t PipeId)
+{
+    (void)MsgId;
+    (void)PipeId;
+
+    return CFE_SUCCESS;
+}
+
+/*
+** Nothing is ever routed to the app's pipe; the benchmark hands packets
+** to the app itself, so a receive just waits out its timeout.
+*/
+int32 CFE_SB_RcvMsg(CFE_SB_MsgPtr_t *BufPtr, CFE_SB_PipeId_t PipeId, int32 TimeOut)
+{
+    (void)BufPtr;
+    (void)PipeId;
+
+    OS_TaskDelay(TimeOut < 0 ? 1000 : (uint32)TimeOut);
+
+    return (TimeOut == CFE_SB_POLL) ? CFE_SB_NO_MESSAGE : CFE_SB_TIME_OUT;
+
+} /* End CFE_SB_RcvMsg */
+
+int32 CFE_SB_SendMsg(CFE_SB_Msg_t *MsgPtr)
+{
+    (void)MsgPtr;
+    __atomic_fetch_add(&CFE_SHIM_SentMessages, 1, __ATOMIC_RELAXED);
+
+    return CFE_SUCCESS;
+}
+
+CFE_SB_Msg_t *CFE_SB_ZeroCopyGetPtr(uint16 MsgSize, CFE_SB_ZeroCopyHandle_t *BufferHandle)
+{
+    CFE_SB_Msg_t *msg = calloc(1, MsgSize);
+
+    *BufferHandle = msg;
+
+    return msg;
+}
+
+int32 CFE_SB_ZeroCopyReleasePtr(CFE_SB_Msg_t *Ptr2Release, CFE_SB_ZeroCopyHandle_t BufferHandle)
+{
+    (void)BufferHandle;
+    free(Ptr2Release);
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_SB_ZeroCopySend(CFE_SB_Msg_t *MsgPtr, CFE_SB_ZeroCopyHandle_t BufferHandle)
+{
+    CFE_SB_SendMsg(MsgPtr);
+
+    return CFE_SB_ZeroCopyReleasePtr(MsgPtr, BufferHandle);
+}
+
+void CFE_SB_InitMsg(void *MsgPtr, CFE_SB_MsgId_t MsgId, uint16 Length, boolean Clear)
+{
+    uint8 *bytes = MsgPtr;
+
+    if (Clear)
+    {
+        memset(bytes, 0, Length);
+    }
+
+    CFE_SHIM_PutBig(&bytes[0], 2, MsgId);
+    CFE_SHIM_PutBig(&bytes[2], 2, 0xC000);
+    CFE_SB_SetTotalMsgLength(MsgPtr, Length);
+
+} /* End CFE_SB_InitMsg */
+
+CFE_SB_MsgId_t CFE_SB_GetMsgId(CFE_SB_MsgPtr_t MsgPtr)
+{
+    return (CFE_SB_MsgId_t)CFE_SHIM_GetBig(MsgPtr->Hdr.StreamId, 2);
+}
+
+uint16 CFE_SB_GetCmdCode(CFE_SB_MsgPtr_t MsgPtr)
+{
+    return ((CFE_SB_CmdHdr_t *)MsgPtr)->Sec[0] & 0x7F;
+}
+
+int32 CFE_SB_SetCmdCode(CFE_SB_MsgPtr_t MsgPtr, uint16 CmdCode)
+{
+    CFE_SB_CmdHdr_t *cmd = (CFE_SB_CmdHdr_t *)MsgPtr;
+
+    cmd->Sec[0] = (uint8)((cmd->Sec[0] & 0x80) | (CmdCode & 0x7F));
+
+    return CFE_SUCCESS;
+}
+
+uint16 CFE_SB_GetTotalMsgLength(CFE_SB_MsgPtr_t MsgPtr)
+{
+    return (uint16)(CFE_SHIM_GetBig(MsgPtr->Hdr.Length, 2) + 7);
+}
+
+void CFE_SB_SetTotalMsgLength(CFE_SB_MsgPtr_t MsgPtr, uint16 TotalLength)
+{
+    CFE_SHIM_PutBig(MsgPtr->Hdr.Length, 2, (uint32)TotalLength - 7);
+}
+
+void CFE_SB_TimeStampMsg(CFE_SB_MsgPtr_t MsgPtr)
+{
+    CFE_SB_TlmHdr_t *tlm = (CFE_SB_TlmHdr_t *)MsgPtr;
+    CFE_TIME_SysTime_t now = CFE_TIME_GetTime();
+
+    CFE_SHIM_PutBig(&tlm->Sec[0], 4, now.Seconds);
+    CFE_SHIM_PutBig(&tlm->Sec[4], 2, now.Subseconds >> 16);
+
+} /* End CFE_SB_TimeStampMsg */
+
+CFE_TIME_SysTime_t CFE_SB_GetMsgTime(CFE_SB_MsgPtr_t MsgPtr)
+{
+    const CFE_SB_TlmHdr_t *tlm = (const CFE_SB_TlmHdr_t *)MsgPtr;
+    CFE_TIME_SysTime_t time;
+
+    time.Seconds = CFE_SHIM_GetBig(&tlm->Sec[0], 4);
+    time.Subseconds = CFE_SHIM_GetBig(&tlm->Sec[4], 2) << 16;
+
+    return time;
+
+} /* End CFE_SB_GetMsgTime */
+
+void CFE_SB_GenerateChecksum(CFE_SB_MsgPtr_t MsgPtr)
+{
+    CFE_SB_CmdHdr_t *cmd = (CFE_SB_CmdHdr_t *)MsgPtr;
+    const uint8 *bytes = (const uint8 *)MsgPtr;
+    uint16 length = CFE_SB_GetTotalMsgLength(MsgPtr);
+    uint8 checksum = 0xFF;
+    uint16 i;
+
+    cmd->Sec[1] = 0;
+    for (i = 0; i < length; i++)
+    {
+        checksum ^= bytes[i];
+    }
+    cmd->Sec[1] = checksum;
+
+} /* End CFE_SB_GenerateChecksum */
+
+static uint32 CFE_SHIM_GetBig(const uint8 *bytes, uint32 count)
+{
+    uint32 value = 0;
+    uint32 i;
+
+    for (i = 0; i < count; i++)
+    {
+        value = (value << 8) | bytes[i];
+    }
+
+    return value;
+
+} /* End CFE_SHIM_GetBig */
+
+static void CFE_SHIM_PutBig(uint8 *bytes, uint32 count, uint32 value)
+{
+    while (count > 0)
+    {
+        bytes[--count] = (uint8)value;
+        value >>= 8;
+    }
+
+} /* End CFE_SHIM_PutBig */
+
+/*
+** Table services
+**
+** A load validates a copy of the registered image and, if it passes,
+** makes it the active table; the next GetAddress reports the update.
+*/
+int32 CFE_TBL_Register(CFE_TBL_Handle_t *TblHandlePtr, const char *Name, uint32 Size,
+                       uint16 TblOptionFlags, CFE_TBL_CallbackFuncPtr_t TblValidationFuncPtr)
+{
+    CFE_SHIM_Table_t *table;
+
+    (void)TblOptionFlags;
+
+    if (CFE_SHIM_TableCount >= CFE_SHIM_MAX_TABLES)
+    {
+        return CFE_TBL_ERR_INVALID_HANDLE;
+    }
+
+    table = &CFE_SHIM_Tables[CFE_SHIM_TableCount];
+    strncpy(table->Name, Name, sizeof(table->Name) - 1);
+    table->Size = Size;
+    table->Buffer = calloc(1, Size);
+    table->Staging = calloc(1, Size);
+    table->Validate = TblValidationFuncPtr;
+    if (table->Buffer == NULL || table->Staging == NULL)
+    {
+        return CFE_TBL_ERR_INVALID_HANDLE;
+    }
+
+    *TblHandlePtr = (CFE_TBL_Handle_t)CFE_SHIM_TableCount++;
+
+    return CFE_SUCCESS;
+
+} /* End CFE_TBL_Register */
+
+int32 CFE_TBL_Load(CFE_TBL_Handle_t TblHandle, uint32 SrcType, const void *SrcDataPtr)
+{
+    CFE_SHIM_Table_t *table;
+    const void *image = SrcDataPtr;
+    uint32 size;
+    uint32 i;
+
+    if (TblHandle < 0 || (uint32)TblHandle >= CFE_SHIM_TableCount)
+    {
+        return CFE_TBL_ERR_INVALID_HANDLE;
+    }
+    table = &CFE_SHIM_Tables[TblHandle];
+    size = table->Size;
+
+    if (SrcType == CFE_TBL_SRC_FILE)
+    {
+        image = NULL;
+        for (i = 0; i < CFE_SHIM_TableImageCount; i++)
+        {
+            if (strcmp(CFE_SHIM_TableImages[i].Filename, SrcDataPtr) == 0)
+            {
+                image = CFE_SHIM_TableImages[i].Image;
+                size = CFE_SHIM_TableImages[i].Size;
+            }
+        }
+        if (image == NULL || size != table->Size)
+        {
+            return CFE_TBL_ERR_FILE_NOT_FOUND;
+        }
+    }
+
+    memcpy(table->Staging, image, size);
+    if (table->Validate != NULL && table->Validate(table->Staging) != CFE_SUCCESS)
+    {
+        return CFE_TBL_ERR_NO_ACCESS;
+    }
+
+    memcpy(table->Buffer, table->Staging, size);
+    table->Loaded = TRUE;
+    table->Updated = TRUE;
+
+    return CFE_SUCCESS;
+
+} /* End CFE_TBL_Load */
+
+int32 CFE_TBL_GetAddress(void **TblPtr, CFE_TBL_Handle_t TblHandle)
+{
+    CFE_SHIM_Table_t *table;
+
+    if (TblHandle < 0 || (uint32)TblHandle >= CFE_SHIM_TableCount)
+    {
+        return CFE_TBL_ERR_INVALID_HANDLE;
+    }
+    table = &CFE_SHIM_Tables[TblHandle];
+
+    if (!table->Loaded)
+    {
+        return CFE_TBL_ERR_NO_ACCESS;
+    }
+
+    *TblPtr = table->Buffer;
+    if (table->Updated)
+    {
+        table->Updated = FALSE;
+        return CFE_TBL_INFO_UPDATED;
+    }
+
+    return CFE_SUCCESS;
+
+} /* End CFE_TBL_GetAddress */
+
+int32 CFE_TBL_ReleaseAddress(CFE_TBL_Handle_t TblHandle)
+{
+    (void)TblHandle;
+
+    return CFE_SUCCESS;
+}
+
+int32 CFE_TBL_Manage(CFE_TBL_Handle_t TblHandle)
+{
+    (void)TblHandle;
+
+    return CFE_SUCCESS;
+}
+
+/*
+** File services
+*/
+void CFE_FS_InitHeader(CFE_FS_Header_t *Hdr, const char *Description, uint32 SubType)
+{
+    memset(Hdr, 0, sizeof(*Hdr));
+    Hdr->ContentType = 0x63464531; /* "cFE1" */
+    Hdr->SubType = SubType;
+    Hdr->Length = sizeof(*Hdr);
+    strncpy(Hdr->Description, Description, sizeof(Hdr->Description) - 1);
+
+} /* End CFE_FS_InitHeader */
+
+int32 CFE_FS_WriteHeader(int32 FileDes, CFE_FS_Header_t *Hdr)
+{
+    CFE_TIME_SysTime_t now = CFE_TIME_GetTime();
+
+    Hdr->TimeSeconds = now.Seconds;
+    Hdr->TimeSubSeconds = now.Subseconds;
+
+    return OS_write(FileDes, Hdr, sizeof(*Hdr));
+
+} /* End CFE_FS_WriteHeader */
+
+/*
+** OSAL semaphores
+*/
+int32_t OS_MutSemCreate(uint32_t *sem_id, const char *sem_name, uint32_t options)
+{
+    pthread_mutexattr_t attr;
+
+    (void)sem_name;
+    (void)options;
+
+    if (CFE_SHIM_MutexCount >= CFE_SHIM_MAX_MUTEXES)
+    {
+        return OS_ERROR;
+    }
+
+    pthread_mutexattr_init(&attr);
+    pthread_mutexattr_settype(&attr, PTHREAD_MUTEX_RECURSIVE);
+    pthread_mutex_init(&CFE_SHIM_Mutexes[CFE_SHIM_MutexCount], &attr);
+    pthread_mutexattr_destroy(&attr);
+
+    *sem_id = CFE_SHIM_MutexCount++;
+
+    return OS_SUCCESS;
+
+} /* End OS_MutSemCreate */
+
+int32_t OS_MutSemTake(uint32_t sem_id)
+{
+    return (pthread_mutex_lock(&CFE_SHIM_Mutexes[sem_id]) == 0) ? OS_SUCCESS : OS_ERROR;
+}
+
+int32_t OS_MutSemGive(uint32_t sem_id)
+{
+    return (pthread_mutex_unlock(&CFE_SHIM_Mutexes[sem_id]) == 0) ? OS_SUCCESS : OS_ERROR;
+}
+
+int32_t OS_CountSemCreate(uint32_t *sem_id, const char *sem_name, uint32_t sem_initial_value, uint32_t options)
+{
+    (void)sem_name;
+    (void)options;
+
+    if (CFE_SHIM_CountSemCount >= CFE_SHIM_MAX_COUNT_SEMS)
+    {
+        return OS_ERROR;
+    }
+
+    sem_init(&CFE_SHIM_CountSems[CFE_SHIM_CountSemCount], 0, sem_initial_value);
+    *sem_id = CFE_SHIM_CountSemCount++;
+
+    return OS_SUCCESS;
+
+} /* End OS_CountSemCreate */
+
+int32_t OS_CountSemGive(uint32_t sem_id)
+{
+    return (sem_post(&CFE_SHIM_CountSems[sem_id]) == 0) ? OS_SUCCESS : OS_ERROR;
+}
+
+int32_t OS_CountSemTimedWait(uint32_t sem_id, uint32_t msecs)
+{
+    struct timespec deadline;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += msecs / 1000;
+    deadline.tv_nsec += (long)(msecs % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000)
+    {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    while (sem_timedwait(&CFE_SHIM_CountSems[sem_id], &deadline) != 0)
+    {
+        if (errno != EINTR)
+        {
+            return (errno == ETIMEDOUT) ? OS_SEM_TIMEOUT : OS_ERROR;
+        }
+    }
+
+    return OS_SUCCESS;
+
+} /* End OS_CountSemTimedWait */
+
+int32_t OS_TaskDelay(uint32_t millisecond)
+{
+    struct timespec delay;
+
+    delay.tv_sec = millisecond / 1000;
+    delay.tv_nsec = (long)(millisecond % 1000) * 1000000;
+    while (nanosleep(&delay, &delay) != 0 && errno == EINTR)
+    {
+    }
+
+    return OS_SUCCESS;
+
+} /* End OS_TaskDelay */
+
+/*
+** The malloc arena stands in for the heap; glibc does not report its
+** largest free block, so the free total is given instead
+*/
+int32_t OS_HeapGetInfo(OS_heap_prop_t *heap_prop)
+{
+    struct mallinfo2 info = mallinfo2();
+
+    heap_prop->free_bytes = (uint32)info.fordblks;
+    heap_prop->free_blocks = (uint32)info.ordblks;
+    heap_prop->largest_free_block = (uint32)info.fordblks;
+
+    return OS_SUCCESS;
+
+} /* End OS_HeapGetInfo */
+
+/*
+** OSAL files
+*/
+int32_t OS_creat(const char *path, int32_t access)
+{
+    int fd;
+
+    (void)access;
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+    return (fd < 0) ? OS_FS_ERROR : fd;
+}
+
+int32_t OS_write(int32_t filedes, void *buffer, uint32_t nbytes)
+{
+    ssize_t written = write(filedes, buffer, nbytes);
+
+    return (written < 0) ? OS_FS_ERROR : (int32_t)written;
+}
+
+int32_t OS_close(int32_t filedes)
+{
+    return (close(filedes) == 0) ? OS_SUCCESS : OS_FS_ERROR;
+}
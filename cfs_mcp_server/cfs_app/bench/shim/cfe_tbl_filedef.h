@@ -0,0 +1,26 @@
+/*
+** MCP Interface Host Benchmark cFE Shim Table File Definition
+**
+** The table sources are compiled into the benchmark directly, so the
+** file definition only has to compile; each table gets its own unused
+** object so that both tables can be linked into one program.
+*/
+
+#ifndef CFE_TBL_FILEDEF_SHIM_H
+#define CFE_TBL_FILEDEF_SHIM_H
+
+#include "cfe.h"
+
+typedef struct {
+    char ObjectName[64];
+    char TableName[40];
+    char Description[32];
+    char TgtFilename[20];
+    uint32 ObjectSize;
+} CFE_TBL_FileDef_t;
+
+#define CFE_TBL_FILEDEF(ObjName, TblName, Desc, Filename) \
+    static const CFE_TBL_FileDef_t ObjName##_FileDef __attribute__((unused)) = \
+        { #ObjName, #TblName, #Desc, #Filename, sizeof(ObjName) };
+
+#endif /* CFE_TBL_FILEDEF_SHIM_H */
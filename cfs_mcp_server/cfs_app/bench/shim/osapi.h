@@ -0,0 +1,46 @@
+/*
+** MCP Interface Host Benchmark OSAL Shim
+**
+** The subset of the OSAL API the MCP interface app uses, implemented
+** on pthreads and POSIX files in cfe_shim.c.
+*/
+
+#ifndef OSAPI_SHIM_H
+#define OSAPI_SHIM_H
+
+#include <stdint.h>
+#include <stdio.h>                  /* as the OSAL osapi.h does */
+
+#define OS_SUCCESS                         0
+#define OS_ERROR                           (-1)
+#define OS_FS_ERROR                        (-1)
+#define OS_SEM_TIMEOUT                     (-6)
+
+#define OS_MAX_API_NAME                    20
+#define OS_MAX_PATH_LEN                    64
+
+#define OS_WRITE_ONLY                      1
+
+int32_t OS_MutSemCreate(uint32_t *sem_id, const char *sem_name, uint32_t options);
+int32_t OS_MutSemTake(uint32_t sem_id);
+int32_t OS_MutSemGive(uint32_t sem_id);
+
+int32_t OS_CountSemCreate(uint32_t *sem_id, const char *sem_name, uint32_t sem_initial_value, uint32_t options);
+int32_t OS_CountSemGive(uint32_t sem_id);
+int32_t OS_CountSemTimedWait(uint32_t sem_id, uint32_t msecs);
+
+int32_t OS_TaskDelay(uint32_t millisecond);
+
+typedef struct {
+    uint32_t free_bytes;
+    uint32_t free_blocks;
+    uint32_t largest_free_block;
+} OS_heap_prop_t;
+
+int32_t OS_HeapGetInfo(OS_heap_prop_t *heap_prop);
+
+int32_t OS_creat(const char *path, int32_t access);
+int32_t OS_write(int32_t filedes, void *buffer, uint32_t nbytes);
+int32_t OS_close(int32_t filedes);
+
+#endif /* OSAPI_SHIM_H */
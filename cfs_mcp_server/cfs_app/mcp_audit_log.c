@@ -0,0 +1,396 @@
+/*
+** MCP Interface Audit Log
+**
+** This file contains the persistent record of what the app did to the
+** spacecraft: every command sent or failed, safety block, confirmation
+** and emergency stop. Callers format an entry and copy it into the
+** filling half of a double buffer, which costs them a short mutex hold
+** and no I/O, so commanding latency does not depend on the file system.
+** The audit task writes the other half in one batch, syncs the file on
+** a bounded cadence and rotates it by size.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+#include <stdio.h>
+#include <stdarg.h>
+#include <sys/stat.h>
+
+/*
+** Local function prototypes
+*/
+static void MCP_INTERFACE_FlushAuditLog(void);
+static void MCP_INTERFACE_WriteAuditBatch(const char *batch, uint32 length);
+static boolean MCP_INTERFACE_OpenAuditFile(void);
+static void MCP_INTERFACE_SyncAuditFile(void);
+static uint32 MCP_INTERFACE_CountAuditEntries(const char *batch, uint32 length);
+
+/*
+** Create the audit buffers and start the task that writes them
+**
+** The file itself is opened by the task, so a missing or full file
+** system costs only the entries, never the app.
+*/
+int32 MCP_INTERFACE_StartAuditLog(void)
+{
+    MCP_INTERFACE_AuditLog_t *log = &MCP_INTERFACE_AppData.AuditLog;
+    int32 status;
+
+    log->Used[0] = 0;
+    log->Used[1] = 0;
+    log->Filling = 0;
+    log->WakeGiven = FALSE;
+    log->Fd = -1;
+    log->FileSize = 0;
+    log->Unsynced = FALSE;
+    log->LastSyncUs = MCP_INTERFACE_MetricsNowUs();
+    log->OpenFailed = FALSE;
+
+    status = OS_MutSemCreate(&log->Mutex, MCP_AUDIT_MUTEX_NAME, 0);
+    if (status != OS_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to create audit mutex, RC = 0x%08X\n",
+                           status);
+        return (status);
+    }
+
+    status = OS_CountSemCreate(&log->SemId, MCP_AUDIT_SEM_NAME, 0, 0);
+    if (status != OS_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to create audit semaphore, RC = 0x%08X\n",
+                           status);
+        return (status);
+    }
+
+    status = CFE_ES_CreateChildTask(&log->TaskId,
+                                    MCP_AUDIT_TASK_NAME,
+                                    MCP_INTERFACE_AuditTask,
+                                    NULL,
+                                    MCP_AUDIT_TASK_STACK_SIZE,
+                                    MCP_AUDIT_TASK_PRIORITY,
+                                    0);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to create audit task, RC = 0x%08X\n",
+                           status);
+        return (status);
+    }
+
+    return (CFE_SUCCESS);
+
+} /* End MCP_INTERFACE_StartAuditLog */
+
+/*
+** Audit child task
+**
+** Writes a batch whenever it is woken for a half full buffer, and at
+** least every MCP_AUDIT_FLUSH_MS. What is buffered when the app stops
+** is written and synced before the task exits.
+*/
+void MCP_INTERFACE_AuditTask(void)
+{
+    MCP_INTERFACE_AuditLog_t *log = &MCP_INTERFACE_AppData.AuditLog;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    while (MCP_INTERFACE_AppData.RunStatus == CFE_ES_APP_RUN)
+    {
+        /* A timeout flushes as well as a wakeup does */
+        (void)OS_CountSemTimedWait(log->SemId, MCP_AUDIT_FLUSH_MS);
+
+        MCP_INTERFACE_FlushAuditLog();
+
+        if (log->Unsynced &&
+            MCP_INTERFACE_MetricsNowUs() - log->LastSyncUs >= MCP_AUDIT_SYNC_MS * 1000u)
+        {
+            MCP_INTERFACE_SyncAuditFile();
+        }
+    }
+
+    MCP_INTERFACE_FlushAuditLog();
+    MCP_INTERFACE_SyncAuditFile();
+
+    if (log->Fd >= 0)
+    {
+        close(log->Fd);
+        log->Fd = -1;
+    }
+
+    CFE_ES_ExitChildTask();
+
+} /* End MCP_INTERFACE_AuditTask */
+
+/*
+** Append an audit entry
+**
+** The entry is kind followed by the formatted text, stamped with the
+** CFE time, and truncated to MCP_AUDIT_LINE_MAX. Control characters in
+** the text, which may come from a client, are written as \xNN so no
+** entry can break the log into lines of its own making. Safe to call
+** from any task, with or without the data mutex held.
+*/
+void MCP_INTERFACE_Audit(const char *kind, const char *format, ...)
+{
+    MCP_INTERFACE_AuditLog_t *log = &MCP_INTERFACE_AppData.AuditLog;
+    CFE_TIME_SysTime_t now;
+    va_list args;
+    char text[MCP_AUDIT_LINE_MAX];
+    char line[MCP_AUDIT_LINE_MAX];
+    const char *c;
+    int length;
+    uint32 half;
+    boolean wake = FALSE;
+
+    now = CFE_TIME_GetTime();
+
+    length = snprintf(line, sizeof(line), "%u.%06u %s ",
+                      (unsigned int)now.Seconds,
+                      (unsigned int)CFE_TIME_Sub2MicroSecs(now.Subseconds), kind);
+
+    va_start(args, format);
+    (void)vsnprintf(text, sizeof(text), format, args);
+    va_end(args);
+
+    /* Leave room for the newline, and for an escape to end the text */
+    for (c = text; *c != '\0' && length < (int)sizeof(line) - 5; c++)
+    {
+        if ((uint8)*c < 0x20 || (uint8)*c == 0x7F)
+        {
+            length += snprintf(&line[length], 5, "\\x%02X", (unsigned int)(uint8)*c);
+        }
+        else
+        {
+            line[length++] = *c;
+        }
+    }
+    line[length++] = '\n';
+
+    OS_MutSemTake(log->Mutex);
+
+    half = log->Filling;
+    if (log->Used[half] + length > MCP_AUDIT_BUFFER_SIZE)
+    {
+        OS_MutSemGive(log->Mutex);
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.AuditDropped, 1);
+        return;
+    }
+
+    memcpy(&log->Buffers[half][log->Used[half]], line, length);
+    log->Used[half] += length;
+
+    if (!log->WakeGiven && log->Used[half] >= MCP_AUDIT_BUFFER_SIZE / 2)
+    {
+        log->WakeGiven = TRUE;
+        wake = TRUE;
+    }
+
+    OS_MutSemGive(log->Mutex);
+
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.AuditEntries, 1);
+
+    if (wake)
+    {
+        OS_CountSemGive(log->SemId);
+    }
+
+} /* End MCP_INTERFACE_Audit */
+
+/*
+** Append the entry for a command put on the bus, or that failed to be
+**
+** via says how the command got there: sent as requested, from the rate
+** queue, or confirmed after being prepared.
+*/
+void MCP_INTERFACE_AuditCommand(const char *via, uint32 request_id, const MCP_INTERFACE_CmdEntry_t *entry,
+                                boolean critical, const char *payload_hex, uint32 payload_hex_len, int32 status)
+{
+    if (status == CFE_SUCCESS)
+    {
+        MCP_INTERFACE_Audit("COMMAND", "sent via=%s request=%u app=%s command=%s msg_id=0x%04X code=%u "
+                            "critical=%u payload=%.*s",
+                            via, (unsigned int)request_id, entry->AppName, entry->CommandName,
+                            entry->MsgId, entry->CommandCode, (unsigned int)(critical != FALSE),
+                            (int)payload_hex_len, payload_hex);
+    }
+    else
+    {
+        MCP_INTERFACE_Audit("COMMAND", "failed via=%s request=%u app=%s command=%s msg_id=0x%04X code=%u "
+                            "critical=%u status=0x%08X",
+                            via, (unsigned int)request_id, entry->AppName, entry->CommandName,
+                            entry->MsgId, entry->CommandCode, (unsigned int)(critical != FALSE),
+                            (unsigned int)status);
+    }
+
+} /* End MCP_INTERFACE_AuditCommand */
+
+/*
+** Swap the buffer halves and write the one that was filling
+**
+** The half the task wrote last is empty by the time it is swapped back
+** in, since only the task writes and it writes one half at a time.
+*/
+static void MCP_INTERFACE_FlushAuditLog(void)
+{
+    MCP_INTERFACE_AuditLog_t *log = &MCP_INTERFACE_AppData.AuditLog;
+    uint32 half;
+    uint32 used;
+
+    OS_MutSemTake(log->Mutex);
+
+    half = log->Filling;
+    used = log->Used[half];
+    if (used > 0)
+    {
+        log->Filling = half ^ 1;
+        log->Used[log->Filling] = 0;
+        log->WakeGiven = FALSE;
+    }
+
+    OS_MutSemGive(log->Mutex);
+
+    if (used > 0)
+    {
+        MCP_INTERFACE_WriteAuditBatch(log->Buffers[half], used);
+    }
+
+} /* End MCP_INTERFACE_FlushAuditLog */
+
+/*
+** Append a batch of entries to the file, rotating it first if the
+** batch would take it past its size
+*/
+static void MCP_INTERFACE_WriteAuditBatch(const char *batch, uint32 length)
+{
+    MCP_INTERFACE_AuditLog_t *log = &MCP_INTERFACE_AppData.AuditLog;
+    uint32 written = 0;
+    ssize_t count;
+
+    if (log->Fd >= 0 && log->FileSize > 0 && log->FileSize + length > MCP_AUDIT_LOG_MAX_SIZE)
+    {
+        MCP_INTERFACE_SyncAuditFile();
+        close(log->Fd);
+        log->Fd = -1;
+
+        if (rename(MCP_AUDIT_LOG_FILE, MCP_AUDIT_LOG_OLD_FILE) != 0)
+        {
+            CFE_EVS_SendEvent(MCP_INTERFACE_AUDIT_ERR_EID,
+                             CFE_EVS_ERROR,
+                             "MCP_INTERFACE: Audit log %s not rotated, errno = %d",
+                             MCP_AUDIT_LOG_FILE, errno);
+        }
+    }
+
+    if (log->Fd < 0 && !MCP_INTERFACE_OpenAuditFile())
+    {
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.AuditDropped,
+                                  MCP_INTERFACE_CountAuditEntries(batch, length));
+        return;
+    }
+
+    while (written < length)
+    {
+        count = write(log->Fd, batch + written, length - written);
+        if (count < 0 && errno == EINTR)
+        {
+            continue;
+        }
+        if (count <= 0)
+        {
+            CFE_EVS_SendEvent(MCP_INTERFACE_AUDIT_ERR_EID,
+                             CFE_EVS_ERROR,
+                             "MCP_INTERFACE: Audit log write failed, errno = %d",
+                             errno);
+            MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.AuditDropped,
+                                      MCP_INTERFACE_CountAuditEntries(batch + written, length - written));
+
+            /* Reopened for the next batch, in case the file went away */
+            close(log->Fd);
+            log->Fd = -1;
+            break;
+        }
+        written += (uint32)count;
+    }
+
+    log->FileSize += written;
+    if (written > 0)
+    {
+        log->Unsynced = TRUE;
+    }
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.AuditBatches, 1);
+
+} /* End MCP_INTERFACE_WriteAuditBatch */
+
+/*
+** Open the log for appending and learn its size
+**
+** A failure is reported once, then retried quietly with every batch
+** until the file opens again.
+*/
+static boolean MCP_INTERFACE_OpenAuditFile(void)
+{
+    MCP_INTERFACE_AuditLog_t *log = &MCP_INTERFACE_AppData.AuditLog;
+    struct stat file_stat;
+
+    log->Fd = open(MCP_AUDIT_LOG_FILE, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (log->Fd < 0)
+    {
+        if (!log->OpenFailed)
+        {
+            log->OpenFailed = TRUE;
+            CFE_EVS_SendEvent(MCP_INTERFACE_AUDIT_ERR_EID,
+                             CFE_EVS_ERROR,
+                             "MCP_INTERFACE: Audit log %s not opened, errno = %d",
+                             MCP_AUDIT_LOG_FILE, errno);
+        }
+        return FALSE;
+    }
+
+    log->OpenFailed = FALSE;
+    log->FileSize = (fstat(log->Fd, &file_stat) == 0) ? (uint32)file_stat.st_size : 0;
+
+    return TRUE;
+
+} /* End MCP_INTERFACE_OpenAuditFile */
+
+/*
+** Sync what has been written since the last sync
+*/
+static void MCP_INTERFACE_SyncAuditFile(void)
+{
+    MCP_INTERFACE_AuditLog_t *log = &MCP_INTERFACE_AppData.AuditLog;
+
+    if (log->Fd >= 0 && log->Unsynced)
+    {
+        (void)fsync(log->Fd);
+    }
+
+    log->Unsynced = FALSE;
+    log->LastSyncUs = MCP_INTERFACE_MetricsNowUs();
+
+} /* End MCP_INTERFACE_SyncAuditFile */
+
+/*
+** Count the entries in part of a batch, for the dropped metric
+*/
+static uint32 MCP_INTERFACE_CountAuditEntries(const char *batch, uint32 length)
+{
+    uint32 count = 0;
+    uint32 i;
+
+    for (i = 0; i < length; i++)
+    {
+        if (batch[i] == '\n')
+        {
+            count++;
+        }
+    }
+
+    return count;
+
+} /* End MCP_INTERFACE_CountAuditEntries */
@@ -0,0 +1,394 @@
+/*
+** MCP Interface Command Admission
+**
+** This file contains the rate limiting of commands sent through the
+** dictionary. Each app and rate class has a token bucket, kept as the
+** time at which it is full again: taking a token moves that time one
+** refill later, and a token is free once the bucket is due to be full
+** within Burst - 1 refills. A command that would wait for a token takes
+** it at once and is queued until it is due, so queued commands keep
+** their order and a later command never overtakes them. Commands are
+** only admitted and queued commands only sent on the socket task, and
+** apart from MCP_INTERFACE_SendQueuedCommands, which takes it, every
+** function is called with the data mutex held.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+
+/*
+** Local function prototypes
+*/
+static MCP_INTERFACE_RateBucket_t *MCP_INTERFACE_FindRateBucket(const char *app_name, uint32 class_id,
+                                                                 uint32 now);
+static int32 MCP_INTERFACE_SendDueCommands(uint32 now);
+static void MCP_INTERFACE_SendQueuedCommand(MCP_INTERFACE_QueuedCmd_t *queued);
+
+/*
+** Start with full buckets and an empty queue
+*/
+void MCP_INTERFACE_InitCmdAdmission(void)
+{
+    memset(&MCP_INTERFACE_AppData.CmdAdmission, 0, sizeof(MCP_INTERFACE_AppData.CmdAdmission));
+
+} /* End MCP_INTERFACE_InitCmdAdmission */
+
+/*
+** Admit a command to the bus
+**
+** Returns MCP_ADMIT_SEND when the command may be sent now, MCP_ADMIT_QUEUED
+** when it was queued to be sent in admission->WaitMs, or MCP_ADMIT_REJECTED
+** when it should be retried in admission->WaitMs. The payload must already
+** be valid for the entry.
+*/
+int32 MCP_INTERFACE_AdmitCommand(const MCP_Request_t *request, const MCP_INTERFACE_CmdEntry_t *entry,
+                                 const char *payload_hex, uint32 payload_hex_len,
+                                 MCP_INTERFACE_Admission_t *admission)
+{
+    MCP_INTERFACE_CmdAdmission_t *state = &MCP_INTERFACE_AppData.CmdAdmission;
+    const MCP_INTERFACE_RateClass_t *rate;
+    MCP_INTERFACE_RateBucket_t *bucket;
+    MCP_INTERFACE_QueuedCmd_t *queued = NULL;
+    boolean critical = request->is_critical || (entry->Flags & MCP_CMD_FLAG_CRITICAL);
+    uint32 class_id = MCP_CMD_CLASS(entry->Flags);
+    uint32 now;
+    uint32 full;
+    uint32 depth;
+    uint32 wait;
+    uint32 i;
+
+    admission->Position = 0;
+    admission->WaitMs = 0;
+
+    if (class_id == 0 && critical)
+    {
+        class_id = MCP_RATE_CLASS_CRITICAL;
+    }
+
+    rate = &MCP_INTERFACE_AppData.CmdTblPtr->RateClasses[class_id];
+    if (rate->Burst == 0)
+    {
+        return MCP_ADMIT_SEND;
+    }
+
+    now = MCP_INTERFACE_MetricsNowMs();
+
+    /* Send whatever is due first, so the queue goes out before this command */
+    if (state->Queued > 0)
+    {
+        (void)MCP_INTERFACE_SendDueCommands(now);
+    }
+
+    bucket = MCP_INTERFACE_FindRateBucket(entry->AppName, class_id, now);
+    if (bucket == NULL)
+    {
+        admission->WaitMs = rate->RefillMs;
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.CommandsRateLimited, 1);
+        return MCP_ADMIT_REJECTED;
+    }
+
+    /* A token is free once the bucket is due to be full within Burst - 1 refills */
+    full = ((int32)(bucket->FullMs - now) > 0) ? bucket->FullMs : now;
+    depth = (uint32)(rate->Burst - 1) * rate->RefillMs;
+    wait = (full - now > depth) ? full - now - depth : 0;
+
+    if (wait > 0)
+    {
+        for (i = 0; i < MCP_CMD_QUEUE_DEPTH && queued == NULL; i++)
+        {
+            if (state->Queue[i].Entry == NULL)
+            {
+                queued = &state->Queue[i];
+            }
+        }
+
+        if (wait > rate->MaxWaitMs || queued == NULL)
+        {
+            admission->WaitMs = (wait > rate->MaxWaitMs) ? wait - rate->MaxWaitMs : wait;
+            MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.CommandsRateLimited, 1);
+            return MCP_ADMIT_REJECTED;
+        }
+    }
+
+    bucket->FullMs = full + rate->RefillMs;
+
+    if (queued == NULL)
+    {
+        return MCP_ADMIT_SEND;
+    }
+
+    queued->Entry = entry;
+    queued->RequestId = request->id;
+    queued->DueMs = now + wait;
+    queued->Bucket = (uint16)(bucket - state->Buckets);
+    queued->PayloadLen = (uint16)payload_hex_len;
+    queued->Critical = critical;
+    memcpy(queued->Payload, payload_hex, payload_hex_len);
+    state->Queued++;
+
+    for (i = 0; i < MCP_CMD_QUEUE_DEPTH; i++)
+    {
+        if (state->Queue[i].Entry != NULL && state->Queue[i].Bucket == queued->Bucket)
+        {
+            admission->Position++;
+        }
+    }
+    admission->WaitMs = wait;
+
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.CommandsQueued, 1);
+
+    return MCP_ADMIT_QUEUED;
+
+} /* End MCP_INTERFACE_AdmitCommand */
+
+/*
+** Admit a command and send it if it may go now
+**
+** Returns MCP_ADMIT_SEND once the command is on the bus, MCP_ADMIT_QUEUED
+** or MCP_ADMIT_REJECTED as MCP_INTERFACE_AdmitCommand does, or
+** MCP_ADMIT_FAILED with admission->Status set when the send failed.
+*/
+int32 MCP_INTERFACE_IssueCommand(const MCP_Request_t *request, const MCP_INTERFACE_CmdEntry_t *entry,
+                                 const char *payload_hex, uint32 payload_hex_len,
+                                 MCP_INTERFACE_Admission_t *admission)
+{
+    int32 admit;
+    boolean critical;
+
+    admission->Status = CFE_SUCCESS;
+
+    admit = MCP_INTERFACE_AdmitCommand(request, entry, payload_hex, payload_hex_len, admission);
+    if (admit != MCP_ADMIT_SEND)
+    {
+        return admit;
+    }
+
+    critical = request->is_critical || (entry->Flags & MCP_CMD_FLAG_CRITICAL);
+    if (critical)
+    {
+        MCP_INTERFACE_AppData.CriticalCommandCount++;
+
+        /* Log critical command */
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
+                         CFE_EVS_INFORMATION,
+                         "MCP_INTERFACE: Critical command sent to %s: %s",
+                         entry->AppName, entry->CommandName);
+    }
+
+    /* Send the prebuilt command packet */
+    admission->Status = MCP_INTERFACE_SendCommandPacket(entry, payload_hex, payload_hex_len);
+    MCP_INTERFACE_AuditCommand("request", request->id, entry, critical, payload_hex, payload_hex_len,
+                               admission->Status);
+
+    return (admission->Status == CFE_SUCCESS) ? MCP_ADMIT_SEND : MCP_ADMIT_FAILED;
+
+} /* End MCP_INTERFACE_IssueCommand */
+
+/*
+** Send the queued commands that are due
+**
+** Called by the socket task on every pass. Returns the milliseconds
+** until the next queued command is due, at most the socket poll timeout.
+*/
+int32 MCP_INTERFACE_SendQueuedCommands(void)
+{
+    int32 wait;
+
+    /* Commands are only queued on this task, so a zero here is never stale */
+    if (MCP_INTERFACE_AppData.CmdAdmission.Queued == 0)
+    {
+        return MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+    }
+
+    OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+    wait = MCP_INTERFACE_SendDueCommands(MCP_INTERFACE_MetricsNowMs());
+    OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+
+    return wait;
+
+} /* End MCP_INTERFACE_SendQueuedCommands */
+
+/*
+** Drop every queued command
+**
+** Their tokens stay taken, so dropped commands still count against
+** their rate.
+*/
+void MCP_INTERFACE_FlushCommandQueue(const char *reason)
+{
+    MCP_INTERFACE_CmdAdmission_t *state = &MCP_INTERFACE_AppData.CmdAdmission;
+    uint32 i;
+
+    if (state->Queued == 0)
+    {
+        return;
+    }
+
+    CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                     CFE_EVS_ERROR,
+                     "MCP_INTERFACE: %u queued commands dropped, %s",
+                     (unsigned int)state->Queued, reason);
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.CommandsExpired, state->Queued);
+    MCP_INTERFACE_Audit("COMMAND", "dropped %u queued reason=%s", (unsigned int)state->Queued, reason);
+
+    for (i = 0; i < MCP_CMD_QUEUE_DEPTH; i++)
+    {
+        state->Queue[i].Entry = NULL;
+    }
+    state->Queued = 0;
+
+} /* End MCP_INTERFACE_FlushCommandQueue */
+
+/*
+** Free the buckets that have refilled
+**
+** Called by the main task on every housekeeping request, so no bucket
+** sits long enough for its millisecond time to wrap.
+*/
+void MCP_INTERFACE_ExpireRateBuckets(void)
+{
+    MCP_INTERFACE_RateBucket_t *bucket;
+    uint32 now = MCP_INTERFACE_MetricsNowMs();
+    uint32 i;
+
+    for (i = 0; i < MCP_RATE_BUCKETS; i++)
+    {
+        bucket = &MCP_INTERFACE_AppData.CmdAdmission.Buckets[i];
+        if (bucket->AppName[0] != '\0' && (int32)(bucket->FullMs - now) <= 0)
+        {
+            bucket->AppName[0] = '\0';
+        }
+    }
+
+} /* End MCP_INTERFACE_ExpireRateBuckets */
+
+/*
+** Bucket of an app and rate class, or NULL if every bucket is in use
+**
+** A new bucket starts full, so one that has refilled can be reused
+** for another app.
+*/
+static MCP_INTERFACE_RateBucket_t *MCP_INTERFACE_FindRateBucket(const char *app_name, uint32 class_id,
+                                                                 uint32 now)
+{
+    MCP_INTERFACE_RateBucket_t *bucket;
+    MCP_INTERFACE_RateBucket_t *spare = NULL;
+    uint32 i;
+
+    for (i = 0; i < MCP_RATE_BUCKETS; i++)
+    {
+        bucket = &MCP_INTERFACE_AppData.CmdAdmission.Buckets[i];
+        if (bucket->AppName[0] != '\0' && bucket->Class == class_id &&
+            strcmp(bucket->AppName, app_name) == 0)
+        {
+            return bucket;
+        }
+
+        if (spare == NULL && (bucket->AppName[0] == '\0' || (int32)(bucket->FullMs - now) <= 0))
+        {
+            spare = bucket;
+        }
+    }
+
+    if (spare != NULL)
+    {
+        strncpy(spare->AppName, app_name, sizeof(spare->AppName) - 1);
+        spare->AppName[sizeof(spare->AppName) - 1] = '\0';
+        spare->Class = class_id;
+        spare->FullMs = now;
+    }
+
+    return spare;
+
+} /* End MCP_INTERFACE_FindRateBucket */
+
+/*
+** Send or drop the queued commands due by now, earliest first
+**
+** Returns the milliseconds until the next one is due.
+*/
+static int32 MCP_INTERFACE_SendDueCommands(uint32 now)
+{
+    MCP_INTERFACE_CmdAdmission_t *state = &MCP_INTERFACE_AppData.CmdAdmission;
+    MCP_INTERFACE_QueuedCmd_t *queued;
+    MCP_INTERFACE_QueuedCmd_t *next;
+    int32 wait;
+    uint32 i;
+
+    while (state->Queued > 0)
+    {
+        next = NULL;
+        for (i = 0; i < MCP_CMD_QUEUE_DEPTH; i++)
+        {
+            queued = &state->Queue[i];
+            if (queued->Entry != NULL && (next == NULL || (int32)(queued->DueMs - next->DueMs) < 0))
+            {
+                next = queued;
+            }
+        }
+
+        wait = (int32)(next->DueMs - now);
+        if (wait > 0)
+        {
+            return (wait < MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS) ? wait : MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+        }
+
+        if (-wait > MCP_CMD_QUEUE_LATE_MS)
+        {
+            CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                             CFE_EVS_ERROR,
+                             "MCP_INTERFACE: Queued command %s %s (request %u) dropped, %d ms late",
+                             next->Entry->AppName, next->Entry->CommandName,
+                             (unsigned int)next->RequestId, (int)-wait);
+            MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.CommandsExpired, 1);
+            MCP_INTERFACE_Audit("COMMAND", "dropped via=queue request=%u app=%s command=%s late_ms=%d",
+                                (unsigned int)next->RequestId, next->Entry->AppName,
+                                next->Entry->CommandName, (int)-wait);
+        }
+        else
+        {
+            MCP_INTERFACE_SendQueuedCommand(next);
+        }
+
+        next->Entry = NULL;
+        state->Queued--;
+    }
+
+    return MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+
+} /* End MCP_INTERFACE_SendDueCommands */
+
+/*
+** Send one queued command
+*/
+static void MCP_INTERFACE_SendQueuedCommand(MCP_INTERFACE_QueuedCmd_t *queued)
+{
+    int32 status;
+
+    status = MCP_INTERFACE_SendCommandPacket(queued->Entry, queued->Payload, queued->PayloadLen);
+    MCP_INTERFACE_AuditCommand("queue", queued->RequestId, queued->Entry, queued->Critical,
+                               queued->Payload, queued->PayloadLen, status);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Queued command %s %s (request %u) failed, status = 0x%08X",
+                         queued->Entry->AppName, queued->Entry->CommandName,
+                         (unsigned int)queued->RequestId, (unsigned int)status);
+        return;
+    }
+
+    if (queued->Critical)
+    {
+        MCP_INTERFACE_AppData.CriticalCommandCount++;
+    }
+
+    CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
+                     CFE_EVS_INFORMATION,
+                     "MCP_INTERFACE: Queued %scommand sent to %s: %s (request %u)",
+                     queued->Critical ? "critical " : "", queued->Entry->AppName,
+                     queued->Entry->CommandName, (unsigned int)queued->RequestId);
+
+} /* End MCP_INTERFACE_SendQueuedCommand */
@@ -0,0 +1,418 @@
+/*
+** MCP Interface Command Dictionary
+**
+** This file contains the command dictionary table used to resolve
+** app and command names from MCP requests into software bus commands.
+** The table is a regular cFE table, so commands can be added with a
+** table load; a hash index over it and the command header of every
+** entry are rebuilt on every load, so sending a command only copies the
+** prebuilt header and payload into a zero copy software bus buffer.
+** The table also lists the housekeeping telemetry to cache and the
+** admission rate of each command class.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+
+/*
+** Local function prototypes
+*/
+static uint32 MCP_INTERFACE_HashCommand(const char *app_name, const char *command);
+static void MCP_INTERFACE_BuildCmdIndex(void);
+static int32 MCP_INTERFACE_HexNibble(char c);
+
+/*
+** Register and load the command dictionary table
+*/
+int32 MCP_INTERFACE_InitCmdDictionary(void)
+{
+    int32 status;
+
+    MCP_INTERFACE_AppData.CmdTblPtr = NULL;
+    memset(MCP_INTERFACE_AppData.CmdIndex, 0, sizeof(MCP_INTERFACE_AppData.CmdIndex));
+    memset(MCP_INTERFACE_AppData.TlmCache, 0, sizeof(MCP_INTERFACE_AppData.TlmCache));
+
+    status = CFE_TBL_Register(&MCP_INTERFACE_AppData.CmdTblHandle,
+                              MCP_CMD_TBL_NAME,
+                              sizeof(MCP_INTERFACE_CmdTbl_t),
+                              CFE_TBL_OPT_DEFAULT,
+                              MCP_INTERFACE_ValidateCmdTbl);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Error registering command table, RC = 0x%08X\n",
+                           status);
+        return (status);
+    }
+
+    status = CFE_TBL_Load(MCP_INTERFACE_AppData.CmdTblHandle,
+                          CFE_TBL_SRC_FILE,
+                          MCP_CMD_TBL_FILENAME);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Error loading command table %s, RC = 0x%08X\n",
+                           MCP_CMD_TBL_FILENAME, status);
+        return (status);
+    }
+
+    MCP_INTERFACE_ManageCmdDictionary();
+
+    return (CFE_SUCCESS);
+
+} /* End MCP_INTERFACE_InitCmdDictionary */
+
+/*
+** Give table services a chance to apply a pending load
+**
+** Called with the data mutex held, so no request can be resolving a
+** command while the table or its index changes.
+*/
+void MCP_INTERFACE_ManageCmdDictionary(void)
+{
+    int32 status;
+
+    CFE_TBL_ReleaseAddress(MCP_INTERFACE_AppData.CmdTblHandle);
+    CFE_TBL_Manage(MCP_INTERFACE_AppData.CmdTblHandle);
+
+    status = CFE_TBL_GetAddress((void **)&MCP_INTERFACE_AppData.CmdTblPtr,
+                                MCP_INTERFACE_AppData.CmdTblHandle);
+    if (status == CFE_TBL_INFO_UPDATED)
+    {
+        MCP_INTERFACE_BuildCmdIndex();
+        MCP_INTERFACE_SubscribeTelemetry();
+        MCP_INTERFACE_FlushCommandQueue("command table loaded");
+        MCP_INTERFACE_AbortSequences("command table loaded");
+        MCP_INTERFACE_FlushConfirmations("command table loaded");
+
+        CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_INF_EID,
+                         CFE_EVS_INFORMATION,
+                         "MCP_INTERFACE: Command table loaded");
+    }
+    else if (status != CFE_SUCCESS)
+    {
+        MCP_INTERFACE_AppData.CmdTblPtr = NULL;
+        MCP_INTERFACE_FlushCommandQueue("command table unavailable");
+        MCP_INTERFACE_AbortSequences("command table unavailable");
+        MCP_INTERFACE_FlushConfirmations("command table unavailable");
+
+        CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Command table unavailable, RC = 0x%08X", status);
+    }
+
+} /* End MCP_INTERFACE_ManageCmdDictionary */
+
+/*
+** Validate a command table image before it is loaded
+*/
+int32 MCP_INTERFACE_ValidateCmdTbl(void *TblData)
+{
+    MCP_INTERFACE_CmdTbl_t *table = (MCP_INTERFACE_CmdTbl_t *)TblData;
+    MCP_INTERFACE_CmdEntry_t *entry;
+    MCP_INTERFACE_TlmEntry_t *tlm;
+    MCP_INTERFACE_RateClass_t *rate;
+    uint32 i;
+    uint32 j;
+
+    for (i = 0; i < MCP_CMD_TBL_MAX_ENTRIES; i++)
+    {
+        entry = &table->Entries[i];
+        if (entry->AppName[0] == '\0')
+        {
+            continue;
+        }
+
+        if (memchr(entry->AppName, '\0', sizeof(entry->AppName)) == NULL ||
+            memchr(entry->CommandName, '\0', sizeof(entry->CommandName)) == NULL ||
+            entry->CommandName[0] == '\0' ||
+            entry->MsgId == 0 ||
+            entry->PayloadLength > MCP_CMD_MAX_PAYLOAD_LEN)
+        {
+            CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_ERR_EID,
+                             CFE_EVS_ERROR,
+                             "MCP_INTERFACE: Command table entry %u is invalid", (unsigned int)i);
+            return CFE_ES_ERR_APPNAME;
+        }
+
+        for (j = 0; j < i; j++)
+        {
+            if (strcmp(table->Entries[j].AppName, entry->AppName) == 0 &&
+                strcmp(table->Entries[j].CommandName, entry->CommandName) == 0)
+            {
+                CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_ERR_EID,
+                                 CFE_EVS_ERROR,
+                                 "MCP_INTERFACE: Command table entry %u duplicates %s %s",
+                                 (unsigned int)i, entry->AppName, entry->CommandName);
+                return CFE_ES_ERR_APPNAME;
+            }
+        }
+    }
+
+    for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+    {
+        tlm = &table->Telemetry[i];
+        if (tlm->AppName[0] == '\0')
+        {
+            continue;
+        }
+
+        if (memchr(tlm->AppName, '\0', sizeof(tlm->AppName)) == NULL || tlm->MsgId == 0)
+        {
+            CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_ERR_EID,
+                             CFE_EVS_ERROR,
+                             "MCP_INTERFACE: Command table telemetry entry %u is invalid", (unsigned int)i);
+            return CFE_ES_ERR_APPNAME;
+        }
+
+        for (j = 0; j < i; j++)
+        {
+            if (table->Telemetry[j].AppName[0] != '\0' &&
+                (table->Telemetry[j].MsgId == tlm->MsgId ||
+                 strcmp(table->Telemetry[j].AppName, tlm->AppName) == 0))
+            {
+                CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_ERR_EID,
+                                 CFE_EVS_ERROR,
+                                 "MCP_INTERFACE: Command table telemetry entry %u duplicates %s 0x%04X",
+                                 (unsigned int)i, tlm->AppName, (unsigned int)tlm->MsgId);
+                return CFE_ES_ERR_APPNAME;
+            }
+        }
+    }
+
+    for (i = 0; i < MCP_RATE_CLASS_COUNT; i++)
+    {
+        rate = &table->RateClasses[i];
+        if (rate->Burst > 0 && rate->RefillMs == 0)
+        {
+            CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_ERR_EID,
+                             CFE_EVS_ERROR,
+                             "MCP_INTERFACE: Command table rate class %u has no refill time", (unsigned int)i);
+            return CFE_ES_ERR_APPNAME;
+        }
+    }
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_ValidateCmdTbl */
+
+/*
+** Resolve an app and command name to its dictionary entry
+*/
+const MCP_INTERFACE_CmdEntry_t *MCP_INTERFACE_LookupCommand(const char *app_name, const char *command)
+{
+    const MCP_INTERFACE_CmdEntry_t *entry;
+    uint32 slot;
+    uint32 probes;
+
+    if (MCP_INTERFACE_AppData.CmdTblPtr == NULL)
+    {
+        return NULL;
+    }
+
+    slot = MCP_INTERFACE_HashCommand(app_name, command);
+
+    for (probes = 0; probes < MCP_CMD_HASH_SLOTS; probes++)
+    {
+        if (MCP_INTERFACE_AppData.CmdIndex[slot] == 0)
+        {
+            return NULL;
+        }
+
+        entry = &MCP_INTERFACE_AppData.CmdTblPtr->Entries[MCP_INTERFACE_AppData.CmdIndex[slot] - 1];
+        if (strcmp(entry->AppName, app_name) == 0 && strcmp(entry->CommandName, command) == 0)
+        {
+            return entry;
+        }
+
+        slot = (slot + 1) & (MCP_CMD_HASH_SLOTS - 1);
+    }
+
+    return NULL;
+
+} /* End MCP_INTERFACE_LookupCommand */
+
+/*
+** Build the packet of a dictionary command in a zero copy buffer
+** without sending it; NULL when the payload does not fit the command
+** or no buffer is free
+*/
+CFE_SB_Msg_t *MCP_INTERFACE_BuildCommandPacket(const MCP_INTERFACE_CmdEntry_t *entry, const char *payload_hex,
+                                               uint32 payload_hex_len, CFE_SB_ZeroCopyHandle_t *handle)
+{
+    CFE_SB_Msg_t *msg;
+    uint8 *payload;
+    uint32 msg_size;
+    uint32 i;
+
+    if (!MCP_INTERFACE_ValidPayload(entry, payload_hex, payload_hex_len))
+    {
+        return NULL;
+    }
+
+    msg_size = sizeof(CFE_SB_CmdHdr_t) + entry->PayloadLength;
+
+    msg = CFE_SB_ZeroCopyGetPtr((uint16)msg_size, handle);
+    if (msg == NULL)
+    {
+        return NULL;
+    }
+
+    memcpy(msg, &MCP_INTERFACE_AppData.CmdHeaders[entry - MCP_INTERFACE_AppData.CmdTblPtr->Entries],
+           sizeof(CFE_SB_CmdHdr_t));
+
+    payload = (uint8 *)msg + sizeof(CFE_SB_CmdHdr_t);
+    for (i = 0; i < payload_hex_len / 2; i++)
+    {
+        payload[i] = (uint8)((MCP_INTERFACE_HexNibble(payload_hex[2 * i]) << 4) |
+                             MCP_INTERFACE_HexNibble(payload_hex[2 * i + 1]));
+    }
+    memset(&payload[i], 0, entry->PayloadLength - i);
+
+    CFE_SB_GenerateChecksum(msg);
+
+    return msg;
+
+} /* End MCP_INTERFACE_BuildCommandPacket */
+
+/*
+** Send a dictionary command with its payload given as hex digits
+**
+** Missing trailing payload bytes are sent as zero, which suits the
+** fixed size string arguments most commands take. Returns
+** CFE_SB_BAD_ARGUMENT if the payload is malformed or too long.
+*/
+int32 MCP_INTERFACE_SendCommandPacket(const MCP_INTERFACE_CmdEntry_t *entry, const char *payload_hex,
+                                      uint32 payload_hex_len)
+{
+    CFE_SB_ZeroCopyHandle_t handle;
+    CFE_SB_Msg_t *msg;
+    int32 status;
+
+    if (!MCP_INTERFACE_ValidPayload(entry, payload_hex, payload_hex_len))
+    {
+        return CFE_SB_BAD_ARGUMENT;
+    }
+
+    msg = MCP_INTERFACE_BuildCommandPacket(entry, payload_hex, payload_hex_len, &handle);
+    if (msg == NULL)
+    {
+        return CFE_SB_BUF_ALOC_ERR;
+    }
+
+    status = CFE_SB_ZeroCopySend(msg, handle);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_SB_ZeroCopyReleasePtr(msg, handle);
+    }
+
+    return status;
+
+} /* End MCP_INTERFACE_SendCommandPacket */
+
+/*
+** Whether a hex payload fits a dictionary command
+*/
+boolean MCP_INTERFACE_ValidPayload(const MCP_INTERFACE_CmdEntry_t *entry, const char *payload_hex,
+                                   uint32 payload_hex_len)
+{
+    uint32 i;
+
+    if ((payload_hex_len % 2) != 0 || payload_hex_len / 2 > entry->PayloadLength)
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < payload_hex_len; i++)
+    {
+        if (MCP_INTERFACE_HexNibble(payload_hex[i]) < 0)
+        {
+            return FALSE;
+        }
+    }
+
+    return TRUE;
+
+} /* End MCP_INTERFACE_ValidPayload */
+
+/*
+** FNV-1a over "app\0command", reduced to a hash slot
+*/
+static uint32 MCP_INTERFACE_HashCommand(const char *app_name, const char *command)
+{
+    uint32 hash = 2166136261u;
+
+    while (*app_name != '\0')
+    {
+        hash = (hash ^ (uint8)*app_name++) * 16777619u;
+    }
+
+    hash = hash * 16777619u;
+
+    while (*command != '\0')
+    {
+        hash = (hash ^ (uint8)*command++) * 16777619u;
+    }
+
+    return hash & (MCP_CMD_HASH_SLOTS - 1);
+
+} /* End MCP_INTERFACE_HashCommand */
+
+/*
+** Rebuild the open-addressed lookup index and command headers over the
+** current table
+*/
+static void MCP_INTERFACE_BuildCmdIndex(void)
+{
+    const MCP_INTERFACE_CmdEntry_t *entry;
+    CFE_SB_MsgPtr_t msg;
+    uint32 slot;
+    uint32 i;
+
+    memset(MCP_INTERFACE_AppData.CmdIndex, 0, sizeof(MCP_INTERFACE_AppData.CmdIndex));
+
+    for (i = 0; i < MCP_CMD_TBL_MAX_ENTRIES; i++)
+    {
+        entry = &MCP_INTERFACE_AppData.CmdTblPtr->Entries[i];
+        if (entry->AppName[0] == '\0')
+        {
+            continue;
+        }
+
+        msg = (CFE_SB_MsgPtr_t)&MCP_INTERFACE_AppData.CmdHeaders[i];
+        CFE_SB_InitMsg(msg, entry->MsgId, sizeof(CFE_SB_CmdHdr_t), TRUE);
+        CFE_SB_SetTotalMsgLength(msg, (uint16)(sizeof(CFE_SB_CmdHdr_t) + entry->PayloadLength));
+        CFE_SB_SetCmdCode(msg, entry->CommandCode);
+
+        slot = MCP_INTERFACE_HashCommand(entry->AppName, entry->CommandName);
+        while (MCP_INTERFACE_AppData.CmdIndex[slot] != 0)
+        {
+            slot = (slot + 1) & (MCP_CMD_HASH_SLOTS - 1);
+        }
+
+        MCP_INTERFACE_AppData.CmdIndex[slot] = (uint8)(i + 1);
+    }
+
+} /* End MCP_INTERFACE_BuildCmdIndex */
+
+/*
+** Value of a hex digit, or -1
+*/
+static int32 MCP_INTERFACE_HexNibble(char c)
+{
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0';
+    }
+    if (c >= 'a' && c <= 'f')
+    {
+        return c - 'a' + 10;
+    }
+    if (c >= 'A' && c <= 'F')
+    {
+        return c - 'A' + 10;
+    }
+
+    return -1;
+
+} /* End MCP_INTERFACE_HexNibble */
@@ -9,21 +9,48 @@
 ** Include Files
 */
 #include "mcp_interface_app.h"
+#include "mcp_json_reader.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <dirent.h>
+#include <fnmatch.h>
 #include <sys/stat.h>
 
+/*
+** Selection and progress of one GET_FILE_LIST page
+*/
+typedef struct {
+    const char *Directory;
+    char Glob[64];                  /* empty matches every name */
+    int32 Type;                     /* MCP_DIR_ENTRY_*, or -1 for any */
+    boolean Details;
+    uint32 Limit;
+    uint32 Count;
+} MCP_INTERFACE_FileFilter_t;
+
+/*
+** Local function prototypes
+*/
+static boolean MCP_INTERFACE_WriteFileEntry(MCP_JSON_Writer_t *json, MCP_INTERFACE_FileFilter_t *filter,
+                                            const char *name, uint8 type);
+static uint32 MCP_INTERFACE_Utf8Boundary(const uint8 *text, uint32 length);
+
 /*
 ** Handle Send Command request
 */
 int32 MCP_INTERFACE_HandleSendCommand(MCP_Request_t *request, MCP_Response_t *response)
 {
-    CFE_SB_Msg_t *cmd_msg;
+    const MCP_INTERFACE_CmdEntry_t *entry;
+    MCP_INTERFACE_Admission_t admission;
+    MCP_JSON_Reader_t reader;
     CFE_SB_MsgId_t msg_id;
     uint16 cmd_code;
-    int32 status;
-    char result_str[512];
+    int32 admit;
+    char msg_id_str[8];
+    char key[16];
+    char *payload = NULL;
+    uint32 payload_len = 0;
+    boolean ok = TRUE;
 
     /* Validate app name */
     if (strlen(request->app_name) == 0)
@@ -33,98 +60,104 @@ int32 MCP_INTERFACE_HandleSendCommand(MCP_Request_t *request, MCP_Response_t *re
         return CFE_ES_ERR_APPNAME;
     }
 
-    /* Critical command handling */
-    if (request->is_critical)
+    /* Resolve the command through the dictionary table */
+    entry = MCP_INTERFACE_LookupCommand(request->app_name, request->command);
+    if (entry == NULL)
     {
-        uint32 current_time = CFE_TIME_GetTime().Seconds;
-        
-        /* Rate limiting for critical commands */
-        if (current_time - MCP_INTERFACE_AppData.LastCriticalCommandTime < 5)
-        {
-            response->status = -1;
-            strncpy(response->error_msg, "Critical command rate limit exceeded", sizeof(response->error_msg) - 1);
-            return CFE_ES_ERR_APPNAME;
-        }
-        
-        MCP_INTERFACE_AppData.CriticalCommandCount++;
-        MCP_INTERFACE_AppData.LastCriticalCommandTime = current_time;
-        
-        /* Log critical command */
-        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
-                         CFE_EVS_INFORMATION,
-                         "MCP_INTERFACE: Critical command sent to %s: %s",
-                         request->app_name, request->command);
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Unknown command '%s' for app '%s'", request->command, request->app_name);
+        return CFE_ES_ERR_APPNAME;
     }
 
-    /* Simple command mapping - in real implementation, this would be more sophisticated */
-    if (strcmp(request->app_name, "CFE_ES") == 0)
+    msg_id = entry->MsgId;
+    cmd_code = entry->CommandCode;
+
+    /* Command arguments, if any, come as {"payload": "<hex bytes>"} */
+    if (request->params_len > 0)
     {
-        msg_id = CFE_ES_CMD_MID;
-        if (strcmp(request->command, "NOOP") == 0)
-        {
-            cmd_code = CFE_ES_NOOP_CC;
-        }
-        else if (strcmp(request->command, "RESET_COUNTERS") == 0)
+        MCP_JSON_ReaderInit(&reader, request->params, request->params_len);
+        ok = MCP_JSON_ReadObjectBegin(&reader);
+
+        while (ok && MCP_JSON_ReadObjectNext(&reader, key, sizeof(key)))
         {
-            cmd_code = CFE_ES_RESET_COUNTERS_CC;
+            if (strcmp(key, "payload") == 0 && MCP_JSON_PeekType(&reader) == MCP_JSON_TYPE_STRING)
+            {
+                ok = MCP_JSON_ReadStringInPlace(&reader, &payload, &payload_len);
+            }
+            else
+            {
+                ok = MCP_JSON_SkipValue(&reader);
+            }
         }
-        else
+
+        if (!ok || reader.Error || !MCP_JSON_ReadEnd(&reader))
         {
             response->status = -1;
-            snprintf(response->error_msg, sizeof(response->error_msg),
-                    "Unknown command '%s' for app '%s'", request->command, request->app_name);
+            strncpy(response->error_msg, "Invalid command params", sizeof(response->error_msg) - 1);
             return CFE_ES_ERR_APPNAME;
         }
     }
-    else if (strcmp(request->app_name, "FM") == 0)
+
+    if (!MCP_INTERFACE_ValidPayload(entry, payload, payload_len))
     {
-        msg_id = FM_CMD_MID;
-        if (strcmp(request->command, "GET_DIR_LIST") == 0)
-        {
-            cmd_code = FM_GET_DIR_LIST_CC;
-        }
-        else
-        {
-            response->status = -1;
-            snprintf(response->error_msg, sizeof(response->error_msg),
-                    "Unknown command '%s' for app '%s'", request->command, request->app_name);
-            return CFE_ES_ERR_APPNAME;
-        }
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Invalid payload, expected up to %u bytes as hex", (unsigned int)entry->PayloadLength);
+        return CFE_ES_ERR_APPNAME;
     }
-    else
+
+    /* Build the packet now and send it when its token is confirmed */
+    if (request->prepare)
+    {
+        return MCP_INTERFACE_PrepareCommand(request, entry, payload, payload_len, response);
+    }
+
+    /* Take a token from the command's rate class, or wait in the queue for one */
+    admit = MCP_INTERFACE_IssueCommand(request, entry, payload, payload_len, &admission);
+    if (admit == MCP_ADMIT_REJECTED)
     {
         response->status = -1;
         snprintf(response->error_msg, sizeof(response->error_msg),
-                "Unknown app '%s'", request->app_name);
+                "Command rate limit exceeded, retry after %u ms", (unsigned int)admission.WaitMs);
         return CFE_ES_ERR_APPNAME;
     }
 
-    /* Create and send command */
-    cmd_msg = CFE_SB_CreateMsg(msg_id, sizeof(CFE_SB_CmdHdr_t), TRUE);
-    if (cmd_msg != NULL)
+    if (admit == MCP_ADMIT_QUEUED)
     {
-        CFE_SB_SetCmdCode(cmd_msg, cmd_code);
-        status = CFE_SB_SendMsg(cmd_msg);
-        
-        if (status == CFE_SUCCESS)
-        {
-            response->status = 0;
-            snprintf(result_str, sizeof(result_str),
-                    "{\"command_sent\": true, \"app\": \"%s\", \"command\": \"%s\", \"msg_id\": \"0x%04X\", \"cmd_code\": %d}",
-                    request->app_name, request->command, msg_id, cmd_code);
-            strncpy(response->result, result_str, sizeof(response->result) - 1);
-        }
-        else
-        {
-            response->status = -1;
-            snprintf(response->error_msg, sizeof(response->error_msg),
-                    "Failed to send command, status = 0x%08X", status);
-        }
+        response->status = 0;
+
+        MCP_JSON_BeginObject(response->result);
+        MCP_JSON_KeyBool(response->result, "command_sent", FALSE);
+        MCP_JSON_KeyBool(response->result, "queued", TRUE);
+        MCP_JSON_KeyString(response->result, "app", request->app_name);
+        MCP_JSON_KeyString(response->result, "command", request->command);
+        MCP_JSON_KeyUint(response->result, "queue_position", admission.Position);
+        MCP_JSON_KeyUint(response->result, "send_in_ms", admission.WaitMs);
+        MCP_JSON_EndObject(response->result);
+
+        return CFE_SUCCESS;
+    }
+
+    if (admit == MCP_ADMIT_SEND)
+    {
+        response->status = 0;
+        snprintf(msg_id_str, sizeof(msg_id_str), "0x%04X", msg_id);
+
+        MCP_JSON_BeginObject(response->result);
+        MCP_JSON_KeyBool(response->result, "command_sent", TRUE);
+        MCP_JSON_KeyString(response->result, "app", request->app_name);
+        MCP_JSON_KeyString(response->result, "command", request->command);
+        MCP_JSON_KeyString(response->result, "msg_id", msg_id_str);
+        MCP_JSON_KeyUint(response->result, "cmd_code", cmd_code);
+        MCP_JSON_KeyUint(response->result, "payload_len", entry->PayloadLength);
+        MCP_JSON_EndObject(response->result);
     }
     else
     {
         response->status = -1;
-        strncpy(response->error_msg, "Failed to create command message", sizeof(response->error_msg) - 1);
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Failed to send command, status = 0x%08X", admission.Status);
     }
 
     return CFE_SUCCESS;
@@ -136,53 +169,55 @@ int32 MCP_INTERFACE_HandleSendCommand(MCP_Request_t *request, MCP_Response_t *re
 */
 int32 MCP_INTERFACE_HandleGetTelemetry(MCP_Request_t *request, MCP_Response_t *response)
 {
-    char result_str[2048];
+    MCP_JSON_Writer_t *json = response->result;
+    const MCP_INTERFACE_TlmSnapshot_t *snapshot;
+    char message[96];
     uint32 current_time;
 
     /* Get current system time */
     current_time = CFE_TIME_GetTime().Seconds;
 
-    /* For demonstration, return MCP interface app's own telemetry */
+    MCP_JSON_BeginObject(json);
+
+    /* The MCP interface app's own telemetry is always current */
     if (strcmp(request->app_name, "MCP_INTERFACE") == 0)
     {
-        snprintf(result_str, sizeof(result_str),
-                "{"
-                "\"app_name\": \"MCP_INTERFACE\","
-                "\"timestamp\": %u,"
-                "\"cmd_counter\": %u,"
-                "\"err_counter\": %u,"
-                "\"active_clients\": %u,"
-                "\"request_counter\": %u,"
-                "\"success_counter\": %u,"
-                "\"error_counter\": %u,"
-                "\"safety_mode\": %s,"
-                "\"debug_mode\": %s"
-                "}",
-                current_time,
-                MCP_INTERFACE_AppData.CmdCounter,
-                MCP_INTERFACE_AppData.ErrCounter,
-                MCP_INTERFACE_AppData.ActiveClients,
-                MCP_INTERFACE_AppData.RequestCounter,
-                MCP_INTERFACE_AppData.SuccessCounter,
-                MCP_INTERFACE_AppData.ErrorCounter,
-                MCP_INTERFACE_AppData.SafetyMode ? "true" : "false",
-                MCP_INTERFACE_AppData.DebugMode ? "true" : "false");
+        MCP_JSON_KeyString(json, "app_name", "MCP_INTERFACE");
+        MCP_JSON_KeyUint(json, "timestamp", current_time);
+        MCP_JSON_KeyUint(json, "cmd_counter", MCP_INTERFACE_AppData.CmdCounter);
+        MCP_JSON_KeyUint(json, "err_counter", MCP_INTERFACE_AppData.ErrCounter);
+        MCP_JSON_KeyUint(json, "active_clients", MCP_INTERFACE_AppData.ActiveClients);
+        MCP_JSON_KeyUint(json, "request_counter", MCP_INTERFACE_AppData.RequestCounter);
+        MCP_JSON_KeyUint(json, "success_counter", MCP_INTERFACE_AppData.SuccessCounter);
+        MCP_JSON_KeyUint(json, "error_counter", MCP_INTERFACE_AppData.ErrorCounter);
+        MCP_JSON_KeyBool(json, "safety_mode", MCP_INTERFACE_AppData.SafetyMode);
+        MCP_JSON_KeyBool(json, "debug_mode", MCP_INTERFACE_AppData.DebugMode);
+        MCP_JSON_EndObject(json);
+
+        response->status = 0;
+        return CFE_SUCCESS;
+    }
+
+    /* Everything else is served from the telemetry cache */
+    MCP_JSON_KeyString(json, "app_name", request->app_name);
+    MCP_JSON_KeyUint(json, "timestamp", current_time);
+
+    snapshot = MCP_INTERFACE_FindTelemetry(request->app_name);
+    if (snapshot == NULL)
+    {
+        MCP_JSON_KeyString(json, "status", "telemetry_not_available");
+        snprintf(message, sizeof(message),
+                "No telemetry listed for %s in the command dictionary", request->app_name);
+        MCP_JSON_KeyString(json, "message", message);
     }
     else
     {
-        /* In a real implementation, this would query the actual app's telemetry */
-        snprintf(result_str, sizeof(result_str),
-                "{"
-                "\"app_name\": \"%s\","
-                "\"timestamp\": %u,"
-                "\"status\": \"telemetry_not_available\","
-                "\"message\": \"Telemetry retrieval for %s not implemented yet\""
-                "}",
-                request->app_name, current_time, request->app_name);
+        MCP_INTERFACE_WriteTelemetry(json, snapshot, current_time);
     }
 
+    MCP_JSON_EndObject(json);
+
     response->status = 0;
-    strncpy(response->result, result_str, sizeof(response->result) - 1);
 
     return CFE_SUCCESS;
 
@@ -190,57 +225,87 @@ int32 MCP_INTERFACE_HandleGetTelemetry(MCP_Request_t *request, MCP_Response_t *r
 
 /*
 ** Handle Get System Status request
+**
+** Params are optional: {"apps": true, "start": n} adds the latest sample
+** of each registered app from app ID start on. Memory, task and app
+** figures come from the system snapshot the main task keeps up to date.
 */
 int32 MCP_INTERFACE_HandleGetSystemStatus(MCP_Request_t *request, MCP_Response_t *response)
 {
-    char result_str[3072];
-    uint32 current_time;
+    MCP_JSON_Writer_t *json = response->result;
+    MCP_JSON_Reader_t reader;
+    char cfs_version[16];
+    char key[16];
     CFE_ES_AppInfo_t app_info;
+    uint32 app_id;
+    uint32 start = 0;
+    boolean apps = FALSE;
+    boolean ok = TRUE;
     int32 status;
 
-    current_time = CFE_TIME_GetTime().Seconds;
+    if (request->params_len > 0)
+    {
+        MCP_JSON_ReaderInit(&reader, request->params, request->params_len);
+        ok = MCP_JSON_ReadObjectBegin(&reader);
+
+        while (ok && MCP_JSON_ReadObjectNext(&reader, key, sizeof(key)))
+        {
+            if (strcmp(key, "apps") == 0)
+            {
+                ok = MCP_JSON_ReadBool(&reader, &apps);
+            }
+            else if (strcmp(key, "start") == 0)
+            {
+                ok = MCP_JSON_ReadUint(&reader, &start);
+            }
+            else
+            {
+                ok = MCP_JSON_SkipValue(&reader);
+            }
+        }
+
+        if (!ok || reader.Error || !MCP_JSON_ReadEnd(&reader))
+        {
+            response->status = -1;
+            strncpy(response->error_msg, "Invalid system status params", sizeof(response->error_msg) - 1);
+            return CFE_ES_ERR_APPNAME;
+        }
+    }
 
     /* Get Executive Services information */
-    status = CFE_ES_GetAppInfo(&app_info, "MCP_INTERFACE");
-    
-    snprintf(result_str, sizeof(result_str),
-            "{"
-            "\"system_status\": {"
-            "\"timestamp\": %u,"
-            "\"cfs_version\": \"cFE %d.%d\","
-            "\"mcp_interface_status\": {"
-            "\"app_id\": %u,"
-            "\"execution_counter\": %u,"
-            "\"active_clients\": %u,"
-            "\"total_requests\": %u,"
-            "\"successful_requests\": %u,"
-            "\"failed_requests\": %u,"
-            "\"safety_mode\": %s,"
-            "\"debug_mode\": %s"
-            "},"
-            "\"memory_status\": {"
-            "\"available_memory\": \"unknown\","
-            "\"used_memory\": \"unknown\""
-            "},"
-            "\"task_status\": {"
-            "\"total_tasks\": \"unknown\","
-            "\"active_tasks\": \"unknown\""
-            "}"
-            "}"
-            "}",
-            current_time,
-            CFE_MAJOR_VERSION, CFE_MINOR_VERSION,
-            (status == CFE_SUCCESS) ? app_info.AppId : 0,
-            (status == CFE_SUCCESS) ? app_info.ExecutionCounter : 0,
-            MCP_INTERFACE_AppData.ActiveClients,
-            MCP_INTERFACE_AppData.RequestCounter,
-            MCP_INTERFACE_AppData.SuccessCounter,
-            MCP_INTERFACE_AppData.ErrorCounter,
-            MCP_INTERFACE_AppData.SafetyMode ? "true" : "false",
-            MCP_INTERFACE_AppData.DebugMode ? "true" : "false");
+    status = CFE_ES_GetAppID(&app_id);
+    if (status == CFE_SUCCESS)
+    {
+        status = CFE_ES_GetAppInfo(&app_info, app_id);
+    }
+
+    snprintf(cfs_version, sizeof(cfs_version), "cFE %d.%d",
+            CFE_MAJOR_VERSION, CFE_MINOR_VERSION);
+
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_Key(json, "system_status");
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyUint(json, "timestamp", CFE_TIME_GetTime().Seconds);
+    MCP_JSON_KeyString(json, "cfs_version", cfs_version);
+
+    MCP_JSON_Key(json, "mcp_interface_status");
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyUint(json, "app_id", (status == CFE_SUCCESS) ? app_info.AppId : 0);
+    MCP_JSON_KeyUint(json, "execution_counter", (status == CFE_SUCCESS) ? app_info.ExecutionCounter : 0);
+    MCP_JSON_KeyUint(json, "active_clients", MCP_INTERFACE_AppData.ActiveClients);
+    MCP_JSON_KeyUint(json, "total_requests", MCP_INTERFACE_AppData.RequestCounter);
+    MCP_JSON_KeyUint(json, "successful_requests", MCP_INTERFACE_AppData.SuccessCounter);
+    MCP_JSON_KeyUint(json, "failed_requests", MCP_INTERFACE_AppData.ErrorCounter);
+    MCP_JSON_KeyBool(json, "safety_mode", MCP_INTERFACE_AppData.SafetyMode);
+    MCP_JSON_KeyBool(json, "debug_mode", MCP_INTERFACE_AppData.DebugMode);
+    MCP_JSON_EndObject(json);
+
+    MCP_INTERFACE_WriteSystemSnapshot(json, apps, start);
+
+    MCP_JSON_EndObject(json);
+    MCP_JSON_EndObject(json);
 
     response->status = 0;
-    strncpy(response->result, result_str, sizeof(response->result) - 1);
 
     return CFE_SUCCESS;
 
@@ -251,9 +316,10 @@ int32 MCP_INTERFACE_HandleGetSystemStatus(MCP_Request_t *request, MCP_Response_t
 */
 int32 MCP_INTERFACE_HandleManageApp(MCP_Request_t *request, MCP_Response_t *response)
 {
+    MCP_JSON_Writer_t *json = response->result;
     int32 status;
-    char result_str[512];
     CFE_ES_AppInfo_t app_info;
+    uint32 app_id;
 
     /* Validate app name */
     if (strlen(request->app_name) == 0)
@@ -270,9 +336,11 @@ int32 MCP_INTERFACE_HandleManageApp(MCP_Request_t *request, MCP_Response_t *resp
         if (!MCP_INTERFACE_AppData.SafetyMode || request->require_confirmation)
         {
             /* In a real implementation, this would start the app */
-            snprintf(result_str, sizeof(result_str),
-                    "{\"action\": \"start\", \"app\": \"%s\", \"status\": \"not_implemented\"}",
-                    request->app_name);
+            MCP_JSON_BeginObject(json);
+            MCP_JSON_KeyString(json, "action", "start");
+            MCP_JSON_KeyString(json, "app", request->app_name);
+            MCP_JSON_KeyString(json, "status", "not_implemented");
+            MCP_JSON_EndObject(json);
             
             CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
                              CFE_EVS_INFORMATION,
@@ -291,9 +359,11 @@ int32 MCP_INTERFACE_HandleManageApp(MCP_Request_t *request, MCP_Response_t *resp
         if (!MCP_INTERFACE_AppData.SafetyMode || request->require_confirmation)
         {
             /* In a real implementation, this would stop the app */
-            snprintf(result_str, sizeof(result_str),
-                    "{\"action\": \"stop\", \"app\": \"%s\", \"status\": \"not_implemented\"}",
-                    request->app_name);
+            MCP_JSON_BeginObject(json);
+            MCP_JSON_KeyString(json, "action", "stop");
+            MCP_JSON_KeyString(json, "app", request->app_name);
+            MCP_JSON_KeyString(json, "status", "not_implemented");
+            MCP_JSON_EndObject(json);
             
             CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
                              CFE_EVS_INFORMATION,
@@ -309,31 +379,30 @@ int32 MCP_INTERFACE_HandleManageApp(MCP_Request_t *request, MCP_Response_t *resp
     else if (strcmp(request->params, "\"status\"") == 0)
     {
         /* Get app status */
-        status = CFE_ES_GetAppInfo(&app_info, request->app_name);
+        status = CFE_ES_GetAppIDByName(&app_id, request->app_name);
+        if (status == CFE_SUCCESS)
+        {
+            status = CFE_ES_GetAppInfo(&app_info, app_id);
+        }
         if (status == CFE_SUCCESS)
         {
-            snprintf(result_str, sizeof(result_str),
-                    "{"
-                    "\"action\": \"status\","
-                    "\"app\": \"%s\","
-                    "\"app_id\": %u,"
-                    "\"execution_counter\": %u,"
-                    "\"app_state\": %u,"
-                    "\"stack_size\": %u,"
-                    "\"address_space_id\": %u"
-                    "}",
-                    request->app_name,
-                    app_info.AppId,
-                    app_info.ExecutionCounter,
-                    app_info.AppState,
-                    app_info.StackSize,
-                    app_info.AddressSpaceId);
+            MCP_JSON_BeginObject(json);
+            MCP_JSON_KeyString(json, "action", "status");
+            MCP_JSON_KeyString(json, "app", request->app_name);
+            MCP_JSON_KeyUint(json, "app_id", app_info.AppId);
+            MCP_JSON_KeyUint(json, "execution_counter", app_info.ExecutionCounter);
+            MCP_JSON_KeyUint(json, "app_state", app_info.AppState);
+            MCP_JSON_KeyUint(json, "stack_size", app_info.StackSize);
+            MCP_JSON_KeyUint(json, "address_space_id", app_info.AddressSpaceId);
+            MCP_JSON_EndObject(json);
         }
         else
         {
-            snprintf(result_str, sizeof(result_str),
-                    "{\"action\": \"status\", \"app\": \"%s\", \"error\": \"App not found or error getting info\"}",
-                    request->app_name);
+            MCP_JSON_BeginObject(json);
+            MCP_JSON_KeyString(json, "action", "status");
+            MCP_JSON_KeyString(json, "app", request->app_name);
+            MCP_JSON_KeyString(json, "error", "App not found or error getting info");
+            MCP_JSON_EndObject(json);
         }
     }
     else
@@ -345,7 +414,6 @@ int32 MCP_INTERFACE_HandleManageApp(MCP_Request_t *request, MCP_Response_t *resp
     }
 
     response->status = 0;
-    strncpy(response->result, result_str, sizeof(response->result) - 1);
 
     return CFE_SUCCESS;
 
@@ -353,101 +421,333 @@ int32 MCP_INTERFACE_HandleManageApp(MCP_Request_t *request, MCP_Response_t *resp
 
 /*
 ** Handle Get File List request
+**
+** Params are the directory as a string, or {"path": ..., "cursor": n,
+** "limit": n, "type": "file" | "directory", "glob": ..., "details":
+** bool}. The cursor counts entries in directory order; a page ends at
+** the limit or when the response frame fills, and next_cursor resumes
+** it. Without details only names and types are returned, which takes no
+** stat() calls where the file system reports entry types.
 */
 int32 MCP_INTERFACE_HandleGetFileList(MCP_Request_t *request, MCP_Response_t *response)
 {
+    MCP_JSON_Writer_t *json = response->result;
+    const MCP_INTERFACE_DirListing_t *listing;
+    MCP_INTERFACE_FileFilter_t filter;
+    MCP_JSON_Reader_t reader;
     DIR *dir;
     struct dirent *entry;
-    struct stat file_stat;
-    char result_str[2048];
-    char file_path[256];
-    char *directory = "/cf"; /* Default cFS file system directory */
-    int file_count = 0;
-    
-    /* Parse directory from params if provided */
-    if (strlen(request->params) > 2)
+    char dir_path[MCP_MAX_PATH_LEN] = "/cf"; /* Default cFS file system directory */
+    char type[16] = "";
+    char key[16];
+    uint32 cursor = 0;
+    uint32 position = 0;
+    boolean eof = TRUE;
+    boolean ok = TRUE;
+
+    filter.Directory = dir_path;
+    filter.Glob[0] = '\0';
+    filter.Type = -1;
+    filter.Details = TRUE;
+    filter.Limit = MCP_FILE_LIST_DEFAULT_LIMIT;
+    filter.Count = 0;
+
+    /* Parse directory and paging from params if provided */
+    MCP_JSON_ReaderInit(&reader, request->params, request->params_len);
+
+    if (MCP_JSON_PeekType(&reader) == MCP_JSON_TYPE_STRING)
+    {
+        ok = MCP_JSON_ReadString(&reader, dir_path, sizeof(dir_path));
+    }
+    else if (MCP_JSON_PeekType(&reader) == MCP_JSON_TYPE_OBJECT)
     {
-        /* Remove quotes from JSON string */
-        strncpy(file_path, request->params + 1, sizeof(file_path) - 1);
-        file_path[strlen(file_path) - 1] = '\0';
-        directory = file_path;
+        ok = MCP_JSON_ReadObjectBegin(&reader);
+
+        while (ok && MCP_JSON_ReadObjectNext(&reader, key, sizeof(key)))
+        {
+            if (strcmp(key, "path") == 0)
+            {
+                ok = MCP_JSON_ReadString(&reader, dir_path, sizeof(dir_path));
+            }
+            else if (strcmp(key, "cursor") == 0)
+            {
+                ok = MCP_JSON_ReadUint(&reader, &cursor);
+            }
+            else if (strcmp(key, "limit") == 0)
+            {
+                ok = MCP_JSON_ReadUint(&reader, &filter.Limit);
+            }
+            else if (strcmp(key, "type") == 0)
+            {
+                ok = MCP_JSON_ReadString(&reader, type, sizeof(type));
+            }
+            else if (strcmp(key, "glob") == 0)
+            {
+                ok = MCP_JSON_ReadString(&reader, filter.Glob, sizeof(filter.Glob));
+            }
+            else if (strcmp(key, "details") == 0)
+            {
+                ok = MCP_JSON_ReadBool(&reader, &filter.Details);
+            }
+            else
+            {
+                ok = MCP_JSON_SkipValue(&reader);
+            }
+        }
     }
 
-    /* Open directory */
-    dir = opendir(directory);
-    if (dir == NULL)
+    if (!ok || reader.Error || !MCP_JSON_ReadEnd(&reader) || dir_path[0] == '\0')
     {
         response->status = -1;
-        snprintf(response->error_msg, sizeof(response->error_msg),
-                "Failed to open directory: %s", directory);
+        strncpy(response->error_msg, "Invalid file list params", sizeof(response->error_msg) - 1);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    if (strcmp(type, "file") == 0)
+    {
+        filter.Type = MCP_DIR_ENTRY_FILE;
+    }
+    else if (strcmp(type, "directory") == 0)
+    {
+        filter.Type = MCP_DIR_ENTRY_DIRECTORY;
+    }
+    else if (type[0] != '\0')
+    {
+        response->status = -1;
+        strncpy(response->error_msg, "Type must be file or directory", sizeof(response->error_msg) - 1);
         return CFE_ES_ERR_APPNAME;
     }
 
-    /* Start building JSON response */
-    snprintf(result_str, sizeof(result_str),
-            "{\"directory\": \"%s\", \"files\": [", directory);
+    if (filter.Limit == 0 || filter.Limit > MCP_FILE_LIST_MAX_LIMIT)
+    {
+        filter.Limit = MCP_FILE_LIST_MAX_LIMIT;
+    }
+
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyString(json, "directory", dir_path);
+    MCP_JSON_Key(json, "files");
+    MCP_JSON_BeginArray(json);
 
-    /* Read directory entries */
-    while ((entry = readdir(dir)) != NULL && file_count < 50)
+    /* Pages of a cached listing start right at the cursor */
+    listing = MCP_INTERFACE_LockDirListing(dir_path);
+    if (listing != NULL)
     {
-        /* Skip . and .. */
-        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
-            continue;
+        for (position = cursor; position < listing->Count; position++)
+        {
+            if (filter.Count == filter.Limit ||
+                !MCP_INTERFACE_WriteFileEntry(json, &filter,
+                                              &listing->Names[listing->NameOffset[position]],
+                                              listing->Type[position]))
+            {
+                eof = FALSE;
+                break;
+            }
+        }
+        MCP_INTERFACE_UnlockDirListing();
+    }
+    else
+    {
+        /* Open directory */
+        dir = opendir(dir_path);
+        if (dir == NULL)
+        {
+            response->status = -1;
+            snprintf(response->error_msg, sizeof(response->error_msg),
+                    "Failed to open directory: %s", dir_path);
+            return CFE_ES_ERR_APPNAME;
+        }
 
-        /* Get file stats */
-        snprintf(file_path, sizeof(file_path), "%s/%s", directory, entry->d_name);
-        if (stat(file_path, &file_stat) == 0)
+        /* Read directory entries */
+        while ((entry = readdir(dir)) != NULL)
         {
-            if (file_count > 0)
+            /* Skip . and .. */
+            if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+                continue;
+
+            if (position >= cursor &&
+                (filter.Count == filter.Limit ||
+                 !MCP_INTERFACE_WriteFileEntry(json, &filter, entry->d_name,
+                                               MCP_INTERFACE_DirEntryType(dir_path, entry->d_name,
+                                                                          entry->d_type))))
             {
-                strncat(result_str, ", ", sizeof(result_str) - strlen(result_str) - 1);
+                eof = FALSE;
+                break;
             }
-            
-            /* Add file info to JSON */
-            char file_info[256];
-            snprintf(file_info, sizeof(file_info),
-                    "{\"name\": \"%s\", \"size\": %ld, \"type\": \"%s\"}",
-                    entry->d_name,
-                    file_stat.st_size,
-                    S_ISDIR(file_stat.st_mode) ? "directory" : "file");
-            
-            strncat(result_str, file_info, sizeof(result_str) - strlen(result_str) - 1);
-            file_count++;
+            position++;
         }
+
+        closedir(dir);
     }
 
-    strncat(result_str, "]}", sizeof(result_str) - strlen(result_str) - 1);
-    closedir(dir);
+    MCP_JSON_EndArray(json);
+    MCP_JSON_KeyUint(json, "count", filter.Count);
+    MCP_JSON_KeyUint(json, "next_cursor", (position > cursor) ? position : cursor);
+    MCP_JSON_KeyBool(json, "eof", eof);
+    MCP_JSON_EndObject(json);
 
     response->status = 0;
-    strncpy(response->result, result_str, sizeof(response->result) - 1);
 
     return CFE_SUCCESS;
 
 } /* End MCP_INTERFACE_HandleGetFileList */
 
+/*
+** Write one directory entry of a file list page
+**
+** Entries the filter rejects, or that can no longer be stat()ed, are
+** skipped. Returns FALSE, with nothing written, when the entry does not
+** fit in the response frame.
+*/
+static boolean MCP_INTERFACE_WriteFileEntry(MCP_JSON_Writer_t *json, MCP_INTERFACE_FileFilter_t *filter,
+                                            const char *name, uint8 type)
+{
+    MCP_JSON_Mark_t mark;
+    struct stat file_stat;
+    char file_path[MCP_MAX_PATH_LEN];
+
+    if ((filter->Type >= 0 && filter->Type != type) ||
+        (filter->Glob[0] != '\0' && fnmatch(filter->Glob, name, 0) != 0))
+    {
+        return TRUE;
+    }
+
+    if (filter->Details)
+    {
+        snprintf(file_path, sizeof(file_path), "%s/%s", filter->Directory, name);
+        if (stat(file_path, &file_stat) != 0)
+        {
+            return TRUE;
+        }
+    }
+
+    mark = MCP_JSON_GetMark(json);
+
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyString(json, "name", name);
+    if (filter->Details)
+    {
+        MCP_JSON_KeyUint(json, "size", (uint32)file_stat.st_size);
+        MCP_JSON_KeyUint(json, "mtime", (uint32)file_stat.st_mtime);
+    }
+    MCP_JSON_KeyString(json, "type", (type == MCP_DIR_ENTRY_DIRECTORY) ? "directory" : "file");
+    MCP_JSON_EndObject(json);
+
+    if (!MCP_JSON_Ok(json) || json->Length + MCP_FILE_LIST_RESERVE > json->Size)
+    {
+        MCP_JSON_Rewind(json, &mark);
+        return FALSE;
+    }
+
+    filter->Count++;
+
+    return TRUE;
+
+} /* End MCP_INTERFACE_WriteFileEntry */
+
 /*
 ** Handle Read File request
+**
+** Params are the file path as a string, or {"path": ..., "offset": n,
+** "length": n, "encoding": "text" | "base64" | "raw"}. One chunk is
+** returned per request; the length actually read and the eof flag tell
+** the client where to continue. Raw chunks follow the response unframed
+** and cannot be read inside a batch.
 */
 int32 MCP_INTERFACE_HandleReadFile(MCP_Request_t *request, MCP_Response_t *response)
 {
-    FILE *file;
+    MCP_JSON_Reader_t reader;
+    struct stat file_stat;
     char file_path[256];
-    char file_content[1024];
-    char result_str[2048];
-    size_t bytes_read;
+    char encoding[8] = "text";
+    char key[16];
+    uint8 buffer[MCP_FILE_CHUNK_BASE64];
+    uint32 offset = 0;
+    uint32 length = 0;
+    uint32 limit;
+    uint32 file_size;
+    uint32 available;
+    ssize_t bytes_read;
+    boolean is_text;
+    boolean is_raw;
+    boolean ok;
+    int fd;
+
+    MCP_JSON_ReaderInit(&reader, request->params, request->params_len);
+    file_path[0] = '\0';
 
-    /* Parse file path from params */
-    if (strlen(request->params) < 3)
+    if (MCP_JSON_PeekType(&reader) == MCP_JSON_TYPE_STRING)
+    {
+        ok = MCP_JSON_ReadString(&reader, file_path, sizeof(file_path));
+    }
+    else
+    {
+        ok = MCP_JSON_ReadObjectBegin(&reader);
+
+        while (ok && MCP_JSON_ReadObjectNext(&reader, key, sizeof(key)))
+        {
+            if (strcmp(key, "path") == 0)
+            {
+                ok = MCP_JSON_ReadString(&reader, file_path, sizeof(file_path));
+            }
+            else if (strcmp(key, "offset") == 0)
+            {
+                ok = MCP_JSON_ReadUint(&reader, &offset);
+            }
+            else if (strcmp(key, "length") == 0)
+            {
+                ok = MCP_JSON_ReadUint(&reader, &length);
+            }
+            else if (strcmp(key, "encoding") == 0)
+            {
+                ok = MCP_JSON_ReadString(&reader, encoding, sizeof(encoding));
+            }
+            else
+            {
+                ok = MCP_JSON_SkipValue(&reader);
+            }
+        }
+    }
+
+    if (!ok || reader.Error || !MCP_JSON_ReadEnd(&reader) || file_path[0] == '\0')
     {
         response->status = -1;
         strncpy(response->error_msg, "File path is required", sizeof(response->error_msg) - 1);
         return CFE_ES_ERR_APPNAME;
     }
 
-    /* Remove quotes from JSON string */
-    strncpy(file_path, request->params + 1, sizeof(file_path) - 1);
-    file_path[strlen(file_path) - 1] = '\0';
+    if (!MCP_INTERFACE_IsSafePath(request, file_path))
+    {
+        response->status = -1;
+        strncpy(response->error_msg, "Command blocked by safety system", sizeof(response->error_msg) - 1);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    is_text = (strcmp(encoding, "text") == 0);
+    is_raw = (strcmp(encoding, "raw") == 0);
+
+    if (is_text)
+    {
+        limit = MCP_FILE_CHUNK_TEXT;
+    }
+    else if (strcmp(encoding, "base64") == 0)
+    {
+        limit = MCP_FILE_CHUNK_BASE64;
+    }
+    else if (is_raw)
+    {
+        limit = MCP_FILE_CHUNK_RAW;
+    }
+    else
+    {
+        response->status = -1;
+        strncpy(response->error_msg, "Encoding must be text, base64 or raw", sizeof(response->error_msg) - 1);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    if (length == 0 || length > limit)
+    {
+        length = limit;
+    }
 
     /* Safety check - only allow reading from certain directories */
     if (strstr(file_path, "..") != NULL || file_path[0] != '/')
@@ -458,32 +758,118 @@ int32 MCP_INTERFACE_HandleReadFile(MCP_Request_t *request, MCP_Response_t *respo
     }
 
     /* Open file */
-    file = fopen(file_path, "r");
-    if (file == NULL)
+    fd = open(file_path, O_RDONLY);
+    if (fd < 0 || fstat(fd, &file_stat) != 0 || !S_ISREG(file_stat.st_mode))
     {
+        if (fd >= 0)
+        {
+            close(fd);
+        }
         response->status = -1;
         snprintf(response->error_msg, sizeof(response->error_msg),
                 "Failed to open file: %s", file_path);
         return CFE_ES_ERR_APPNAME;
     }
 
-    /* Read file content (limited to avoid buffer overflow) */
-    bytes_read = fread(file_content, 1, sizeof(file_content) - 1, file);
-    file_content[bytes_read] = '\0';
-    fclose(file);
+    /* Offsets are 32 bit, so only the first 4 GB of a file can be read */
+    file_size = (file_stat.st_size > (off_t)0xFFFFFFFF) ? 0xFFFFFFFF : (uint32)file_stat.st_size;
+    available = (file_size > offset) ? file_size - offset : 0;
+    if (length > available)
+    {
+        length = available;
+    }
+
+    if (is_raw)
+    {
+        bytes_read = (ssize_t)length;
+    }
+    else
+    {
+        bytes_read = (length > 0) ? pread(fd, buffer, length, (off_t)offset) : 0;
+        close(fd);
+        fd = -1;
+
+        if (bytes_read < 0)
+        {
+            response->status = -1;
+            snprintf(response->error_msg, sizeof(response->error_msg),
+                    "Failed to read file: %s", file_path);
+            return CFE_ES_ERR_APPNAME;
+        }
+    }
+
+    /* Do not split a UTF-8 sequence across text chunks */
+    if (is_text && (uint32)bytes_read < available)
+    {
+        bytes_read = (ssize_t)MCP_INTERFACE_Utf8Boundary(buffer, (uint32)bytes_read);
+    }
 
     /* Create JSON response */
-    snprintf(result_str, sizeof(result_str),
-            "{\"file_path\": \"%s\", \"size\": %zu, \"content\": \"%s\"}",
-            file_path, bytes_read, file_content);
+    MCP_JSON_BeginObject(response->result);
+    MCP_JSON_KeyString(response->result, "file_path", file_path);
+    MCP_JSON_KeyUint(response->result, "offset", offset);
+    MCP_JSON_KeyUint(response->result, "length", (uint32)bytes_read);
+    MCP_JSON_KeyUint(response->result, "file_size", file_size);
+    MCP_JSON_KeyBool(response->result, "eof", (uint32)bytes_read == available);
+    MCP_JSON_KeyString(response->result, "encoding", encoding);
+    if (is_text)
+    {
+        MCP_JSON_Key(response->result, "content");
+        MCP_JSON_StringN(response->result, (const char *)buffer, (uint32)bytes_read);
+    }
+    else if (!is_raw)
+    {
+        MCP_JSON_Key(response->result, "content");
+        MCP_JSON_Base64(response->result, buffer, (uint32)bytes_read);
+    }
+    MCP_JSON_EndObject(response->result);
+
+    /* The bytes of a raw chunk are sent from the file once the header is out */
+    if (fd >= 0 && length > 0)
+    {
+        response->stream_fd = fd;
+        response->stream_offset = offset;
+        response->stream_length = length;
+    }
+    else if (fd >= 0)
+    {
+        close(fd);
+    }
 
     response->status = 0;
-    strncpy(response->result, result_str, sizeof(response->result) - 1);
 
     return CFE_SUCCESS;
 
 } /* End MCP_INTERFACE_HandleReadFile */
 
+/*
+** Length of a text chunk without a UTF-8 sequence cut off at its end
+*/
+static uint32 MCP_INTERFACE_Utf8Boundary(const uint8 *text, uint32 length)
+{
+    uint32 lead = length;
+    uint32 needed;
+
+    /* Find the start of the last sequence, at most three bytes back */
+    while (lead > 0 && length - lead < 4 && (text[lead - 1] & 0xC0) == 0x80)
+    {
+        lead--;
+    }
+
+    if (lead == 0 || (text[lead - 1] & 0x80) == 0)
+    {
+        return length;
+    }
+
+    lead--;
+    needed = ((text[lead] & 0xE0) == 0xC0) ? 2 :
+             ((text[lead] & 0xF0) == 0xE0) ? 3 :
+             ((text[lead] & 0xF8) == 0xF0) ? 4 : 1;
+
+    return (lead > 0 && length - lead < needed) ? lead : length;
+
+} /* End MCP_INTERFACE_Utf8Boundary */
+
 /*
 ** Handle Write File request
 */
@@ -511,37 +897,91 @@ int32 MCP_INTERFACE_HandleWriteFile(MCP_Request_t *request, MCP_Response_t *resp
 
 /*
 ** Handle Get Event Log request
+**
+** Params are optional: {"since_seq": n, "max": n, "severity": "DEBUG" |
+** "INFO" | "ERROR" | "CRITICAL", "app": ...}. Events after since_seq are
+** returned oldest first, at least as severe as severity and only from
+** app when given. Passing back next_seq as since_seq fetches only the
+** events recorded since.
 */
 int32 MCP_INTERFACE_HandleGetEventLog(MCP_Request_t *request, MCP_Response_t *response)
 {
-    char result_str[2048];
-
-    /* This is a simplified implementation - real version would access EVS log */
-    snprintf(result_str, sizeof(result_str),
-            "{"
-            "\"event_log\": {"
-            "\"timestamp\": %u,"
-            "\"message\": \"Event log access not fully implemented\","
-            "\"recent_events\": ["
-            "{"
-            "\"id\": 1,"
-            "\"app\": \"MCP_INTERFACE\","
-            "\"type\": \"INFO\","
-            "\"message\": \"MCP Interface App Started\""
-            "},"
-            "{"
-            "\"id\": 2,"
-            "\"app\": \"MCP_INTERFACE\","
-            "\"type\": \"INFO\","
-            "\"message\": \"Client connected\""
-            "}"
-            "]"
-            "}"
-            "}",
-            CFE_TIME_GetTime().Seconds);
+    MCP_INTERFACE_EventQuery_t query;
+    MCP_JSON_Reader_t reader;
+    char severity[16] = "";
+    char key[16];
+    boolean ok = TRUE;
+
+    query.SinceSeq = 0;
+    query.Max = MCP_EVENT_LOG_DEFAULT_MAX;
+    query.MinType = CFE_EVS_DEBUG;
+    query.AppName[0] = '\0';
+
+    if (request->params_len > 0)
+    {
+        MCP_JSON_ReaderInit(&reader, request->params, request->params_len);
+        ok = MCP_JSON_ReadObjectBegin(&reader);
+
+        while (ok && MCP_JSON_ReadObjectNext(&reader, key, sizeof(key)))
+        {
+            if (strcmp(key, "since_seq") == 0)
+            {
+                ok = MCP_JSON_ReadUint(&reader, &query.SinceSeq);
+            }
+            else if (strcmp(key, "max") == 0)
+            {
+                ok = MCP_JSON_ReadUint(&reader, &query.Max);
+            }
+            else if (strcmp(key, "severity") == 0)
+            {
+                ok = MCP_JSON_ReadString(&reader, severity, sizeof(severity));
+            }
+            else if (strcmp(key, "app") == 0)
+            {
+                ok = MCP_JSON_ReadString(&reader, query.AppName, sizeof(query.AppName));
+            }
+            else
+            {
+                ok = MCP_JSON_SkipValue(&reader);
+            }
+        }
+
+        if (!ok || reader.Error || !MCP_JSON_ReadEnd(&reader))
+        {
+            response->status = -1;
+            strncpy(response->error_msg, "Invalid event log params", sizeof(response->error_msg) - 1);
+            return CFE_ES_ERR_APPNAME;
+        }
+    }
+
+    if (strcmp(severity, "INFO") == 0)
+    {
+        query.MinType = CFE_EVS_INFORMATION;
+    }
+    else if (strcmp(severity, "ERROR") == 0)
+    {
+        query.MinType = CFE_EVS_ERROR;
+    }
+    else if (strcmp(severity, "CRITICAL") == 0)
+    {
+        query.MinType = CFE_EVS_CRITICAL;
+    }
+    else if (severity[0] != '\0' && strcmp(severity, "DEBUG") != 0)
+    {
+        response->status = -1;
+        strncpy(response->error_msg, "Severity must be DEBUG, INFO, ERROR or CRITICAL",
+                sizeof(response->error_msg) - 1);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    if (query.Max == 0 || query.Max > MCP_EVENT_LOG_DEPTH)
+    {
+        query.Max = MCP_EVENT_LOG_DEPTH;
+    }
+
+    MCP_INTERFACE_WriteEventLog(response->result, &query);
 
     response->status = 0;
-    strncpy(response->result, result_str, sizeof(response->result) - 1);
 
     return CFE_SUCCESS;
 
@@ -552,37 +992,454 @@ int32 MCP_INTERFACE_HandleGetEventLog(MCP_Request_t *request, MCP_Response_t *re
 */
 int32 MCP_INTERFACE_HandleEmergencyStop(MCP_Request_t *request, MCP_Response_t *response)
 {
-    char result_str[512];
+    MCP_JSON_Writer_t *json = response->result;
 
     /* Log emergency stop event */
     CFE_EVS_SendEvent(MCP_INTERFACE_SAFETY_ERR_EID,
                      CFE_EVS_CRITICAL,
                      "MCP_INTERFACE: EMERGENCY STOP requested via MCP interface");
 
+    MCP_INTERFACE_Audit("STOP", "emergency stop request=%u", (unsigned int)request->id);
+
     /* In a real implementation, this would:
      * 1. Stop all non-essential applications
      * 2. Put system in safe mode
      * 3. Alert ground control
-     * 4. Log the event
      */
 
     /* Enable safety mode */
     MCP_INTERFACE_AppData.SafetyMode = TRUE;
+    MCP_INTERFACE_FlushResponseCache();
+    MCP_INTERFACE_FlushCommandQueue("emergency stop");
+    MCP_INTERFACE_AbortSequences("emergency stop");
+    MCP_INTERFACE_FlushConfirmations("emergency stop");
 
-    snprintf(result_str, sizeof(result_str),
-            "{"
-            "\"emergency_stop\": {"
-            "\"timestamp\": %u,"
-            "\"status\": \"executed\","
-            "\"actions\": [\"safety_mode_enabled\", \"event_logged\"],"
-            "\"message\": \"Emergency stop procedure initiated\""
-            "}"
-            "}",
-            CFE_TIME_GetTime().Seconds);
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_Key(json, "emergency_stop");
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyUint(json, "timestamp", CFE_TIME_GetTime().Seconds);
+    MCP_JSON_KeyString(json, "status", "executed");
+    MCP_JSON_Key(json, "actions");
+    MCP_JSON_BeginArray(json);
+    MCP_JSON_String(json, "safety_mode_enabled");
+    MCP_JSON_String(json, "event_logged");
+    MCP_JSON_EndArray(json);
+    MCP_JSON_KeyString(json, "message", "Emergency stop procedure initiated");
+    MCP_JSON_EndObject(json);
+    MCP_JSON_EndObject(json);
 
     response->status = 0;
-    strncpy(response->result, result_str, sizeof(response->result) - 1);
 
     return CFE_SUCCESS;
 
 } /* End MCP_INTERFACE_HandleEmergencyStop */
+
+/*
+** Handle Batch request
+**
+** Each element of the batch is validated, safety checked and executed
+** exactly as a standalone request would be, and the results are
+** returned as one array with a status per element.
+*/
+int32 MCP_INTERFACE_HandleBatch(MCP_Request_t *request, MCP_Response_t *response)
+{
+    MCP_JSON_Reader_t reader;
+    const char *item;
+    uint32 item_len;
+    MCP_Request_t sub_request;
+    MCP_Response_t sub_response;
+    uint32 count = 0;
+    uint32 index = 0;
+
+    /* Count the elements first so an oversized batch runs nothing */
+    MCP_JSON_ReaderInit(&reader, request->params, request->params_len);
+    if (MCP_JSON_ReadArrayBegin(&reader))
+    {
+        while (MCP_JSON_ReadArrayNext(&reader) && MCP_JSON_SkipValue(&reader))
+        {
+            count++;
+        }
+    }
+
+    if (reader.Error || !MCP_JSON_ReadEnd(&reader) ||
+        count == 0 || count > MCP_MAX_BATCH_SIZE)
+    {
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Batch must contain 1 to %d requests", MCP_MAX_BATCH_SIZE);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    /* Sub-responses are written straight into this response's result */
+    MCP_JSON_BeginArray(response->result);
+
+    MCP_JSON_ReaderInit(&reader, request->params, request->params_len);
+    MCP_JSON_ReadArrayBegin(&reader);
+
+    while (MCP_JSON_ReadArrayNext(&reader) && MCP_JSON_ReadRaw(&reader, &item, &item_len))
+    {
+        index++;
+
+        /*
+        ** Sub-requests without an id are numbered by position. Each item
+        ** is decoded in place, which is safe as the reader is past it.
+        */
+        if (MCP_INTERFACE_ParseJSONBatchItem((char *)item, item_len, &sub_request, index) != CFE_SUCCESS)
+        {
+            MCP_INTERFACE_BeginJSONResponse(&sub_response, response->result, index);
+            sub_response.status = -1;
+            strncpy(sub_response.error_msg, "Invalid batch request", sizeof(sub_response.error_msg) - 1);
+        }
+        else if (sub_request.type == MCP_CMD_BATCH)
+        {
+            MCP_INTERFACE_BeginJSONResponse(&sub_response, response->result, sub_request.id);
+            sub_response.status = -1;
+            strncpy(sub_response.error_msg, "Nested batch requests are not allowed", sizeof(sub_response.error_msg) - 1);
+        }
+        else
+        {
+            sub_request.client_slot = request->client_slot;
+            MCP_INTERFACE_BeginJSONResponse(&sub_response, response->result, sub_request.id);
+            MCP_INTERFACE_ProcessRequest(&sub_request, &sub_response);
+
+            /* Unframed file bytes have no place between batch results */
+            if (sub_response.stream_fd >= 0)
+            {
+                close(sub_response.stream_fd);
+                sub_response.stream_fd = -1;
+                sub_response.status = -1;
+                strncpy(sub_response.error_msg, "Raw file reads are not allowed in a batch",
+                        sizeof(sub_response.error_msg) - 1);
+            }
+        }
+
+        MCP_INTERFACE_EndJSONResponse(&sub_response);
+    }
+
+    MCP_JSON_EndArray(response->result);
+
+    response->status = 0;
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_HandleBatch */
+
+/*
+** Handle Subscribe request
+**
+** Params are {"apps": [...], "max_hz": n, "on_change": bool}. The
+** subscription replaces any earlier one on the same connection, and
+** every update is pushed with the id of this request.
+*/
+int32 MCP_INTERFACE_HandleSubscribe(MCP_Request_t *request, MCP_Response_t *response)
+{
+    MCP_INTERFACE_TlmSubscription_t *sub;
+    const MCP_INTERFACE_TlmSnapshot_t *snapshot;
+    MCP_JSON_Reader_t reader;
+    char key[16];
+    char app_name[MCP_MAX_APP_NAME_LEN];
+    uint32 app_mask = 0;
+    uint32 max_hz = 0;
+    boolean on_change = FALSE;
+    boolean ok = TRUE;
+    uint32 i;
+
+    if (request->client_slot < 0)
+    {
+        response->status = -1;
+        strncpy(response->error_msg, "Subscriptions need a client connection", sizeof(response->error_msg) - 1);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    MCP_JSON_ReaderInit(&reader, request->params, request->params_len);
+    ok = MCP_JSON_ReadObjectBegin(&reader);
+
+    while (ok && MCP_JSON_ReadObjectNext(&reader, key, sizeof(key)))
+    {
+        if (strcmp(key, "apps") == 0 && MCP_JSON_PeekType(&reader) == MCP_JSON_TYPE_ARRAY)
+        {
+            ok = MCP_JSON_ReadArrayBegin(&reader);
+            while (ok && MCP_JSON_ReadArrayNext(&reader))
+            {
+                ok = MCP_JSON_ReadString(&reader, app_name, sizeof(app_name));
+                if (!ok)
+                {
+                    break;
+                }
+
+                snapshot = MCP_INTERFACE_FindTelemetry(app_name);
+                if (snapshot == NULL)
+                {
+                    response->status = -1;
+                    snprintf(response->error_msg, sizeof(response->error_msg),
+                            "No telemetry listed for %s in the command dictionary", app_name);
+                    return CFE_ES_ERR_APPNAME;
+                }
+
+                app_mask |= (1u << (snapshot - MCP_INTERFACE_AppData.TlmCache));
+            }
+        }
+        else if (strcmp(key, "max_hz") == 0)
+        {
+            ok = MCP_JSON_ReadUint(&reader, &max_hz);
+        }
+        else if (strcmp(key, "on_change") == 0)
+        {
+            ok = MCP_JSON_ReadBool(&reader, &on_change);
+        }
+        else
+        {
+            ok = MCP_JSON_SkipValue(&reader);
+        }
+    }
+
+    if (!ok || reader.Error || !MCP_JSON_ReadEnd(&reader) ||
+        app_mask == 0 || max_hz > MCP_TLM_PUSH_MAX_HZ)
+    {
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Subscription needs at least one app and max_hz up to %d", MCP_TLM_PUSH_MAX_HZ);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    sub = &MCP_INTERFACE_AppData.Clients[request->client_slot].Subscription;
+    memset(sub, 0, sizeof(*sub));
+    sub->Id = request->id;
+    sub->AppMask = app_mask;
+    sub->MinIntervalMs = (max_hz != 0) ? (1000 / max_hz) : 0;
+    sub->OnChange = on_change;
+    MCP_INTERFACE_UpdateTlmSubscribers();
+
+    /* Packets already cached are pushed right away as the initial values */
+    MCP_JSON_BeginObject(response->result);
+    MCP_JSON_KeyBool(response->result, "subscribed", TRUE);
+    MCP_JSON_Key(response->result, "apps");
+    MCP_JSON_BeginArray(response->result);
+    for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+    {
+        if (app_mask & (1u << i))
+        {
+            MCP_JSON_String(response->result, MCP_INTERFACE_AppData.TlmCache[i].AppName);
+        }
+    }
+    MCP_JSON_EndArray(response->result);
+    MCP_JSON_KeyUint(response->result, "max_hz", max_hz);
+    MCP_JSON_KeyBool(response->result, "on_change", on_change);
+    MCP_JSON_EndObject(response->result);
+
+    response->status = 0;
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_HandleSubscribe */
+
+/*
+** Handle Unsubscribe request
+*/
+int32 MCP_INTERFACE_HandleUnsubscribe(MCP_Request_t *request, MCP_Response_t *response)
+{
+    if (request->client_slot < 0)
+    {
+        response->status = -1;
+        strncpy(response->error_msg, "Subscriptions need a client connection", sizeof(response->error_msg) - 1);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    memset(&MCP_INTERFACE_AppData.Clients[request->client_slot].Subscription, 0,
+           sizeof(MCP_INTERFACE_TlmSubscription_t));
+    MCP_INTERFACE_UpdateTlmSubscribers();
+
+    MCP_JSON_BeginObject(response->result);
+    MCP_JSON_KeyBool(response->result, "subscribed", FALSE);
+    MCP_JSON_EndObject(response->result);
+
+    response->status = 0;
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_HandleUnsubscribe */
+
+/*
+** Handle Get Metrics request
+*/
+int32 MCP_INTERFACE_HandleGetMetrics(MCP_Request_t *request, MCP_Response_t *response)
+{
+    /* Metrics take no parameters */
+    (void)request;
+
+    MCP_INTERFACE_WriteMetrics(response->result);
+
+    response->status = 0;
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_HandleGetMetrics */
+
+/*
+** Handle Get Trace request
+**
+** Params are optional: {"since_seq": n, "max": n}. Traces after
+** since_seq are returned oldest first; passing back next_seq as
+** since_seq fetches only the requests traced since.
+*/
+int32 MCP_INTERFACE_HandleGetTrace(MCP_Request_t *request, MCP_Response_t *response)
+{
+    MCP_JSON_Reader_t reader;
+    char key[16];
+    uint32 since_seq = 0;
+    uint32 max = MCP_TRACE_DEFAULT_MAX;
+    boolean ok = TRUE;
+
+    if (request->params_len > 0)
+    {
+        MCP_JSON_ReaderInit(&reader, request->params, request->params_len);
+        ok = MCP_JSON_ReadObjectBegin(&reader);
+
+        while (ok && MCP_JSON_ReadObjectNext(&reader, key, sizeof(key)))
+        {
+            if (strcmp(key, "since_seq") == 0)
+            {
+                ok = MCP_JSON_ReadUint(&reader, &since_seq);
+            }
+            else if (strcmp(key, "max") == 0)
+            {
+                ok = MCP_JSON_ReadUint(&reader, &max);
+            }
+            else
+            {
+                ok = MCP_JSON_SkipValue(&reader);
+            }
+        }
+
+        if (!ok || reader.Error || !MCP_JSON_ReadEnd(&reader))
+        {
+            response->status = -1;
+            strncpy(response->error_msg, "Invalid trace params", sizeof(response->error_msg) - 1);
+            return CFE_ES_ERR_APPNAME;
+        }
+    }
+
+    if (max == 0 || max > MCP_TRACE_DEPTH)
+    {
+        max = MCP_TRACE_DEPTH;
+    }
+
+    MCP_INTERFACE_WriteTrace(response->result, since_seq, max);
+
+    response->status = 0;
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_HandleGetTrace */
+
+/*
+** Handle Run Sequence request
+**
+** Params are {"steps": [...]} to start a sequence or {"cancel": id} to
+** abort a running one. Progress of a started sequence is pushed with
+** the id of this request; see mcp_sequence.c for the steps.
+*/
+int32 MCP_INTERFACE_HandleRunSequence(MCP_Request_t *request, MCP_Response_t *response)
+{
+    MCP_JSON_Reader_t reader;
+    char key[16];
+    const char *steps = NULL;
+    uint32 steps_len = 0;
+    uint32 cancel = 0;
+    boolean ok = TRUE;
+
+    MCP_JSON_ReaderInit(&reader, request->params, request->params_len);
+    ok = MCP_JSON_ReadObjectBegin(&reader);
+
+    while (ok && MCP_JSON_ReadObjectNext(&reader, key, sizeof(key)))
+    {
+        if (strcmp(key, "steps") == 0 && MCP_JSON_PeekType(&reader) == MCP_JSON_TYPE_ARRAY)
+        {
+            ok = MCP_JSON_ReadRaw(&reader, &steps, &steps_len);
+        }
+        else if (strcmp(key, "cancel") == 0)
+        {
+            ok = MCP_JSON_ReadUint(&reader, &cancel);
+        }
+        else
+        {
+            ok = MCP_JSON_SkipValue(&reader);
+        }
+    }
+
+    if (!ok || reader.Error || !MCP_JSON_ReadEnd(&reader) || (steps == NULL) == (cancel == 0))
+    {
+        response->status = -1;
+        strncpy(response->error_msg, "Sequence needs either steps or a sequence to cancel",
+                sizeof(response->error_msg) - 1);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    if (steps != NULL)
+    {
+        return MCP_INTERFACE_StartSequence(request, steps, steps_len, response);
+    }
+
+    if (!MCP_INTERFACE_CancelSequence(cancel))
+    {
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "No sequence %u is running", (unsigned int)cancel);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    MCP_JSON_BeginObject(response->result);
+    MCP_JSON_KeyUint(response->result, "sequence_id", cancel);
+    MCP_JSON_KeyString(response->result, "state", "cancelled");
+    MCP_JSON_EndObject(response->result);
+
+    response->status = 0;
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_HandleRunSequence */
+
+/*
+** Handle Confirm request
+**
+** Params are the token of a prepared send_command request, as the
+** MCP_CONFIRM_TOKEN_LEN hex digits it was returned as.
+*/
+int32 MCP_INTERFACE_HandleConfirm(MCP_Request_t *request, MCP_Response_t *response)
+{
+    uint32 token = 0;
+    uint32 i;
+    char c;
+    boolean ok = (request->params_len == MCP_CONFIRM_TOKEN_LEN);
+
+    for (i = 0; ok && i < MCP_CONFIRM_TOKEN_LEN; i++)
+    {
+        c = request->params[i];
+        if (c >= '0' && c <= '9')
+        {
+            token = (token << 4) | (uint32)(c - '0');
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            token = (token << 4) | (uint32)(c - 'A' + 10);
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            token = (token << 4) | (uint32)(c - 'a' + 10);
+        }
+        else
+        {
+            ok = FALSE;
+        }
+    }
+
+    if (!ok)
+    {
+        response->status = -1;
+        strncpy(response->error_msg, "Invalid confirmation token", sizeof(response->error_msg) - 1);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    return MCP_INTERFACE_ConfirmCommand(token, request, response);
+
+} /* End MCP_INTERFACE_HandleConfirm */
@@ -0,0 +1,357 @@
+/*
+** MCP Interface Confirmation Tokens
+**
+** This file contains the two phase sending of commands. A send_command
+** request marked prepare is checked as if confirmed, its packet built
+** in a zero copy buffer and held in a pending slot under a short lived
+** token; a confirm request with the token sends the held packet without
+** the command being parsed, resolved or built again. The token is the
+** confirmation, so the client can issue it as soon as the prepare
+** response arrives. Every function is called with the data mutex held.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+#include <stdio.h>
+
+/*
+** Local function prototypes
+*/
+static MCP_INTERFACE_PendingCmd_t *MCP_INTERFACE_FindPending(uint32 token);
+static uint32 MCP_INTERFACE_NewToken(uint32 slot, uint32 now);
+static void MCP_INTERFACE_DropPending(MCP_INTERFACE_PendingCmd_t *pending);
+
+/*
+** Start with no command awaiting confirmation
+*/
+void MCP_INTERFACE_InitConfirmations(void)
+{
+    memset(&MCP_INTERFACE_AppData.Confirmations, 0, sizeof(MCP_INTERFACE_AppData.Confirmations));
+
+} /* End MCP_INTERFACE_InitConfirmations */
+
+/*
+** Build a command's packet and hold it for confirmation
+**
+** The payload must already be valid for the entry. Responds with the
+** token to confirm it with, or an error when every slot is taken or no
+** buffer is free.
+*/
+int32 MCP_INTERFACE_PrepareCommand(const MCP_Request_t *request, const MCP_INTERFACE_CmdEntry_t *entry,
+                                   const char *payload_hex, uint32 payload_hex_len, MCP_Response_t *response)
+{
+    MCP_INTERFACE_Confirmations_t *state = &MCP_INTERFACE_AppData.Confirmations;
+    MCP_INTERFACE_PendingCmd_t *pending = NULL;
+    uint32 now;
+    uint32 i;
+    char token_str[MCP_CONFIRM_TOKEN_LEN + 1];
+    char msg_id_str[8];
+
+    for (i = 0; i < MCP_CONFIRM_SLOTS && pending == NULL; i++)
+    {
+        if (state->Pending[i].Token == 0)
+        {
+            pending = &state->Pending[i];
+        }
+    }
+
+    if (pending == NULL)
+    {
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "%u commands already awaiting confirmation", (unsigned int)MCP_CONFIRM_SLOTS);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    pending->Msg = MCP_INTERFACE_BuildCommandPacket(entry, payload_hex, payload_hex_len, &pending->Handle);
+    if (pending->Msg == NULL)
+    {
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Failed to build command, status = 0x%08X", (unsigned int)CFE_SB_BUF_ALOC_ERR);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    now = MCP_INTERFACE_MetricsNowUs();
+
+    pending->Token = MCP_INTERFACE_NewToken((uint32)(pending - state->Pending), now);
+    pending->RequestId = request->id;
+    pending->ExpiresUs = now + MCP_CONFIRM_TTL_MS * 1000u;
+    pending->Entry = entry;
+    pending->Critical = request->is_critical || (entry->Flags & MCP_CMD_FLAG_CRITICAL);
+    pending->PayloadLen = (uint16)payload_hex_len;
+    memcpy(pending->Payload, payload_hex, payload_hex_len);
+    state->Count++;
+
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.ConfirmationsIssued, 1);
+
+    snprintf(token_str, sizeof(token_str), "%08X", (unsigned int)pending->Token);
+    MCP_INTERFACE_Audit("CONFIRM", "issued token=%s request=%u app=%s command=%s critical=%u payload=%.*s",
+                        token_str, (unsigned int)request->id, entry->AppName, entry->CommandName,
+                        (unsigned int)(pending->Critical != FALSE), (int)payload_hex_len, payload_hex);
+    snprintf(msg_id_str, sizeof(msg_id_str), "0x%04X", entry->MsgId);
+
+    response->status = 0;
+
+    MCP_JSON_BeginObject(response->result);
+    MCP_JSON_KeyBool(response->result, "command_sent", FALSE);
+    MCP_JSON_KeyBool(response->result, "confirmation_required", TRUE);
+    MCP_JSON_KeyString(response->result, "token", token_str);
+    MCP_JSON_KeyUint(response->result, "expires_in_ms", MCP_CONFIRM_TTL_MS);
+    MCP_JSON_KeyString(response->result, "app", entry->AppName);
+    MCP_JSON_KeyString(response->result, "command", entry->CommandName);
+    MCP_JSON_KeyString(response->result, "msg_id", msg_id_str);
+    MCP_JSON_KeyUint(response->result, "cmd_code", entry->CommandCode);
+    MCP_JSON_EndObject(response->result);
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_PrepareCommand */
+
+/*
+** Send the command held under a token
+**
+** The command is admitted like any other, so a confirmed command may be
+** queued for a rate token; one that is rejected keeps its token, to be
+** confirmed again once the rate allows.
+*/
+int32 MCP_INTERFACE_ConfirmCommand(uint32 token, MCP_Request_t *request, MCP_Response_t *response)
+{
+    MCP_INTERFACE_PendingCmd_t *pending;
+    MCP_INTERFACE_Admission_t admission;
+    const MCP_INTERFACE_CmdEntry_t *entry;
+    int32 admit;
+    int32 status;
+    char msg_id_str[8];
+
+    pending = MCP_INTERFACE_FindPending(token);
+    if (pending == NULL || (int32)(pending->ExpiresUs - MCP_INTERFACE_MetricsNowUs()) <= 0)
+    {
+        response->status = -1;
+        strncpy(response->error_msg, "Unknown or expired confirmation token", sizeof(response->error_msg) - 1);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    entry = pending->Entry;
+
+    /* Admit under the criticality the command was prepared with */
+    request->is_critical = pending->Critical;
+
+    admit = MCP_INTERFACE_AdmitCommand(request, entry, pending->Payload, pending->PayloadLen, &admission);
+    if (admit == MCP_ADMIT_REJECTED)
+    {
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Command rate limit exceeded, retry after %u ms", (unsigned int)admission.WaitMs);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.ConfirmationsUsed, 1);
+    MCP_INTERFACE_Audit("CONFIRM", "used token=%08X request=%u prepared_by=%u %s",
+                        (unsigned int)token, (unsigned int)request->id, (unsigned int)pending->RequestId,
+                        (admit == MCP_ADMIT_QUEUED) ? "queued" : "sending");
+
+    if (admit == MCP_ADMIT_QUEUED)
+    {
+        /* The queue sends from the payload, so the held packet is not needed */
+        MCP_INTERFACE_DropPending(pending);
+
+        response->status = 0;
+
+        MCP_JSON_BeginObject(response->result);
+        MCP_JSON_KeyBool(response->result, "command_sent", FALSE);
+        MCP_JSON_KeyBool(response->result, "queued", TRUE);
+        MCP_JSON_KeyBool(response->result, "confirmed", TRUE);
+        MCP_JSON_KeyString(response->result, "app", entry->AppName);
+        MCP_JSON_KeyString(response->result, "command", entry->CommandName);
+        MCP_JSON_KeyUint(response->result, "queue_position", admission.Position);
+        MCP_JSON_KeyUint(response->result, "send_in_ms", admission.WaitMs);
+        MCP_JSON_EndObject(response->result);
+
+        return CFE_SUCCESS;
+    }
+
+    if (pending->Critical)
+    {
+        MCP_INTERFACE_AppData.CriticalCommandCount++;
+
+        /* Log critical command */
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
+                         CFE_EVS_INFORMATION,
+                         "MCP_INTERFACE: Confirmed critical command sent to %s: %s",
+                         entry->AppName, entry->CommandName);
+    }
+
+    /* The buffer belongs to the bus once it is sent */
+    status = CFE_SB_ZeroCopySend(pending->Msg, pending->Handle);
+    if (status == CFE_SUCCESS)
+    {
+        pending->Msg = NULL;
+    }
+    MCP_INTERFACE_AuditCommand("confirm", request->id, entry, pending->Critical, pending->Payload,
+                               pending->PayloadLen, status);
+    MCP_INTERFACE_DropPending(pending);
+
+    if (status != CFE_SUCCESS)
+    {
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Failed to send command, status = 0x%08X", (unsigned int)status);
+        return CFE_SUCCESS;
+    }
+
+    response->status = 0;
+    snprintf(msg_id_str, sizeof(msg_id_str), "0x%04X", entry->MsgId);
+
+    MCP_JSON_BeginObject(response->result);
+    MCP_JSON_KeyBool(response->result, "command_sent", TRUE);
+    MCP_JSON_KeyBool(response->result, "confirmed", TRUE);
+    MCP_JSON_KeyString(response->result, "app", entry->AppName);
+    MCP_JSON_KeyString(response->result, "command", entry->CommandName);
+    MCP_JSON_KeyString(response->result, "msg_id", msg_id_str);
+    MCP_JSON_KeyUint(response->result, "cmd_code", entry->CommandCode);
+    MCP_JSON_KeyUint(response->result, "payload_len", entry->PayloadLength);
+    MCP_JSON_EndObject(response->result);
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_ConfirmCommand */
+
+/*
+** Drop the tokens whose time is up
+**
+** Called by the main task on every housekeeping request, so no token
+** outlives the wrap of its microsecond time.
+*/
+void MCP_INTERFACE_ExpireConfirmations(void)
+{
+    MCP_INTERFACE_PendingCmd_t *pending;
+    uint32 now;
+    uint32 i;
+
+    if (MCP_INTERFACE_AppData.Confirmations.Count == 0)
+    {
+        return;
+    }
+
+    now = MCP_INTERFACE_MetricsNowUs();
+
+    for (i = 0; i < MCP_CONFIRM_SLOTS; i++)
+    {
+        pending = &MCP_INTERFACE_AppData.Confirmations.Pending[i];
+        if (pending->Token != 0 && (int32)(pending->ExpiresUs - now) <= 0)
+        {
+            MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.ConfirmationsExpired, 1);
+            MCP_INTERFACE_Audit("CONFIRM", "expired token=%08X request=%u",
+                                (unsigned int)pending->Token, (unsigned int)pending->RequestId);
+            MCP_INTERFACE_DropPending(pending);
+        }
+    }
+
+} /* End MCP_INTERFACE_ExpireConfirmations */
+
+/*
+** Drop every token
+**
+** Held packets carry the headers of the table they were built from, so
+** none survives a new table, nor an emergency stop.
+*/
+void MCP_INTERFACE_FlushConfirmations(const char *reason)
+{
+    MCP_INTERFACE_Confirmations_t *state = &MCP_INTERFACE_AppData.Confirmations;
+    uint32 i;
+
+    if (state->Count == 0)
+    {
+        return;
+    }
+
+    CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                     CFE_EVS_ERROR,
+                     "MCP_INTERFACE: %u commands awaiting confirmation dropped, %s",
+                     (unsigned int)state->Count, reason);
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.ConfirmationsExpired, state->Count);
+
+    for (i = 0; i < MCP_CONFIRM_SLOTS; i++)
+    {
+        if (state->Pending[i].Token != 0)
+        {
+            MCP_INTERFACE_Audit("CONFIRM", "dropped token=%08X request=%u reason=%s",
+                                (unsigned int)state->Pending[i].Token,
+                                (unsigned int)state->Pending[i].RequestId, reason);
+            MCP_INTERFACE_DropPending(&state->Pending[i]);
+        }
+    }
+
+} /* End MCP_INTERFACE_FlushConfirmations */
+
+/*
+** Slot holding a token, or NULL if none does
+*/
+static MCP_INTERFACE_PendingCmd_t *MCP_INTERFACE_FindPending(uint32 token)
+{
+    uint32 i;
+
+    if (token == 0)
+    {
+        return NULL;
+    }
+
+    for (i = 0; i < MCP_CONFIRM_SLOTS; i++)
+    {
+        if (MCP_INTERFACE_AppData.Confirmations.Pending[i].Token == token)
+        {
+            return &MCP_INTERFACE_AppData.Confirmations.Pending[i];
+        }
+    }
+
+    return NULL;
+
+} /* End MCP_INTERFACE_FindPending */
+
+/*
+** FNV-1a over the issue count, the time and the slot, so a stale token
+** from an earlier prepare does not match a new one; never 0 and never a
+** token that is still pending
+*/
+static uint32 MCP_INTERFACE_NewToken(uint32 slot, uint32 now)
+{
+    uint32 words[3];
+    uint32 hash;
+    uint32 i;
+
+    do
+    {
+        words[0] = ++MCP_INTERFACE_AppData.Confirmations.Issued;
+        words[1] = now;
+        words[2] = slot;
+
+        hash = 2166136261u;
+        for (i = 0; i < sizeof(words); i++)
+        {
+            hash = (hash ^ ((const uint8 *)words)[i]) * 16777619u;
+        }
+    } while (hash == 0 || MCP_INTERFACE_FindPending(hash) != NULL);
+
+    return hash;
+
+} /* End MCP_INTERFACE_NewToken */
+
+/*
+** Free a slot and the packet it still holds
+*/
+static void MCP_INTERFACE_DropPending(MCP_INTERFACE_PendingCmd_t *pending)
+{
+    if (pending->Msg != NULL)
+    {
+        CFE_SB_ZeroCopyReleasePtr(pending->Msg, pending->Handle);
+        pending->Msg = NULL;
+    }
+
+    pending->Token = 0;
+    pending->Entry = NULL;
+    MCP_INTERFACE_AppData.Confirmations.Count--;
+
+} /* End MCP_INTERFACE_DropPending */
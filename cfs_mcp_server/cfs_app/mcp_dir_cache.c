@@ -0,0 +1,207 @@
+/*
+** MCP Interface Directory Cache
+**
+** This file contains the cache of directory listings used to page
+** through GET_FILE_LIST results. A listing holds the names and types of
+** a directory's entries in readdir() order, so a cursor is simply an
+** index into it. Entry types come from d_type where the file system
+** provides it, so filling a listing costs no stat() calls.
+**
+** A listing is reused while the directory's modification time and inode
+** are unchanged. A directory modified within the current second may
+** still change without its time moving, so its listing is used for the
+** request that read it but not kept.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+#include <stdio.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+/*
+** Local function prototypes
+*/
+static boolean MCP_INTERFACE_FillDirListing(MCP_INTERFACE_DirListing_t *listing, const char *path);
+
+/*
+** Create the mutex guarding the cache
+*/
+int32 MCP_INTERFACE_InitDirCache(void)
+{
+    int32 status;
+
+    status = OS_MutSemCreate(&MCP_INTERFACE_AppData.DirCache.Mutex, MCP_DIR_CACHE_MUTEX_NAME, 0);
+    if (status != OS_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Error creating directory cache mutex, RC = 0x%08X\n",
+                           status);
+        return (status);
+    }
+
+    return (CFE_SUCCESS);
+
+} /* End MCP_INTERFACE_InitDirCache */
+
+/*
+** Get the current listing of a directory
+**
+** Returns the listing with the cache locked, to be released with
+** MCP_INTERFACE_UnlockDirListing, or NULL with the cache unlocked when
+** the directory cannot be read or does not fit in a cache slot.
+*/
+const MCP_INTERFACE_DirListing_t *MCP_INTERFACE_LockDirListing(const char *path)
+{
+    MCP_INTERFACE_DirCache_t *cache = &MCP_INTERFACE_AppData.DirCache;
+    MCP_INTERFACE_DirListing_t *listing = NULL;
+    MCP_INTERFACE_DirListing_t *victim = &cache->Listings[0];
+    struct stat dir_stat;
+    uint32 i;
+
+    if (stat(path, &dir_stat) != 0 || !S_ISDIR(dir_stat.st_mode))
+    {
+        return NULL;
+    }
+
+    OS_MutSemTake(cache->Mutex);
+    cache->UseCounter++;
+
+    for (i = 0; i < MCP_DIR_CACHE_COUNT; i++)
+    {
+        if (strcmp(cache->Listings[i].Path, path) == 0)
+        {
+            listing = &cache->Listings[i];
+            break;
+        }
+        if (cache->Listings[i].LastUsed < victim->LastUsed)
+        {
+            victim = &cache->Listings[i];
+        }
+    }
+
+    if (listing != NULL && listing->MTime == (uint32)dir_stat.st_mtime &&
+        listing->Inode == (uint32)dir_stat.st_ino)
+    {
+        listing->LastUsed = cache->UseCounter;
+        return listing;
+    }
+
+    /* Refill a stale listing in place, otherwise the least recently used */
+    if (listing == NULL)
+    {
+        listing = victim;
+    }
+
+    listing->Path[0] = '\0';
+    if (!MCP_INTERFACE_FillDirListing(listing, path))
+    {
+        OS_MutSemGive(cache->Mutex);
+        return NULL;
+    }
+
+    listing->MTime = (uint32)dir_stat.st_mtime;
+    listing->Inode = (uint32)dir_stat.st_ino;
+    listing->LastUsed = cache->UseCounter;
+    if (dir_stat.st_mtime < time(NULL))
+    {
+        strncpy(listing->Path, path, sizeof(listing->Path) - 1);
+        listing->Path[sizeof(listing->Path) - 1] = '\0';
+    }
+
+    return listing;
+
+} /* End MCP_INTERFACE_LockDirListing */
+
+/*
+** Release the cache locked by MCP_INTERFACE_LockDirListing
+*/
+void MCP_INTERFACE_UnlockDirListing(void)
+{
+    OS_MutSemGive(MCP_INTERFACE_AppData.DirCache.Mutex);
+
+} /* End MCP_INTERFACE_UnlockDirListing */
+
+/*
+** Type of a directory entry
+**
+** d_type answers without touching the inode. Symbolic links are
+** followed, and file systems that leave d_type unknown are asked with
+** stat().
+*/
+uint8 MCP_INTERFACE_DirEntryType(const char *directory, const char *name, uint8 d_type)
+{
+    char file_path[MCP_MAX_PATH_LEN];
+    struct stat file_stat;
+
+    if (d_type == DT_DIR)
+    {
+        return MCP_DIR_ENTRY_DIRECTORY;
+    }
+
+    if (d_type != DT_UNKNOWN && d_type != DT_LNK)
+    {
+        return MCP_DIR_ENTRY_FILE;
+    }
+
+    snprintf(file_path, sizeof(file_path), "%s/%s", directory, name);
+    if (stat(file_path, &file_stat) == 0 && S_ISDIR(file_stat.st_mode))
+    {
+        return MCP_DIR_ENTRY_DIRECTORY;
+    }
+
+    return MCP_DIR_ENTRY_FILE;
+
+} /* End MCP_INTERFACE_DirEntryType */
+
+/*
+** Read a directory into a listing
+**
+** Returns FALSE when the directory cannot be opened or has more entries
+** or longer names than the listing holds.
+*/
+static boolean MCP_INTERFACE_FillDirListing(MCP_INTERFACE_DirListing_t *listing, const char *path)
+{
+    DIR *dir;
+    struct dirent *entry;
+    uint32 used = 0;
+    uint32 length;
+    boolean fits = TRUE;
+
+    dir = opendir(path);
+    if (dir == NULL)
+    {
+        return FALSE;
+    }
+
+    listing->Count = 0;
+
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strcmp(entry->d_name, ".") == 0 || strcmp(entry->d_name, "..") == 0)
+        {
+            continue;
+        }
+
+        length = (uint32)strlen(entry->d_name) + 1;
+        if (listing->Count == MCP_DIR_CACHE_MAX_ENTRIES ||
+            used + length > MCP_DIR_CACHE_NAME_POOL_SIZE)
+        {
+            fits = FALSE;
+            break;
+        }
+
+        memcpy(&listing->Names[used], entry->d_name, length);
+        listing->NameOffset[listing->Count] = used;
+        listing->Type[listing->Count] = MCP_INTERFACE_DirEntryType(path, entry->d_name, entry->d_type);
+        listing->Count++;
+        used += length;
+    }
+
+    closedir(dir);
+
+    return fits;
+
+} /* End MCP_INTERFACE_FillDirListing */
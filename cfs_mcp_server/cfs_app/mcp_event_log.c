@@ -0,0 +1,163 @@
+/*
+** MCP Interface Event Log
+**
+** This file contains the ring of recent EVS events. Every event packet
+** EVS sends on the software bus is copied into the ring by the main
+** task, so event log requests read memory instead of asking EVS to
+** write its log to a file. Both sides run under the data mutex.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+
+/*
+** Local function prototypes
+*/
+static const char *MCP_INTERFACE_EventTypeName(uint16 event_type);
+
+/*
+** Subscribe to EVS event packets
+*/
+int32 MCP_INTERFACE_InitEventLog(void)
+{
+    int32 status;
+
+    MCP_INTERFACE_AppData.EventLog.NextSeq = 1;
+
+    status = CFE_SB_SubscribeEx(CFE_EVS_EVENT_MSG_MID,
+                                MCP_INTERFACE_AppData.CommandPipe,
+                                CFE_SB_Default_Qos,
+                                MCP_EVENT_MSG_LIMIT);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Error Subscribing to EVS events, RC = 0x%08X\n",
+                           status);
+        return (status);
+    }
+
+    return (CFE_SUCCESS);
+
+} /* End MCP_INTERFACE_InitEventLog */
+
+/*
+** Record an EVS event packet, replacing the oldest event when full
+*/
+void MCP_INTERFACE_RecordEvent(CFE_SB_MsgPtr_t msg)
+{
+    MCP_INTERFACE_EventLog_t *log = &MCP_INTERFACE_AppData.EventLog;
+    const CFE_EVS_Packet_t *packet = (const CFE_EVS_Packet_t *)msg;
+    MCP_INTERFACE_EventRecord_t *record;
+
+    if (CFE_SB_GetTotalMsgLength(msg) < sizeof(CFE_EVS_Packet_t))
+    {
+        return;
+    }
+
+    record = &log->Records[log->NextSeq % MCP_EVENT_LOG_DEPTH];
+    record->Seq = log->NextSeq++;
+    record->Seconds = CFE_SB_GetMsgTime(msg).Seconds;
+    record->EventId = packet->PacketID.EventID;
+    record->EventType = packet->PacketID.EventType;
+
+    /* Neither string is guaranteed to be terminated in the packet */
+    strncpy(record->AppName, packet->PacketID.AppName, sizeof(record->AppName) - 1);
+    record->AppName[sizeof(record->AppName) - 1] = '\0';
+    strncpy(record->Message, packet->Message, sizeof(record->Message) - 1);
+    record->Message[sizeof(record->Message) - 1] = '\0';
+
+} /* End MCP_INTERFACE_RecordEvent */
+
+/*
+** Write the events a query selects, oldest first
+**
+** The result has the selected events, first_seq (the oldest event still
+** in the ring), lost (how many events after since_seq were overwritten
+** before they could be fetched), next_seq (the since_seq of the next
+** fetch) and more. Events the filters reject still advance next_seq. A
+** since_seq ahead of the log, as after an app restart, reads from the
+** oldest event.
+*/
+void MCP_INTERFACE_WriteEventLog(MCP_JSON_Writer_t *json, const MCP_INTERFACE_EventQuery_t *query)
+{
+    const MCP_INTERFACE_EventLog_t *log = &MCP_INTERFACE_AppData.EventLog;
+    const MCP_INTERFACE_EventRecord_t *record;
+    MCP_JSON_Mark_t mark;
+    uint32 first_seq;
+    uint32 seq;
+    uint32 since = query->SinceSeq;
+    uint32 lost = 0;
+    uint32 count = 0;
+
+    first_seq = (log->NextSeq > MCP_EVENT_LOG_DEPTH) ? log->NextSeq - MCP_EVENT_LOG_DEPTH : 1;
+
+    if (since >= log->NextSeq)
+    {
+        since = 0;
+    }
+    if (since + 1 < first_seq)
+    {
+        lost = first_seq - since - 1;
+        since = first_seq - 1;
+    }
+
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_Key(json, "events");
+    MCP_JSON_BeginArray(json);
+
+    for (seq = since + 1; seq < log->NextSeq && count < query->Max; seq++)
+    {
+        record = &log->Records[seq % MCP_EVENT_LOG_DEPTH];
+
+        if (record->EventType < query->MinType ||
+            (query->AppName[0] != '\0' && strcmp(record->AppName, query->AppName) != 0))
+        {
+            continue;
+        }
+
+        mark = MCP_JSON_GetMark(json);
+
+        MCP_JSON_BeginObject(json);
+        MCP_JSON_KeyUint(json, "seq", record->Seq);
+        MCP_JSON_KeyUint(json, "time", record->Seconds);
+        MCP_JSON_KeyString(json, "app", record->AppName);
+        MCP_JSON_KeyUint(json, "event_id", record->EventId);
+        MCP_JSON_KeyString(json, "type", MCP_INTERFACE_EventTypeName(record->EventType));
+        MCP_JSON_KeyString(json, "message", record->Message);
+        MCP_JSON_EndObject(json);
+
+        /* Stop at the first event that would not leave room for the rest */
+        if (!MCP_JSON_Ok(json) || json->Length + MCP_EVENT_LOG_RESERVE > json->Size)
+        {
+            MCP_JSON_Rewind(json, &mark);
+            break;
+        }
+
+        count++;
+    }
+
+    MCP_JSON_EndArray(json);
+    MCP_JSON_KeyUint(json, "first_seq", first_seq);
+    MCP_JSON_KeyUint(json, "lost", lost);
+    MCP_JSON_KeyUint(json, "next_seq", seq - 1);
+    MCP_JSON_KeyBool(json, "more", seq < log->NextSeq);
+    MCP_JSON_EndObject(json);
+
+} /* End MCP_INTERFACE_WriteEventLog */
+
+/*
+** Name of an EVS event type
+*/
+static const char *MCP_INTERFACE_EventTypeName(uint16 event_type)
+{
+    switch (event_type)
+    {
+        case CFE_EVS_DEBUG:       return "DEBUG";
+        case CFE_EVS_INFORMATION: return "INFO";
+        case CFE_EVS_ERROR:       return "ERROR";
+        case CFE_EVS_CRITICAL:    return "CRITICAL";
+        default:                  return "UNKNOWN";
+    }
+
+} /* End MCP_INTERFACE_EventTypeName */
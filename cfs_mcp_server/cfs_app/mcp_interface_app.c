@@ -17,13 +17,33 @@
 */
 MCP_INTERFACE_AppData_t MCP_INTERFACE_AppData;
 
+/*
+** Request types, expanded from mcp_request_types.def
+*/
+#define MCP_REQUEST_TYPE(id, name, handler, flags) \
+    [MCP_CMD_##id] = { MCP_INTERFACE_##handler, #name, (flags) },
+const MCP_INTERFACE_RequestType_t MCP_INTERFACE_RequestTypes[MCP_CMD_MAX] = {
+#include "mcp_request_types.def"
+};
+#undef MCP_REQUEST_TYPE
+
+/*
+** Per-type metrics are kept for every type; the array size is negative,
+** failing the build, when the list outgrows them
+*/
+typedef char MCP_INTERFACE_MetricsCoverTypes_t[(MCP_CMD_MAX <= MCP_INTERFACE_METRICS_REQUEST_TYPES) ? 1 : -1];
+
+/*
+** Local function prototypes
+*/
+static int32 MCP_INTERFACE_CallHandler(MCP_Request_t *request, MCP_Response_t *response);
+
 /*
 ** Application entry point and main process loop
 */
 void MCP_INTERFACE_AppMain(void)
 {
     int32 status;
-    uint32 RunStatus = CFE_ES_APP_RUN;
 
     CFE_ES_PerfLogEntry(MCP_INTERFACE_APP_PERF_ID);
 
@@ -36,25 +56,25 @@ void MCP_INTERFACE_AppMain(void)
     /*
     ** Main process loop
     */
-    while (CFE_ES_RunLoop(&RunStatus) == TRUE)
+    while (CFE_ES_RunLoop(&MCP_INTERFACE_AppData.RunStatus) == TRUE)
     {
         CFE_ES_PerfLogExit(MCP_INTERFACE_APP_PERF_ID);
 
-        /* Pend on receipt of command packet */
+        /*
+        ** Pend on receipt of command packet. MCP clients are serviced
+        ** by the socket child task, so this loop only handles SB traffic.
+        */
         status = CFE_SB_RcvMsg(&MCP_INTERFACE_AppData.MsgPtr,
                                MCP_INTERFACE_AppData.CommandPipe,
-                               50); /* 50ms timeout for responsiveness */
+                               CFE_SB_PEND_FOREVER);
 
         CFE_ES_PerfLogEntry(MCP_INTERFACE_APP_PERF_ID);
 
         if (status == CFE_SUCCESS)
         {
+            OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
             MCP_INTERFACE_ProcessCommandPacket();
-        }
-        else if (status == CFE_SB_TIME_OUT)
-        {
-            /* Timeout - process MCP clients */
-            MCP_INTERFACE_ProcessMCPClients();
+            OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
         }
         else
         {
@@ -64,7 +84,7 @@ void MCP_INTERFACE_AppMain(void)
         }
     }
 
-    CFE_ES_ExitApp(RunStatus);
+    CFE_ES_ExitApp(MCP_INTERFACE_AppData.RunStatus);
 
 } /* End of MCP_INTERFACE_AppMain() */
 
@@ -88,12 +108,15 @@ int32 MCP_INTERFACE_AppInit(void)
     */
     MCP_INTERFACE_AppData.ActiveClients = 0;
     MCP_INTERFACE_AppData.DebugMode = FALSE;
+    MCP_INTERFACE_AppData.TraceLog.NextSeq = 1;
     MCP_INTERFACE_AppData.RequestCounter = 0;
     MCP_INTERFACE_AppData.SuccessCounter = 0;
     MCP_INTERFACE_AppData.ErrorCounter = 0;
     MCP_INTERFACE_AppData.SafetyMode = TRUE; /* Default to safe mode */
     MCP_INTERFACE_AppData.CriticalCommandCount = 0;
-    MCP_INTERFACE_AppData.LastCriticalCommandTime = 0;
+    MCP_INTERFACE_AppData.RequestQueue.Head = 0;
+    MCP_INTERFACE_AppData.RequestQueue.Count = 0;
+    memset(MCP_INTERFACE_AppData.OutputPool.InUse, 0, sizeof(MCP_INTERFACE_AppData.OutputPool.InUse));
 
     /*
     ** Initialize event filter table
@@ -163,6 +186,64 @@ int32 MCP_INTERFACE_AppInit(void)
         return (status);
     }
 
+    /*
+    ** Subscribe to EVS event packets for the event log
+    */
+    status = MCP_INTERFACE_InitEventLog();
+    if (status != CFE_SUCCESS)
+    {
+        return (status);
+    }
+
+    /*
+    ** Create the mutex shared by the main task and the socket task
+    */
+    status = OS_MutSemCreate(&MCP_INTERFACE_AppData.DataMutex,
+                             MCP_INTERFACE_DATA_MUTEX_NAME, 0);
+    if (status != OS_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Error creating data mutex, RC = 0x%08X\n",
+                           status);
+        return (status);
+    }
+
+    /*
+    ** Start the audit log before anything it records can happen
+    */
+    status = MCP_INTERFACE_StartAuditLog();
+    if (status != CFE_SUCCESS)
+    {
+        return (status);
+    }
+
+    /*
+    ** Load the command dictionary and safety rules before any request can arrive
+    */
+    status = MCP_INTERFACE_InitCmdDictionary();
+    if (status != CFE_SUCCESS)
+    {
+        return (status);
+    }
+
+    status = MCP_INTERFACE_InitSafetyRules();
+    if (status != CFE_SUCCESS)
+    {
+        return (status);
+    }
+
+    status = MCP_INTERFACE_InitDirCache();
+    if (status != CFE_SUCCESS)
+    {
+        return (status);
+    }
+
+    MCP_INTERFACE_InitResponseCache();
+    MCP_INTERFACE_InitSystemSnapshot();
+    MCP_INTERFACE_InitCmdAdmission();
+    MCP_INTERFACE_InitSequences();
+    MCP_INTERFACE_InitConfirmations();
+    MCP_INTERFACE_InitTlmShm();
+
     /*
     ** Initialize MCP socket server
     */
@@ -175,6 +256,30 @@ int32 MCP_INTERFACE_AppInit(void)
         return (status);
     }
 
+    /*
+    ** Start the workers before any request can be handed to them
+    */
+    status = MCP_INTERFACE_StartWorkers();
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_SOCKET_ERR_EID,
+                        CFE_EVS_ERROR,
+                        "MCP_INTERFACE: Failed to start worker pool, RC = 0x%08X", status);
+        return (status);
+    }
+
+    /*
+    ** Start the socket servicing child task
+    */
+    status = MCP_INTERFACE_StartSocketTask();
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_SOCKET_ERR_EID,
+                        CFE_EVS_ERROR,
+                        "MCP_INTERFACE: Failed to create socket task, RC = 0x%08X", status);
+        return (status);
+    }
+
     CFE_EVS_SendEvent(MCP_INTERFACE_STARTUP_INF_EID,
                      CFE_EVS_INFORMATION,
                      "MCP_INTERFACE App Initialized. Version %d.%d.%d.%d",
@@ -200,17 +305,29 @@ void MCP_INTERFACE_ProcessCommandPacket(void)
     {
         case MCP_INTERFACE_HK_REQ_MID:
             MCP_INTERFACE_ReportHousekeeping();
+            MCP_INTERFACE_UpdateSystemSnapshot();
+            MCP_INTERFACE_ExpireRateBuckets();
+            MCP_INTERFACE_ExpireConfirmations();
+            MCP_INTERFACE_ManageCmdDictionary();
+            MCP_INTERFACE_ManageSafetyRules();
             break;
 
         case MCP_INTERFACE_CMD_MID:
             MCP_INTERFACE_ProcessGroundCommand();
             break;
 
+        case CFE_EVS_EVENT_MSG_MID:
+            MCP_INTERFACE_RecordEvent(MCP_INTERFACE_AppData.MsgPtr);
+            break;
+
         default:
-            CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
-                            CFE_EVS_ERROR,
-                            "MCP_INTERFACE: invalid command packet,MID = 0x%x",
-                            MsgId);
+            if (!MCP_INTERFACE_CacheTelemetry(MCP_INTERFACE_AppData.MsgPtr))
+            {
+                CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                                CFE_EVS_ERROR,
+                                "MCP_INTERFACE: invalid command packet,MID = 0x%x",
+                                MsgId);
+            }
             break;
     }
 
@@ -227,6 +344,9 @@ void MCP_INTERFACE_ProcessGroundCommand(void)
 
     CommandCode = CFE_SB_GetCmdCode(MCP_INTERFACE_AppData.MsgPtr);
 
+    /* Any command may change what a cached result reports */
+    MCP_INTERFACE_FlushResponseCache();
+
     /* Process "known" commands */
     switch (CommandCode)
     {
@@ -276,6 +396,14 @@ void MCP_INTERFACE_ProcessGroundCommand(void)
             }
             break;
 
+        case MCP_INTERFACE_DUMP_TRACE_CC:
+            if (MCP_INTERFACE_VerifyCmdLength(MCP_INTERFACE_AppData.MsgPtr,
+                                            sizeof(MCP_INTERFACE_DumpTraceCmd_t)))
+            {
+                MCP_INTERFACE_ProcessDumpTrace((MCP_INTERFACE_DumpTraceCmd_t *)MCP_INTERFACE_AppData.MsgPtr);
+            }
+            break;
+
         /* default case already found during FC vs length test */
         default:
             CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
@@ -291,242 +419,173 @@ void MCP_INTERFACE_ProcessGroundCommand(void)
 } /* End of MCP_INTERFACE_ProcessGroundCommand() */
 
 /*
-** Initialize Unix Domain Socket for MCP communication
+** Handle MCP request
 */
-int32 MCP_INTERFACE_InitSocket(void)
+int32 MCP_INTERFACE_HandleMCPRequest(int32 client_slot, MCP_Request_t *request)
 {
-    struct sockaddr_un server_addr;
-    int32 result;
-    int32 i;
-
-    /* Initialize client sockets array */
-    for (i = 0; i < MCP_MAX_CLIENTS; i++)
-    {
-        MCP_INTERFACE_AppData.ClientSockets[i] = -1;
-    }
-
-    /* Create socket */
-    MCP_INTERFACE_AppData.ServerSocket = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (MCP_INTERFACE_AppData.ServerSocket < 0)
-    {
-        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to create socket\n");
-        return CFE_ES_ERR_APP_CREATE;
-    }
-
-    /* Remove any existing socket file */
-    unlink(MCP_INTERFACE_SOCKET_PATH);
-
-    /* Set up server address */
-    memset(&server_addr, 0, sizeof(server_addr));
-    server_addr.sun_family = AF_UNIX;
-    strncpy(server_addr.sun_path, MCP_INTERFACE_SOCKET_PATH, 
-            sizeof(server_addr.sun_path) - 1);
+    char *frame;
+    MCP_JSON_Writer_t json;
+    MCP_Response_t response;
+    int32 status;
 
-    /* Bind socket */
-    result = bind(MCP_INTERFACE_AppData.ServerSocket,
-                 (struct sockaddr *)&server_addr,
-                 sizeof(server_addr));
-    if (result < 0)
+    frame = MCP_INTERFACE_AcquireOutputBuffer();
+    if (frame == NULL)
     {
-        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to bind socket\n");
-        close(MCP_INTERFACE_AppData.ServerSocket);
-        return CFE_ES_ERR_APP_CREATE;
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: No output buffer for request %u", (unsigned int)request->id);
+        return CFE_ES_ERR_APPNAME;
     }
 
-    /* Listen for connections */
-    result = listen(MCP_INTERFACE_AppData.ServerSocket, MCP_MAX_CLIENTS);
-    if (result < 0)
-    {
-        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to listen on socket\n");
-        close(MCP_INTERFACE_AppData.ServerSocket);
-        unlink(MCP_INTERFACE_SOCKET_PATH);
-        return CFE_ES_ERR_APP_CREATE;
-    }
+    /* The response is written once, directly into the frame sent to the client */
+    MCP_INTERFACE_InitResponseWriter(&json, frame, client_slot);
+    MCP_INTERFACE_BeginJSONResponse(&response, &json, request->id);
+    MCP_INTERFACE_ProcessRequest(request, &response);
+    MCP_INTERFACE_EndJSONResponse(&response);
+    request->stage_us[MCP_TRACE_FORMATTED] = MCP_INTERFACE_MetricsNowUs();
 
-    /* Set socket to non-blocking */
-    fcntl(MCP_INTERFACE_AppData.ServerSocket, F_SETFL, O_NONBLOCK);
+    /* Send response */
+    status = MCP_INTERFACE_SendResponseStream(client_slot, &response);
+    MCP_INTERFACE_RecordTrace(request, &response);
 
-    CFE_EVS_SendEvent(MCP_INTERFACE_STARTUP_INF_EID,
-                     CFE_EVS_INFORMATION,
-                     "MCP_INTERFACE: Socket server initialized at %s",
-                     MCP_INTERFACE_SOCKET_PATH);
+    MCP_INTERFACE_ReleaseOutputBuffer(frame);
 
-    return CFE_SUCCESS;
+    return status;
 
-} /* End MCP_INTERFACE_InitSocket */
+} /* End MCP_INTERFACE_HandleMCPRequest */
 
 /*
-** Process MCP client connections and requests
+** Validate, safety check and execute a request into a started response
 */
-void MCP_INTERFACE_ProcessMCPClients(void)
+void MCP_INTERFACE_ProcessRequest(MCP_Request_t *request, MCP_Response_t *response)
 {
-    int32 new_client;
-    int32 i;
-    struct sockaddr_un client_addr;
-    socklen_t client_len = sizeof(client_addr);
-    char buffer[MCP_MAX_JSON_SIZE];
-    ssize_t bytes_received;
-    MCP_Request_t request;
-    MCP_Response_t response;
+    int32 result;
 
-    /* Accept new connections */
-    new_client = accept(MCP_INTERFACE_AppData.ServerSocket,
-                       (struct sockaddr *)&client_addr,
-                       &client_len);
-    
-    if (new_client >= 0)
+    if (!MCP_INTERFACE_AdmitRequest(request, response))
     {
-        /* Find empty slot for new client */
-        for (i = 0; i < MCP_MAX_CLIENTS; i++)
-        {
-            if (MCP_INTERFACE_AppData.ClientSockets[i] == -1)
-            {
-                MCP_INTERFACE_AppData.ClientSockets[i] = new_client;
-                MCP_INTERFACE_AppData.ActiveClients++;
-                
-                CFE_EVS_SendEvent(MCP_INTERFACE_CLIENT_CONNECT_INF_EID,
-                                CFE_EVS_INFORMATION,
-                                "MCP_INTERFACE: New client connected (slot %d)", i);
-                break;
-            }
-        }
-        
-        if (i >= MCP_MAX_CLIENTS)
-        {
-            /* No available slots - reject connection */
-            close(new_client);
-            CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
-                            CFE_EVS_ERROR,
-                            "MCP_INTERFACE: Maximum clients reached, connection rejected");
-        }
+        return;
     }
 
-    /* Process existing client requests */
-    for (i = 0; i < MCP_MAX_CLIENTS; i++)
-    {
-        if (MCP_INTERFACE_AppData.ClientSockets[i] != -1)
-        {
-            bytes_received = recv(MCP_INTERFACE_AppData.ClientSockets[i],
-                                buffer, sizeof(buffer) - 1, MSG_DONTWAIT);
-            
-            if (bytes_received > 0)
-            {
-                buffer[bytes_received] = '\0';
-                
-                /* Parse JSON request */
-                if (MCP_INTERFACE_ParseJSONRequest(buffer, &request) == CFE_SUCCESS)
-                {
-                    /* Handle the request */
-                    MCP_INTERFACE_HandleMCPRequest(MCP_INTERFACE_AppData.ClientSockets[i], &request);
-                }
-                else
-                {
-                    /* Send error response for invalid JSON */
-                    memset(&response, 0, sizeof(response));
-                    response.id = 0;
-                    response.status = -1;
-                    strncpy(response.error_msg, "Invalid JSON request", sizeof(response.error_msg) - 1);
-                    MCP_INTERFACE_SendMCPResponse(MCP_INTERFACE_AppData.ClientSockets[i], &response);
-                }
-            }
-            else if (bytes_received == 0 || (bytes_received < 0 && errno != EAGAIN && errno != EWOULDBLOCK))
-            {
-                /* Client disconnected or error */
-                close(MCP_INTERFACE_AppData.ClientSockets[i]);
-                MCP_INTERFACE_AppData.ClientSockets[i] = -1;
-                MCP_INTERFACE_AppData.ActiveClients--;
-                
-                CFE_EVS_SendEvent(MCP_INTERFACE_CLIENT_DISCONNECT_INF_EID,
-                                CFE_EVS_INFORMATION,
-                                "MCP_INTERFACE: Client disconnected (slot %d)", i);
-            }
-        }
-    }
+    result = MCP_INTERFACE_ExecuteRequest(request, response);
+    MCP_INTERFACE_CountResult(request, result, response);
 
-} /* End MCP_INTERFACE_ProcessMCPClients */
+} /* End MCP_INTERFACE_ProcessRequest */
 
 /*
-** Handle MCP request
+** Validate and safety check a request
+**
+** Called with the data mutex held. Returns FALSE with the error set in
+** the response when the request must not be executed.
 */
-int32 MCP_INTERFACE_HandleMCPRequest(int32 client_socket, MCP_Request_t *request)
+boolean MCP_INTERFACE_AdmitRequest(MCP_Request_t *request, MCP_Response_t *response)
 {
-    MCP_Response_t response;
-    int32 result = CFE_SUCCESS;
-
-    /* Initialize response */
-    memset(&response, 0, sizeof(response));
-    response.id = request->id;
-    response.timestamp = CFE_TIME_GetTime().Seconds;
+    int32 status;
+    boolean safe;
+    char event_msg[MCP_MAX_ERROR_MSG_LEN];
 
     /* Validate request */
-    if (MCP_INTERFACE_ValidateRequest(request) != CFE_SUCCESS)
+    status = MCP_INTERFACE_ValidateRequest(request);
+    request->stage_us[MCP_TRACE_VALIDATED] = MCP_INTERFACE_MetricsNowUs();
+    if (status != CFE_SUCCESS)
     {
-        response.status = -1;
-        strncpy(response.error_msg, "Invalid request parameters", sizeof(response.error_msg) - 1);
+        response->status = -1;
+        strncpy(response->error_msg, "Invalid request parameters", sizeof(response->error_msg) - 1);
         MCP_INTERFACE_AppData.ErrorCounter++;
-        return MCP_INTERFACE_SendMCPResponse(client_socket, &response);
+        MCP_INTERFACE_CountRequestType(request->type, FALSE);
+        return FALSE;
     }
 
-    /* Safety checks */
-    if (!MCP_INTERFACE_IsSafeCommand(request))
+    /* A prepared command is only sent once its token is confirmed */
+    if (request->prepare)
     {
-        response.status = -1;
-        strncpy(response.error_msg, "Command blocked by safety system", sizeof(response.error_msg) - 1);
-        MCP_INTERFACE_LogSafetyEvent("Unsafe command blocked", MCP_INTERFACE_SAFETY_ERR_EID);
-        MCP_INTERFACE_AppData.ErrorCounter++;
-        return MCP_INTERFACE_SendMCPResponse(client_socket, &response);
+        request->require_confirmation = TRUE;
     }
 
-    /* Process request based on type */
-    switch (request->type)
+    /* Safety checks */
+    safe = MCP_INTERFACE_IsSafeCommand(request);
+    request->stage_us[MCP_TRACE_SAFETY_CHECKED] = MCP_INTERFACE_MetricsNowUs();
+    if (!safe)
     {
-        case MCP_CMD_SEND_COMMAND:
-            result = MCP_INTERFACE_HandleSendCommand(request, &response);
-            break;
+        response->status = -1;
+        strncpy(response->error_msg, "Command blocked by safety system", sizeof(response->error_msg) - 1);
+        snprintf(event_msg, sizeof(event_msg), "Unsafe %s request %u blocked, app '%s' command '%s'",
+                MCP_INTERFACE_RequestTypes[request->type].Name, (unsigned int)request->id,
+                request->app_name, request->command);
+        MCP_INTERFACE_LogSafetyEvent(event_msg, MCP_INTERFACE_SAFETY_ERR_EID);
+        MCP_INTERFACE_AppData.ErrorCounter++;
+        MCP_INTERFACE_CountRequestType(request->type, FALSE);
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.SafetyBlocks, 1);
+        return FALSE;
+    }
 
-        case MCP_CMD_GET_TELEMETRY:
-            result = MCP_INTERFACE_HandleGetTelemetry(request, &response);
-            break;
+    return TRUE;
 
-        case MCP_CMD_GET_SYSTEM_STATUS:
-            result = MCP_INTERFACE_HandleGetSystemStatus(request, &response);
-            break;
+} /* End MCP_INTERFACE_AdmitRequest */
 
-        case MCP_CMD_MANAGE_APP:
-            result = MCP_INTERFACE_HandleManageApp(request, &response);
-            break;
+/*
+** Run the handler of an admitted request
+**
+** I/O bound requests run here on a worker task without the data mutex;
+** everything else is called with it held. Each handler is logged under
+** its own performance ID and its run time is recorded in the execution
+** latency histogram. Read-only requests repeated within their freshness
+** window are answered from the response cache instead.
+*/
+int32 MCP_INTERFACE_ExecuteRequest(MCP_Request_t *request, MCP_Response_t *response)
+{
+    int32 result = CFE_SUCCESS;
+    uint32 result_start;
+    uint32 perf_id = MCP_INTERFACE_HANDLER_PERF_ID + (uint32)request->type;
+    uint32 start_us;
 
-        case MCP_CMD_GET_FILE_LIST:
-            result = MCP_INTERFACE_HandleGetFileList(request, &response);
-            break;
+    CFE_ES_PerfLogEntry(perf_id);
+    start_us = MCP_INTERFACE_MetricsNowUs();
+    request->stage_us[MCP_TRACE_HANDLER_START] = start_us;
 
-        case MCP_CMD_READ_FILE:
-            result = MCP_INTERFACE_HandleReadFile(request, &response);
-            break;
+    if (!MCP_INTERFACE_ReplayResponse(request, response))
+    {
+        result_start = response->result->Length;
+        result = MCP_INTERFACE_CallHandler(request, response);
+        MCP_INTERFACE_StoreResponse(request, response, result, result_start);
+    }
 
-        case MCP_CMD_WRITE_FILE:
-            result = MCP_INTERFACE_HandleWriteFile(request, &response);
-            break;
+    request->stage_us[MCP_TRACE_HANDLER_END] = MCP_INTERFACE_MetricsNowUs();
+    MCP_INTERFACE_RecordLatency(MCP_INTERFACE_AppData.Metrics.ExecLatency,
+                                request->stage_us[MCP_TRACE_HANDLER_END] - start_us);
+    CFE_ES_PerfLogExit(perf_id);
 
-        case MCP_CMD_GET_EVENT_LOG:
-            result = MCP_INTERFACE_HandleGetEventLog(request, &response);
-            break;
+    return result;
 
-        case MCP_CMD_EMERGENCY_STOP:
-            result = MCP_INTERFACE_HandleEmergencyStop(request, &response);
-            break;
+} /* End MCP_INTERFACE_ExecuteRequest */
 
-        default:
-            response.status = -1;
-            snprintf(response.error_msg, sizeof(response.error_msg), 
-                    "Unknown command type: %d", request->type);
-            result = CFE_ES_ERR_APPNAME;
-            break;
+/*
+** Call the handler of a request type
+*/
+static int32 MCP_INTERFACE_CallHandler(MCP_Request_t *request, MCP_Response_t *response)
+{
+    if ((uint32)request->type >= MCP_CMD_MAX)
+    {
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg), 
+                "Unknown command type: %d", request->type);
+        return CFE_ES_ERR_APPNAME;
     }
 
-    /* Update counters */
+    return MCP_INTERFACE_RequestTypes[request->type].Handler(request, response);
+
+} /* End MCP_INTERFACE_CallHandler */
+
+/*
+** Update the request counters for an executed request
+**
+** Called with the data mutex held.
+*/
+void MCP_INTERFACE_CountResult(const MCP_Request_t *request, int32 result, const MCP_Response_t *response)
+{
+    boolean success = (result == CFE_SUCCESS && response->status == 0);
+
     MCP_INTERFACE_AppData.RequestCounter++;
-    if (result == CFE_SUCCESS && response.status == 0)
+    if (success)
     {
         MCP_INTERFACE_AppData.SuccessCounter++;
     }
@@ -535,10 +594,30 @@ int32 MCP_INTERFACE_HandleMCPRequest(int32 client_socket, MCP_Request_t *request
         MCP_INTERFACE_AppData.ErrorCounter++;
     }
 
-    /* Send response */
-    return MCP_INTERFACE_SendMCPResponse(client_socket, &response);
+    MCP_INTERFACE_CountRequestType(request->type, success);
 
-} /* End MCP_INTERFACE_HandleMCPRequest */
+} /* End MCP_INTERFACE_CountResult */
+
+/*
+** Identify request types whose handlers do blocking file system work
+** (a batch may contain such requests)
+*/
+boolean MCP_INTERFACE_IsSlowRequest(MCP_CommandType_t type)
+{
+    /* Unknown types are rejected on the socket task */
+    return ((uint32)type < MCP_CMD_MAX &&
+            (MCP_INTERFACE_RequestTypes[type].Flags & (MCP_REQ_IO_BOUND | MCP_REQ_SLOW)) != 0);
+
+} /* End MCP_INTERFACE_IsSlowRequest */
+
+/*
+** Requests that block on the file system and run on the worker pool
+*/
+boolean MCP_INTERFACE_IsIoBoundRequest(MCP_CommandType_t type)
+{
+    return ((uint32)type < MCP_CMD_MAX && (MCP_INTERFACE_RequestTypes[type].Flags & MCP_REQ_IO_BOUND) != 0);
+
+} /* End MCP_INTERFACE_IsIoBoundRequest */
 
 /*
 ** Report housekeeping telemetry
@@ -552,9 +631,11 @@ void MCP_INTERFACE_ReportHousekeeping(void)
     MCP_INTERFACE_AppData.HkTlm.RequestCounter = MCP_INTERFACE_AppData.RequestCounter;
     MCP_INTERFACE_AppData.HkTlm.SuccessCounter = MCP_INTERFACE_AppData.SuccessCounter;
     MCP_INTERFACE_AppData.HkTlm.ErrorCounter = MCP_INTERFACE_AppData.ErrorCounter;
+    MCP_INTERFACE_CopyMetrics(&MCP_INTERFACE_AppData.HkTlm.Metrics);
 
     CFE_SB_TimeStampMsg((CFE_SB_Msg_t *) &MCP_INTERFACE_AppData.HkTlm);
     CFE_SB_SendMsg((CFE_SB_Msg_t *) &MCP_INTERFACE_AppData.HkTlm);
+    MCP_INTERFACE_ShareHousekeeping();
 
 } /* End of MCP_INTERFACE_ReportHousekeeping() */
 
@@ -568,6 +649,7 @@ void MCP_INTERFACE_ResetCounters(void)
     MCP_INTERFACE_AppData.RequestCounter = 0;
     MCP_INTERFACE_AppData.SuccessCounter = 0;
     MCP_INTERFACE_AppData.ErrorCounter = 0;
+    MCP_INTERFACE_ResetMetrics();
 
     CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
                      CFE_EVS_INFORMATION,
@@ -575,6 +657,32 @@ void MCP_INTERFACE_ResetCounters(void)
 
 } /* End of MCP_INTERFACE_ResetCounters() */
 
+/*
+** Dump the request trace ring to the file a command names
+*/
+void MCP_INTERFACE_ProcessDumpTrace(const MCP_INTERFACE_DumpTraceCmd_t *cmd)
+{
+    char filename[OS_MAX_PATH_LEN];
+
+    /* The name is not guaranteed to be terminated in the packet */
+    strncpy(filename, cmd->Filename, sizeof(filename) - 1);
+    filename[sizeof(filename) - 1] = '\0';
+    if (filename[0] == '\0')
+    {
+        strncpy(filename, MCP_TRACE_DEFAULT_FILE, sizeof(filename) - 1);
+    }
+
+    if (MCP_INTERFACE_DumpTrace(filename) == CFE_SUCCESS)
+    {
+        MCP_INTERFACE_AppData.CmdCounter++;
+    }
+    else
+    {
+        MCP_INTERFACE_AppData.ErrCounter++;
+    }
+
+} /* End of MCP_INTERFACE_ProcessDumpTrace() */
+
 /*
 ** Verify command packet length
 */
@@ -19,9 +19,14 @@
 #include "cfe_sb.h"
 #include "cfe_es.h"
 
+#include "mcp_interface_version.h"
+#include "mcp_json_writer.h"
+
 #include <string.h>
 #include <errno.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <sys/epoll.h>
 #include <sys/socket.h>
 #include <sys/un.h>
 
@@ -29,14 +34,401 @@
 ** Application constants
 */
 #define MCP_INTERFACE_APP_NAME                "MCP_INTERFACE"
-#define MCP_INTERFACE_APP_PIPE_DEPTH          32
+#define MCP_INTERFACE_APP_PIPE_DEPTH          64
 #define MCP_INTERFACE_APP_PIPE_NAME           "MCP_INTERFACE_CMD_PIPE"
 
 #define MCP_INTERFACE_SOCKET_PATH             "/tmp/cfs_mcp.sock"
 #define MCP_MAX_JSON_SIZE                     4096
-#define MCP_MAX_CLIENTS                       4
 #define MCP_MAX_APP_NAME_LEN                  20
 #define MCP_MAX_CMD_NAME_LEN                  32
+#define MCP_MAX_BATCH_SIZE                    16
+#define MCP_MAX_ERROR_MSG_LEN                 (MCP_MAX_PATH_LEN + 64)    /* a path and the message around it */
+#define MCP_OUTPUT_BUFFER_COUNT               2
+
+/*
+** Socket servicing child task
+*/
+#define MCP_INTERFACE_SOCKET_TASK_NAME        "MCP_SOCKET_TASK"
+#define MCP_INTERFACE_SOCKET_TASK_STACK_SIZE  16384
+#define MCP_INTERFACE_SOCKET_TASK_PRIORITY    60
+#define MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS  1000
+#define MCP_INTERFACE_ACCEPT_BACKOFF_MS       250     /* server socket unwatched after accept() fails */
+#define MCP_INTERFACE_DATA_MUTEX_NAME         "MCP_DATA_MUTEX"
+#define MCP_REQUEST_QUEUE_DEPTH               8
+
+/*
+** Worker pool for I/O bound requests
+**
+** MCP_WORKER_JOB_COUNT bounds the requests in flight on the workers and
+** must be a power of two; a request arriving while every job is busy
+** runs on the socket task instead.
+*/
+#define MCP_WORKER_COUNT                      2
+#define MCP_WORKER_JOB_COUNT                  8
+#define MCP_WORKER_TASK_NAME                  "MCP_WORKER"
+#define MCP_WORKER_TASK_STACK_SIZE            16384
+#define MCP_WORKER_TASK_PRIORITY              70
+#define MCP_WORKER_SEM_NAME                   "MCP_WORKER_SEM"
+
+/*
+** Client capacity
+**
+** MCP_MAX_CLIENTS is set at build time by the MCP_MAX_CLIENTS CMake
+** cache variable, which mirrors max_clients in config/cfs_config.json.
+** The socket task waits on an epoll set, so a connected client costs
+** nothing until it becomes ready, and takes at most MCP_EPOLL_BATCH
+** ready descriptors per wakeup. Epoll data carries the client slot
+** and its generation, so an event for a connection that was closed
+** earlier in the same batch is never applied to the slot's next user.
+*/
+#ifndef MCP_MAX_CLIENTS
+#define MCP_MAX_CLIENTS                       16
+#endif
+#define MCP_EPOLL_BATCH                       16
+#define MCP_EPOLL_SERVER                      0xFFFFFFFFu
+#define MCP_EPOLL_WAKE                        0xFFFFFFFEu
+
+/*
+** Wire framing
+**
+** The framing of a connection is fixed by its first non-whitespace byte:
+** '{' selects JSON framing (one top-level object per message, optionally
+** newline separated), anything else selects a 4-byte big-endian length
+** prefix followed by the JSON document. Responses use the same framing.
+**
+** A connection that opens with the binary handshake (MCP_BINARY_MAGIC
+** then MCP_BINARY_VERSION) uses the binary encoding instead; the server
+** echoes the handshake to accept it. Binary requests are a little-endian
+** uint16 length, then uint8 type, uint8 flags, uint32 id, then TLV
+** fields (uint8 tag, uint16 length, value). Binary responses are a
+** little-endian uint16 length followed by the response encoded as CBOR
+** with the same keys as the JSON response.
+*/
+#define MCP_FRAMING_UNKNOWN                   0
+#define MCP_FRAMING_JSON                      1
+#define MCP_FRAMING_LENGTH_PREFIX             2
+#define MCP_FRAMING_BINARY                    3
+#define MCP_FRAME_HEADER_SIZE                 4
+#define MCP_MAX_FRAME_SIZE                    (4 * MCP_MAX_JSON_SIZE)
+#define MCP_CLIENT_RX_BUFFER_SIZE             (MCP_FRAME_HEADER_SIZE + MCP_MAX_FRAME_SIZE)
+#define MCP_RESPONSE_FRAME_SIZE               (MCP_FRAME_HEADER_SIZE + MCP_MAX_JSON_SIZE)
+
+/*
+** Per-client output queue
+**
+** Output a client socket cannot take right away is queued and flushed
+** once the socket becomes writable, so a slow client never holds up the
+** others. While MCP_CLIENT_TX_HIGH_WATER bytes or more are waiting, no
+** further requests are read from that client and no telemetry is pushed
+** to it. The space above the mark holds the responses to requests that
+** were already queued or on the worker pool when it was reached.
+*/
+#define MCP_CLIENT_TX_HIGH_WATER              (2 * MCP_RESPONSE_FRAME_SIZE)
+#define MCP_CLIENT_TX_BUFFER_SIZE             (MCP_CLIENT_TX_HIGH_WATER + \
+                                               (MCP_REQUEST_QUEUE_DEPTH + MCP_WORKER_JOB_COUNT + 1) * \
+                                               MCP_RESPONSE_FRAME_SIZE)
+
+/*
+** File reads
+**
+** READ_FILE returns one chunk of a file per request, at most
+** MCP_FILE_CHUNK_TEXT bytes as an escaped string or MCP_FILE_CHUNK_BASE64
+** bytes as base64 (a CBOR byte string on binary connections); the client
+** continues at offset + length until eof is set. A raw read answers with
+** the header alone and then streams "length" bytes, up to
+** MCP_FILE_CHUNK_RAW, unframed on the connection straight from the file.
+*/
+#define MCP_FILE_CHUNK_TEXT                   512
+#define MCP_FILE_CHUNK_BASE64                 2048
+#define MCP_FILE_CHUNK_RAW                    (16 * 1024 * 1024)
+#define MCP_MAX_PATH_LEN                      256
+
+/*
+** Directory listings
+**
+** GET_FILE_LIST returns a page of at most MCP_FILE_LIST_MAX_LIMIT
+** entries, fewer when the response frame fills, and the cursor the next
+** page starts at. The names and types of up to MCP_DIR_CACHE_COUNT
+** directories are kept until the directory's modification time
+** changes, so paging through a large directory reads it only once.
+** Directories with more entries or longer names than a cache slot holds
+** are read again for every page.
+*/
+#define MCP_FILE_LIST_DEFAULT_LIMIT           50
+#define MCP_FILE_LIST_MAX_LIMIT               500
+#define MCP_FILE_LIST_RESERVE                 96    /* frame space kept for the end of the response */
+#ifndef MCP_DIR_CACHE_COUNT
+#define MCP_DIR_CACHE_COUNT                   2
+#endif
+#define MCP_DIR_CACHE_MAX_ENTRIES             2048
+#define MCP_DIR_CACHE_NAME_POOL_SIZE          32768
+#define MCP_DIR_CACHE_MUTEX_NAME              "MCP_DIR_MUTEX"
+
+#define MCP_DIR_ENTRY_FILE                    0
+#define MCP_DIR_ENTRY_DIRECTORY               1
+
+#define MCP_BINARY_MAGIC                      "MCPB"
+#define MCP_BINARY_VERSION                    1
+#define MCP_BINARY_HANDSHAKE_SIZE             5
+#define MCP_BINARY_LENGTH_SIZE                2
+#define MCP_BINARY_HEADER_SIZE                6
+#define MCP_BINARY_FLAG_REQUIRE_CONFIRMATION  0x01
+#define MCP_BINARY_FLAG_IS_CRITICAL           0x02
+#define MCP_BINARY_FLAG_PREPARE               0x04
+#define MCP_BINARY_TAG_APP_NAME               1
+#define MCP_BINARY_TAG_COMMAND                2
+#define MCP_BINARY_TAG_PARAMS                 3
+
+/*
+** Command dictionary table
+**
+** Maps app and command names to the message ID and function code to
+** send. The lookup index is hashed, so MCP_CMD_HASH_SLOTS must be a
+** power of two comfortably larger than MCP_CMD_TBL_MAX_ENTRIES. Commands
+** with arguments give the size of their payload, which is sent after
+** the command header. Bits 8-10 of an entry's flags select its rate
+** class.
+*/
+#define MCP_CMD_TBL_NAME                      "CmdTbl"
+#define MCP_CMD_TBL_FILENAME                  "/cf/mcp_cmd_tbl.tbl"
+#define MCP_CMD_TBL_MAX_ENTRIES               128
+#define MCP_CMD_HASH_SLOTS                    256
+#define MCP_CMD_FLAG_CRITICAL                 0x01
+#define MCP_CMD_FLAG_CLASS_SHIFT              8
+#define MCP_CMD_FLAG_CLASS(n)                 ((n) << MCP_CMD_FLAG_CLASS_SHIFT)
+#define MCP_CMD_CLASS(flags)                  (((flags) >> MCP_CMD_FLAG_CLASS_SHIFT) & (MCP_RATE_CLASS_COUNT - 1))
+#define MCP_CMD_MAX_PAYLOAD_LEN               256
+
+/*
+** Command admission
+**
+** Commands are admitted through token buckets, one per app and rate
+** class. The command dictionary gives each class a burst size, the time
+** to refill one token and how long a command may wait for a token; a
+** class with a burst of 0 is not limited. Critical commands in class 0
+** use MCP_RATE_CLASS_CRITICAL instead. A command that finds its bucket
+** empty is queued if a token frees up within its class's wait and sent
+** by the socket task when it does; otherwise it is rejected with the
+** time after which it would be accepted. A queued command that cannot
+** be sent within MCP_CMD_QUEUE_LATE_MS of its due time is dropped, and
+** an emergency stop or a new command table drops every queued command.
+*/
+#define MCP_RATE_CLASS_COUNT                  8     /* power of two */
+#define MCP_RATE_CLASS_CRITICAL               1
+#define MCP_RATE_BUCKETS                      32
+#define MCP_CMD_QUEUE_DEPTH                   16
+#define MCP_CMD_QUEUE_LATE_MS                 500
+#define MCP_ADMIT_SEND                        0
+#define MCP_ADMIT_QUEUED                      1
+#define MCP_ADMIT_REJECTED                    2
+#define MCP_ADMIT_FAILED                      3
+
+/*
+** Confirmation tokens
+**
+** A send_command request marked prepare is validated, safety checked
+** as if confirmed and resolved to its packet, which is built and held
+** in one of MCP_CONFIRM_SLOTS pending slots instead of being sent. The
+** response carries a token; a confirm request with that token within
+** MCP_CONFIRM_TTL_MS admits the held packet and sends it, without the
+** command being sent, parsed or checked again. Unused tokens expire on
+** the next housekeeping request after their time is up, and an
+** emergency stop or a new command table drops them all.
+*/
+#define MCP_CONFIRM_SLOTS                     8
+#define MCP_CONFIRM_TTL_MS                    30000
+#define MCP_CONFIRM_TOKEN_LEN                 8     /* hex digits */
+
+/*
+** Audit log
+**
+** Every command sent, safety block, confirmation and emergency stop is
+** appended as a line of text to MCP_AUDIT_LOG_FILE. Entries go into one
+** half of a double buffer without touching the file system; a low
+** priority child task swaps the halves when one is half full or every
+** MCP_AUDIT_FLUSH_MS, writes the full half in one batch and syncs the
+** file at most every MCP_AUDIT_SYNC_MS. A file that reaches
+** MCP_AUDIT_LOG_MAX_SIZE is renamed to MCP_AUDIT_LOG_OLD_FILE and a new
+** one started. Entries that find their half full are dropped and
+** counted rather than held up.
+*/
+#ifndef MCP_AUDIT_LOG_FILE
+#define MCP_AUDIT_LOG_FILE                    "/cf/mcp_audit.log"
+#endif
+#define MCP_AUDIT_LOG_OLD_FILE                MCP_AUDIT_LOG_FILE ".1"
+#define MCP_AUDIT_LOG_MAX_SIZE                (512 * 1024)
+#define MCP_AUDIT_BUFFER_SIZE                 16384     /* bytes per half */
+#define MCP_AUDIT_LINE_MAX                    768
+#define MCP_AUDIT_FLUSH_MS                    1000
+#define MCP_AUDIT_SYNC_MS                     2000
+#define MCP_AUDIT_TASK_NAME                   "MCP_AUDIT"
+#define MCP_AUDIT_TASK_STACK_SIZE             16384
+#define MCP_AUDIT_TASK_PRIORITY               120
+#define MCP_AUDIT_MUTEX_NAME                  "MCP_AUDIT_MUTEX"
+#define MCP_AUDIT_SEM_NAME                    "MCP_AUDIT_SEM"
+
+/*
+** Sequences
+**
+** A run_sequence request hands the app a list of dictionary commands
+** that the socket task sends in order, so the timing of a procedure no
+** longer depends on round trips to the agent. Each step waits for its
+** time tag, delay_ms after the previous step or an absolute CFE time,
+** and may be gated on a field of a cached telemetry packet: a step
+** without a timeout is skipped when its condition is false, one with a
+** timeout waits for the condition and aborts the sequence if it does
+** not hold in time. Steps pass the safety checks when the sequence is
+** started and command admission when they are sent. Progress is pushed
+** to the connection that started the sequence. An emergency stop or a
+** new command table aborts every sequence.
+*/
+#define MCP_SEQUENCE_MAX                      4
+#define MCP_SEQUENCE_MAX_STEPS                16
+#define MCP_SEQUENCE_MAX_PAYLOAD_LEN          64        /* bytes per step */
+#define MCP_SEQUENCE_MAX_WAIT_MS              86400000  /* longest time tag or condition timeout */
+
+#define MCP_SEQUENCE_OP_NONE                  0         /* step has no condition */
+#define MCP_SEQUENCE_OP_LT                    1
+#define MCP_SEQUENCE_OP_LE                    2
+#define MCP_SEQUENCE_OP_EQ                    3
+#define MCP_SEQUENCE_OP_NE                    4
+#define MCP_SEQUENCE_OP_GE                    5
+#define MCP_SEQUENCE_OP_GT                    6
+
+/*
+** Telemetry cache
+**
+** The command dictionary also lists the housekeeping telemetry of its
+** apps. The app subscribes to those message IDs and keeps the latest
+** packet of each, so telemetry requests are answered from memory.
+** Longer packets are truncated to MCP_TLM_CACHE_MAX_PKT_LEN.
+*/
+#define MCP_TLM_CACHE_MAX_ENTRIES             32
+#define MCP_TLM_CACHE_MAX_PKT_LEN             512
+
+/*
+** Telemetry push subscriptions
+**
+** A client subscription selects cache slots with one bit each, so
+** MCP_TLM_CACHE_MAX_ENTRIES must not exceed 32. Updates held back by
+** the rate limit or by a client that is not ready for more are
+** coalesced, and only the latest packet is sent once they are due.
+*/
+#define MCP_TLM_PUSH_MAX_HZ                   50
+
+/*
+** Telemetry shared memory
+**
+** Built with the MCP_TLM_SHM_NAME CMake cache variable set, the main
+** task also publishes the app's own housekeeping packet and every
+** cached packet into a POSIX shared memory region of that name, so
+** co-located readers can poll telemetry without a request. Record 0
+** holds the app's housekeeping packet under the name MCP_INTERFACE and
+** record 1 + i cache slot i. Every record starts on its own cache line
+** and is guarded by a count that is odd while the record is written:
+** a reader copies the record between two reads of the count and
+** retries if they differ or are odd. The region header gives the
+** record offset, stride and count, and its magic is written last.
+*/
+#define MCP_TLM_SHM_MAGIC                     0x4D435054u   /* "MCPT" */
+#define MCP_TLM_SHM_VERSION                   1
+#define MCP_TLM_SHM_LINE_SIZE                 64
+#define MCP_TLM_SHM_RECORDS                   (1 + MCP_TLM_CACHE_MAX_ENTRIES)
+
+/*
+** Event log
+**
+** The app subscribes to EVS event packets and keeps the latest
+** MCP_EVENT_LOG_DEPTH events in a ring, each numbered with a sequence
+** number that starts at 1 and never repeats while the app runs, so a
+** client can fetch only the events after the last one it saw. At most
+** MCP_EVENT_MSG_LIMIT event packets wait on the app pipe at a time, so
+** an event storm cannot crowd out commands.
+*/
+#define MCP_EVENT_LOG_DEPTH                   128   /* power of two */
+#define MCP_EVENT_MSG_LIMIT                   32
+#define MCP_EVENT_LOG_DEFAULT_MAX             32
+#define MCP_EVENT_LOG_RESERVE                 96    /* frame space kept for the end of the response */
+
+/*
+** Request trace
+**
+** Every request leaves a record in a ring of the latest MCP_TRACE_DEPTH
+** requests, holding the time it reached each stage of the request path
+** in MCP_INTERFACE_MetricsNowUs microseconds, or 0 for stages it never
+** reached. In debug mode a record also keeps the start of the response.
+** The ring can be fetched with GET_TRACE or dumped to a file with the
+** MCP_INTERFACE_DUMP_TRACE_CC ground command.
+*/
+#define MCP_TRACE_DEPTH                       256   /* power of two */
+#define MCP_TRACE_SNIPPET_LEN                 48
+#define MCP_TRACE_DEFAULT_MAX                 16
+#define MCP_TRACE_RESERVE                     64    /* frame space kept for the end of the response */
+#define MCP_TRACE_DEFAULT_FILE                "/ram/mcp_trace.dat"
+#define MCP_TRACE_FILE_SUBTYPE                0x4D435054    /* 'MCPT' */
+
+#define MCP_TRACE_ACCEPTED                    0     /* connection accepted */
+#define MCP_TRACE_RECEIVED                    1     /* last bytes of the request read */
+#define MCP_TRACE_PARSED                      2
+#define MCP_TRACE_VALIDATED                   3
+#define MCP_TRACE_SAFETY_CHECKED              4
+#define MCP_TRACE_HANDLER_START               5
+#define MCP_TRACE_HANDLER_END                 6
+#define MCP_TRACE_FORMATTED                   7
+#define MCP_TRACE_SENT                        8     /* handed to the socket */
+#define MCP_TRACE_STAGE_COUNT                 9
+
+/*
+** Response cache
+**
+** Read-only requests keep their encoded result for a freshness window
+** set per request type, and a repeat request with the same type, app
+** name and params within it is answered with a copy of that result.
+** A telemetry result is dropped as soon as a new packet for its app
+** arrives, and status results when CFE_ES housekeeping arrives; a new
+** command table, a ground command or an emergency stop drops them all.
+*/
+#define MCP_RESPONSE_CACHE_ENTRIES            16
+#define MCP_RESPONSE_CACHE_RESULT_SIZE        1536
+#define MCP_RESPONSE_CACHE_PARAMS_LEN         32
+#define MCP_RESPONSE_CACHE_TLM_TTL_MS         1000
+#define MCP_RESPONSE_CACHE_STATUS_TTL_MS      1000
+#define MCP_RESPONSE_CACHE_NO_SLOT            0xFF
+
+/*
+** System snapshot
+**
+** Every housekeeping request the main task samples the next
+** MCP_SNAPSHOT_APPS_PER_PASS app IDs through ES, covering all
+** MCP_SNAPSHOT_MAX_APPS IDs in turn, and the OS heap. get_system_status
+** is answered from these samples without calling ES. An app's execution
+** rate is its counter change between its last two samples.
+*/
+#define MCP_SNAPSHOT_MAX_APPS                 32    /* CFE_ES_MAX_APPLICATIONS */
+#define MCP_SNAPSHOT_APPS_PER_PASS            16
+#define MCP_SNAPSHOT_RESERVE                  64    /* frame space kept for the end of the response */
+
+/*
+** Safety rule table
+**
+** Rules are compiled into a single case-insensitive Aho-Corasick
+** automaton when the table is loaded. Command and path rules match
+** anywhere in their field, app rules match the whole app name, and
+** action rules match anywhere in app management params.
+*/
+#define MCP_SAFETY_TBL_NAME                   "SafetyTbl"
+#define MCP_SAFETY_TBL_FILENAME               "/cf/mcp_safety_tbl.tbl"
+#define MCP_SAFETY_TBL_MAX_RULES              32
+#define MCP_SAFETY_PATTERN_LEN                16
+#define MCP_SAFETY_MAX_STATES                 256
+#define MCP_SAFETY_MAX_CLASSES                48
+
+#define MCP_SAFETY_RULE_NONE                  0
+#define MCP_SAFETY_RULE_COMMAND               1
+#define MCP_SAFETY_RULE_APP                   2
+#define MCP_SAFETY_RULE_PATH                  3
+#define MCP_SAFETY_RULE_ACTION                4
+#define MCP_SAFETY_MATCH(kind)                ((uint8)(1 << ((kind) - 1)))
 
 /*
 ** Event message IDs
@@ -49,6 +441,10 @@
 #define MCP_INTERFACE_COMMAND_SUCCESS_INF_EID 6
 #define MCP_INTERFACE_TELEMETRY_INF_EID       7
 #define MCP_INTERFACE_SAFETY_ERR_EID          8
+#define MCP_INTERFACE_TABLE_ERR_EID           9
+#define MCP_INTERFACE_TABLE_INF_EID           10
+#define MCP_INTERFACE_TELEMETRY_ERR_EID       11
+#define MCP_INTERFACE_AUDIT_ERR_EID           12
 
 /*
 ** Command Codes
@@ -57,22 +453,142 @@
 #define MCP_INTERFACE_RESET_COUNTERS_CC       1
 #define MCP_INTERFACE_ENABLE_DEBUG_CC         2
 #define MCP_INTERFACE_DISABLE_DEBUG_CC        3
+#define MCP_INTERFACE_DUMP_TRACE_CC           4
 
 /*
-** MCP Command Types
+** MCP Command Types, one per entry of mcp_request_types.def
 */
+#define MCP_REQUEST_TYPE(id, name, handler, flags) MCP_CMD_##id,
 typedef enum {
-    MCP_CMD_SEND_COMMAND = 0,
-    MCP_CMD_GET_TELEMETRY,
-    MCP_CMD_GET_SYSTEM_STATUS,
-    MCP_CMD_MANAGE_APP,
-    MCP_CMD_GET_FILE_LIST,
-    MCP_CMD_READ_FILE,
-    MCP_CMD_WRITE_FILE,
-    MCP_CMD_GET_EVENT_LOG,
-    MCP_CMD_EMERGENCY_STOP,
+#include "mcp_request_types.def"
     MCP_CMD_MAX
 } MCP_CommandType_t;
+#undef MCP_REQUEST_TYPE
+
+/*
+** Request type flags
+**
+** NEEDS_APP, NEEDS_COMMAND and NEEDS_PARAMS reject a request without an
+** app name, a command name or params; PREPARABLE types may be prepared
+** for a confirmation token. IO_BOUND types block on the file system and
+** run on the worker pool; SLOW types may contain such requests.
+*/
+#define MCP_REQ_NEEDS_APP                     0x01
+#define MCP_REQ_NEEDS_COMMAND                 0x02
+#define MCP_REQ_NEEDS_PARAMS                  0x04
+#define MCP_REQ_PREPARABLE                    0x08
+#define MCP_REQ_IO_BOUND                      0x10
+#define MCP_REQ_SLOW                          0x20
+
+/*
+** Command dictionary table; entries with an empty AppName are unused
+*/
+typedef struct {
+    char AppName[MCP_MAX_APP_NAME_LEN];
+    char CommandName[MCP_MAX_CMD_NAME_LEN];
+    uint16 MsgId;
+    uint16 CommandCode;
+    uint16 Flags;
+    uint16 PayloadLength;
+} MCP_INTERFACE_CmdEntry_t;
+
+/*
+** Housekeeping telemetry to cache; entries with an empty AppName are unused
+*/
+typedef struct {
+    char AppName[MCP_MAX_APP_NAME_LEN];
+    uint16 MsgId;
+    uint16 Spare;
+} MCP_INTERFACE_TlmEntry_t;
+
+/*
+** Admission rate of a command class; a Burst of 0 is not limited
+*/
+typedef struct {
+    uint16 Burst;
+    uint16 RefillMs;                /* time to refill one token */
+    uint16 MaxWaitMs;               /* longest a command is queued for a token */
+    uint16 Spare;
+} MCP_INTERFACE_RateClass_t;
+
+typedef struct {
+    MCP_INTERFACE_CmdEntry_t Entries[MCP_CMD_TBL_MAX_ENTRIES];
+    MCP_INTERFACE_TlmEntry_t Telemetry[MCP_TLM_CACHE_MAX_ENTRIES];
+    MCP_INTERFACE_RateClass_t RateClasses[MCP_RATE_CLASS_COUNT];
+} MCP_INTERFACE_CmdTbl_t;
+
+/*
+** Latest packet received for a cached telemetry message ID; Count is 0
+** until the first packet arrives and MsgId is 0 for an unused slot
+*/
+typedef struct {
+    char AppName[MCP_MAX_APP_NAME_LEN];
+    CFE_SB_MsgId_t MsgId;
+    uint16 Length;
+    uint16 TotalLength;
+    uint16 Spare;
+    uint32 Count;
+    uint32 DataHash;                /* FNV-1a of the packet after its telemetry header */
+    CFE_TIME_SysTime_t Received;
+    uint8 Packet[MCP_TLM_CACHE_MAX_PKT_LEN];
+} MCP_INTERFACE_TlmSnapshot_t;
+
+/*
+** Header of the telemetry shared memory region
+*/
+typedef struct {
+    uint32 Magic;
+    uint32 Version;
+    uint32 Size;                    /* of the whole region */
+    uint32 RecordOffset;            /* of record 0 */
+    uint32 RecordStride;
+    uint32 RecordCount;
+    uint32 PacketSize;              /* room for a packet in a record */
+    uint32 Spare;
+} MCP_INTERFACE_TlmShmHeader_t;
+
+/*
+** Telemetry record in the shared memory region; MsgId is 0 for an
+** unused record and Count is 0 until its first packet is published
+*/
+typedef struct {
+    uint32 Seq;                     /* odd while the record is written */
+    char AppName[MCP_MAX_APP_NAME_LEN];
+    uint16 MsgId;
+    uint16 Length;
+    uint16 TotalLength;
+    uint16 Spare;
+    uint32 Count;
+    uint32 DataHash;
+    uint32 Seconds;
+    uint32 Subseconds;
+    uint8 Packet[MCP_TLM_CACHE_MAX_PKT_LEN];
+} MCP_INTERFACE_TlmShmRecord_t;
+
+/*
+** Safety rule table; rules with kind MCP_SAFETY_RULE_NONE are unused
+*/
+typedef struct {
+    char Pattern[MCP_SAFETY_PATTERN_LEN];
+    uint8 Kind;
+    uint8 Spare[3];
+} MCP_INTERFACE_SafetyRule_t;
+
+typedef struct {
+    MCP_INTERFACE_SafetyRule_t Rules[MCP_SAFETY_TBL_MAX_RULES];
+} MCP_INTERFACE_SafetyTbl_t;
+
+/*
+** Compiled safety matcher: a full transition table over character
+** classes, with the rule kinds recognized on entering each state
+*/
+typedef struct {
+    uint8 ClassMap[256];
+    uint16 Next[MCP_SAFETY_MAX_STATES][MCP_SAFETY_MAX_CLASSES];
+    uint8 Output[MCP_SAFETY_MAX_STATES];
+    uint16 StateCount;
+    uint16 ClassCount;
+} MCP_INTERFACE_SafetyMatcher_t;
 
 /*
 ** MCP Request/Response structures
@@ -82,19 +598,386 @@ typedef struct {
     MCP_CommandType_t type;
     char app_name[MCP_MAX_APP_NAME_LEN];
     char command[MCP_MAX_CMD_NAME_LEN];
-    char params[MCP_MAX_JSON_SIZE];
+    char *params;                   /* NUL terminated, decoded in place in the receive buffer */
+    uint32 params_len;
     boolean require_confirmation;
     boolean is_critical;
+    boolean prepare;                /* hold the command for a confirm request instead of sending it */
+    int32 client_slot;              /* connection the request arrived on */
+    uint32 stage_us[MCP_TRACE_STAGE_COUNT];    /* when the request reached each trace stage */
 } MCP_Request_t;
 
 typedef struct {
     uint32 id;
     int32 status;
-    char result[MCP_MAX_JSON_SIZE];
-    char error_msg[256];
+    MCP_JSON_Writer_t *result;      /* handlers write the result value here */
+    MCP_JSON_Mark_t result_mark;    /* where "result" starts, for error rewind */
+    char error_msg[MCP_MAX_ERROR_MSG_LEN];
     uint32 timestamp;
+    int32 stream_fd;                /* file streamed after the response, or -1 */
+    uint32 stream_offset;
+    uint32 stream_length;
 } MCP_Response_t;
 
+/*
+** Request type table entry, indexed by type
+*/
+typedef struct {
+    int32 (*Handler)(MCP_Request_t *request, MCP_Response_t *response);
+    const char *Name;
+    uint32 Flags;
+} MCP_INTERFACE_RequestType_t;
+
+/*
+** Telemetry push subscription of a client; bit i of AppMask selects
+** telemetry cache slot i
+*/
+typedef struct {
+    uint32 Id;                      /* subscribe request id, echoed in every update */
+    uint32 AppMask;
+    uint32 MinIntervalMs;           /* 0 sends every packet */
+    boolean OnChange;
+    uint32 SentCount[MCP_TLM_CACHE_MAX_ENTRIES];
+    uint32 SentTimeMs[MCP_TLM_CACHE_MAX_ENTRIES];
+    uint32 SentHash[MCP_TLM_CACHE_MAX_ENTRIES];
+} MCP_INTERFACE_TlmSubscription_t;
+
+/*
+** Event recorded from an EVS event packet
+*/
+typedef struct {
+    uint32 Seq;
+    uint32 Seconds;                 /* packet time */
+    uint16 EventId;
+    uint16 EventType;               /* CFE_EVS_DEBUG .. CFE_EVS_CRITICAL */
+    char AppName[OS_MAX_API_NAME];
+    char Message[CFE_EVS_MAX_MESSAGE_LENGTH];
+} MCP_INTERFACE_EventRecord_t;
+
+/*
+** Event ring; event n is in Records[n % MCP_EVENT_LOG_DEPTH]
+*/
+typedef struct {
+    MCP_INTERFACE_EventRecord_t Records[MCP_EVENT_LOG_DEPTH];
+    uint32 NextSeq;
+} MCP_INTERFACE_EventLog_t;
+
+/*
+** Trace of one request
+*/
+typedef struct {
+    uint32 Seq;
+    uint32 RequestId;
+    uint32 StageUs[MCP_TRACE_STAGE_COUNT];
+    uint32 ResponseLength;
+    uint16 ClientSlot;
+    uint8 Type;
+    int8 Status;
+    char Snippet[MCP_TRACE_SNIPPET_LEN];    /* start of the response, in debug mode */
+} MCP_INTERFACE_TraceRecord_t;
+
+/*
+** Trace ring; request n is in Records[n % MCP_TRACE_DEPTH]
+*/
+typedef struct {
+    MCP_INTERFACE_TraceRecord_t Records[MCP_TRACE_DEPTH];
+    uint32 NextSeq;
+} MCP_INTERFACE_TraceLog_t;
+
+/*
+** Encoded result of a read-only request; Type is MCP_CMD_MAX when unused
+*/
+typedef struct {
+    uint8 Type;
+    uint8 Format;                   /* MCP_JSON_FORMAT_TEXT or MCP_JSON_FORMAT_CBOR */
+    uint8 TlmSlot;                  /* cache slot whose update drops the result */
+    uint8 ParamsLen;
+    char AppName[MCP_MAX_APP_NAME_LEN];
+    char Params[MCP_RESPONSE_CACHE_PARAMS_LEN];
+    uint32 StoredUs;
+    uint32 TtlUs;
+    uint32 Length;
+    char Result[MCP_RESPONSE_CACHE_RESULT_SIZE];
+} MCP_INTERFACE_CachedResponse_t;
+
+typedef struct {
+    MCP_INTERFACE_CachedResponse_t Entries[MCP_RESPONSE_CACHE_ENTRIES];
+} MCP_INTERFACE_ResponseCache_t;
+
+/*
+** Token bucket of one app and rate class, kept as the time it is full
+** again; AppName is empty for an unused bucket
+*/
+typedef struct {
+    char AppName[MCP_MAX_APP_NAME_LEN];
+    uint32 Class;
+    uint32 FullMs;
+} MCP_INTERFACE_RateBucket_t;
+
+/*
+** Command waiting for a rate token; Entry is NULL for an unused slot
+*/
+typedef struct {
+    const MCP_INTERFACE_CmdEntry_t *Entry;
+    uint32 RequestId;
+    uint32 DueMs;
+    uint16 Bucket;
+    uint16 PayloadLen;              /* hex digits */
+    boolean Critical;
+    char Payload[2 * MCP_CMD_MAX_PAYLOAD_LEN];
+} MCP_INTERFACE_QueuedCmd_t;
+
+typedef struct {
+    MCP_INTERFACE_RateBucket_t Buckets[MCP_RATE_BUCKETS];
+    MCP_INTERFACE_QueuedCmd_t Queue[MCP_CMD_QUEUE_DEPTH];
+    uint32 Queued;
+} MCP_INTERFACE_CmdAdmission_t;
+
+/*
+** Outcome of admitting a command
+*/
+typedef struct {
+    uint32 Position;                /* in the queue of its bucket, 0 when sent at once */
+    uint32 WaitMs;                  /* until it is sent, or until a retry is accepted */
+    int32 Status;                   /* of a failed send */
+} MCP_INTERFACE_Admission_t;
+
+/*
+** Command prepared for confirmation, its packet built and held in a
+** zero copy buffer; Token is 0 for an unused slot
+*/
+typedef struct {
+    uint32 Token;
+    uint32 RequestId;               /* of the prepare request */
+    uint32 ExpiresUs;               /* MCP_INTERFACE_MetricsNowUs time */
+    const MCP_INTERFACE_CmdEntry_t *Entry;
+    CFE_SB_Msg_t *Msg;
+    CFE_SB_ZeroCopyHandle_t Handle;
+    boolean Critical;
+    uint16 PayloadLen;              /* hex digits, kept in case the command has to be queued */
+    char Payload[2 * MCP_CMD_MAX_PAYLOAD_LEN];
+} MCP_INTERFACE_PendingCmd_t;
+
+typedef struct {
+    MCP_INTERFACE_PendingCmd_t Pending[MCP_CONFIRM_SLOTS];
+    uint32 Count;
+    uint32 Issued;                  /* tokens handed out, mixed into the next token */
+} MCP_INTERFACE_Confirmations_t;
+
+/*
+** Audit log buffers and file
+**
+** Entries are appended to Buffers[Filling] under the mutex; the other
+** half and the file belong to the audit task, which swaps the halves
+** under the mutex once it has written its own.
+*/
+typedef struct {
+    char Buffers[2][MCP_AUDIT_BUFFER_SIZE];
+    uint32 Used[2];
+    uint32 Filling;
+    boolean WakeGiven;              /* the task has been woken for the filling half */
+    uint32 Mutex;
+    uint32 SemId;
+    uint32 TaskId;
+    int32 Fd;                       /* -1 while the file is not open */
+    uint32 FileSize;
+    boolean Unsynced;               /* written since the last sync */
+    uint32 LastSyncUs;              /* MCP_INTERFACE_MetricsNowUs time */
+    boolean OpenFailed;             /* reported, so not reported again until it opens */
+} MCP_INTERFACE_AuditLog_t;
+
+/*
+** Step of a sequence; Op is MCP_SEQUENCE_OP_NONE for a step without a
+** condition
+*/
+typedef struct {
+    const MCP_INTERFACE_CmdEntry_t *Entry;
+    uint32 DelayMs;                 /* after the previous step, unless AtSeconds is set */
+    uint32 AtSeconds;               /* CFE time to send at, 0 for none */
+    uint32 TimeoutMs;               /* how long the condition is waited for, 0 skips the step instead */
+    uint32 Value;
+    uint16 Offset;                  /* of the field in the telemetry packet */
+    uint8 Size;                     /* 1, 2 or 4 bytes in host byte order, compared unsigned */
+    uint8 Op;
+    uint8 TlmSlot;
+    uint8 Spare;
+    uint16 PayloadLen;              /* hex digits */
+    char Payload[2 * MCP_SEQUENCE_MAX_PAYLOAD_LEN];
+} MCP_INTERFACE_SequenceStep_t;
+
+/*
+** Running sequence; Id is 0 for an unused slot
+*/
+typedef struct {
+    uint32 Id;
+    uint32 RequestId;               /* of the run_sequence request, echoed in every push */
+    int32 ClientSlot;               /* connection progress is pushed to, or -1 */
+    uint32 Generation;              /* of the client slot when started */
+    boolean Critical;
+    const char *AbortReason;        /* set to abort on the next pass */
+    uint32 StepCount;
+    uint32 Next;                    /* step waiting to be sent */
+    uint32 DueMs;                   /* when its time tag is reached */
+    MCP_INTERFACE_SequenceStep_t Steps[MCP_SEQUENCE_MAX_STEPS];
+} MCP_INTERFACE_Sequence_t;
+
+typedef struct {
+    MCP_INTERFACE_Sequence_t Sequences[MCP_SEQUENCE_MAX];
+    uint32 Running;
+    uint32 LastId;
+    uint32 WatchedSlots;            /* telemetry cache slots a waiting condition reads */
+} MCP_INTERFACE_SequenceEngine_t;
+
+/*
+** Latest sample of an ES application; Registered is FALSE for an unused ID
+*/
+typedef struct {
+    boolean Registered;
+    uint32 Type;
+    uint32 AppState;
+    uint32 Priority;
+    uint32 MainTaskId;
+    uint32 NumOfChildTasks;
+    uint32 StackSize;
+    uint32 ExecutionCounter;
+    uint32 ExecRate;                /* executions per second, 0 until sampled twice */
+    uint32 SampledUs;
+    char Name[OS_MAX_API_NAME];
+} MCP_INTERFACE_AppSample_t;
+
+typedef struct {
+    MCP_INTERFACE_AppSample_t Apps[MCP_SNAPSHOT_MAX_APPS];
+    uint32 NextAppId;               /* first ID of the next pass */
+    uint32 Passes;
+    uint32 SampledUs;               /* time of the last pass */
+    boolean HeapValid;
+    OS_heap_prop_t Heap;
+} MCP_INTERFACE_SystemSnapshot_t;
+
+/*
+** Selection of a get_event_log request
+*/
+typedef struct {
+    uint32 SinceSeq;                /* events after this one are returned */
+    uint32 Max;
+    uint16 MinType;                 /* least severe event type returned */
+    char AppName[OS_MAX_API_NAME];  /* empty for every app */
+} MCP_INTERFACE_EventQuery_t;
+
+/*
+** Per-client connection state, receive reassembly buffer and output
+** queue
+*/
+typedef struct {
+    int32 Socket;
+    uint32 Generation;              /* bumped on every accept into this slot */
+    uint32 PollEvents;              /* epoll events currently registered */
+    uint32 AcceptedUs;              /* trace times of the connection and its latest read */
+    uint32 ReceivedUs;
+    uint32 ActiveIndex;             /* position in ActiveSlots while connected */
+    uint8 Framing;
+    boolean ScanInString;
+    boolean ScanEscape;
+    uint32 ScanDepth;
+    uint32 ScanOffset;
+    uint32 RxStart;                 /* bytes already framed, reclaimed on the next read */
+    uint32 RxLength;
+    char RxBuffer[MCP_CLIENT_RX_BUFFER_SIZE + 1];
+    uint32 TxStart;                 /* bytes of the output queue already sent */
+    uint32 TxLength;
+    char TxBuffer[MCP_CLIENT_TX_BUFFER_SIZE];
+    int32 StreamFd;                 /* file being streamed, or -1 */
+    uint32 StreamAt;                /* queue position the file bytes go out at */
+    uint32 StreamOffset;
+    uint32 StreamRemaining;
+    MCP_INTERFACE_TlmSubscription_t Subscription;
+} MCP_INTERFACE_Client_t;
+
+/*
+** Bounded queue handing parsed requests from the socket reader
+** to the command path
+*/
+typedef struct {
+    int32 ClientSlot;
+    MCP_Request_t Request;
+} MCP_INTERFACE_QueuedRequest_t;
+
+typedef struct {
+    MCP_INTERFACE_QueuedRequest_t Entries[MCP_REQUEST_QUEUE_DEPTH];
+    uint32 Head;
+    uint32 Count;
+} MCP_INTERFACE_RequestQueue_t;
+
+/*
+** Request handed to the worker pool, with its own copy of the params
+** and the frame its response is written into
+*/
+typedef struct {
+    int32 ClientSlot;
+    uint32 Generation;              /* of the client slot when submitted */
+    int32 Result;
+    MCP_Request_t Request;
+    MCP_Response_t Response;
+    MCP_JSON_Writer_t Json;
+    char Params[MCP_MAX_JSON_SIZE];
+    char Frame[MCP_RESPONSE_FRAME_SIZE];
+} MCP_INTERFACE_WorkerJob_t;
+
+/*
+** Worker pool
+**
+** The rings carry job indices. Submissions are written by the socket
+** task and claimed by workers after taking the semaphore; completions
+** are claimed by workers and drained by the socket task, an empty slot
+** holding 0 and a completed one its job index + 1. Free jobs are only
+** touched by the socket task.
+*/
+typedef struct {
+    MCP_INTERFACE_WorkerJob_t Jobs[MCP_WORKER_JOB_COUNT];
+    uint8 FreeJobs[MCP_WORKER_JOB_COUNT];
+    uint32 FreeCount;
+    uint8 Submitted[MCP_WORKER_JOB_COUNT];
+    uint32 SubmitHead;
+    uint32 SubmitTail;
+    uint8 Completed[MCP_WORKER_JOB_COUNT];
+    uint32 CompleteHead;
+    uint32 CompleteTail;
+    uint32 SemId;
+    uint32 TaskIds[MCP_WORKER_COUNT];
+} MCP_INTERFACE_WorkerPool_t;
+
+/*
+** Cached directory listing, names packed NUL terminated in the pool in
+** directory order
+*/
+typedef struct {
+    char Path[MCP_MAX_PATH_LEN];    /* empty when the slot holds nothing reusable */
+    uint32 MTime;
+    uint32 Inode;
+    uint32 LastUsed;
+    uint32 Count;
+    uint32 NameOffset[MCP_DIR_CACHE_MAX_ENTRIES];
+    uint8 Type[MCP_DIR_CACHE_MAX_ENTRIES];
+    char Names[MCP_DIR_CACHE_NAME_POOL_SIZE];
+} MCP_INTERFACE_DirListing_t;
+
+/*
+** Directory listing cache, shared by the workers under its own mutex
+*/
+typedef struct {
+    uint32 Mutex;
+    uint32 UseCounter;
+    MCP_INTERFACE_DirListing_t Listings[MCP_DIR_CACHE_COUNT];
+} MCP_INTERFACE_DirCache_t;
+
+/*
+** Response frames, handed out for the lifetime of one response
+*/
+typedef struct {
+    char Frames[MCP_OUTPUT_BUFFER_COUNT][MCP_RESPONSE_FRAME_SIZE];
+    boolean InUse[MCP_OUTPUT_BUFFER_COUNT];
+} MCP_INTERFACE_OutputPool_t;
+
 /*
 ** Application data structure
 */
@@ -108,7 +991,7 @@ typedef struct {
     /*
     ** Housekeeping telemetry packet
     */
-    CFE_SB_TlmHdr_t HkTlm;
+    MCP_INTERFACE_HkTlm_t HkTlm;
 
     /*
     ** Run Status variable used in the main processing loop
@@ -119,12 +1002,108 @@ typedef struct {
     ** Operational data (not reported in housekeeping)
     */
     CFE_SB_PipeId_t CommandPipe;
+    CFE_SB_MsgPtr_t MsgPtr;
+
+    /*
+    ** Socket servicing child task and the mutex serializing
+    ** request execution against SB command processing
+    */
+    uint32 SocketTaskId;
+    uint32 DataMutex;
+    MCP_INTERFACE_RequestQueue_t RequestQueue;
+    MCP_INTERFACE_OutputPool_t OutputPool;
+    MCP_INTERFACE_WorkerPool_t WorkerPool;
+    MCP_INTERFACE_DirCache_t DirCache;
+
+    /*
+    ** Command dictionary table, its lookup index (entry index + 1 per
+    ** slot, 0 when the slot is empty) and a prebuilt command header per
+    ** entry
+    */
+    CFE_TBL_Handle_t CmdTblHandle;
+    MCP_INTERFACE_CmdTbl_t *CmdTblPtr;
+    uint8 CmdIndex[MCP_CMD_HASH_SLOTS];
+    CFE_SB_CmdHdr_t CmdHeaders[MCP_CMD_TBL_MAX_ENTRIES];
+
+    /*
+    ** Telemetry cache, one snapshot per dictionary telemetry entry
+    */
+    MCP_INTERFACE_TlmSnapshot_t TlmCache[MCP_TLM_CACHE_MAX_ENTRIES];
+
+    /*
+    ** Telemetry shared memory region, NULL unless it is published
+    */
+    uint8 *TlmShm;
+
+    /*
+    ** Recent EVS events
+    */
+    MCP_INTERFACE_EventLog_t EventLog;
+
+    /*
+    ** Request metrics
+    */
+    MCP_INTERFACE_Metrics_t Metrics;
+
+    /*
+    ** Recent request traces
+    */
+    MCP_INTERFACE_TraceLog_t TraceLog;
+
+    /*
+    ** Encoded results of recent read-only requests
+    */
+    MCP_INTERFACE_ResponseCache_t ResponseCache;
+
+    /*
+    ** Latest samples of every app and the heap
+    */
+    MCP_INTERFACE_SystemSnapshot_t SystemSnapshot;
+
+    /*
+    ** Rate buckets and commands waiting for a token
+    */
+    MCP_INTERFACE_CmdAdmission_t CmdAdmission;
+
+    /*
+    ** Commands waiting for their confirmation token
+    */
+    MCP_INTERFACE_Confirmations_t Confirmations;
+
+    /*
+    ** Audit entries waiting to be written
+    */
+    MCP_INTERFACE_AuditLog_t AuditLog;
+
+    /*
+    ** Running command sequences
+    */
+    MCP_INTERFACE_SequenceEngine_t Sequences;
+
+    /*
+    ** Cache slots some client is subscribed to, and the pipe the main
+    ** task uses to wake the socket task when one of them, or one a
+    ** sequence is waiting on, is updated
+    */
+    uint32 TlmSubscribers;
+    int32 WakePipe[2];
+
+    /*
+    ** Safety rule table and the matcher compiled from it
+    */
+    CFE_TBL_Handle_t SafetyTblHandle;
+    MCP_INTERFACE_SafetyTbl_t *SafetyTblPtr;
+    MCP_INTERFACE_SafetyMatcher_t SafetyMatcher;
 
     /*
     ** MCP Server data
     */
     int32 ServerSocket;
-    int32 ClientSockets[MCP_MAX_CLIENTS];
+    int32 EpollFd;
+    boolean AcceptPaused;                   /* server socket out of the epoll set */
+    uint32 AcceptResumeMs;
+    MCP_INTERFACE_Client_t Clients[MCP_MAX_CLIENTS];
+    uint16 ActiveSlots[MCP_MAX_CLIENTS];    /* connected slots, densely packed */
     uint32 ActiveClients;
     boolean DebugMode;
     uint32 RequestCounter;
@@ -136,7 +1115,6 @@ typedef struct {
     */
     boolean SafetyMode;
     uint32 CriticalCommandCount;
-    uint32 LastCriticalCommandTime;
 
 } MCP_INTERFACE_AppData_t;
 
@@ -144,6 +1122,7 @@ typedef struct {
 ** Application global data
 */
 extern MCP_INTERFACE_AppData_t MCP_INTERFACE_AppData;
+extern const MCP_INTERFACE_RequestType_t MCP_INTERFACE_RequestTypes[MCP_CMD_MAX];
 
 /*
 ** Function Prototypes
@@ -154,33 +1133,186 @@ void MCP_INTERFACE_ProcessCommandPacket(void);
 void MCP_INTERFACE_ProcessGroundCommand(void);
 void MCP_INTERFACE_ReportHousekeeping(void);
 void MCP_INTERFACE_ResetCounters(void);
+void MCP_INTERFACE_ProcessDumpTrace(const MCP_INTERFACE_DumpTraceCmd_t *cmd);
 boolean MCP_INTERFACE_VerifyCmdLength(CFE_SB_MsgPtr_t msg, uint16 ExpectedLength);
 
 /*
 ** MCP Server Functions
 */
 int32 MCP_INTERFACE_InitSocket(void);
-void MCP_INTERFACE_ProcessMCPClients(void);
-int32 MCP_INTERFACE_HandleMCPRequest(int32 client_socket, MCP_Request_t *request);
-int32 MCP_INTERFACE_SendMCPResponse(int32 client_socket, MCP_Response_t *response);
+int32 MCP_INTERFACE_StartSocketTask(void);
+void MCP_INTERFACE_SocketTask(void);
+void MCP_INTERFACE_ProcessMCPClients(const struct epoll_event *events, int32 count);
+void MCP_INTERFACE_DispatchRequests(void);
+int32 MCP_INTERFACE_QueueClientOutput(int32 slot, const char *data, uint32 length);
+int32 MCP_INTERFACE_QueueClientStream(int32 slot, int32 fd, uint32 offset, uint32 length);
+boolean MCP_INTERFACE_ClientBacklogged(int32 slot);
+boolean MCP_INTERFACE_IsSlowRequest(MCP_CommandType_t type);
+int32 MCP_INTERFACE_HandleMCPRequest(int32 client_slot, MCP_Request_t *request);
+void MCP_INTERFACE_ProcessRequest(MCP_Request_t *request, MCP_Response_t *response);
+boolean MCP_INTERFACE_AdmitRequest(MCP_Request_t *request, MCP_Response_t *response);
+int32 MCP_INTERFACE_ExecuteRequest(MCP_Request_t *request, MCP_Response_t *response);
+void MCP_INTERFACE_CountResult(const MCP_Request_t *request, int32 result, const MCP_Response_t *response);
+boolean MCP_INTERFACE_IsIoBoundRequest(MCP_CommandType_t type);
+int32 MCP_INTERFACE_SendMCPResponse(int32 client_slot, MCP_JSON_Writer_t *json);
+int32 MCP_INTERFACE_SendResponseStream(int32 client_slot, MCP_Response_t *response);
+int32 MCP_INTERFACE_SendErrorResponse(int32 client_slot, uint32 id, const char *error_msg);
+
+/*
+** Worker pool functions
+*/
+int32 MCP_INTERFACE_StartWorkers(void);
+void MCP_INTERFACE_WorkerTask(void);
+boolean MCP_INTERFACE_SubmitRequest(int32 client_slot, const MCP_Request_t *request);
+void MCP_INTERFACE_CollectCompletions(void);
+
+/*
+** Directory cache functions
+*/
+int32 MCP_INTERFACE_InitDirCache(void);
+const MCP_INTERFACE_DirListing_t *MCP_INTERFACE_LockDirListing(const char *path);
+void MCP_INTERFACE_UnlockDirListing(void);
+uint8 MCP_INTERFACE_DirEntryType(const char *directory, const char *name, uint8 d_type);
 
 /*
 ** MCP Command Handlers
 */
-int32 MCP_INTERFACE_HandleSendCommand(MCP_Request_t *request, MCP_Response_t *response);
-int32 MCP_INTERFACE_HandleGetTelemetry(MCP_Request_t *request, MCP_Response_t *response);
-int32 MCP_INTERFACE_HandleGetSystemStatus(MCP_Request_t *request, MCP_Response_t *response);
-int32 MCP_INTERFACE_HandleManageApp(MCP_Request_t *request, MCP_Response_t *response);
-int32 MCP_INTERFACE_HandleGetFileList(MCP_Request_t *request, MCP_Response_t *response);
-int32 MCP_INTERFACE_HandleReadFile(MCP_Request_t *request, MCP_Response_t *response);
-int32 MCP_INTERFACE_HandleWriteFile(MCP_Request_t *request, MCP_Response_t *response);
-int32 MCP_INTERFACE_HandleGetEventLog(MCP_Request_t *request, MCP_Response_t *response);
-int32 MCP_INTERFACE_HandleEmergencyStop(MCP_Request_t *request, MCP_Response_t *response);
+#define MCP_REQUEST_TYPE(id, name, handler, flags) \
+    int32 MCP_INTERFACE_##handler(MCP_Request_t *request, MCP_Response_t *response);
+#include "mcp_request_types.def"
+#undef MCP_REQUEST_TYPE
+
+/*
+** Command dictionary functions
+*/
+int32 MCP_INTERFACE_InitCmdDictionary(void);
+void MCP_INTERFACE_ManageCmdDictionary(void);
+int32 MCP_INTERFACE_ValidateCmdTbl(void *TblData);
+const MCP_INTERFACE_CmdEntry_t *MCP_INTERFACE_LookupCommand(const char *app_name, const char *command);
+CFE_SB_Msg_t *MCP_INTERFACE_BuildCommandPacket(const MCP_INTERFACE_CmdEntry_t *entry, const char *payload_hex,
+                                               uint32 payload_hex_len, CFE_SB_ZeroCopyHandle_t *handle);
+int32 MCP_INTERFACE_SendCommandPacket(const MCP_INTERFACE_CmdEntry_t *entry, const char *payload_hex,
+                                      uint32 payload_hex_len);
+boolean MCP_INTERFACE_ValidPayload(const MCP_INTERFACE_CmdEntry_t *entry, const char *payload_hex,
+                                   uint32 payload_hex_len);
+
+/*
+** Command admission functions
+*/
+void MCP_INTERFACE_InitCmdAdmission(void);
+int32 MCP_INTERFACE_AdmitCommand(const MCP_Request_t *request, const MCP_INTERFACE_CmdEntry_t *entry,
+                                 const char *payload_hex, uint32 payload_hex_len,
+                                 MCP_INTERFACE_Admission_t *admission);
+int32 MCP_INTERFACE_IssueCommand(const MCP_Request_t *request, const MCP_INTERFACE_CmdEntry_t *entry,
+                                 const char *payload_hex, uint32 payload_hex_len,
+                                 MCP_INTERFACE_Admission_t *admission);
+int32 MCP_INTERFACE_SendQueuedCommands(void);
+void MCP_INTERFACE_FlushCommandQueue(const char *reason);
+void MCP_INTERFACE_ExpireRateBuckets(void);
+
+/*
+** Confirmation token functions
+*/
+void MCP_INTERFACE_InitConfirmations(void);
+int32 MCP_INTERFACE_PrepareCommand(const MCP_Request_t *request, const MCP_INTERFACE_CmdEntry_t *entry,
+                                   const char *payload_hex, uint32 payload_hex_len, MCP_Response_t *response);
+int32 MCP_INTERFACE_ConfirmCommand(uint32 token, MCP_Request_t *request, MCP_Response_t *response);
+void MCP_INTERFACE_ExpireConfirmations(void);
+void MCP_INTERFACE_FlushConfirmations(const char *reason);
+
+/*
+** Audit log functions
+*/
+int32 MCP_INTERFACE_StartAuditLog(void);
+void MCP_INTERFACE_AuditTask(void);
+void MCP_INTERFACE_Audit(const char *kind, const char *format, ...);
+void MCP_INTERFACE_AuditCommand(const char *via, uint32 request_id, const MCP_INTERFACE_CmdEntry_t *entry,
+                                boolean critical, const char *payload_hex, uint32 payload_hex_len, int32 status);
+
+/*
+** Sequence functions
+*/
+void MCP_INTERFACE_InitSequences(void);
+int32 MCP_INTERFACE_StartSequence(MCP_Request_t *request, const char *steps, uint32 steps_len,
+                                  MCP_Response_t *response);
+boolean MCP_INTERFACE_CancelSequence(uint32 sequence_id);
+int32 MCP_INTERFACE_RunSequences(void);
+void MCP_INTERFACE_AbortSequences(const char *reason);
+
+/*
+** Telemetry cache functions
+*/
+void MCP_INTERFACE_SubscribeTelemetry(void);
+boolean MCP_INTERFACE_CacheTelemetry(CFE_SB_MsgPtr_t msg);
+const MCP_INTERFACE_TlmSnapshot_t *MCP_INTERFACE_FindTelemetry(const char *app_name);
+void MCP_INTERFACE_WriteTelemetry(MCP_JSON_Writer_t *json, const MCP_INTERFACE_TlmSnapshot_t *snapshot,
+                                  uint32 current_time);
+void MCP_INTERFACE_UpdateTlmSubscribers(void);
+int32 MCP_INTERFACE_PublishTelemetry(void);
+
+/*
+** Telemetry shared memory functions
+*/
+void MCP_INTERFACE_InitTlmShm(void);
+void MCP_INTERFACE_ShareTelemetry(uint32 index);
+void MCP_INTERFACE_ShareHousekeeping(void);
+
+/*
+** Event log functions
+*/
+int32 MCP_INTERFACE_InitEventLog(void);
+void MCP_INTERFACE_RecordEvent(CFE_SB_MsgPtr_t msg);
+void MCP_INTERFACE_WriteEventLog(MCP_JSON_Writer_t *json, const MCP_INTERFACE_EventQuery_t *query);
+
+/*
+** Request metrics functions
+*/
+uint32 MCP_INTERFACE_MetricsNowUs(void);
+uint32 MCP_INTERFACE_MetricsNowMs(void);
+void MCP_INTERFACE_CountMetric(uint32 *counter, uint32 amount);
+void MCP_INTERFACE_CountRequestType(MCP_CommandType_t type, boolean success);
+void MCP_INTERFACE_RecordLatency(uint32 *histogram, uint32 elapsed_us);
+void MCP_INTERFACE_CopyMetrics(MCP_INTERFACE_Metrics_t *copy);
+void MCP_INTERFACE_ResetMetrics(void);
+void MCP_INTERFACE_WriteMetrics(MCP_JSON_Writer_t *json);
+
+/*
+** Request trace functions
+*/
+void MCP_INTERFACE_RecordTrace(const MCP_Request_t *request, const MCP_Response_t *response);
+void MCP_INTERFACE_WriteTrace(MCP_JSON_Writer_t *json, uint32 since_seq, uint32 max);
+int32 MCP_INTERFACE_DumpTrace(const char *filename);
+
+/*
+** Response cache functions
+*/
+void MCP_INTERFACE_InitResponseCache(void);
+boolean MCP_INTERFACE_ReplayResponse(const MCP_Request_t *request, MCP_Response_t *response);
+void MCP_INTERFACE_StoreResponse(const MCP_Request_t *request, const MCP_Response_t *response,
+                                 int32 result, uint32 result_start);
+void MCP_INTERFACE_InvalidateResponses(uint32 tlm_slot);
+void MCP_INTERFACE_FlushResponseCache(void);
+
+/*
+** System snapshot functions
+*/
+void MCP_INTERFACE_InitSystemSnapshot(void);
+void MCP_INTERFACE_UpdateSystemSnapshot(void);
+void MCP_INTERFACE_WriteSystemSnapshot(MCP_JSON_Writer_t *json, boolean apps, uint32 start);
+
+/*
+** Safety rule matcher functions
+*/
+int32 MCP_INTERFACE_InitSafetyRules(void);
+void MCP_INTERFACE_ManageSafetyRules(void);
+int32 MCP_INTERFACE_ValidateSafetyTbl(void *TblData);
+uint8 MCP_INTERFACE_MatchSafetyRules(const char *text, uint32 length, boolean whole, uint8 wanted);
 
 /*
 ** Safety and utility functions
 */
 boolean MCP_INTERFACE_IsSafeCommand(MCP_Request_t *request);
+boolean MCP_INTERFACE_IsSafePath(const MCP_Request_t *request, const char *path);
 boolean MCP_INTERFACE_RequiresConfirmation(MCP_Request_t *request);
 int32 MCP_INTERFACE_ValidateRequest(MCP_Request_t *request);
 void MCP_INTERFACE_LogSafetyEvent(const char *event_msg, uint32 event_id);
@@ -188,7 +1320,14 @@ void MCP_INTERFACE_LogSafetyEvent(const char *event_msg, uint32 event_id);
 /*
 ** JSON utility functions
 */
-int32 MCP_INTERFACE_ParseJSONRequest(const char *json_str, MCP_Request_t *request);
-int32 MCP_INTERFACE_FormatJSONResponse(MCP_Response_t *response, char *json_str, uint32 max_len);
+int32 MCP_INTERFACE_ParseJSONRequest(char *json_str, uint32 json_len, MCP_Request_t *request);
+int32 MCP_INTERFACE_ParseJSONBatchItem(char *json_str, uint32 json_len,
+                                       MCP_Request_t *request, uint32 default_id);
+int32 MCP_INTERFACE_ParseBinaryRequest(char *frame, uint32 frame_len, MCP_Request_t *request);
+char *MCP_INTERFACE_AcquireOutputBuffer(void);
+void MCP_INTERFACE_ReleaseOutputBuffer(char *frame);
+void MCP_INTERFACE_InitResponseWriter(MCP_JSON_Writer_t *json, char *frame, int32 client_slot);
+void MCP_INTERFACE_BeginJSONResponse(MCP_Response_t *response, MCP_JSON_Writer_t *json, uint32 id);
+void MCP_INTERFACE_EndJSONResponse(MCP_Response_t *response);
 
 #endif /* MCP_INTERFACE_APP_H */
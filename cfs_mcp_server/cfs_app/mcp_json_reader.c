@@ -0,0 +1,607 @@
+/*
+** MCP Interface JSON Reader
+**
+** This file contains the in-situ JSON tokenizer used to parse MCP
+** requests without building a document tree.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_json_reader.h"
+#include <string.h>
+
+/*
+** Local function prototypes
+*/
+static void MCP_JSON_SkipSpace(MCP_JSON_Reader_t *reader);
+static boolean MCP_JSON_Fail(MCP_JSON_Reader_t *reader);
+static boolean MCP_JSON_SkipValueDepth(MCP_JSON_Reader_t *reader, uint32 depth);
+static boolean MCP_JSON_SkipString(MCP_JSON_Reader_t *reader);
+static boolean MCP_JSON_ReadHex4(MCP_JSON_Reader_t *reader, uint32 *code);
+static boolean MCP_JSON_Literal(MCP_JSON_Reader_t *reader, const char *literal, uint32 length);
+
+/*
+** Initialize a reader over a text span (need not be NUL terminated)
+*/
+void MCP_JSON_ReaderInit(MCP_JSON_Reader_t *reader, const char *text, uint32 length)
+{
+    reader->Pos = text;
+    reader->End = text + length;
+    reader->First = TRUE;
+    reader->Error = FALSE;
+
+} /* End MCP_JSON_ReaderInit */
+
+/*
+** Check that nothing but whitespace is left
+*/
+boolean MCP_JSON_ReadEnd(MCP_JSON_Reader_t *reader)
+{
+    MCP_JSON_SkipSpace(reader);
+    return (!reader->Error && reader->Pos == reader->End);
+
+} /* End MCP_JSON_ReadEnd */
+
+/*
+** Type of the next value, without consuming it
+*/
+uint8 MCP_JSON_PeekType(MCP_JSON_Reader_t *reader)
+{
+    MCP_JSON_SkipSpace(reader);
+    if (reader->Error || reader->Pos >= reader->End)
+    {
+        return MCP_JSON_TYPE_NONE;
+    }
+
+    switch (*reader->Pos)
+    {
+        case '{': return MCP_JSON_TYPE_OBJECT;
+        case '[': return MCP_JSON_TYPE_ARRAY;
+        case '"': return MCP_JSON_TYPE_STRING;
+        case 't':
+        case 'f': return MCP_JSON_TYPE_BOOL;
+        case 'n': return MCP_JSON_TYPE_NULL;
+        default:
+            if (*reader->Pos == '-' || (*reader->Pos >= '0' && *reader->Pos <= '9'))
+            {
+                return MCP_JSON_TYPE_NUMBER;
+            }
+            return MCP_JSON_TYPE_NONE;
+    }
+
+} /* End MCP_JSON_PeekType */
+
+/*
+** Objects: Begin consumes '{', each Next reads one member name and
+** its ':' and leaves the reader on the value. Next returns FALSE once
+** the closing '}' has been consumed or on error.
+*/
+boolean MCP_JSON_ReadObjectBegin(MCP_JSON_Reader_t *reader)
+{
+    if (MCP_JSON_PeekType(reader) != MCP_JSON_TYPE_OBJECT)
+    {
+        return MCP_JSON_Fail(reader);
+    }
+
+    reader->Pos++;
+    reader->First = TRUE;
+    return TRUE;
+
+} /* End MCP_JSON_ReadObjectBegin */
+
+boolean MCP_JSON_ReadObjectNext(MCP_JSON_Reader_t *reader, char *key, uint32 key_size)
+{
+    MCP_JSON_SkipSpace(reader);
+    if (reader->Error || reader->Pos >= reader->End)
+    {
+        return MCP_JSON_Fail(reader);
+    }
+
+    if (*reader->Pos == '}')
+    {
+        reader->Pos++;
+        reader->First = FALSE;
+        return FALSE;
+    }
+
+    if (!reader->First)
+    {
+        if (*reader->Pos != ',')
+        {
+            return MCP_JSON_Fail(reader);
+        }
+        reader->Pos++;
+    }
+    reader->First = FALSE;
+
+    /* Names too long for the caller's buffer cannot match anything it knows */
+    if (MCP_JSON_PeekType(reader) != MCP_JSON_TYPE_STRING)
+    {
+        return MCP_JSON_Fail(reader);
+    }
+    if (!MCP_JSON_ReadString(reader, key, key_size))
+    {
+        if (reader->Error)
+        {
+            return FALSE;
+        }
+        key[0] = '\0';
+        MCP_JSON_SkipString(reader);
+    }
+
+    MCP_JSON_SkipSpace(reader);
+    if (reader->Pos >= reader->End || *reader->Pos != ':')
+    {
+        return MCP_JSON_Fail(reader);
+    }
+    reader->Pos++;
+
+    return TRUE;
+
+} /* End MCP_JSON_ReadObjectNext */
+
+/*
+** Arrays: Begin consumes '[', each Next leaves the reader on the next
+** element. Next returns FALSE once the closing ']' has been consumed
+** or on error.
+*/
+boolean MCP_JSON_ReadArrayBegin(MCP_JSON_Reader_t *reader)
+{
+    if (MCP_JSON_PeekType(reader) != MCP_JSON_TYPE_ARRAY)
+    {
+        return MCP_JSON_Fail(reader);
+    }
+
+    reader->Pos++;
+    reader->First = TRUE;
+    return TRUE;
+
+} /* End MCP_JSON_ReadArrayBegin */
+
+boolean MCP_JSON_ReadArrayNext(MCP_JSON_Reader_t *reader)
+{
+    MCP_JSON_SkipSpace(reader);
+    if (reader->Error || reader->Pos >= reader->End)
+    {
+        return MCP_JSON_Fail(reader);
+    }
+
+    if (*reader->Pos == ']')
+    {
+        reader->Pos++;
+        reader->First = FALSE;
+        return FALSE;
+    }
+
+    if (!reader->First)
+    {
+        if (*reader->Pos != ',')
+        {
+            return MCP_JSON_Fail(reader);
+        }
+        reader->Pos++;
+    }
+    reader->First = FALSE;
+
+    return TRUE;
+
+} /* End MCP_JSON_ReadArrayNext */
+
+/*
+** Decode a string value into value[value_size]
+**
+** Returns FALSE without consuming the string when it does not fit, so
+** the caller may skip it instead.
+*/
+boolean MCP_JSON_ReadString(MCP_JSON_Reader_t *reader, char *value, uint32 value_size)
+{
+    const char *start;
+    uint32 length = 0;
+    uint32 code;
+    uint32 low;
+    char c;
+
+    if (MCP_JSON_PeekType(reader) != MCP_JSON_TYPE_STRING)
+    {
+        return FALSE;
+    }
+
+    start = reader->Pos;
+    reader->Pos++;
+
+    while (reader->Pos < reader->End && *reader->Pos != '"')
+    {
+        c = *reader->Pos++;
+
+        if ((unsigned char)c < 0x20)
+        {
+            return MCP_JSON_Fail(reader);
+        }
+
+        if (c == '\\')
+        {
+            if (reader->Pos >= reader->End)
+            {
+                return MCP_JSON_Fail(reader);
+            }
+
+            c = *reader->Pos++;
+            switch (c)
+            {
+                case '"':
+                case '\\':
+                case '/':
+                    break;
+                case 'b': c = '\b'; break;
+                case 'f': c = '\f'; break;
+                case 'n': c = '\n'; break;
+                case 'r': c = '\r'; break;
+                case 't': c = '\t'; break;
+                case 'u':
+                    if (!MCP_JSON_ReadHex4(reader, &code))
+                    {
+                        return FALSE;
+                    }
+
+                    /* Combine a surrogate pair */
+                    if (code >= 0xD800 && code <= 0xDBFF &&
+                        reader->End - reader->Pos >= 6 &&
+                        reader->Pos[0] == '\\' && reader->Pos[1] == 'u')
+                    {
+                        reader->Pos += 2;
+                        if (!MCP_JSON_ReadHex4(reader, &low))
+                        {
+                            return FALSE;
+                        }
+                        code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    }
+
+                    /* Encode as UTF-8 */
+                    if (length + 4 >= value_size)
+                    {
+                        value[0] = '\0';
+                        reader->Pos = start;
+                        return FALSE;
+                    }
+                    if (code < 0x80)
+                    {
+                        value[length++] = (char)code;
+                    }
+                    else if (code < 0x800)
+                    {
+                        value[length++] = (char)(0xC0 | (code >> 6));
+                        value[length++] = (char)(0x80 | (code & 0x3F));
+                    }
+                    else if (code < 0x10000)
+                    {
+                        value[length++] = (char)(0xE0 | (code >> 12));
+                        value[length++] = (char)(0x80 | ((code >> 6) & 0x3F));
+                        value[length++] = (char)(0x80 | (code & 0x3F));
+                    }
+                    else
+                    {
+                        value[length++] = (char)(0xF0 | (code >> 18));
+                        value[length++] = (char)(0x80 | ((code >> 12) & 0x3F));
+                        value[length++] = (char)(0x80 | ((code >> 6) & 0x3F));
+                        value[length++] = (char)(0x80 | (code & 0x3F));
+                    }
+                    continue;
+                default:
+                    return MCP_JSON_Fail(reader);
+            }
+        }
+
+        if (length + 1 >= value_size)
+        {
+            value[0] = '\0';
+            reader->Pos = start;
+            return FALSE;
+        }
+        value[length++] = c;
+    }
+
+    if (reader->Pos >= reader->End)
+    {
+        return MCP_JSON_Fail(reader);
+    }
+
+    reader->Pos++;
+    value[length] = '\0';
+    return TRUE;
+
+} /* End MCP_JSON_ReadString */
+
+/*
+** Decode a string value over its own text and return a view of it
+**
+** Decoding never grows a string, so the result and its terminator fit
+** where the encoded form was. The reader must be over writable text;
+** the text must not be read again afterwards.
+*/
+boolean MCP_JSON_ReadStringInPlace(MCP_JSON_Reader_t *reader, char **value, uint32 *length)
+{
+    char *text;
+
+    if (MCP_JSON_PeekType(reader) != MCP_JSON_TYPE_STRING)
+    {
+        return FALSE;
+    }
+
+    text = (char *)reader->Pos + 1;
+    if (!MCP_JSON_ReadString(reader, text, (uint32)(reader->End - reader->Pos)))
+    {
+        return MCP_JSON_Fail(reader);
+    }
+
+    *value = text;
+    *length = (uint32)strlen(text);
+    return TRUE;
+
+} /* End MCP_JSON_ReadStringInPlace */
+
+/*
+** Read a non-negative integer that fits in 32 bits
+*/
+boolean MCP_JSON_ReadUint(MCP_JSON_Reader_t *reader, uint32 *value)
+{
+    uint32 result = 0;
+    uint32 digit;
+    const char *start;
+
+    if (MCP_JSON_PeekType(reader) != MCP_JSON_TYPE_NUMBER)
+    {
+        return FALSE;
+    }
+
+    start = reader->Pos;
+    while (reader->Pos < reader->End && *reader->Pos >= '0' && *reader->Pos <= '9')
+    {
+        digit = (uint32)(*reader->Pos - '0');
+        if (result > (0xFFFFFFFFu - digit) / 10)
+        {
+            reader->Pos = start;
+            return FALSE;
+        }
+        result = result * 10 + digit;
+        reader->Pos++;
+    }
+
+    /* Negative, fractional or exponent forms are not integers we accept */
+    if (reader->Pos == start ||
+        (reader->Pos < reader->End &&
+         (*reader->Pos == '.' || *reader->Pos == 'e' || *reader->Pos == 'E')))
+    {
+        reader->Pos = start;
+        return FALSE;
+    }
+
+    *value = result;
+    return TRUE;
+
+} /* End MCP_JSON_ReadUint */
+
+/*
+** Read true or false
+*/
+boolean MCP_JSON_ReadBool(MCP_JSON_Reader_t *reader, boolean *value)
+{
+    if (MCP_JSON_PeekType(reader) != MCP_JSON_TYPE_BOOL)
+    {
+        return FALSE;
+    }
+
+    if (MCP_JSON_Literal(reader, "true", 4))
+    {
+        *value = TRUE;
+        return TRUE;
+    }
+
+    if (MCP_JSON_Literal(reader, "false", 5))
+    {
+        *value = FALSE;
+        return TRUE;
+    }
+
+    return MCP_JSON_Fail(reader);
+
+} /* End MCP_JSON_ReadBool */
+
+/*
+** Skip a value and return the text span it occupied
+*/
+boolean MCP_JSON_ReadRaw(MCP_JSON_Reader_t *reader, const char **value, uint32 *length)
+{
+    const char *start;
+
+    MCP_JSON_SkipSpace(reader);
+    start = reader->Pos;
+
+    if (!MCP_JSON_SkipValue(reader))
+    {
+        return FALSE;
+    }
+
+    *value = start;
+    *length = (uint32)(reader->Pos - start);
+    return TRUE;
+
+} /* End MCP_JSON_ReadRaw */
+
+/*
+** Skip any value, checking its syntax
+*/
+boolean MCP_JSON_SkipValue(MCP_JSON_Reader_t *reader)
+{
+    return MCP_JSON_SkipValueDepth(reader, 0);
+
+} /* End MCP_JSON_SkipValue */
+
+static boolean MCP_JSON_SkipValueDepth(MCP_JSON_Reader_t *reader, uint32 depth)
+{
+    char key[1];
+
+    if (depth >= MCP_JSON_READER_MAX_DEPTH)
+    {
+        return MCP_JSON_Fail(reader);
+    }
+
+    switch (MCP_JSON_PeekType(reader))
+    {
+        case MCP_JSON_TYPE_OBJECT:
+            MCP_JSON_ReadObjectBegin(reader);
+            while (MCP_JSON_ReadObjectNext(reader, key, sizeof(key)))
+            {
+                if (!MCP_JSON_SkipValueDepth(reader, depth + 1))
+                {
+                    return FALSE;
+                }
+                reader->First = FALSE;
+            }
+            break;
+
+        case MCP_JSON_TYPE_ARRAY:
+            MCP_JSON_ReadArrayBegin(reader);
+            while (MCP_JSON_ReadArrayNext(reader))
+            {
+                if (!MCP_JSON_SkipValueDepth(reader, depth + 1))
+                {
+                    return FALSE;
+                }
+                reader->First = FALSE;
+            }
+            break;
+
+        case MCP_JSON_TYPE_STRING:
+            return MCP_JSON_SkipString(reader);
+
+        case MCP_JSON_TYPE_NUMBER:
+            reader->Pos++;
+            while (reader->Pos < reader->End &&
+                   ((*reader->Pos >= '0' && *reader->Pos <= '9') ||
+                    *reader->Pos == '.' || *reader->Pos == 'e' || *reader->Pos == 'E' ||
+                    *reader->Pos == '+' || *reader->Pos == '-'))
+            {
+                reader->Pos++;
+            }
+            return TRUE;
+
+        case MCP_JSON_TYPE_BOOL:
+            if (MCP_JSON_Literal(reader, "true", 4) || MCP_JSON_Literal(reader, "false", 5))
+            {
+                return TRUE;
+            }
+            return MCP_JSON_Fail(reader);
+
+        case MCP_JSON_TYPE_NULL:
+            if (MCP_JSON_Literal(reader, "null", 4))
+            {
+                return TRUE;
+            }
+            return MCP_JSON_Fail(reader);
+
+        default:
+            return MCP_JSON_Fail(reader);
+    }
+
+    return !reader->Error;
+
+} /* End MCP_JSON_SkipValueDepth */
+
+/*
+** Local helpers
+*/
+static void MCP_JSON_SkipSpace(MCP_JSON_Reader_t *reader)
+{
+    while (reader->Pos < reader->End &&
+           (*reader->Pos == ' ' || *reader->Pos == '\t' ||
+            *reader->Pos == '\r' || *reader->Pos == '\n'))
+    {
+        reader->Pos++;
+    }
+
+} /* End MCP_JSON_SkipSpace */
+
+static boolean MCP_JSON_Fail(MCP_JSON_Reader_t *reader)
+{
+    reader->Error = TRUE;
+    return FALSE;
+
+} /* End MCP_JSON_Fail */
+
+static boolean MCP_JSON_SkipString(MCP_JSON_Reader_t *reader)
+{
+    reader->Pos++;
+
+    while (reader->Pos < reader->End && *reader->Pos != '"')
+    {
+        if ((unsigned char)*reader->Pos < 0x20)
+        {
+            return MCP_JSON_Fail(reader);
+        }
+        if (*reader->Pos == '\\')
+        {
+            reader->Pos++;
+        }
+        reader->Pos++;
+    }
+
+    if (reader->Pos >= reader->End)
+    {
+        return MCP_JSON_Fail(reader);
+    }
+
+    reader->Pos++;
+    return TRUE;
+
+} /* End MCP_JSON_SkipString */
+
+static boolean MCP_JSON_ReadHex4(MCP_JSON_Reader_t *reader, uint32 *code)
+{
+    uint32 i;
+    char c;
+
+    if (reader->End - reader->Pos < 4)
+    {
+        return MCP_JSON_Fail(reader);
+    }
+
+    *code = 0;
+    for (i = 0; i < 4; i++)
+    {
+        c = *reader->Pos++;
+        *code <<= 4;
+        if (c >= '0' && c <= '9')
+        {
+            *code |= (uint32)(c - '0');
+        }
+        else if (c >= 'a' && c <= 'f')
+        {
+            *code |= (uint32)(c - 'a' + 10);
+        }
+        else if (c >= 'A' && c <= 'F')
+        {
+            *code |= (uint32)(c - 'A' + 10);
+        }
+        else
+        {
+            return MCP_JSON_Fail(reader);
+        }
+    }
+
+    return TRUE;
+
+} /* End MCP_JSON_ReadHex4 */
+
+static boolean MCP_JSON_Literal(MCP_JSON_Reader_t *reader, const char *literal, uint32 length)
+{
+    if ((uint32)(reader->End - reader->Pos) < length ||
+        memcmp(reader->Pos, literal, length) != 0)
+    {
+        return FALSE;
+    }
+
+    reader->Pos += length;
+    return TRUE;
+
+} /* End MCP_JSON_Literal */
@@ -0,0 +1,59 @@
+/*
+** MCP Interface JSON Reader Header File
+**
+** In-situ JSON tokenizer used to parse MCP requests. It walks the
+** request text directly and decodes only the values the caller asks
+** for into caller-provided storage; it never allocates.
+*/
+
+#ifndef MCP_JSON_READER_H
+#define MCP_JSON_READER_H
+
+#include "cfe.h"
+
+/*
+** Maximum nesting accepted in values that are skipped
+*/
+#define MCP_JSON_READER_MAX_DEPTH             32
+
+/*
+** Value types reported by MCP_JSON_PeekType
+*/
+#define MCP_JSON_TYPE_NONE                    0
+#define MCP_JSON_TYPE_OBJECT                  1
+#define MCP_JSON_TYPE_ARRAY                   2
+#define MCP_JSON_TYPE_STRING                  3
+#define MCP_JSON_TYPE_NUMBER                  4
+#define MCP_JSON_TYPE_BOOL                    5
+#define MCP_JSON_TYPE_NULL                    6
+
+/*
+** Reader state
+*/
+typedef struct {
+    const char *Pos;
+    const char *End;
+    boolean First;
+    boolean Error;
+} MCP_JSON_Reader_t;
+
+/*
+** Function Prototypes
+*/
+void MCP_JSON_ReaderInit(MCP_JSON_Reader_t *reader, const char *text, uint32 length);
+boolean MCP_JSON_ReadEnd(MCP_JSON_Reader_t *reader);
+uint8 MCP_JSON_PeekType(MCP_JSON_Reader_t *reader);
+
+boolean MCP_JSON_ReadObjectBegin(MCP_JSON_Reader_t *reader);
+boolean MCP_JSON_ReadObjectNext(MCP_JSON_Reader_t *reader, char *key, uint32 key_size);
+boolean MCP_JSON_ReadArrayBegin(MCP_JSON_Reader_t *reader);
+boolean MCP_JSON_ReadArrayNext(MCP_JSON_Reader_t *reader);
+
+boolean MCP_JSON_ReadString(MCP_JSON_Reader_t *reader, char *value, uint32 value_size);
+boolean MCP_JSON_ReadStringInPlace(MCP_JSON_Reader_t *reader, char **value, uint32 *length);
+boolean MCP_JSON_ReadUint(MCP_JSON_Reader_t *reader, uint32 *value);
+boolean MCP_JSON_ReadBool(MCP_JSON_Reader_t *reader, boolean *value);
+boolean MCP_JSON_ReadRaw(MCP_JSON_Reader_t *reader, const char **value, uint32 *length);
+boolean MCP_JSON_SkipValue(MCP_JSON_Reader_t *reader);
+
+#endif /* MCP_JSON_READER_H */
@@ -0,0 +1,508 @@
+/*
+** MCP Interface JSON Writer
+**
+** This file contains the streaming JSON writer used to build MCP
+** responses directly into their output buffer.
+**
+** In CBOR mode objects and arrays are written with indefinite lengths
+** (RFC 8949 section 3.2.2), so nothing has to be counted ahead and
+** marks and rewinds work exactly as they do for text.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_json_writer.h"
+#include <string.h>
+
+/*
+** Local function prototypes
+*/
+static void MCP_JSON_Put(MCP_JSON_Writer_t *json, const char *data, uint32 length);
+static void MCP_JSON_PutChar(MCP_JSON_Writer_t *json, char c);
+static void MCP_JSON_BeforeValue(MCP_JSON_Writer_t *json);
+static void MCP_JSON_PutDigits(MCP_JSON_Writer_t *json, uint32 value);
+static void MCP_JSON_PutCborHead(MCP_JSON_Writer_t *json, uint8 major, uint32 value);
+
+/*
+** CBOR initial bytes
+*/
+#define MCP_CBOR_UINT                         0
+#define MCP_CBOR_NEGINT                       1
+#define MCP_CBOR_BYTES                        2
+#define MCP_CBOR_TEXT                         3
+#define MCP_CBOR_ARRAY_BEGIN                  ((char)0x9F)
+#define MCP_CBOR_MAP_BEGIN                    ((char)0xBF)
+#define MCP_CBOR_FALSE                        ((char)0xF4)
+#define MCP_CBOR_TRUE                         ((char)0xF5)
+#define MCP_CBOR_BREAK                        ((char)0xFF)
+
+/*
+** Initialize a writer over a caller-provided buffer
+*/
+void MCP_JSON_Init(MCP_JSON_Writer_t *json, char *buffer, uint32 size)
+{
+    json->Buffer = buffer;
+    json->Size = size;
+    json->Length = 0;
+    json->Depth = 0;
+    json->CommaMask = 0;
+    json->AfterKey = FALSE;
+    json->Overflow = FALSE;
+    json->Format = MCP_JSON_FORMAT_TEXT;
+
+    if (size > 0)
+    {
+        buffer[0] = '\0';
+    }
+
+} /* End MCP_JSON_Init */
+
+/*
+** Select text or CBOR output; must be called before anything is written
+*/
+void MCP_JSON_SetFormat(MCP_JSON_Writer_t *json, uint8 format)
+{
+    json->Format = format;
+
+} /* End MCP_JSON_SetFormat */
+
+/*
+** Report whether everything written so far fit in the buffer
+*/
+boolean MCP_JSON_Ok(const MCP_JSON_Writer_t *json)
+{
+    return !json->Overflow;
+
+} /* End MCP_JSON_Ok */
+
+/*
+** Save the current position
+*/
+MCP_JSON_Mark_t MCP_JSON_GetMark(const MCP_JSON_Writer_t *json)
+{
+    MCP_JSON_Mark_t mark;
+
+    mark.Length = json->Length;
+    mark.Depth = json->Depth;
+    mark.CommaMask = json->CommaMask;
+    mark.AfterKey = json->AfterKey;
+
+    return mark;
+
+} /* End MCP_JSON_GetMark */
+
+/*
+** Discard everything written since a mark, including any overflow
+*/
+void MCP_JSON_Rewind(MCP_JSON_Writer_t *json, const MCP_JSON_Mark_t *mark)
+{
+    json->Length = mark->Length;
+    json->Depth = mark->Depth;
+    json->CommaMask = mark->CommaMask;
+    json->AfterKey = mark->AfterKey;
+    json->Overflow = FALSE;
+    json->Buffer[json->Length] = '\0';
+
+} /* End MCP_JSON_Rewind */
+
+/*
+** Object and array structure
+*/
+void MCP_JSON_BeginObject(MCP_JSON_Writer_t *json)
+{
+    MCP_JSON_BeforeValue(json);
+    MCP_JSON_PutChar(json, (json->Format == MCP_JSON_FORMAT_CBOR) ? MCP_CBOR_MAP_BEGIN : '{');
+    json->Depth++;
+    json->CommaMask &= ~(1u << (json->Depth % MCP_JSON_MAX_DEPTH));
+
+} /* End MCP_JSON_BeginObject */
+
+void MCP_JSON_EndObject(MCP_JSON_Writer_t *json)
+{
+    json->Depth--;
+    MCP_JSON_PutChar(json, (json->Format == MCP_JSON_FORMAT_CBOR) ? MCP_CBOR_BREAK : '}');
+
+} /* End MCP_JSON_EndObject */
+
+void MCP_JSON_BeginArray(MCP_JSON_Writer_t *json)
+{
+    MCP_JSON_BeforeValue(json);
+    MCP_JSON_PutChar(json, (json->Format == MCP_JSON_FORMAT_CBOR) ? MCP_CBOR_ARRAY_BEGIN : '[');
+    json->Depth++;
+    json->CommaMask &= ~(1u << (json->Depth % MCP_JSON_MAX_DEPTH));
+
+} /* End MCP_JSON_BeginArray */
+
+void MCP_JSON_EndArray(MCP_JSON_Writer_t *json)
+{
+    json->Depth--;
+    MCP_JSON_PutChar(json, (json->Format == MCP_JSON_FORMAT_CBOR) ? MCP_CBOR_BREAK : ']');
+
+} /* End MCP_JSON_EndArray */
+
+/*
+** Object member name; the next value written belongs to it
+*/
+void MCP_JSON_Key(MCP_JSON_Writer_t *json, const char *key)
+{
+    MCP_JSON_String(json, key);
+    if (json->Format != MCP_JSON_FORMAT_CBOR)
+    {
+        MCP_JSON_PutChar(json, ':');
+    }
+    json->AfterKey = TRUE;
+
+} /* End MCP_JSON_Key */
+
+/*
+** Scalar values
+*/
+void MCP_JSON_String(MCP_JSON_Writer_t *json, const char *value)
+{
+    MCP_JSON_StringN(json, value, (uint32)strlen(value));
+
+} /* End MCP_JSON_String */
+
+void MCP_JSON_StringN(MCP_JSON_Writer_t *json, const char *value, uint32 length)
+{
+    static const char hex[] = "0123456789abcdef";
+    char escape[6];
+    uint32 run = 0;
+    uint32 i;
+    unsigned char c;
+
+    MCP_JSON_BeforeValue(json);
+
+    if (json->Format == MCP_JSON_FORMAT_CBOR)
+    {
+        MCP_JSON_PutCborHead(json, MCP_CBOR_TEXT, length);
+        MCP_JSON_Put(json, value, length);
+        return;
+    }
+
+    MCP_JSON_PutChar(json, '"');
+
+    /* Copy unescaped runs in one piece */
+    for (i = 0; i < length; i++)
+    {
+        c = (unsigned char)value[i];
+        if (c >= 0x20 && c != '"' && c != '\\')
+        {
+            continue;
+        }
+
+        MCP_JSON_Put(json, &value[run], i - run);
+        run = i + 1;
+
+        escape[0] = '\\';
+        switch (c)
+        {
+            case '"':  escape[1] = '"';  break;
+            case '\\': escape[1] = '\\'; break;
+            case '\n': escape[1] = 'n';  break;
+            case '\r': escape[1] = 'r';  break;
+            case '\t': escape[1] = 't';  break;
+            case '\b': escape[1] = 'b';  break;
+            case '\f': escape[1] = 'f';  break;
+            default:
+                escape[1] = 'u';
+                escape[2] = '0';
+                escape[3] = '0';
+                escape[4] = hex[c >> 4];
+                escape[5] = hex[c & 0x0F];
+                MCP_JSON_Put(json, escape, 6);
+                continue;
+        }
+        MCP_JSON_Put(json, escape, 2);
+    }
+
+    MCP_JSON_Put(json, &value[run], length - run);
+    MCP_JSON_PutChar(json, '"');
+
+} /* End MCP_JSON_StringN */
+
+void MCP_JSON_Uint(MCP_JSON_Writer_t *json, uint32 value)
+{
+    MCP_JSON_BeforeValue(json);
+    if (json->Format == MCP_JSON_FORMAT_CBOR)
+    {
+        MCP_JSON_PutCborHead(json, MCP_CBOR_UINT, value);
+        return;
+    }
+    MCP_JSON_PutDigits(json, value);
+
+} /* End MCP_JSON_Uint */
+
+void MCP_JSON_Int(MCP_JSON_Writer_t *json, int32 value)
+{
+    MCP_JSON_BeforeValue(json);
+    if (json->Format == MCP_JSON_FORMAT_CBOR)
+    {
+        if (value < 0)
+        {
+            MCP_JSON_PutCborHead(json, MCP_CBOR_NEGINT, (uint32)(-(value + 1)));
+        }
+        else
+        {
+            MCP_JSON_PutCborHead(json, MCP_CBOR_UINT, (uint32)value);
+        }
+        return;
+    }
+
+    if (value < 0)
+    {
+        MCP_JSON_PutChar(json, '-');
+        MCP_JSON_PutDigits(json, (uint32)(-(value + 1)) + 1);
+    }
+    else
+    {
+        MCP_JSON_PutDigits(json, (uint32)value);
+    }
+
+} /* End MCP_JSON_Int */
+
+void MCP_JSON_Bool(MCP_JSON_Writer_t *json, boolean value)
+{
+    MCP_JSON_BeforeValue(json);
+    if (json->Format == MCP_JSON_FORMAT_CBOR)
+    {
+        MCP_JSON_PutChar(json, value ? MCP_CBOR_TRUE : MCP_CBOR_FALSE);
+    }
+    else if (value)
+    {
+        MCP_JSON_Put(json, "true", 4);
+    }
+    else
+    {
+        MCP_JSON_Put(json, "false", 5);
+    }
+
+} /* End MCP_JSON_Bool */
+
+/*
+** Binary data, as a hex string in text or a byte string in CBOR
+*/
+void MCP_JSON_Bytes(MCP_JSON_Writer_t *json, const uint8 *data, uint32 length)
+{
+    static const char hex[] = "0123456789abcdef";
+    char chunk[64];
+    uint32 used = 0;
+    uint32 i;
+
+    MCP_JSON_BeforeValue(json);
+
+    if (json->Format == MCP_JSON_FORMAT_CBOR)
+    {
+        MCP_JSON_PutCborHead(json, MCP_CBOR_BYTES, length);
+        MCP_JSON_Put(json, (const char *)data, length);
+        return;
+    }
+
+    MCP_JSON_PutChar(json, '"');
+
+    for (i = 0; i < length; i++)
+    {
+        chunk[used++] = hex[data[i] >> 4];
+        chunk[used++] = hex[data[i] & 0x0F];
+        if (used == sizeof(chunk))
+        {
+            MCP_JSON_Put(json, chunk, used);
+            used = 0;
+        }
+    }
+
+    MCP_JSON_Put(json, chunk, used);
+    MCP_JSON_PutChar(json, '"');
+
+} /* End MCP_JSON_Bytes */
+
+/*
+** Byte string value, base64 encoded in JSON and a byte string in CBOR
+*/
+void MCP_JSON_Base64(MCP_JSON_Writer_t *json, const uint8 *data, uint32 length)
+{
+    static const char alphabet[] =
+        "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+    char chunk[64];
+    uint32 used = 0;
+    uint32 bits;
+    uint32 i;
+
+    if (json->Format == MCP_JSON_FORMAT_CBOR)
+    {
+        MCP_JSON_Bytes(json, data, length);
+        return;
+    }
+
+    MCP_JSON_BeforeValue(json);
+    MCP_JSON_PutChar(json, '"');
+
+    for (i = 0; i < length; i += 3)
+    {
+        bits = (uint32)data[i] << 16;
+        if (i + 1 < length)
+        {
+            bits |= (uint32)data[i + 1] << 8;
+        }
+        if (i + 2 < length)
+        {
+            bits |= data[i + 2];
+        }
+
+        chunk[used++] = alphabet[(bits >> 18) & 0x3F];
+        chunk[used++] = alphabet[(bits >> 12) & 0x3F];
+        chunk[used++] = (i + 1 < length) ? alphabet[(bits >> 6) & 0x3F] : '=';
+        chunk[used++] = (i + 2 < length) ? alphabet[bits & 0x3F] : '=';
+        if (used == sizeof(chunk))
+        {
+            MCP_JSON_Put(json, chunk, used);
+            used = 0;
+        }
+    }
+
+    MCP_JSON_Put(json, chunk, used);
+    MCP_JSON_PutChar(json, '"');
+
+} /* End MCP_JSON_Base64 */
+
+/*
+** Already-encoded value in the writer's format, copied as is
+*/
+void MCP_JSON_Raw(MCP_JSON_Writer_t *json, const char *text, uint32 length)
+{
+    MCP_JSON_BeforeValue(json);
+    MCP_JSON_Put(json, text, length);
+
+} /* End MCP_JSON_Raw */
+
+/*
+** Object member shorthands
+*/
+void MCP_JSON_KeyString(MCP_JSON_Writer_t *json, const char *key, const char *value)
+{
+    MCP_JSON_Key(json, key);
+    MCP_JSON_String(json, value);
+
+} /* End MCP_JSON_KeyString */
+
+void MCP_JSON_KeyUint(MCP_JSON_Writer_t *json, const char *key, uint32 value)
+{
+    MCP_JSON_Key(json, key);
+    MCP_JSON_Uint(json, value);
+
+} /* End MCP_JSON_KeyUint */
+
+void MCP_JSON_KeyInt(MCP_JSON_Writer_t *json, const char *key, int32 value)
+{
+    MCP_JSON_Key(json, key);
+    MCP_JSON_Int(json, value);
+
+} /* End MCP_JSON_KeyInt */
+
+void MCP_JSON_KeyBool(MCP_JSON_Writer_t *json, const char *key, boolean value)
+{
+    MCP_JSON_Key(json, key);
+    MCP_JSON_Bool(json, value);
+
+} /* End MCP_JSON_KeyBool */
+
+/*
+** Append bytes, keeping the buffer NUL terminated
+*/
+static void MCP_JSON_Put(MCP_JSON_Writer_t *json, const char *data, uint32 length)
+{
+    if (json->Overflow || length >= json->Size - json->Length)
+    {
+        json->Overflow = TRUE;
+        return;
+    }
+
+    memcpy(&json->Buffer[json->Length], data, length);
+    json->Length += length;
+    json->Buffer[json->Length] = '\0';
+
+} /* End MCP_JSON_Put */
+
+static void MCP_JSON_PutChar(MCP_JSON_Writer_t *json, char c)
+{
+    MCP_JSON_Put(json, &c, 1);
+
+} /* End MCP_JSON_PutChar */
+
+/*
+** Emit the separator a value needs in its container
+*/
+static void MCP_JSON_BeforeValue(MCP_JSON_Writer_t *json)
+{
+    uint32 bit = 1u << (json->Depth % MCP_JSON_MAX_DEPTH);
+
+    /* CBOR needs no separators */
+    if (json->AfterKey || json->Format == MCP_JSON_FORMAT_CBOR)
+    {
+        json->AfterKey = FALSE;
+        return;
+    }
+
+    if (json->CommaMask & bit)
+    {
+        MCP_JSON_PutChar(json, ',');
+    }
+    json->CommaMask |= bit;
+
+} /* End MCP_JSON_BeforeValue */
+
+static void MCP_JSON_PutDigits(MCP_JSON_Writer_t *json, uint32 value)
+{
+    char digits[10];
+    uint32 pos = sizeof(digits);
+
+    do
+    {
+        digits[--pos] = (char)('0' + (value % 10));
+        value /= 10;
+    } while (value != 0);
+
+    MCP_JSON_Put(json, &digits[pos], sizeof(digits) - pos);
+
+} /* End MCP_JSON_PutDigits */
+
+/*
+** CBOR item head: major type plus the shortest argument encoding
+*/
+static void MCP_JSON_PutCborHead(MCP_JSON_Writer_t *json, uint8 major, uint32 value)
+{
+    char head[5];
+    uint32 length;
+
+    if (value < 24)
+    {
+        head[0] = (char)((major << 5) | value);
+        length = 1;
+    }
+    else if (value <= 0xFF)
+    {
+        head[0] = (char)((major << 5) | 24);
+        head[1] = (char)value;
+        length = 2;
+    }
+    else if (value <= 0xFFFF)
+    {
+        head[0] = (char)((major << 5) | 25);
+        head[1] = (char)(value >> 8);
+        head[2] = (char)value;
+        length = 3;
+    }
+    else
+    {
+        head[0] = (char)((major << 5) | 26);
+        head[1] = (char)(value >> 24);
+        head[2] = (char)(value >> 16);
+        head[3] = (char)(value >> 8);
+        head[4] = (char)value;
+        length = 5;
+    }
+
+    MCP_JSON_Put(json, head, length);
+
+} /* End MCP_JSON_PutCborHead */
@@ -0,0 +1,80 @@
+/*
+** MCP Interface JSON Writer Header File
+**
+** Single-pass, allocation-free JSON writer. Output is compact, strings
+** are escaped, and everything is written into a caller-provided buffer.
+** The same calls can emit CBOR instead of text for binary clients.
+** Running out of space sets an overflow flag instead of truncating
+** silently; a mark taken earlier can be rewound to discard output.
+*/
+
+#ifndef MCP_JSON_WRITER_H
+#define MCP_JSON_WRITER_H
+
+#include "cfe.h"
+
+/*
+** Maximum nesting of objects and arrays
+*/
+#define MCP_JSON_MAX_DEPTH                    32
+
+/*
+** Output formats
+*/
+#define MCP_JSON_FORMAT_TEXT                  0
+#define MCP_JSON_FORMAT_CBOR                  1
+
+/*
+** Writer state
+*/
+typedef struct {
+    char *Buffer;
+    uint32 Size;
+    uint32 Length;
+    uint32 Depth;
+    uint32 CommaMask;
+    boolean AfterKey;
+    boolean Overflow;
+    uint8 Format;
+} MCP_JSON_Writer_t;
+
+/*
+** Saved writer position for MCP_JSON_Rewind
+*/
+typedef struct {
+    uint32 Length;
+    uint32 Depth;
+    uint32 CommaMask;
+    boolean AfterKey;
+} MCP_JSON_Mark_t;
+
+/*
+** Function Prototypes
+*/
+void MCP_JSON_Init(MCP_JSON_Writer_t *json, char *buffer, uint32 size);
+void MCP_JSON_SetFormat(MCP_JSON_Writer_t *json, uint8 format);
+boolean MCP_JSON_Ok(const MCP_JSON_Writer_t *json);
+MCP_JSON_Mark_t MCP_JSON_GetMark(const MCP_JSON_Writer_t *json);
+void MCP_JSON_Rewind(MCP_JSON_Writer_t *json, const MCP_JSON_Mark_t *mark);
+
+void MCP_JSON_BeginObject(MCP_JSON_Writer_t *json);
+void MCP_JSON_EndObject(MCP_JSON_Writer_t *json);
+void MCP_JSON_BeginArray(MCP_JSON_Writer_t *json);
+void MCP_JSON_EndArray(MCP_JSON_Writer_t *json);
+void MCP_JSON_Key(MCP_JSON_Writer_t *json, const char *key);
+
+void MCP_JSON_String(MCP_JSON_Writer_t *json, const char *value);
+void MCP_JSON_StringN(MCP_JSON_Writer_t *json, const char *value, uint32 length);
+void MCP_JSON_Uint(MCP_JSON_Writer_t *json, uint32 value);
+void MCP_JSON_Int(MCP_JSON_Writer_t *json, int32 value);
+void MCP_JSON_Bool(MCP_JSON_Writer_t *json, boolean value);
+void MCP_JSON_Bytes(MCP_JSON_Writer_t *json, const uint8 *data, uint32 length);
+void MCP_JSON_Base64(MCP_JSON_Writer_t *json, const uint8 *data, uint32 length);
+void MCP_JSON_Raw(MCP_JSON_Writer_t *json, const char *text, uint32 length);
+
+void MCP_JSON_KeyString(MCP_JSON_Writer_t *json, const char *key, const char *value);
+void MCP_JSON_KeyUint(MCP_JSON_Writer_t *json, const char *key, uint32 value);
+void MCP_JSON_KeyInt(MCP_JSON_Writer_t *json, const char *key, int32 value);
+void MCP_JSON_KeyBool(MCP_JSON_Writer_t *json, const char *key, boolean value);
+
+#endif /* MCP_JSON_WRITER_H */
@@ -0,0 +1,271 @@
+/*
+** MCP Interface Request Metrics
+**
+** This file contains the request counters and latency histograms
+** reported in housekeeping telemetry and by GET_METRICS. Metrics are
+** recorded by whichever task sees the event: the socket task for bytes,
+** parsing, queueing and connections, the task running a handler for its
+** execution time. Every update is a relaxed atomic add, so recording
+** takes no lock, and a reset stores zero word by word, so an update
+** racing it either lands before the reset or counts afresh after it.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+#include <time.h>
+
+/*
+** Local function prototypes
+*/
+static void MCP_INTERFACE_WriteHistogram(MCP_JSON_Writer_t *json, const char *key, const uint32 *histogram);
+static uint32 MCP_INTERFACE_HistogramPercentile(const uint32 *histogram, uint32 total, uint32 per_mille);
+
+/*
+** Microseconds since an arbitrary start, for measuring short intervals
+**
+** Wraps every 71 minutes; differences of two readings stay correct.
+*/
+uint32 MCP_INTERFACE_MetricsNowUs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32)now.tv_sec * 1000000 + (uint32)(now.tv_nsec / 1000);
+
+} /* End MCP_INTERFACE_MetricsNowUs */
+
+/*
+** Milliseconds on the same clock, for timers and rate limits
+**
+** Wraps every 49 days; times are only compared as differences.
+*/
+uint32 MCP_INTERFACE_MetricsNowMs(void)
+{
+    struct timespec now;
+
+    clock_gettime(CLOCK_MONOTONIC, &now);
+
+    return (uint32)now.tv_sec * 1000 + (uint32)(now.tv_nsec / 1000000);
+
+} /* End MCP_INTERFACE_MetricsNowMs */
+
+/*
+** Add to a metrics counter
+*/
+void MCP_INTERFACE_CountMetric(uint32 *counter, uint32 amount)
+{
+    (void)__atomic_fetch_add(counter, amount, __ATOMIC_RELAXED);
+
+} /* End MCP_INTERFACE_CountMetric */
+
+/*
+** Count a finished or rejected request of a type
+*/
+void MCP_INTERFACE_CountRequestType(MCP_CommandType_t type, boolean success)
+{
+    MCP_INTERFACE_Metrics_t *metrics = &MCP_INTERFACE_AppData.Metrics;
+
+    if ((uint32)type >= MCP_CMD_MAX || (uint32)type >= MCP_INTERFACE_METRICS_REQUEST_TYPES)
+    {
+        return;
+    }
+
+    MCP_INTERFACE_CountMetric(&metrics->Requests[type], 1);
+    if (!success)
+    {
+        MCP_INTERFACE_CountMetric(&metrics->Errors[type], 1);
+    }
+
+} /* End MCP_INTERFACE_CountRequestType */
+
+/*
+** Count a latency in its log2 bucket
+*/
+void MCP_INTERFACE_RecordLatency(uint32 *histogram, uint32 elapsed_us)
+{
+    uint32 bucket = 0;
+
+    if (elapsed_us > 0)
+    {
+        bucket = 32 - (uint32)__builtin_clz(elapsed_us);
+    }
+    if (bucket >= MCP_INTERFACE_METRICS_BUCKETS)
+    {
+        bucket = MCP_INTERFACE_METRICS_BUCKETS - 1;
+    }
+
+    MCP_INTERFACE_CountMetric(&histogram[bucket], 1);
+
+} /* End MCP_INTERFACE_RecordLatency */
+
+/*
+** Copy the metrics, one counter at a time
+*/
+void MCP_INTERFACE_CopyMetrics(MCP_INTERFACE_Metrics_t *copy)
+{
+    const uint32 *from = (const uint32 *)&MCP_INTERFACE_AppData.Metrics;
+    uint32 *to = (uint32 *)copy;
+    uint32 i;
+
+    for (i = 0; i < sizeof(MCP_INTERFACE_Metrics_t) / sizeof(uint32); i++)
+    {
+        to[i] = __atomic_load_n(&from[i], __ATOMIC_RELAXED);
+    }
+
+} /* End MCP_INTERFACE_CopyMetrics */
+
+/*
+** Zero the metrics
+*/
+void MCP_INTERFACE_ResetMetrics(void)
+{
+    uint32 *counters = (uint32 *)&MCP_INTERFACE_AppData.Metrics;
+    uint32 i;
+
+    for (i = 0; i < sizeof(MCP_INTERFACE_Metrics_t) / sizeof(uint32); i++)
+    {
+        __atomic_store_n(&counters[i], 0, __ATOMIC_RELAXED);
+    }
+
+} /* End MCP_INTERFACE_ResetMetrics */
+
+/*
+** Write the metrics as a GET_METRICS result
+**
+** Each histogram has its bucket counts and the p50, p99 and p999
+** latencies, given as the upper limit of the bucket the percentile
+** falls in (the lower limit for the unbounded last bucket).
+*/
+void MCP_INTERFACE_WriteMetrics(MCP_JSON_Writer_t *json)
+{
+    MCP_INTERFACE_Metrics_t metrics;
+    uint32 type;
+    uint32 i;
+
+    MCP_INTERFACE_CopyMetrics(&metrics);
+
+    MCP_JSON_BeginObject(json);
+
+    MCP_JSON_Key(json, "requests");
+    MCP_JSON_BeginObject(json);
+    for (type = 0; type < MCP_CMD_MAX && type < MCP_INTERFACE_METRICS_REQUEST_TYPES; type++)
+    {
+        MCP_JSON_Key(json, MCP_INTERFACE_RequestTypes[type].Name);
+        MCP_JSON_BeginObject(json);
+        MCP_JSON_KeyUint(json, "count", metrics.Requests[type]);
+        MCP_JSON_KeyUint(json, "errors", metrics.Errors[type]);
+        MCP_JSON_EndObject(json);
+    }
+    MCP_JSON_EndObject(json);
+
+    MCP_JSON_Key(json, "bucket_limits_us");
+    MCP_JSON_BeginArray(json);
+    for (i = 0; i < MCP_INTERFACE_METRICS_BUCKETS - 1; i++)
+    {
+        MCP_JSON_Uint(json, (uint32)1 << i);
+    }
+    MCP_JSON_EndArray(json);
+
+    MCP_INTERFACE_WriteHistogram(json, "queue_latency", metrics.QueueLatency);
+    MCP_INTERFACE_WriteHistogram(json, "exec_latency", metrics.ExecLatency);
+
+    MCP_JSON_KeyUint(json, "bytes_in", metrics.BytesIn);
+    MCP_JSON_KeyUint(json, "bytes_out", metrics.BytesOut);
+    MCP_JSON_KeyUint(json, "parse_time_us", metrics.ParseTimeUs);
+    MCP_JSON_KeyUint(json, "format_time_us", metrics.FormatTimeUs);
+    MCP_JSON_KeyUint(json, "rejected_connections", metrics.RejectedConnections);
+    MCP_JSON_KeyUint(json, "accept_errors", metrics.AcceptErrors);
+    MCP_JSON_KeyUint(json, "safety_blocks", metrics.SafetyBlocks);
+    MCP_JSON_Key(json, "response_cache");
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyUint(json, "hits", metrics.ResponseCacheHits);
+    MCP_JSON_KeyUint(json, "misses", metrics.ResponseCacheMisses);
+    MCP_JSON_EndObject(json);
+    MCP_JSON_Key(json, "admission");
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyUint(json, "queued", metrics.CommandsQueued);
+    MCP_JSON_KeyUint(json, "rate_limited", metrics.CommandsRateLimited);
+    MCP_JSON_KeyUint(json, "expired", metrics.CommandsExpired);
+    MCP_JSON_EndObject(json);
+    MCP_JSON_Key(json, "sequences");
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyUint(json, "started", metrics.SequencesStarted);
+    MCP_JSON_KeyUint(json, "steps_sent", metrics.SequenceStepsSent);
+    MCP_JSON_KeyUint(json, "aborted", metrics.SequencesAborted);
+    MCP_JSON_EndObject(json);
+    MCP_JSON_Key(json, "confirmations");
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyUint(json, "issued", metrics.ConfirmationsIssued);
+    MCP_JSON_KeyUint(json, "used", metrics.ConfirmationsUsed);
+    MCP_JSON_KeyUint(json, "expired", metrics.ConfirmationsExpired);
+    MCP_JSON_EndObject(json);
+    MCP_JSON_Key(json, "audit");
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyUint(json, "entries", metrics.AuditEntries);
+    MCP_JSON_KeyUint(json, "dropped", metrics.AuditDropped);
+    MCP_JSON_KeyUint(json, "batches", metrics.AuditBatches);
+    MCP_JSON_EndObject(json);
+    MCP_JSON_EndObject(json);
+
+} /* End MCP_INTERFACE_WriteMetrics */
+
+/*
+** Write one latency histogram with its percentiles
+*/
+static void MCP_INTERFACE_WriteHistogram(MCP_JSON_Writer_t *json, const char *key, const uint32 *histogram)
+{
+    uint32 total = 0;
+    uint32 i;
+
+    MCP_JSON_Key(json, key);
+    MCP_JSON_BeginObject(json);
+
+    MCP_JSON_Key(json, "buckets");
+    MCP_JSON_BeginArray(json);
+    for (i = 0; i < MCP_INTERFACE_METRICS_BUCKETS; i++)
+    {
+        MCP_JSON_Uint(json, histogram[i]);
+        total += histogram[i];
+    }
+    MCP_JSON_EndArray(json);
+
+    MCP_JSON_KeyUint(json, "count", total);
+    MCP_JSON_KeyUint(json, "p50_us", MCP_INTERFACE_HistogramPercentile(histogram, total, 500));
+    MCP_JSON_KeyUint(json, "p99_us", MCP_INTERFACE_HistogramPercentile(histogram, total, 990));
+    MCP_JSON_KeyUint(json, "p999_us", MCP_INTERFACE_HistogramPercentile(histogram, total, 999));
+    MCP_JSON_EndObject(json);
+
+} /* End MCP_INTERFACE_WriteHistogram */
+
+/*
+** Latency limit of the bucket holding a percentile, 0 when empty
+*/
+static uint32 MCP_INTERFACE_HistogramPercentile(const uint32 *histogram, uint32 total, uint32 per_mille)
+{
+    uint64 rank;
+    uint64 seen = 0;
+    uint32 i;
+
+    if (total == 0)
+    {
+        return 0;
+    }
+
+    /* The smallest latency at or above per_mille of the samples */
+    rank = ((uint64)total * per_mille + 999) / 1000;
+
+    for (i = 0; i < MCP_INTERFACE_METRICS_BUCKETS - 1; i++)
+    {
+        seen += histogram[i];
+        if (seen >= rank)
+        {
+            return (uint32)1 << i;
+        }
+    }
+
+    return (uint32)1 << (MCP_INTERFACE_METRICS_BUCKETS - 2);
+
+} /* End MCP_INTERFACE_HistogramPercentile */
@@ -0,0 +1,244 @@
+/*
+** MCP Interface Response Cache
+**
+** This file contains the cache of encoded results of read-only
+** requests. Agents poll status and telemetry several times a second;
+** a repeat within the freshness window of its type is answered by
+** copying the result bytes of the first answer into the new response,
+** so only the envelope (id, status and timestamp) is written again.
+** Results are kept per output format, as text and CBOR results differ.
+** Every access is made with the data mutex held: the cacheable request
+** types never run on a worker.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+
+/*
+** Local function prototypes
+*/
+static uint32 MCP_INTERFACE_ResponseTtlUs(const MCP_Request_t *request);
+static uint8 MCP_INTERFACE_ResponseTlmSlot(const MCP_Request_t *request);
+static boolean MCP_INTERFACE_ResponseKeyMatches(const MCP_INTERFACE_CachedResponse_t *entry,
+                                                const MCP_Request_t *request, uint8 format);
+
+/*
+** Empty the cache at startup
+*/
+void MCP_INTERFACE_InitResponseCache(void)
+{
+    MCP_INTERFACE_FlushResponseCache();
+
+} /* End MCP_INTERFACE_InitResponseCache */
+
+/*
+** Answer a request from the cache
+**
+** Returns TRUE with the cached result written into the started response
+** when a fresh result for the same request is held.
+*/
+boolean MCP_INTERFACE_ReplayResponse(const MCP_Request_t *request, MCP_Response_t *response)
+{
+    MCP_INTERFACE_CachedResponse_t *entry;
+    uint32 now_us;
+    uint32 i;
+
+    if (MCP_INTERFACE_ResponseTtlUs(request) == 0)
+    {
+        return FALSE;
+    }
+
+    now_us = MCP_INTERFACE_MetricsNowUs();
+
+    for (i = 0; i < MCP_RESPONSE_CACHE_ENTRIES; i++)
+    {
+        entry = &MCP_INTERFACE_AppData.ResponseCache.Entries[i];
+        if (MCP_INTERFACE_ResponseKeyMatches(entry, request, response->result->Format) &&
+            now_us - entry->StoredUs < entry->TtlUs)
+        {
+            MCP_JSON_Raw(response->result, entry->Result, entry->Length);
+            response->status = 0;
+            MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.ResponseCacheHits, 1);
+            return TRUE;
+        }
+    }
+
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.ResponseCacheMisses, 1);
+
+    return FALSE;
+
+} /* End MCP_INTERFACE_ReplayResponse */
+
+/*
+** Keep the result a handler just wrote, if its request is cacheable
+**
+** result_start is where the handler started writing. Failed requests
+** and results too large for an entry are not kept. The entry replaced
+** is the one holding the same request, else an unused one, else the
+** oldest.
+*/
+void MCP_INTERFACE_StoreResponse(const MCP_Request_t *request, const MCP_Response_t *response,
+                                 int32 result, uint32 result_start)
+{
+    MCP_INTERFACE_CachedResponse_t *entry;
+    MCP_INTERFACE_CachedResponse_t *victim = NULL;
+    const MCP_JSON_Writer_t *json = response->result;
+    uint32 ttl_us = MCP_INTERFACE_ResponseTtlUs(request);
+    uint32 length = json->Length - result_start;
+    uint32 now_us;
+    uint32 age_us;
+    uint32 oldest_us = 0;
+    uint32 i;
+
+    if (ttl_us == 0 || result != CFE_SUCCESS || response->status != 0 || !MCP_JSON_Ok(json) ||
+        length > MCP_RESPONSE_CACHE_RESULT_SIZE)
+    {
+        return;
+    }
+
+    now_us = MCP_INTERFACE_MetricsNowUs();
+
+    for (i = 0; i < MCP_RESPONSE_CACHE_ENTRIES; i++)
+    {
+        entry = &MCP_INTERFACE_AppData.ResponseCache.Entries[i];
+        if (MCP_INTERFACE_ResponseKeyMatches(entry, request, json->Format))
+        {
+            victim = entry;
+            break;
+        }
+
+        age_us = (entry->Type == MCP_CMD_MAX) ? 0xFFFFFFFF : now_us - entry->StoredUs;
+        if (victim == NULL || age_us > oldest_us)
+        {
+            victim = entry;
+            oldest_us = age_us;
+        }
+    }
+
+    victim->Type = (uint8)request->type;
+    victim->Format = json->Format;
+    victim->TlmSlot = MCP_INTERFACE_ResponseTlmSlot(request);
+    victim->ParamsLen = (uint8)request->params_len;
+    strncpy(victim->AppName, request->app_name, sizeof(victim->AppName) - 1);
+    victim->AppName[sizeof(victim->AppName) - 1] = '\0';
+    memcpy(victim->Params, request->params, request->params_len);
+    victim->StoredUs = now_us;
+    victim->TtlUs = ttl_us;
+    victim->Length = length;
+    memcpy(victim->Result, &json->Buffer[result_start], length);
+
+} /* End MCP_INTERFACE_StoreResponse */
+
+/*
+** Drop the results that depend on a telemetry cache slot
+**
+** Called by the main task with the data mutex held whenever a packet
+** for the slot is cached.
+*/
+void MCP_INTERFACE_InvalidateResponses(uint32 tlm_slot)
+{
+    MCP_INTERFACE_CachedResponse_t *entry;
+    uint32 i;
+
+    for (i = 0; i < MCP_RESPONSE_CACHE_ENTRIES; i++)
+    {
+        entry = &MCP_INTERFACE_AppData.ResponseCache.Entries[i];
+        if (entry->Type != MCP_CMD_MAX && entry->TlmSlot == tlm_slot)
+        {
+            entry->Type = MCP_CMD_MAX;
+        }
+    }
+
+} /* End MCP_INTERFACE_InvalidateResponses */
+
+/*
+** Drop every cached result
+*/
+void MCP_INTERFACE_FlushResponseCache(void)
+{
+    uint32 i;
+
+    for (i = 0; i < MCP_RESPONSE_CACHE_ENTRIES; i++)
+    {
+        MCP_INTERFACE_AppData.ResponseCache.Entries[i].Type = MCP_CMD_MAX;
+    }
+
+} /* End MCP_INTERFACE_FlushResponseCache */
+
+/*
+** Freshness window of a request's result, 0 when it must not be cached
+**
+** Only pure reads are cached, and only with params short enough to be
+** kept as part of the key.
+*/
+static uint32 MCP_INTERFACE_ResponseTtlUs(const MCP_Request_t *request)
+{
+    if (request->params_len > MCP_RESPONSE_CACHE_PARAMS_LEN)
+    {
+        return 0;
+    }
+
+    switch (request->type)
+    {
+        case MCP_CMD_GET_TELEMETRY:
+            return MCP_RESPONSE_CACHE_TLM_TTL_MS * 1000;
+
+        case MCP_CMD_GET_SYSTEM_STATUS:
+            return MCP_RESPONSE_CACHE_STATUS_TTL_MS * 1000;
+
+        case MCP_CMD_MANAGE_APP:
+            if (strcmp(request->params, "\"status\"") == 0)
+            {
+                return MCP_RESPONSE_CACHE_STATUS_TTL_MS * 1000;
+            }
+            return 0;
+
+        default:
+            return 0;
+    }
+
+} /* End MCP_INTERFACE_ResponseTtlUs */
+
+/*
+** Telemetry cache slot whose next packet makes a result stale
+**
+** Telemetry depends on its app's packet and app status on CFE_ES
+** housekeeping. The app's own telemetry has no packet and only expires.
+*/
+static uint8 MCP_INTERFACE_ResponseTlmSlot(const MCP_Request_t *request)
+{
+    const MCP_INTERFACE_TlmSnapshot_t *snapshot;
+
+    if (request->type == MCP_CMD_GET_TELEMETRY)
+    {
+        snapshot = MCP_INTERFACE_FindTelemetry(request->app_name);
+    }
+    else
+    {
+        snapshot = MCP_INTERFACE_FindTelemetry("CFE_ES");
+    }
+
+    if (snapshot == NULL)
+    {
+        return MCP_RESPONSE_CACHE_NO_SLOT;
+    }
+
+    return (uint8)(snapshot - MCP_INTERFACE_AppData.TlmCache);
+
+} /* End MCP_INTERFACE_ResponseTlmSlot */
+
+/*
+** Whether an entry holds the result of a request in a format
+*/
+static boolean MCP_INTERFACE_ResponseKeyMatches(const MCP_INTERFACE_CachedResponse_t *entry,
+                                                const MCP_Request_t *request, uint8 format)
+{
+    return (entry->Type == (uint8)request->type &&
+            entry->Format == format &&
+            entry->ParamsLen == request->params_len &&
+            strncmp(entry->AppName, request->app_name, sizeof(entry->AppName)) == 0 &&
+            memcmp(entry->Params, request->params, request->params_len) == 0);
+
+} /* End MCP_INTERFACE_ResponseKeyMatches */
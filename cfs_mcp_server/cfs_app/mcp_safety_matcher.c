@@ -0,0 +1,324 @@
+/*
+** MCP Interface Safety Rule Matcher
+**
+** This file contains the safety rule table and the matcher compiled
+** from it. All rules are folded into one Aho-Corasick automaton, so a
+** field is checked against every rule in a single pass over it. The
+** automaton runs over character classes rather than bytes: every
+** character used by some pattern gets a class (both cases share one),
+** everything else falls into class 0, and two extra classes mark the
+** start and end of fields matched whole.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+#include <ctype.h>
+
+/*
+** Reserved character classes
+*/
+#define MCP_SAFETY_CLASS_OTHER                0
+#define MCP_SAFETY_CLASS_BEGIN                1
+#define MCP_SAFETY_CLASS_END                  2
+#define MCP_SAFETY_CLASS_FIRST                3
+
+/*
+** Local function prototypes
+*/
+static void MCP_INTERFACE_CompileSafetyRules(const MCP_INTERFACE_SafetyTbl_t *table,
+                                             MCP_INTERFACE_SafetyMatcher_t *matcher);
+static uint16 MCP_INTERFACE_AddSafetyTransition(MCP_INTERFACE_SafetyMatcher_t *matcher,
+                                                uint16 state, uint16 class_id);
+static uint16 MCP_INTERFACE_SafetyClassOf(MCP_INTERFACE_SafetyMatcher_t *matcher, char c);
+
+/*
+** Register and load the safety rule table
+*/
+int32 MCP_INTERFACE_InitSafetyRules(void)
+{
+    int32 status;
+
+    MCP_INTERFACE_AppData.SafetyTblPtr = NULL;
+
+    status = CFE_TBL_Register(&MCP_INTERFACE_AppData.SafetyTblHandle,
+                              MCP_SAFETY_TBL_NAME,
+                              sizeof(MCP_INTERFACE_SafetyTbl_t),
+                              CFE_TBL_OPT_DEFAULT,
+                              MCP_INTERFACE_ValidateSafetyTbl);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Error registering safety table, RC = 0x%08X\n",
+                           status);
+        return (status);
+    }
+
+    status = CFE_TBL_Load(MCP_INTERFACE_AppData.SafetyTblHandle,
+                          CFE_TBL_SRC_FILE,
+                          MCP_SAFETY_TBL_FILENAME);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Error loading safety table %s, RC = 0x%08X\n",
+                           MCP_SAFETY_TBL_FILENAME, status);
+        return (status);
+    }
+
+    MCP_INTERFACE_ManageSafetyRules();
+
+    return (CFE_SUCCESS);
+
+} /* End MCP_INTERFACE_InitSafetyRules */
+
+/*
+** Give table services a chance to apply a pending load
+**
+** Called with the data mutex held. The compiled matcher does not refer
+** to the table, so the previous rules stay in force if the table
+** becomes unavailable.
+*/
+void MCP_INTERFACE_ManageSafetyRules(void)
+{
+    int32 status;
+
+    CFE_TBL_ReleaseAddress(MCP_INTERFACE_AppData.SafetyTblHandle);
+    CFE_TBL_Manage(MCP_INTERFACE_AppData.SafetyTblHandle);
+
+    status = CFE_TBL_GetAddress((void **)&MCP_INTERFACE_AppData.SafetyTblPtr,
+                                MCP_INTERFACE_AppData.SafetyTblHandle);
+    if (status == CFE_TBL_INFO_UPDATED)
+    {
+        MCP_INTERFACE_CompileSafetyRules(MCP_INTERFACE_AppData.SafetyTblPtr,
+                                         &MCP_INTERFACE_AppData.SafetyMatcher);
+
+        CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_INF_EID,
+                         CFE_EVS_INFORMATION,
+                         "MCP_INTERFACE: Safety table loaded, %u matcher states",
+                         (unsigned int)MCP_INTERFACE_AppData.SafetyMatcher.StateCount);
+    }
+    else if (status != CFE_SUCCESS)
+    {
+        MCP_INTERFACE_AppData.SafetyTblPtr = NULL;
+
+        CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Safety table unavailable, RC = 0x%08X", status);
+    }
+
+} /* End MCP_INTERFACE_ManageSafetyRules */
+
+/*
+** Validate a safety table image before it is loaded
+**
+** Besides checking each rule, make sure the rules are guaranteed to
+** compile within the fixed matcher size.
+*/
+int32 MCP_INTERFACE_ValidateSafetyTbl(void *TblData)
+{
+    MCP_INTERFACE_SafetyTbl_t *table = (MCP_INTERFACE_SafetyTbl_t *)TblData;
+    MCP_INTERFACE_SafetyRule_t *rule;
+    boolean used[256];
+    uint32 states = 1;
+    uint32 classes = MCP_SAFETY_CLASS_FIRST;
+    uint32 i;
+    uint32 j;
+    uint8 c;
+
+    memset(used, 0, sizeof(used));
+
+    for (i = 0; i < MCP_SAFETY_TBL_MAX_RULES; i++)
+    {
+        rule = &table->Rules[i];
+        if (rule->Kind == MCP_SAFETY_RULE_NONE)
+        {
+            continue;
+        }
+
+        if (rule->Kind > MCP_SAFETY_RULE_ACTION ||
+            memchr(rule->Pattern, '\0', sizeof(rule->Pattern)) == NULL ||
+            rule->Pattern[0] == '\0')
+        {
+            CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_ERR_EID,
+                             CFE_EVS_ERROR,
+                             "MCP_INTERFACE: Safety table rule %u is invalid", (unsigned int)i);
+            return CFE_ES_ERR_APPNAME;
+        }
+
+        for (j = 0; rule->Pattern[j] != '\0'; j++)
+        {
+            c = (uint8)toupper((uint8)rule->Pattern[j]);
+            if (!used[c])
+            {
+                used[c] = TRUE;
+                classes++;
+            }
+        }
+
+        states += j + ((rule->Kind == MCP_SAFETY_RULE_APP) ? 2 : 0);
+    }
+
+    if (states > MCP_SAFETY_MAX_STATES || classes > MCP_SAFETY_MAX_CLASSES)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Safety table too large (%u states, %u classes)",
+                         (unsigned int)states, (unsigned int)classes);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_ValidateSafetyTbl */
+
+/*
+** Run the matcher over a field
+**
+** Returns the subset of the wanted MCP_SAFETY_MATCH bits recognized in
+** the field, stopping as soon as one is found. With whole set, patterns
+** only match the complete field.
+*/
+uint8 MCP_INTERFACE_MatchSafetyRules(const char *text, uint32 length, boolean whole, uint8 wanted)
+{
+    const MCP_INTERFACE_SafetyMatcher_t *matcher = &MCP_INTERFACE_AppData.SafetyMatcher;
+    uint16 state = 0;
+    uint8 found = 0;
+    uint32 i;
+
+    if (whole)
+    {
+        state = matcher->Next[state][MCP_SAFETY_CLASS_BEGIN];
+        found |= matcher->Output[state];
+    }
+
+    for (i = 0; i < length && (found & wanted) == 0; i++)
+    {
+        state = matcher->Next[state][matcher->ClassMap[(uint8)text[i]]];
+        found |= matcher->Output[state];
+    }
+
+    if (whole)
+    {
+        state = matcher->Next[state][MCP_SAFETY_CLASS_END];
+        found |= matcher->Output[state];
+    }
+
+    return (uint8)(found & wanted);
+
+} /* End MCP_INTERFACE_MatchSafetyRules */
+
+/*
+** Compile a validated table into the matcher
+*/
+static void MCP_INTERFACE_CompileSafetyRules(const MCP_INTERFACE_SafetyTbl_t *table,
+                                             MCP_INTERFACE_SafetyMatcher_t *matcher)
+{
+    const MCP_INTERFACE_SafetyRule_t *rule;
+    uint16 fail[MCP_SAFETY_MAX_STATES];
+    uint16 queue[MCP_SAFETY_MAX_STATES];
+    uint32 head = 0;
+    uint32 tail = 0;
+    uint16 state;
+    uint16 next;
+    uint16 c;
+    uint32 i;
+    uint32 j;
+
+    memset(matcher, 0, sizeof(*matcher));
+    matcher->StateCount = 1;
+    matcher->ClassCount = MCP_SAFETY_CLASS_FIRST;
+
+    /* Build the trie of all patterns */
+    for (i = 0; i < MCP_SAFETY_TBL_MAX_RULES; i++)
+    {
+        rule = &table->Rules[i];
+        if (rule->Kind == MCP_SAFETY_RULE_NONE)
+        {
+            continue;
+        }
+
+        state = 0;
+        if (rule->Kind == MCP_SAFETY_RULE_APP)
+        {
+            state = MCP_INTERFACE_AddSafetyTransition(matcher, state, MCP_SAFETY_CLASS_BEGIN);
+        }
+
+        for (j = 0; rule->Pattern[j] != '\0'; j++)
+        {
+            state = MCP_INTERFACE_AddSafetyTransition(matcher, state,
+                        MCP_INTERFACE_SafetyClassOf(matcher, rule->Pattern[j]));
+        }
+
+        if (rule->Kind == MCP_SAFETY_RULE_APP)
+        {
+            state = MCP_INTERFACE_AddSafetyTransition(matcher, state, MCP_SAFETY_CLASS_END);
+        }
+
+        matcher->Output[state] |= MCP_SAFETY_MATCH(rule->Kind);
+    }
+
+    /* Breadth first, fill in failure links and complete the transition table */
+    for (c = 0; c < matcher->ClassCount; c++)
+    {
+        next = matcher->Next[0][c];
+        if (next != 0)
+        {
+            fail[next] = 0;
+            queue[tail++] = next;
+        }
+    }
+
+    while (head < tail)
+    {
+        state = queue[head++];
+        matcher->Output[state] |= matcher->Output[fail[state]];
+
+        for (c = 0; c < matcher->ClassCount; c++)
+        {
+            next = matcher->Next[state][c];
+            if (next != 0)
+            {
+                fail[next] = matcher->Next[fail[state]][c];
+                queue[tail++] = next;
+            }
+            else
+            {
+                matcher->Next[state][c] = matcher->Next[fail[state]][c];
+            }
+        }
+    }
+
+} /* End MCP_INTERFACE_CompileSafetyRules */
+
+/*
+** Follow or create a trie edge
+*/
+static uint16 MCP_INTERFACE_AddSafetyTransition(MCP_INTERFACE_SafetyMatcher_t *matcher,
+                                                uint16 state, uint16 class_id)
+{
+    if (matcher->Next[state][class_id] == 0)
+    {
+        matcher->Next[state][class_id] = matcher->StateCount++;
+    }
+
+    return matcher->Next[state][class_id];
+
+} /* End MCP_INTERFACE_AddSafetyTransition */
+
+/*
+** Character class of a pattern character, allocated on first use
+*/
+static uint16 MCP_INTERFACE_SafetyClassOf(MCP_INTERFACE_SafetyMatcher_t *matcher, char c)
+{
+    uint8 upper = (uint8)toupper((uint8)c);
+    uint8 lower = (uint8)tolower((uint8)c);
+
+    if (matcher->ClassMap[upper] == MCP_SAFETY_CLASS_OTHER)
+    {
+        matcher->ClassMap[upper] = (uint8)matcher->ClassCount;
+        matcher->ClassMap[lower] = (uint8)matcher->ClassCount;
+        matcher->ClassCount++;
+    }
+
+    return matcher->ClassMap[upper];
+
+} /* End MCP_INTERFACE_SafetyClassOf */
@@ -9,90 +9,69 @@
 ** Include Files
 */
 #include "mcp_interface_app.h"
-#include <cjson/cJSON.h>
+#include "mcp_json_reader.h"
 
 /*
-** List of commands that require confirmation
+** Local function prototypes
 */
-static const char* critical_commands[] = {
-    "RESET",
-    "RESTART",
-    "STOP",
-    "START",
-    "DELETE",
-    "FORMAT",
-    "POWER_OFF",
-    "REBOOT",
-    NULL
-};
+static int32 MCP_INTERFACE_ParseJSONRequestFields(MCP_JSON_Reader_t *reader, MCP_Request_t *request,
+                                                  boolean allow_default_id, uint32 default_id);
+static void MCP_INTERFACE_ResetRequest(MCP_Request_t *request);
 
 /*
-** List of apps that are critical to system operation
+** Params of a request that carries none
 */
-static const char* critical_apps[] = {
-    "CFE_ES",
-    "CFE_EVS",
-    "CFE_SB",
-    "CFE_TIME",
-    "CFE_TBL",
-    "SCH_LAB",
-    NULL
-};
+static char MCP_INTERFACE_NoParams[1] = "";
 
 /*
 ** Safety check for commands
 */
 boolean MCP_INTERFACE_IsSafeCommand(MCP_Request_t *request)
 {
-    int i;
-    char upper_command[MCP_MAX_CMD_NAME_LEN];
-    char upper_app[MCP_MAX_APP_NAME_LEN];
+    const MCP_INTERFACE_CmdEntry_t *entry;
 
-    /* Convert command to uppercase for comparison */
-    for (i = 0; i < strlen(request->command) && i < sizeof(upper_command) - 1; i++)
+    /* Check if command matches a critical command rule */
+    if (MCP_INTERFACE_MatchSafetyRules(request->command, strlen(request->command), FALSE,
+                                       MCP_SAFETY_MATCH(MCP_SAFETY_RULE_COMMAND)))
     {
-        upper_command[i] = toupper(request->command[i]);
-    }
-    upper_command[i] = '\0';
-
-    /* Convert app name to uppercase for comparison */
-    for (i = 0; i < strlen(request->app_name) && i < sizeof(upper_app) - 1; i++)
-    {
-        upper_app[i] = toupper(request->app_name[i]);
+        /* Critical command found */
+        if (MCP_INTERFACE_AppData.SafetyMode && !request->require_confirmation)
+        {
+            CFE_EVS_SendEvent(MCP_INTERFACE_SAFETY_ERR_EID,
+                            CFE_EVS_ERROR,
+                            "MCP_INTERFACE: Critical command '%s' blocked - requires confirmation",
+                            request->command);
+            return FALSE;
+        }
     }
-    upper_app[i] = '\0';
 
-    /* Check if command is in critical command list */
-    for (i = 0; critical_commands[i] != NULL; i++)
+    /* Commands the dictionary marks critical need confirmation as well */
+    if (request->type == MCP_CMD_SEND_COMMAND && MCP_INTERFACE_AppData.SafetyMode &&
+        !request->require_confirmation)
     {
-        if (strstr(upper_command, critical_commands[i]) != NULL)
+        entry = MCP_INTERFACE_LookupCommand(request->app_name, request->command);
+        if (entry != NULL && (entry->Flags & MCP_CMD_FLAG_CRITICAL))
         {
-            /* Critical command found */
-            if (MCP_INTERFACE_AppData.SafetyMode && !request->require_confirmation)
-            {
-                CFE_EVS_SendEvent(MCP_INTERFACE_SAFETY_ERR_EID,
-                                CFE_EVS_ERROR,
-                                "MCP_INTERFACE: Critical command '%s' blocked - requires confirmation",
-                                request->command);
-                return FALSE;
-            }
+            CFE_EVS_SendEvent(MCP_INTERFACE_SAFETY_ERR_EID,
+                            CFE_EVS_ERROR,
+                            "MCP_INTERFACE: Critical command '%s' blocked - requires confirmation",
+                            request->command);
+            return FALSE;
         }
     }
 
     /* Check if app is critical */
-    for (i = 0; critical_apps[i] != NULL; i++)
+    if (MCP_INTERFACE_MatchSafetyRules(request->app_name, strlen(request->app_name), TRUE,
+                                       MCP_SAFETY_MATCH(MCP_SAFETY_RULE_APP)))
     {
-        if (strcmp(upper_app, critical_apps[i]) == 0)
+        /* Operating on critical app */
+        if (MCP_INTERFACE_AppData.SafetyMode && !request->require_confirmation)
         {
-            /* Operating on critical app */
-            if (MCP_INTERFACE_AppData.SafetyMode && !request->require_confirmation)
-            {
-                CFE_EVS_SendEvent(MCP_INTERFACE_SAFETY_ERR_EID,
-                                CFE_EVS_ERROR,
-                                "MCP_INTERFACE: Command to critical app '%s' blocked - requires confirmation",
-                                request->app_name);
-                return FALSE;
-            }
+            CFE_EVS_SendEvent(MCP_INTERFACE_SAFETY_ERR_EID,
+                            CFE_EVS_ERROR,
+                            "MCP_INTERFACE: Command to critical app '%s' blocked - requires confirmation",
+                            request->app_name);
+            return FALSE;
         }
     }
 
@@ -100,10 +79,8 @@ boolean MCP_INTERFACE_IsSafeCommand(MCP_Request_t *request)
     if (request->type == MCP_CMD_WRITE_FILE || request->type == MCP_CMD_READ_FILE)
     {
         /* Check if trying to access system files */
-        if (strstr(request->params, "/boot") != NULL ||
-            strstr(request->params, "/etc") != NULL ||
-            strstr(request->params, "/sys") != NULL ||
-            strstr(request->params, "/proc") != NULL)
+        if (MCP_INTERFACE_MatchSafetyRules(request->params, request->params_len, FALSE,
+                                           MCP_SAFETY_MATCH(MCP_SAFETY_RULE_PATH)))
         {
             CFE_EVS_SendEvent(MCP_INTERFACE_SAFETY_ERR_EID,
                             CFE_EVS_ERROR,
@@ -122,25 +99,56 @@ boolean MCP_INTERFACE_IsSafeCommand(MCP_Request_t *request)
 
 } /* End MCP_INTERFACE_IsSafeCommand */
 
+/*
+** Safety check for a decoded file path
+**
+** IsSafeCommand sees the params of a file request as sent, so a path
+** spelled with escapes is checked again here once the handler has
+** decoded it. The handler may run on a worker, so the data mutex is
+** taken to keep a table reload from changing the matcher under it.
+*/
+boolean MCP_INTERFACE_IsSafePath(const MCP_Request_t *request, const char *path)
+{
+    char event_msg[MCP_MAX_ERROR_MSG_LEN];
+    uint8 matched;
+
+    OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+    matched = MCP_INTERFACE_MatchSafetyRules(path, strlen(path), FALSE,
+                                             MCP_SAFETY_MATCH(MCP_SAFETY_RULE_PATH));
+    OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+
+    if (matched)
+    {
+        snprintf(event_msg, sizeof(event_msg), "Unsafe %s request %u blocked, path '%s'",
+                MCP_INTERFACE_RequestTypes[request->type].Name, (unsigned int)request->id, path);
+        MCP_INTERFACE_LogSafetyEvent(event_msg, MCP_INTERFACE_SAFETY_ERR_EID);
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.SafetyBlocks, 1);
+        return FALSE;
+    }
+
+    return TRUE;
+
+} /* End MCP_INTERFACE_IsSafePath */
+
 /*
 ** Check if command requires confirmation
 */
 boolean MCP_INTERFACE_RequiresConfirmation(MCP_Request_t *request)
 {
-    int i;
-    char upper_command[MCP_MAX_CMD_NAME_LEN];
+    const MCP_INTERFACE_CmdEntry_t *entry;
 
-    /* Convert command to uppercase for comparison */
-    for (i = 0; i < strlen(request->command) && i < sizeof(upper_command) - 1; i++)
+    /* Check if command matches a critical command rule */
+    if (MCP_INTERFACE_MatchSafetyRules(request->command, strlen(request->command), FALSE,
+                                       MCP_SAFETY_MATCH(MCP_SAFETY_RULE_COMMAND)))
     {
-        upper_command[i] = toupper(request->command[i]);
+        return TRUE;
     }
-    upper_command[i] = '\0';
 
-    /* Check if command is in critical command list */
-    for (i = 0; critical_commands[i] != NULL; i++)
+    /* As do commands the dictionary marks critical */
+    if (request->type == MCP_CMD_SEND_COMMAND)
     {
-        if (strstr(upper_command, critical_commands[i]) != NULL)
+        entry = MCP_INTERFACE_LookupCommand(request->app_name, request->command);
+        if (entry != NULL && (entry->Flags & MCP_CMD_FLAG_CRITICAL))
         {
             return TRUE;
         }
@@ -155,9 +163,8 @@ boolean MCP_INTERFACE_RequiresConfirmation(MCP_Request_t *request)
     /* App management operations require confirmation */
     if (request->type == MCP_CMD_MANAGE_APP)
     {
-        if (strstr(request->params, "start") != NULL ||
-            strstr(request->params, "stop") != NULL ||
-            strstr(request->params, "restart") != NULL)
+        if (MCP_INTERFACE_MatchSafetyRules(request->params, request->params_len, FALSE,
+                                           MCP_SAFETY_MATCH(MCP_SAFETY_RULE_ACTION)))
         {
             return TRUE;
         }
@@ -172,6 +179,8 @@ boolean MCP_INTERFACE_RequiresConfirmation(MCP_Request_t *request)
 */
 int32 MCP_INTERFACE_ValidateRequest(MCP_Request_t *request)
 {
+    uint32 flags;
+
     /* Check request ID */
     if (request->id == 0)
     {
@@ -179,33 +188,41 @@ int32 MCP_INTERFACE_ValidateRequest(MCP_Request_t *request)
     }
 
     /* Check command type */
-    if (request->type >= MCP_CMD_MAX)
+    if ((uint32)request->type >= MCP_CMD_MAX)
     {
         return CFE_ES_ERR_APPNAME;
     }
 
+    flags = MCP_INTERFACE_RequestTypes[request->type].Flags;
+
     /* Validate app name for commands that require it */
-    if (request->type == MCP_CMD_SEND_COMMAND ||
-        request->type == MCP_CMD_GET_TELEMETRY ||
-        request->type == MCP_CMD_MANAGE_APP)
+    if ((flags & MCP_REQ_NEEDS_APP) &&
+        (request->app_name[0] == '\0' || strlen(request->app_name) >= MCP_MAX_APP_NAME_LEN))
     {
-        if (strlen(request->app_name) == 0 || strlen(request->app_name) >= MCP_MAX_APP_NAME_LEN)
-        {
-            return CFE_ES_ERR_APPNAME;
-        }
+        return CFE_ES_ERR_APPNAME;
     }
 
-    /* Validate command name for send command */
-    if (request->type == MCP_CMD_SEND_COMMAND)
+    /* Validate command name for commands that require it */
+    if ((flags & MCP_REQ_NEEDS_COMMAND) &&
+        (request->command[0] == '\0' || strlen(request->command) >= MCP_MAX_CMD_NAME_LEN))
     {
-        if (strlen(request->command) == 0 || strlen(request->command) >= MCP_MAX_CMD_NAME_LEN)
-        {
-            return CFE_ES_ERR_APPNAME;
-        }
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    /* A batch must carry its sub-requests, a subscription its apps and so on */
+    if ((flags & MCP_REQ_NEEDS_PARAMS) && request->params_len == 0)
+    {
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    /* Only a command can be prepared for confirmation */
+    if (request->prepare && !(flags & MCP_REQ_PREPARABLE))
+    {
+        return CFE_ES_ERR_APPNAME;
     }
 
     /* Check parameters length */
-    if (strlen(request->params) >= MCP_MAX_JSON_SIZE)
+    if (request->params_len >= MCP_MAX_JSON_SIZE)
     {
         return CFE_ES_ERR_APPNAME;
     }
@@ -216,6 +233,8 @@ int32 MCP_INTERFACE_ValidateRequest(MCP_Request_t *request)
 
 /*
 ** Log safety event
+**
+** Reported as an event for the ground and kept in the audit log.
 */
 void MCP_INTERFACE_LogSafetyEvent(const char *event_msg, uint32 event_id)
 {
@@ -223,201 +242,502 @@ void MCP_INTERFACE_LogSafetyEvent(const char *event_msg, uint32 event_id)
                      CFE_EVS_ERROR,
                      "MCP_INTERFACE SAFETY: %s", event_msg);
 
-    /* In a real implementation, this would also:
-     * 1. Log to persistent storage
-     * 2. Send alert to ground control
-     * 3. Update system status
-     */
+    MCP_INTERFACE_Audit("SAFETY", "%s", event_msg);
 
 } /* End MCP_INTERFACE_LogSafetyEvent */
 
 /*
 ** Parse JSON request
+**
+** The request text is tokenized in place and only the fields we use
+** are decoded, so parsing takes no heap. Params are decoded over their
+** own text and the request keeps a view of them, which stays valid as
+** long as the text does. The text need not be NUL terminated.
+*/
+int32 MCP_INTERFACE_ParseJSONRequest(char *json_str, uint32 json_len, MCP_Request_t *request)
+{
+    MCP_JSON_Reader_t reader;
+
+    MCP_JSON_ReaderInit(&reader, json_str, json_len);
+
+    return MCP_INTERFACE_ParseJSONRequestFields(&reader, request, FALSE, 0);
+
+} /* End MCP_INTERFACE_ParseJSONRequest */
+
+/*
+** Parse one element of a batch; elements without an id get default_id
+*/
+int32 MCP_INTERFACE_ParseJSONBatchItem(char *json_str, uint32 json_len,
+                                       MCP_Request_t *request, uint32 default_id)
+{
+    MCP_JSON_Reader_t reader;
+
+    MCP_JSON_ReaderInit(&reader, json_str, json_len);
+
+    return MCP_INTERFACE_ParseJSONRequestFields(&reader, request, TRUE, default_id);
+
+} /* End MCP_INTERFACE_ParseJSONBatchItem */
+
+/*
+** Extract request fields from the object under the reader
 */
-int32 MCP_INTERFACE_ParseJSONRequest(const char *json_str, MCP_Request_t *request)
+static int32 MCP_INTERFACE_ParseJSONRequestFields(MCP_JSON_Reader_t *reader, MCP_Request_t *request,
+                                                  boolean allow_default_id, uint32 default_id)
 {
-    cJSON *json = NULL;
-    cJSON *id = NULL;
-    cJSON *type = NULL;
-    cJSON *app_name = NULL;
-    cJSON *command = NULL;
-    cJSON *params = NULL;
-    cJSON *require_confirmation = NULL;
-    cJSON *is_critical = NULL;
-    int32 status = CFE_SUCCESS;
-
-    /* Initialize request structure */
-    memset(request, 0, sizeof(MCP_Request_t));
-
-    /* Parse JSON */
-    json = cJSON_Parse(json_str);
-    if (json == NULL)
+    char key[32];
+    boolean have_id = FALSE;
+    boolean have_type = FALSE;
+    const char *requests = NULL;
+    uint32 requests_len = 0;
+    uint32 type = 0;
+    boolean ok = TRUE;
+
+    MCP_INTERFACE_ResetRequest(request);
+
+    if (!MCP_JSON_ReadObjectBegin(reader))
     {
         return CFE_ES_ERR_APPNAME;
     }
 
-    /* Extract fields */
-    id = cJSON_GetObjectItem(json, "id");
-    if (cJSON_IsNumber(id))
+    while (ok && MCP_JSON_ReadObjectNext(reader, key, sizeof(key)))
     {
-        request->id = (uint32)id->valueint;
-    }
-    else
-    {
-        status = CFE_ES_ERR_APPNAME;
-        goto cleanup;
+        if (strcmp(key, "id") == 0)
+        {
+            ok = MCP_JSON_ReadUint(reader, &request->id);
+            have_id = ok;
+        }
+        else if (strcmp(key, "type") == 0)
+        {
+            ok = MCP_JSON_ReadUint(reader, &type);
+            have_type = ok;
+        }
+        else if (strcmp(key, "app_name") == 0 && MCP_JSON_PeekType(reader) == MCP_JSON_TYPE_STRING)
+        {
+            ok = MCP_JSON_ReadString(reader, request->app_name, sizeof(request->app_name));
+        }
+        else if (strcmp(key, "command") == 0 && MCP_JSON_PeekType(reader) == MCP_JSON_TYPE_STRING)
+        {
+            ok = MCP_JSON_ReadString(reader, request->command, sizeof(request->command));
+        }
+        else if (strcmp(key, "params") == 0 && MCP_JSON_PeekType(reader) == MCP_JSON_TYPE_STRING)
+        {
+            ok = MCP_JSON_ReadStringInPlace(reader, &request->params, &request->params_len);
+        }
+        else if (strcmp(key, "requests") == 0 && MCP_JSON_PeekType(reader) == MCP_JSON_TYPE_ARRAY)
+        {
+            ok = MCP_JSON_ReadRaw(reader, &requests, &requests_len);
+        }
+        else if (strcmp(key, "require_confirmation") == 0 && MCP_JSON_PeekType(reader) == MCP_JSON_TYPE_BOOL)
+        {
+            ok = MCP_JSON_ReadBool(reader, &request->require_confirmation);
+        }
+        else if (strcmp(key, "is_critical") == 0 && MCP_JSON_PeekType(reader) == MCP_JSON_TYPE_BOOL)
+        {
+            ok = MCP_JSON_ReadBool(reader, &request->is_critical);
+        }
+        else if (strcmp(key, "prepare") == 0 && MCP_JSON_PeekType(reader) == MCP_JSON_TYPE_BOOL)
+        {
+            ok = MCP_JSON_ReadBool(reader, &request->prepare);
+        }
+        else
+        {
+            ok = MCP_JSON_SkipValue(reader);
+        }
     }
 
-    type = cJSON_GetObjectItem(json, "type");
-    if (cJSON_IsNumber(type))
+    /* Overlong strings and non-integer ids are rejected rather than truncated */
+    if (!ok || reader->Error || !MCP_JSON_ReadEnd(reader))
     {
-        request->type = (MCP_CommandType_t)type->valueint;
-    }
-    else
-    {
-        status = CFE_ES_ERR_APPNAME;
-        goto cleanup;
+        return CFE_ES_ERR_APPNAME;
     }
 
-    app_name = cJSON_GetObjectItem(json, "app_name");
-    if (cJSON_IsString(app_name) && app_name->valuestring != NULL)
+    if (!have_id)
     {
-        strncpy(request->app_name, app_name->valuestring, sizeof(request->app_name) - 1);
+        if (!allow_default_id)
+        {
+            return CFE_ES_ERR_APPNAME;
+        }
+        request->id = default_id;
     }
 
-    command = cJSON_GetObjectItem(json, "command");
-    if (cJSON_IsString(command) && command->valuestring != NULL)
+    if (!have_type)
     {
-        strncpy(request->command, command->valuestring, sizeof(request->command) - 1);
+        return CFE_ES_ERR_APPNAME;
     }
+    request->type = (MCP_CommandType_t)type;
 
-    params = cJSON_GetObjectItem(json, "params");
-    if (cJSON_IsString(params) && params->valuestring != NULL)
+    /*
+    ** A batch carries its sub-requests as a JSON array, kept as text in
+    ** params. The byte after the array is no longer needed now the whole
+    ** object has been read, so it can take the terminator.
+    */
+    if (request->type == MCP_CMD_BATCH)
     {
-        strncpy(request->params, params->valuestring, sizeof(request->params) - 1);
+        if (requests == NULL)
+        {
+            return CFE_ES_ERR_APPNAME;
+        }
+
+        request->params = (char *)requests;
+        request->params_len = requests_len;
+        request->params[requests_len] = '\0';
     }
 
-    require_confirmation = cJSON_GetObjectItem(json, "require_confirmation");
-    if (cJSON_IsBool(require_confirmation))
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_ParseJSONRequestFields */
+
+/*
+** Clear only what parsing fills in; nothing here is large enough to memset
+*/
+static void MCP_INTERFACE_ResetRequest(MCP_Request_t *request)
+{
+    request->id = 0;
+    request->type = 0;
+    request->app_name[0] = '\0';
+    request->command[0] = '\0';
+    request->params = MCP_INTERFACE_NoParams;
+    request->params_len = 0;
+    request->require_confirmation = FALSE;
+    request->is_critical = FALSE;
+    request->prepare = FALSE;
+    request->client_slot = -1;
+
+} /* End MCP_INTERFACE_ResetRequest */
+
+/*
+** Parse binary request
+**
+** The frame is everything after the length field. Unknown tags are
+** skipped so newer clients can add fields; a value that does not fit
+** its request field rejects the request.
+*/
+int32 MCP_INTERFACE_ParseBinaryRequest(char *frame, uint32 frame_len, MCP_Request_t *request)
+{
+    const uint8 *data = (const uint8 *)frame;
+    uint32 pos = MCP_BINARY_HEADER_SIZE;
+    uint32 length;
+    uint8 tag;
+    char *field;
+    uint32 field_size;
+
+    MCP_INTERFACE_ResetRequest(request);
+
+    if (frame_len < MCP_BINARY_HEADER_SIZE)
     {
-        request->require_confirmation = cJSON_IsTrue(require_confirmation);
+        return CFE_ES_ERR_APPNAME;
     }
 
-    is_critical = cJSON_GetObjectItem(json, "is_critical");
-    if (cJSON_IsBool(is_critical))
+    request->type = (MCP_CommandType_t)data[0];
+    request->require_confirmation = (data[1] & MCP_BINARY_FLAG_REQUIRE_CONFIRMATION) ? TRUE : FALSE;
+    request->is_critical = (data[1] & MCP_BINARY_FLAG_IS_CRITICAL) ? TRUE : FALSE;
+    request->prepare = (data[1] & MCP_BINARY_FLAG_PREPARE) ? TRUE : FALSE;
+    request->id = (uint32)data[2] | ((uint32)data[3] << 8) |
+                  ((uint32)data[4] << 16) | ((uint32)data[5] << 24);
+
+    while (pos < frame_len)
     {
-        request->is_critical = cJSON_IsTrue(is_critical);
+        if (frame_len - pos < 3)
+        {
+            return CFE_ES_ERR_APPNAME;
+        }
+
+        tag = data[pos];
+        length = (uint32)data[pos + 1] | ((uint32)data[pos + 2] << 8);
+        pos += 3;
+
+        if (frame_len - pos < length)
+        {
+            return CFE_ES_ERR_APPNAME;
+        }
+
+        switch (tag)
+        {
+            case MCP_BINARY_TAG_APP_NAME:
+                field = request->app_name;
+                field_size = sizeof(request->app_name);
+                break;
+            case MCP_BINARY_TAG_COMMAND:
+                field = request->command;
+                field_size = sizeof(request->command);
+                break;
+            case MCP_BINARY_TAG_PARAMS:
+                /* Slide the value over its own tag and length to terminate it in place */
+                request->params = &frame[pos - 3];
+                request->params_len = length;
+                memmove(request->params, &frame[pos], length);
+                request->params[length] = '\0';
+                field = NULL;
+                field_size = 0;
+                break;
+            default:
+                field = NULL;
+                field_size = 0;
+                break;
+        }
+
+        if (field != NULL)
+        {
+            if (length >= field_size)
+            {
+                return CFE_ES_ERR_APPNAME;
+            }
+            memcpy(field, &frame[pos], length);
+            field[length] = '\0';
+        }
+
+        pos += length;
     }
 
-cleanup:
-    cJSON_Delete(json);
-    return status;
+    return CFE_SUCCESS;
 
-} /* End MCP_INTERFACE_ParseJSONRequest */
+} /* End MCP_INTERFACE_ParseBinaryRequest */
 
 /*
-** Format JSON response
+** Take a response frame from the output pool
+**
+** Frames are only handed out on the socket task, so the pool needs no
+** lock. Returns NULL when every frame is in use.
 */
-int32 MCP_INTERFACE_FormatJSONResponse(MCP_Response_t *response, char *json_str, uint32 max_len)
+char *MCP_INTERFACE_AcquireOutputBuffer(void)
 {
-    cJSON *json = NULL;
-    char *json_string = NULL;
-    int32 status = CFE_SUCCESS;
+    MCP_INTERFACE_OutputPool_t *pool = &MCP_INTERFACE_AppData.OutputPool;
+    uint32 i;
 
-    /* Create JSON object */
-    json = cJSON_CreateObject();
-    if (json == NULL)
+    for (i = 0; i < MCP_OUTPUT_BUFFER_COUNT; i++)
     {
-        return CFE_ES_ERR_APPNAME;
+        if (!pool->InUse[i])
+        {
+            pool->InUse[i] = TRUE;
+            return pool->Frames[i];
+        }
     }
 
-    /* Add fields */
-    cJSON_AddNumberToObject(json, "id", response->id);
-    cJSON_AddNumberToObject(json, "status", response->status);
-    cJSON_AddNumberToObject(json, "timestamp", response->timestamp);
+    return NULL;
+
+} /* End MCP_INTERFACE_AcquireOutputBuffer */
 
-    if (response->status == 0)
+/*
+** Return a response frame to the output pool
+*/
+void MCP_INTERFACE_ReleaseOutputBuffer(char *frame)
+{
+    MCP_INTERFACE_OutputPool_t *pool = &MCP_INTERFACE_AppData.OutputPool;
+    uint32 i;
+
+    for (i = 0; i < MCP_OUTPUT_BUFFER_COUNT; i++)
     {
-        /* Success - add result */
-        cJSON *result_json = cJSON_Parse(response->result);
-        if (result_json != NULL)
-        {
-            cJSON_AddItemToObject(json, "result", result_json);
-        }
-        else
+        if (pool->Frames[i] == frame)
         {
-            cJSON_AddStringToObject(json, "result", response->result);
+            pool->InUse[i] = FALSE;
+            return;
         }
     }
-    else
+
+} /* End MCP_INTERFACE_ReleaseOutputBuffer */
+
+/*
+** Set up a response writer over a frame buffer of MCP_RESPONSE_FRAME_SIZE
+** bytes, leaving room in front for the frame header. Binary clients get
+** CBOR output.
+*/
+void MCP_INTERFACE_InitResponseWriter(MCP_JSON_Writer_t *json, char *frame, int32 client_slot)
+{
+    MCP_JSON_Init(json, &frame[MCP_FRAME_HEADER_SIZE], MCP_MAX_JSON_SIZE);
+
+    if (MCP_INTERFACE_AppData.Clients[client_slot].Framing == MCP_FRAMING_BINARY)
     {
-        /* Error - add error message */
-        cJSON_AddStringToObject(json, "error", response->error_msg);
+        MCP_JSON_SetFormat(json, MCP_JSON_FORMAT_CBOR);
     }
 
-    /* Convert to string */
-    json_string = cJSON_Print(json);
-    if (json_string == NULL)
+} /* End MCP_INTERFACE_InitResponseWriter */
+
+/*
+** Start a JSON response
+**
+** Writes the opening of the response object and the "result" key, so
+** the handler can emit its result straight into the output.
+*/
+void MCP_INTERFACE_BeginJSONResponse(MCP_Response_t *response, MCP_JSON_Writer_t *json, uint32 id)
+{
+    response->id = id;
+    response->status = 0;
+    response->error_msg[0] = '\0';
+    response->timestamp = CFE_TIME_GetTime().Seconds;
+    response->result = json;
+    response->stream_fd = -1;
+
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyUint(json, "id", id);
+    response->result_mark = MCP_JSON_GetMark(json);
+    MCP_JSON_Key(json, "result");
+
+} /* End MCP_INTERFACE_BeginJSONResponse */
+
+/*
+** Finish a JSON response
+**
+** On failure whatever the handler wrote as its result is discarded and
+** replaced by the error message.
+*/
+void MCP_INTERFACE_EndJSONResponse(MCP_Response_t *response)
+{
+    MCP_JSON_Writer_t *json = response->result;
+
+    if (response->status == 0 && !MCP_JSON_Ok(json))
     {
-        status = CFE_ES_ERR_APPNAME;
-        goto cleanup;
+        response->status = -1;
+        strncpy(response->error_msg, "Response too large", sizeof(response->error_msg) - 1);
     }
 
-    /* Copy to output buffer */
-    if (strlen(json_string) >= max_len)
+    if (response->status != 0)
     {
-        status = CFE_ES_ERR_APPNAME;
-        goto cleanup;
+        MCP_JSON_Rewind(json, &response->result_mark);
+        MCP_JSON_KeyString(json, "error", response->error_msg);
     }
 
-    strcpy(json_str, json_string);
+    MCP_JSON_KeyInt(json, "status", response->status);
+    MCP_JSON_KeyUint(json, "timestamp", response->timestamp);
+    MCP_JSON_EndObject(json);
 
-cleanup:
-    if (json_string != NULL)
+} /* End MCP_INTERFACE_EndJSONResponse */
+
+/*
+** Send MCP response
+**
+** The writer must have been set up with MCP_INTERFACE_InitResponseWriter.
+** The frame may be reused as soon as this returns.
+*/
+int32 MCP_INTERFACE_SendMCPResponse(int32 client_slot, MCP_JSON_Writer_t *json)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[client_slot];
+    char *json_str = json->Buffer;
+    char *frame = json_str - MCP_FRAME_HEADER_SIZE;
+    const char *send_ptr;
+    uint32 json_len;
+    size_t send_len;
+    int32 status;
+    uint8 format = json->Format;
+    uint32 start_us = MCP_INTERFACE_MetricsNowUs();
+
+    if (!MCP_JSON_Ok(json))
+    {
+        /* Even the error envelope did not fit */
+        MCP_JSON_Init(json, json_str, MCP_MAX_JSON_SIZE);
+        MCP_JSON_SetFormat(json, format);
+        MCP_JSON_BeginObject(json);
+        MCP_JSON_KeyString(json, "error", "Failed to format response");
+        MCP_JSON_KeyInt(json, "status", -1);
+        MCP_JSON_EndObject(json);
+    }
+    json_len = json->Length;
+
+    /* Frame the response the same way the client frames its requests */
+    if (client->Framing == MCP_FRAMING_LENGTH_PREFIX)
+    {
+        frame[0] = (char)((json_len >> 24) & 0xFF);
+        frame[1] = (char)((json_len >> 16) & 0xFF);
+        frame[2] = (char)((json_len >> 8) & 0xFF);
+        frame[3] = (char)(json_len & 0xFF);
+        send_ptr = frame;
+        send_len = MCP_FRAME_HEADER_SIZE + json_len;
+    }
+    else if (client->Framing == MCP_FRAMING_BINARY)
+    {
+        frame = json_str - MCP_BINARY_LENGTH_SIZE;
+        frame[0] = (char)(json_len & 0xFF);
+        frame[1] = (char)((json_len >> 8) & 0xFF);
+        send_ptr = frame;
+        send_len = MCP_BINARY_LENGTH_SIZE + json_len;
+    }
+    else
     {
-        free(json_string);
+        /* The writer always leaves room for its terminator */
+        json_str[json_len] = '\n';
+        send_ptr = json_str;
+        send_len = json_len + 1;
     }
-    cJSON_Delete(json);
+
+    /* Whatever the socket cannot take now is queued for the socket task */
+    status = MCP_INTERFACE_QueueClientOutput(client_slot, send_ptr, (uint32)send_len);
+
+    /* Restore termination */
+    json_str[json_len] = '\0';
+
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.FormatTimeUs,
+                              MCP_INTERFACE_MetricsNowUs() - start_us);
+
     return status;
 
-} /* End MCP_INTERFACE_FormatJSONResponse */
+} /* End MCP_INTERFACE_SendMCPResponse */
 
 /*
-** Send MCP response
+** Send a finished response and start the file stream it announces
+**
+** A connection carries one stream at a time, so a raw read finishing
+** while another is still being sent is answered with an error instead.
+** The stream's file is closed on every path that does not start it.
 */
-int32 MCP_INTERFACE_SendMCPResponse(int32 client_socket, MCP_Response_t *response)
+int32 MCP_INTERFACE_SendResponseStream(int32 client_slot, MCP_Response_t *response)
 {
-    char json_str[MCP_MAX_JSON_SIZE];
-    ssize_t bytes_sent;
+    int32 fd = response->stream_fd;
     int32 status;
 
-    /* Format response as JSON */
-    status = MCP_INTERFACE_FormatJSONResponse(response, json_str, sizeof(json_str));
-    if (status != CFE_SUCCESS)
+    if (fd < 0)
     {
-        /* Send simple error response */
-        snprintf(json_str, sizeof(json_str),
-                "{\"id\": %u, \"status\": -1, \"error\": \"Failed to format response\", \"timestamp\": %u}",
-                response->id, response->timestamp);
+        return MCP_INTERFACE_SendMCPResponse(client_slot, response->result);
     }
 
-    /* Send response */
-    bytes_sent = send(client_socket, json_str, strlen(json_str), MSG_NOSIGNAL);
-    if (bytes_sent < 0)
+    response->stream_fd = -1;
+
+    if (response->status == 0 && MCP_INTERFACE_AppData.Clients[client_slot].StreamFd >= 0)
     {
-        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
-                         CFE_EVS_ERROR,
-                         "MCP_INTERFACE: Failed to send response to client");
-        return CFE_ES_ERR_APPNAME;
+        /* Ending again rewinds the result and writes the error in its place */
+        response->status = -1;
+        strncpy(response->error_msg, "Another raw file read is in progress",
+                sizeof(response->error_msg) - 1);
+        MCP_INTERFACE_EndJSONResponse(response);
     }
 
-    if (MCP_INTERFACE_AppData.DebugMode)
+    status = MCP_INTERFACE_SendMCPResponse(client_slot, response->result);
+    if (status != CFE_SUCCESS || response->status != 0)
     {
-        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
-                         CFE_EVS_INFORMATION,
-                         "MCP_INTERFACE: Response sent: %s", json_str);
+        close(fd);
+        return status;
     }
 
-    return CFE_SUCCESS;
+    return MCP_INTERFACE_QueueClientStream(client_slot, fd, response->stream_offset,
+                                           response->stream_length);
 
-} /* End MCP_INTERFACE_SendMCPResponse */
+} /* End MCP_INTERFACE_SendResponseStream */
+
+/*
+** Send an error response that did not come from a handler
+*/
+int32 MCP_INTERFACE_SendErrorResponse(int32 client_slot, uint32 id, const char *error_msg)
+{
+    char *frame;
+    MCP_JSON_Writer_t json;
+    MCP_Response_t response;
+    int32 status;
+
+    frame = MCP_INTERFACE_AcquireOutputBuffer();
+    if (frame == NULL)
+    {
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    MCP_INTERFACE_InitResponseWriter(&json, frame, client_slot);
+    MCP_INTERFACE_BeginJSONResponse(&response, &json, id);
+    response.status = -1;
+    strncpy(response.error_msg, error_msg, sizeof(response.error_msg) - 1);
+    response.error_msg[sizeof(response.error_msg) - 1] = '\0';
+    MCP_INTERFACE_EndJSONResponse(&response);
+
+    status = MCP_INTERFACE_SendMCPResponse(client_slot, &json);
+
+    MCP_INTERFACE_ReleaseOutputBuffer(frame);
+
+    return status;
+
+} /* End MCP_INTERFACE_SendErrorResponse */
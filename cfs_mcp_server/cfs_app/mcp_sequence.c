@@ -0,0 +1,755 @@
+/*
+** MCP Interface Sequences
+**
+** This file contains the engine running command sequences on board. A
+** sequence is parsed and safety checked in full when it is started,
+** then run by the socket task a step at a time: a step is sent once its
+** time tag is reached and its condition, if it has one, holds against
+** the telemetry cache, and the next step's delay counts from when it
+** goes out. The outcome of every step and the end of the sequence are
+** pushed to the connection that started it while that connection is
+** open and keeping up; the sequence itself carries on without it.
+** Apart from MCP_INTERFACE_RunSequences, which takes it, every function
+** is called with the data mutex held.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+#include "mcp_json_reader.h"
+#include <stdio.h>
+
+/*
+** Local function prototypes
+*/
+static boolean MCP_INTERFACE_ParseStep(MCP_JSON_Reader_t *reader, MCP_Request_t *request, uint32 index,
+                                       MCP_INTERFACE_SequenceStep_t *step, MCP_Response_t *response);
+static boolean MCP_INTERFACE_ParseCondition(MCP_JSON_Reader_t *reader, MCP_INTERFACE_SequenceStep_t *step);
+static int32 MCP_INTERFACE_RunSequence(MCP_INTERFACE_Sequence_t *seq, uint32 now);
+static void MCP_INTERFACE_ScheduleStep(MCP_INTERFACE_Sequence_t *seq, uint32 base_ms);
+static void MCP_INTERFACE_NextStep(MCP_INTERFACE_Sequence_t *seq, uint32 base_ms);
+static boolean MCP_INTERFACE_ConditionHolds(const MCP_INTERFACE_SequenceStep_t *step);
+static void MCP_INTERFACE_EndSequence(MCP_INTERFACE_Sequence_t *seq, const char *abort_reason);
+static void MCP_INTERFACE_PushProgress(const MCP_INTERFACE_Sequence_t *seq, const char *state,
+                                       const char *detail, int32 send_in_ms);
+
+/*
+** Comparison operators of step conditions, indexed by MCP_SEQUENCE_OP_*
+*/
+static const char *const MCP_INTERFACE_SequenceOps[] = {
+    "", "<", "<=", "==", "!=", ">=", ">"
+};
+
+/*
+** Start with no sequence running
+*/
+void MCP_INTERFACE_InitSequences(void)
+{
+    memset(&MCP_INTERFACE_AppData.Sequences, 0, sizeof(MCP_INTERFACE_AppData.Sequences));
+
+} /* End MCP_INTERFACE_InitSequences */
+
+/*
+** Start a sequence from the steps array of a run_sequence request
+**
+** Nothing runs unless every step names a dictionary command with a
+** valid payload, passes the safety checks and has a usable time tag and
+** condition. The first step is due delay_ms after the start.
+*/
+int32 MCP_INTERFACE_StartSequence(MCP_Request_t *request, const char *steps, uint32 steps_len,
+                                  MCP_Response_t *response)
+{
+    MCP_INTERFACE_SequenceEngine_t *engine = &MCP_INTERFACE_AppData.Sequences;
+    MCP_INTERFACE_Sequence_t *seq = NULL;
+    MCP_JSON_Reader_t reader;
+    uint32 count = 0;
+    boolean ok = TRUE;
+    uint32 i;
+
+    for (i = 0; i < MCP_SEQUENCE_MAX && seq == NULL; i++)
+    {
+        if (engine->Sequences[i].Id == 0)
+        {
+            seq = &engine->Sequences[i];
+        }
+    }
+
+    if (seq == NULL)
+    {
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "At most %d sequences can run at a time", MCP_SEQUENCE_MAX);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    /* Steps are parsed straight into the free slot, which stays free on failure */
+    MCP_JSON_ReaderInit(&reader, steps, steps_len);
+    ok = MCP_JSON_ReadArrayBegin(&reader);
+
+    while (ok && MCP_JSON_ReadArrayNext(&reader))
+    {
+        if (count == MCP_SEQUENCE_MAX_STEPS)
+        {
+            ok = FALSE;
+            break;
+        }
+
+        ok = MCP_INTERFACE_ParseStep(&reader, request, count, &seq->Steps[count], response);
+        count++;
+    }
+
+    if (response->error_msg[0] != '\0')
+    {
+        response->status = -1;
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    if (!ok || reader.Error || !MCP_JSON_ReadEnd(&reader) || count == 0)
+    {
+        response->status = -1;
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Sequence must contain 1 to %d steps", MCP_SEQUENCE_MAX_STEPS);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    engine->LastId++;
+    if (engine->LastId == 0)
+    {
+        engine->LastId = 1;
+    }
+
+    seq->Id = engine->LastId;
+    seq->RequestId = request->id;
+    seq->ClientSlot = request->client_slot;
+    seq->Generation = (request->client_slot >= 0) ?
+                      MCP_INTERFACE_AppData.Clients[request->client_slot].Generation : 0;
+    seq->Critical = request->is_critical;
+    seq->AbortReason = NULL;
+    seq->StepCount = count;
+    seq->Next = 0;
+    MCP_INTERFACE_ScheduleStep(seq, MCP_INTERFACE_MetricsNowMs());
+    engine->Running++;
+
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.SequencesStarted, 1);
+
+    CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
+                     CFE_EVS_INFORMATION,
+                     "MCP_INTERFACE: Sequence %u started with %u steps (request %u)",
+                     (unsigned int)seq->Id, (unsigned int)count, (unsigned int)request->id);
+
+    MCP_JSON_BeginObject(response->result);
+    MCP_JSON_KeyUint(response->result, "sequence_id", seq->Id);
+    MCP_JSON_KeyUint(response->result, "steps", count);
+    MCP_JSON_KeyString(response->result, "state", "started");
+    MCP_JSON_EndObject(response->result);
+
+    response->status = 0;
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_StartSequence */
+
+/*
+** Abort a running sequence on the socket task's next pass
+**
+** Returns FALSE if no sequence with the ID is running.
+*/
+boolean MCP_INTERFACE_CancelSequence(uint32 sequence_id)
+{
+    MCP_INTERFACE_Sequence_t *seq;
+    uint32 i;
+
+    for (i = 0; i < MCP_SEQUENCE_MAX; i++)
+    {
+        seq = &MCP_INTERFACE_AppData.Sequences.Sequences[i];
+        if (seq->Id == sequence_id && seq->AbortReason == NULL)
+        {
+            seq->AbortReason = "cancelled";
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+
+} /* End MCP_INTERFACE_CancelSequence */
+
+/*
+** Run every sequence as far as it can go now
+**
+** Called by the socket task on every pass. Returns the milliseconds
+** until a waiting step is due or its condition times out, at most the
+** socket poll timeout. A step waiting on a condition has its telemetry
+** slot wake the socket task whenever a new packet is cached.
+*/
+int32 MCP_INTERFACE_RunSequences(void)
+{
+    MCP_INTERFACE_SequenceEngine_t *engine = &MCP_INTERFACE_AppData.Sequences;
+    int32 wait = MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+    int32 sequence_wait;
+    uint32 now;
+    uint32 i;
+
+    /* Sequences are only started on this task, so a zero here is never stale */
+    if (engine->Running == 0)
+    {
+        return wait;
+    }
+
+    OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+
+    now = MCP_INTERFACE_MetricsNowMs();
+    engine->WatchedSlots = 0;
+
+    for (i = 0; i < MCP_SEQUENCE_MAX; i++)
+    {
+        if (engine->Sequences[i].Id == 0)
+        {
+            continue;
+        }
+
+        sequence_wait = MCP_INTERFACE_RunSequence(&engine->Sequences[i], now);
+        if (sequence_wait < wait)
+        {
+            wait = sequence_wait;
+        }
+    }
+
+    OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+
+    return wait;
+
+} /* End MCP_INTERFACE_RunSequences */
+
+/*
+** Abort every running sequence
+**
+** The sequences end on the socket task's next pass, which is woken for
+** it, so their clients are told from the task that owns their output.
+** The reason must be a string constant.
+*/
+void MCP_INTERFACE_AbortSequences(const char *reason)
+{
+    MCP_INTERFACE_Sequence_t *seq;
+    uint32 i;
+
+    if (MCP_INTERFACE_AppData.Sequences.Running == 0)
+    {
+        return;
+    }
+
+    for (i = 0; i < MCP_SEQUENCE_MAX; i++)
+    {
+        seq = &MCP_INTERFACE_AppData.Sequences.Sequences[i];
+        if (seq->Id != 0 && seq->AbortReason == NULL)
+        {
+            seq->AbortReason = reason;
+        }
+    }
+
+    /* A full pipe means a wakeup is already pending */
+    (void)write(MCP_INTERFACE_AppData.WakePipe[1], "", 1);
+
+} /* End MCP_INTERFACE_AbortSequences */
+
+/*
+** Parse and check one step
+**
+** Returns FALSE on malformed JSON, or with the error set in the response
+** when the step is well formed but cannot run.
+*/
+static boolean MCP_INTERFACE_ParseStep(MCP_JSON_Reader_t *reader, MCP_Request_t *request, uint32 index,
+                                       MCP_INTERFACE_SequenceStep_t *step, MCP_Response_t *response)
+{
+    MCP_Request_t step_request;
+    CFE_TIME_SysTime_t current_time;
+    char key[16];
+    char event_msg[MCP_MAX_ERROR_MSG_LEN];
+    char *payload = NULL;
+    uint32 payload_len = 0;
+    boolean ok;
+
+    memset(step, 0, sizeof(*step));
+    step_request = *request;
+    step_request.type = MCP_CMD_SEND_COMMAND;
+    step_request.app_name[0] = '\0';
+    step_request.command[0] = '\0';
+
+    ok = MCP_JSON_ReadObjectBegin(reader);
+
+    while (ok && MCP_JSON_ReadObjectNext(reader, key, sizeof(key)))
+    {
+        if (strcmp(key, "app") == 0)
+        {
+            ok = MCP_JSON_ReadString(reader, step_request.app_name, sizeof(step_request.app_name));
+        }
+        else if (strcmp(key, "command") == 0)
+        {
+            ok = MCP_JSON_ReadString(reader, step_request.command, sizeof(step_request.command));
+        }
+        else if (strcmp(key, "payload") == 0 && MCP_JSON_PeekType(reader) == MCP_JSON_TYPE_STRING)
+        {
+            ok = MCP_JSON_ReadStringInPlace(reader, &payload, &payload_len);
+        }
+        else if (strcmp(key, "delay_ms") == 0)
+        {
+            ok = MCP_JSON_ReadUint(reader, &step->DelayMs);
+        }
+        else if (strcmp(key, "at") == 0)
+        {
+            ok = MCP_JSON_ReadUint(reader, &step->AtSeconds);
+        }
+        else if (strcmp(key, "when") == 0 && MCP_JSON_PeekType(reader) == MCP_JSON_TYPE_OBJECT)
+        {
+            ok = MCP_INTERFACE_ParseCondition(reader, step);
+        }
+        else
+        {
+            ok = MCP_JSON_SkipValue(reader);
+        }
+    }
+
+    if (!ok)
+    {
+        return FALSE;
+    }
+
+    step->Entry = MCP_INTERFACE_LookupCommand(step_request.app_name, step_request.command);
+    if (step->Entry == NULL)
+    {
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Step %u: unknown command '%s' for app '%s'", (unsigned int)index,
+                step_request.command, step_request.app_name);
+        return FALSE;
+    }
+
+    if (payload_len > sizeof(step->Payload) || !MCP_INTERFACE_ValidPayload(step->Entry, payload, payload_len))
+    {
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Step %u: invalid payload, expected up to %u bytes as hex", (unsigned int)index,
+                (unsigned int)MCP_SEQUENCE_MAX_PAYLOAD_LEN);
+        return FALSE;
+    }
+
+    current_time = CFE_TIME_GetTime();
+    if (step->DelayMs > MCP_SEQUENCE_MAX_WAIT_MS || step->TimeoutMs > MCP_SEQUENCE_MAX_WAIT_MS ||
+        (step->AtSeconds != 0 &&
+         (step->DelayMs != 0 || step->AtSeconds > current_time.Seconds + MCP_SEQUENCE_MAX_WAIT_MS / 1000)))
+    {
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Step %u: needs delay_ms or at, no more than %u s ahead", (unsigned int)index,
+                (unsigned int)(MCP_SEQUENCE_MAX_WAIT_MS / 1000));
+        return FALSE;
+    }
+
+    if (step->Op == MCP_SEQUENCE_OP_NONE && step->TlmSlot != 0)
+    {
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Step %u: condition needs a cached app, an op and a field of 1, 2 or 4 bytes in the packet",
+                (unsigned int)index);
+        return FALSE;
+    }
+
+    /* Each step is checked as the send_command request it stands for */
+    if (!MCP_INTERFACE_IsSafeCommand(&step_request))
+    {
+        snprintf(response->error_msg, sizeof(response->error_msg),
+                "Step %u: command blocked by safety system", (unsigned int)index);
+        snprintf(event_msg, sizeof(event_msg), "Unsafe step %u of request %u blocked, app '%s' command '%s'",
+                (unsigned int)index, (unsigned int)request->id, step_request.app_name, step_request.command);
+        MCP_INTERFACE_LogSafetyEvent(event_msg, MCP_INTERFACE_SAFETY_ERR_EID);
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.SafetyBlocks, 1);
+        return FALSE;
+    }
+
+    step->PayloadLen = (uint16)payload_len;
+    memcpy(step->Payload, payload, payload_len);
+
+    return TRUE;
+
+} /* End MCP_INTERFACE_ParseStep */
+
+/*
+** Parse the condition of a step
+**
+** The condition is {"app", "offset", "size", "op", "value",
+** "timeout_ms"}. A condition that cannot be evaluated is left with Op
+** MCP_SEQUENCE_OP_NONE and TlmSlot set, for the caller to reject.
+*/
+static boolean MCP_INTERFACE_ParseCondition(MCP_JSON_Reader_t *reader, MCP_INTERFACE_SequenceStep_t *step)
+{
+    const MCP_INTERFACE_TlmSnapshot_t *snapshot = NULL;
+    char key[16];
+    char app_name[MCP_MAX_APP_NAME_LEN] = "";
+    char op[4] = "";
+    uint32 offset = 0;
+    uint32 size = 0;
+    boolean ok;
+    uint32 i;
+
+    ok = MCP_JSON_ReadObjectBegin(reader);
+
+    while (ok && MCP_JSON_ReadObjectNext(reader, key, sizeof(key)))
+    {
+        if (strcmp(key, "app") == 0)
+        {
+            ok = MCP_JSON_ReadString(reader, app_name, sizeof(app_name));
+        }
+        else if (strcmp(key, "offset") == 0)
+        {
+            ok = MCP_JSON_ReadUint(reader, &offset);
+        }
+        else if (strcmp(key, "size") == 0)
+        {
+            ok = MCP_JSON_ReadUint(reader, &size);
+        }
+        else if (strcmp(key, "op") == 0)
+        {
+            ok = MCP_JSON_ReadString(reader, op, sizeof(op));
+        }
+        else if (strcmp(key, "value") == 0)
+        {
+            ok = MCP_JSON_ReadUint(reader, &step->Value);
+        }
+        else if (strcmp(key, "timeout_ms") == 0)
+        {
+            ok = MCP_JSON_ReadUint(reader, &step->TimeoutMs);
+        }
+        else
+        {
+            ok = MCP_JSON_SkipValue(reader);
+        }
+    }
+
+    if (!ok)
+    {
+        return FALSE;
+    }
+
+    /* Marks the step as having a condition until it proves usable */
+    step->TlmSlot = 0xFF;
+
+    snapshot = MCP_INTERFACE_FindTelemetry(app_name);
+    if (snapshot == NULL || (size != 1 && size != 2 && size != 4) ||
+        offset + size > MCP_TLM_CACHE_MAX_PKT_LEN)
+    {
+        return TRUE;
+    }
+
+    for (i = 1; i < sizeof(MCP_INTERFACE_SequenceOps) / sizeof(MCP_INTERFACE_SequenceOps[0]); i++)
+    {
+        if (strcmp(op, MCP_INTERFACE_SequenceOps[i]) == 0)
+        {
+            step->Op = (uint8)i;
+            step->Offset = (uint16)offset;
+            step->Size = (uint8)size;
+            step->TlmSlot = (uint8)(snapshot - MCP_INTERFACE_AppData.TlmCache);
+        }
+    }
+
+    return TRUE;
+
+} /* End MCP_INTERFACE_ParseCondition */
+
+/*
+** Send the steps of a sequence that are due, until one has to wait
+**
+** Returns the milliseconds until the waiting step needs another look.
+*/
+static int32 MCP_INTERFACE_RunSequence(MCP_INTERFACE_Sequence_t *seq, uint32 now)
+{
+    const MCP_INTERFACE_SequenceStep_t *step;
+    MCP_INTERFACE_Admission_t admission;
+    MCP_Request_t request;
+    char detail[64];
+    int32 wait;
+    int32 admit;
+
+    while (seq->Id != 0)
+    {
+        /* Checked first: after a table load the steps' entries are gone */
+        if (seq->AbortReason != NULL)
+        {
+            MCP_INTERFACE_EndSequence(seq, seq->AbortReason);
+            break;
+        }
+
+        step = &seq->Steps[seq->Next];
+
+        wait = (int32)(seq->DueMs - now);
+        if (wait > 0)
+        {
+            return (wait < MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS) ? wait : MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+        }
+
+        if (step->Op != MCP_SEQUENCE_OP_NONE && !MCP_INTERFACE_ConditionHolds(step))
+        {
+            if (step->TimeoutMs == 0)
+            {
+                MCP_INTERFACE_PushProgress(seq, "skipped", "condition false", -1);
+                MCP_INTERFACE_NextStep(seq, now);
+                continue;
+            }
+
+            wait = (int32)(seq->DueMs + step->TimeoutMs - now);
+            if (wait <= 0)
+            {
+                snprintf(detail, sizeof(detail), "condition not met within %u ms",
+                         (unsigned int)step->TimeoutMs);
+                MCP_INTERFACE_EndSequence(seq, detail);
+                break;
+            }
+
+            MCP_INTERFACE_AppData.Sequences.WatchedSlots |= (1u << step->TlmSlot);
+            return (wait < MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS) ? wait : MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+        }
+
+        /* Admission only needs to know what the step was requested as */
+        memset(&request, 0, sizeof(request));
+        request.id = seq->RequestId;
+        request.type = MCP_CMD_SEND_COMMAND;
+        request.is_critical = seq->Critical;
+        request.client_slot = -1;
+
+        admit = MCP_INTERFACE_IssueCommand(&request, step->Entry, step->Payload, step->PayloadLen, &admission);
+        if (admit == MCP_ADMIT_SEND)
+        {
+            MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.SequenceStepsSent, 1);
+            MCP_INTERFACE_PushProgress(seq, "sent", NULL, -1);
+            MCP_INTERFACE_NextStep(seq, now);
+        }
+        else if (admit == MCP_ADMIT_QUEUED)
+        {
+            /* The next delay counts from when this command goes out */
+            MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.SequenceStepsSent, 1);
+            MCP_INTERFACE_PushProgress(seq, "queued", NULL, (int32)admission.WaitMs);
+            MCP_INTERFACE_NextStep(seq, now + admission.WaitMs);
+        }
+        else
+        {
+            if (admit == MCP_ADMIT_REJECTED)
+            {
+                snprintf(detail, sizeof(detail), "rate limit exceeded, retry after %u ms",
+                         (unsigned int)admission.WaitMs);
+            }
+            else
+            {
+                snprintf(detail, sizeof(detail), "send failed, status = 0x%08X",
+                         (unsigned int)admission.Status);
+            }
+            MCP_INTERFACE_EndSequence(seq, detail);
+        }
+    }
+
+    return MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+
+} /* End MCP_INTERFACE_RunSequence */
+
+/*
+** Set when the next step of a sequence is due
+**
+** base_ms is when the previous step went out, or the start of the
+** sequence. An absolute time tag already passed is due at once.
+*/
+static void MCP_INTERFACE_ScheduleStep(MCP_INTERFACE_Sequence_t *seq, uint32 base_ms)
+{
+    const MCP_INTERFACE_SequenceStep_t *step = &seq->Steps[seq->Next];
+    CFE_TIME_SysTime_t current_time;
+    uint32 wait = 0;
+
+    if (step->AtSeconds == 0)
+    {
+        seq->DueMs = base_ms + step->DelayMs;
+        return;
+    }
+
+    current_time = CFE_TIME_GetTime();
+    if (step->AtSeconds > current_time.Seconds)
+    {
+        wait = (step->AtSeconds - current_time.Seconds) * 1000 -
+               CFE_TIME_Sub2MicroSecs(current_time.Subseconds) / 1000;
+    }
+
+    seq->DueMs = MCP_INTERFACE_MetricsNowMs() + wait;
+
+} /* End MCP_INTERFACE_ScheduleStep */
+
+/*
+** Move a sequence past its current step, ending it after the last
+*/
+static void MCP_INTERFACE_NextStep(MCP_INTERFACE_Sequence_t *seq, uint32 base_ms)
+{
+    seq->Next++;
+
+    if (seq->Next == seq->StepCount)
+    {
+        MCP_INTERFACE_EndSequence(seq, NULL);
+        return;
+    }
+
+    MCP_INTERFACE_ScheduleStep(seq, base_ms);
+
+} /* End MCP_INTERFACE_NextStep */
+
+/*
+** Evaluate the condition of a step against the latest cached packet
+**
+** A condition on a packet not yet received, or too short for the
+** field, is false.
+*/
+static boolean MCP_INTERFACE_ConditionHolds(const MCP_INTERFACE_SequenceStep_t *step)
+{
+    const MCP_INTERFACE_TlmSnapshot_t *snapshot = &MCP_INTERFACE_AppData.TlmCache[step->TlmSlot];
+    uint8 value8;
+    uint16 value16;
+    uint32 value;
+
+    if (snapshot->Count == 0 || step->Offset + step->Size > snapshot->Length)
+    {
+        return FALSE;
+    }
+
+    switch (step->Size)
+    {
+        case 1:
+            value8 = snapshot->Packet[step->Offset];
+            value = value8;
+            break;
+
+        case 2:
+            memcpy(&value16, &snapshot->Packet[step->Offset], sizeof(value16));
+            value = value16;
+            break;
+
+        default:
+            memcpy(&value, &snapshot->Packet[step->Offset], sizeof(value));
+            break;
+    }
+
+    switch (step->Op)
+    {
+        case MCP_SEQUENCE_OP_LT:
+            return (value < step->Value);
+
+        case MCP_SEQUENCE_OP_LE:
+            return (value <= step->Value);
+
+        case MCP_SEQUENCE_OP_EQ:
+            return (value == step->Value);
+
+        case MCP_SEQUENCE_OP_NE:
+            return (value != step->Value);
+
+        case MCP_SEQUENCE_OP_GE:
+            return (value >= step->Value);
+
+        default:
+            return (value > step->Value);
+    }
+
+} /* End MCP_INTERFACE_ConditionHolds */
+
+/*
+** End a sequence, completed when abort_reason is NULL, and free its slot
+*/
+static void MCP_INTERFACE_EndSequence(MCP_INTERFACE_Sequence_t *seq, const char *abort_reason)
+{
+    if (abort_reason == NULL)
+    {
+        MCP_INTERFACE_PushProgress(seq, "completed", NULL, -1);
+
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
+                         CFE_EVS_INFORMATION,
+                         "MCP_INTERFACE: Sequence %u completed (request %u)",
+                         (unsigned int)seq->Id, (unsigned int)seq->RequestId);
+    }
+    else
+    {
+        MCP_INTERFACE_PushProgress(seq, "aborted", abort_reason, -1);
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.SequencesAborted, 1);
+
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Sequence %u (request %u) aborted at step %u, %s",
+                         (unsigned int)seq->Id, (unsigned int)seq->RequestId,
+                         (unsigned int)seq->Next, abort_reason);
+    }
+
+    seq->Id = 0;
+    MCP_INTERFACE_AppData.Sequences.Running--;
+
+} /* End MCP_INTERFACE_EndSequence */
+
+/*
+** Push the state of a sequence's current step to the client that
+** started it
+**
+** Nothing is pushed once that connection has closed, even if the slot
+** has a new client, nor while it is backlogged: progress is lost then
+** but the sequence is not held up.
+*/
+static void MCP_INTERFACE_PushProgress(const MCP_INTERFACE_Sequence_t *seq, const char *state,
+                                       const char *detail, int32 send_in_ms)
+{
+    const MCP_INTERFACE_Client_t *client;
+    const MCP_INTERFACE_CmdEntry_t *entry;
+    MCP_JSON_Writer_t json;
+    uint32 current_time;
+    char *frame;
+
+    if (seq->ClientSlot < 0)
+    {
+        return;
+    }
+
+    client = &MCP_INTERFACE_AppData.Clients[seq->ClientSlot];
+    if (client->Socket < 0 || client->Generation != seq->Generation ||
+        MCP_INTERFACE_ClientBacklogged(seq->ClientSlot))
+    {
+        return;
+    }
+
+    frame = MCP_INTERFACE_AcquireOutputBuffer();
+    if (frame == NULL)
+    {
+        return;
+    }
+
+    current_time = CFE_TIME_GetTime().Seconds;
+
+    /* Same envelope as a response, marked as a push for the sequence */
+    MCP_INTERFACE_InitResponseWriter(&json, frame, seq->ClientSlot);
+    MCP_JSON_BeginObject(&json);
+    MCP_JSON_KeyUint(&json, "id", seq->RequestId);
+    MCP_JSON_KeyString(&json, "push", "sequence");
+    MCP_JSON_Key(&json, "result");
+    MCP_JSON_BeginObject(&json);
+    MCP_JSON_KeyUint(&json, "sequence_id", seq->Id);
+    MCP_JSON_KeyUint(&json, "step", seq->Next);
+    MCP_JSON_KeyString(&json, "state", state);
+
+    /* The entry of an aborted step may belong to a replaced table */
+    if (seq->Next < seq->StepCount && seq->AbortReason == NULL)
+    {
+        entry = seq->Steps[seq->Next].Entry;
+        MCP_JSON_KeyString(&json, "app", entry->AppName);
+        MCP_JSON_KeyString(&json, "command", entry->CommandName);
+    }
+    if (send_in_ms >= 0)
+    {
+        MCP_JSON_KeyUint(&json, "send_in_ms", (uint32)send_in_ms);
+    }
+    if (detail != NULL)
+    {
+        MCP_JSON_KeyString(&json, "detail", detail);
+    }
+    MCP_JSON_EndObject(&json);
+    MCP_JSON_KeyInt(&json, "status", 0);
+    MCP_JSON_KeyUint(&json, "timestamp", current_time);
+    MCP_JSON_EndObject(&json);
+
+    (void)MCP_INTERFACE_SendMCPResponse(seq->ClientSlot, &json);
+
+    MCP_INTERFACE_ReleaseOutputBuffer(frame);
+
+} /* End MCP_INTERFACE_PushProgress */
@@ -0,0 +1,1205 @@
+/*
+** MCP Interface Socket Server
+**
+** This file contains the Unix domain socket server and the socket
+** servicing child task for the cFS MCP Interface Application.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+#include <signal.h>
+#ifdef __linux__
+#include <sys/sendfile.h>
+#endif
+
+/*
+** Local function prototypes
+*/
+static void MCP_INTERFACE_AcceptClients(void);
+static int32 MCP_INTERFACE_ResumeAccept(void);
+static void MCP_INTERFACE_ReadClient(int32 slot);
+static void MCP_INTERFACE_ExtractFrames(int32 slot);
+static boolean MCP_INTERFACE_NextFrame(MCP_INTERFACE_Client_t *client,
+                                       uint32 *frame_start, uint32 *frame_len,
+                                       uint32 *consumed);
+static boolean MCP_INTERFACE_Negotiate(int32 slot);
+static void MCP_INTERFACE_QueueFrame(int32 slot, char *frame, uint32 frame_len);
+static void MCP_INTERFACE_FlushClient(int32 slot);
+static ssize_t MCP_INTERFACE_SendStream(MCP_INTERFACE_Client_t *client);
+static void MCP_INTERFACE_ShutdownClient(int32 slot);
+static void MCP_INTERFACE_UpdateInterest(int32 slot);
+static int32 MCP_INTERFACE_WatchDescriptor(int32 fd, uint32 tag);
+static void MCP_INTERFACE_CloseClient(int32 slot);
+static boolean MCP_INTERFACE_HasQueuedRequests(int32 slot);
+
+/*
+** Initialize Unix Domain Socket for MCP communication
+*/
+int32 MCP_INTERFACE_InitSocket(void)
+{
+    struct sockaddr_un server_addr;
+    int32 result;
+    int32 i;
+
+    /* Initialize client sockets array */
+    for (i = 0; i < MCP_MAX_CLIENTS; i++)
+    {
+        MCP_INTERFACE_AppData.Clients[i].Socket = -1;
+        MCP_INTERFACE_AppData.Clients[i].Generation = 0;
+        MCP_INTERFACE_AppData.Clients[i].StreamFd = -1;
+    }
+
+    /* Create socket */
+    MCP_INTERFACE_AppData.ServerSocket = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (MCP_INTERFACE_AppData.ServerSocket < 0)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to create socket\n");
+        return CFE_ES_ERR_APP_CREATE;
+    }
+
+    /* Remove any existing socket file */
+    unlink(MCP_INTERFACE_SOCKET_PATH);
+
+    /* Set up server address */
+    memset(&server_addr, 0, sizeof(server_addr));
+    server_addr.sun_family = AF_UNIX;
+    strncpy(server_addr.sun_path, MCP_INTERFACE_SOCKET_PATH, 
+            sizeof(server_addr.sun_path) - 1);
+
+    /* Bind socket */
+    result = bind(MCP_INTERFACE_AppData.ServerSocket,
+                 (struct sockaddr *)&server_addr,
+                 sizeof(server_addr));
+    if (result < 0)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to bind socket\n");
+        close(MCP_INTERFACE_AppData.ServerSocket);
+        return CFE_ES_ERR_APP_CREATE;
+    }
+
+    /* Listen for connections */
+    result = listen(MCP_INTERFACE_AppData.ServerSocket, SOMAXCONN);
+    if (result < 0)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to listen on socket\n");
+        close(MCP_INTERFACE_AppData.ServerSocket);
+        unlink(MCP_INTERFACE_SOCKET_PATH);
+        return CFE_ES_ERR_APP_CREATE;
+    }
+
+    /* Set socket to non-blocking */
+    fcntl(MCP_INTERFACE_AppData.ServerSocket, F_SETFL, O_NONBLOCK);
+
+    /* Pipe the main task writes to when subscribed telemetry arrives */
+    if (pipe(MCP_INTERFACE_AppData.WakePipe) < 0)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to create wake pipe\n");
+        close(MCP_INTERFACE_AppData.ServerSocket);
+        unlink(MCP_INTERFACE_SOCKET_PATH);
+        return CFE_ES_ERR_APP_CREATE;
+    }
+    fcntl(MCP_INTERFACE_AppData.WakePipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(MCP_INTERFACE_AppData.WakePipe[1], F_SETFL, O_NONBLOCK);
+
+    /* Readiness set for the socket task; clients are added as they connect */
+    MCP_INTERFACE_AppData.EpollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (MCP_INTERFACE_AppData.EpollFd < 0 ||
+        MCP_INTERFACE_WatchDescriptor(MCP_INTERFACE_AppData.ServerSocket,
+                                      MCP_EPOLL_SERVER) != CFE_SUCCESS ||
+        MCP_INTERFACE_WatchDescriptor(MCP_INTERFACE_AppData.WakePipe[0],
+                                      MCP_EPOLL_WAKE) != CFE_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to create epoll set\n");
+        if (MCP_INTERFACE_AppData.EpollFd >= 0)
+        {
+            close(MCP_INTERFACE_AppData.EpollFd);
+        }
+        close(MCP_INTERFACE_AppData.WakePipe[0]);
+        close(MCP_INTERFACE_AppData.WakePipe[1]);
+        close(MCP_INTERFACE_AppData.ServerSocket);
+        unlink(MCP_INTERFACE_SOCKET_PATH);
+        return CFE_ES_ERR_APP_CREATE;
+    }
+    MCP_INTERFACE_AppData.AcceptPaused = FALSE;
+
+    CFE_EVS_SendEvent(MCP_INTERFACE_STARTUP_INF_EID,
+                     CFE_EVS_INFORMATION,
+                     "MCP_INTERFACE: Socket server initialized at %s",
+                     MCP_INTERFACE_SOCKET_PATH);
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_InitSocket */
+
+/*
+** Create the socket servicing child task
+*/
+int32 MCP_INTERFACE_StartSocketTask(void)
+{
+    int32 status;
+
+    status = CFE_ES_CreateChildTask(&MCP_INTERFACE_AppData.SocketTaskId,
+                                    MCP_INTERFACE_SOCKET_TASK_NAME,
+                                    MCP_INTERFACE_SocketTask,
+                                    NULL,
+                                    MCP_INTERFACE_SOCKET_TASK_STACK_SIZE,
+                                    MCP_INTERFACE_SOCKET_TASK_PRIORITY,
+                                    0);
+    if (status != CFE_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to create socket task, RC = 0x%08X\n",
+                           status);
+    }
+
+    return status;
+
+} /* End MCP_INTERFACE_StartSocketTask */
+
+/*
+** Socket servicing child task
+**
+** Blocks in epoll_wait() on the server socket, every connected client
+** and the wake pipe, so requests are picked up as soon as they arrive
+** rather than on the next SB pipe timeout, and subscribed telemetry and
+** worker results are sent as soon as they are ready. Clients with queued
+** output are also watched for writability, and backlogged clients are
+** not watched for input until their queue drains.
+*/
+void MCP_INTERFACE_SocketTask(void)
+{
+    struct epoll_event events[MCP_EPOLL_BATCH];
+    sigset_t sigpipe;
+    int ready;
+    int32 timeout = MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+    int32 wait;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    /* File streams cannot pass MSG_NOSIGNAL; a gone peer must fail with EPIPE */
+    sigemptyset(&sigpipe);
+    sigaddset(&sigpipe, SIGPIPE);
+    pthread_sigmask(SIG_BLOCK, &sigpipe, NULL);
+
+    while (MCP_INTERFACE_AppData.RunStatus == CFE_ES_APP_RUN)
+    {
+        /*
+        ** Timeout bounds how long shutdown takes to be noticed, or how
+        ** long until a rate limited telemetry update, a sequence step or
+        ** a queued command is due
+        */
+        ready = epoll_wait(MCP_INTERFACE_AppData.EpollFd, events, MCP_EPOLL_BATCH, timeout);
+        if (ready < 0)
+        {
+            if (errno != EINTR)
+            {
+                CFE_EVS_SendEvent(MCP_INTERFACE_SOCKET_ERR_EID,
+                                CFE_EVS_ERROR,
+                                "MCP_INTERFACE: epoll_wait failed, errno = %d", errno);
+                OS_TaskDelay(MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS);
+            }
+            continue;
+        }
+
+        if (ready > 0)
+        {
+            MCP_INTERFACE_ProcessMCPClients(events, ready);
+            MCP_INTERFACE_CollectCompletions();
+            MCP_INTERFACE_DispatchRequests();
+        }
+
+        timeout = MCP_INTERFACE_PublishTelemetry();
+
+        /* Sequence steps may queue commands, so they run first */
+        wait = MCP_INTERFACE_RunSequences();
+        if (wait < timeout)
+        {
+            timeout = wait;
+        }
+
+        wait = MCP_INTERFACE_SendQueuedCommands();
+        if (wait < timeout)
+        {
+            timeout = wait;
+        }
+
+        wait = MCP_INTERFACE_ResumeAccept();
+        if (wait < timeout)
+        {
+            timeout = wait;
+        }
+    }
+
+    CFE_ES_ExitChildTask();
+
+} /* End MCP_INTERFACE_SocketTask */
+
+/*
+** Process MCP client connections and requests
+**
+** Only descriptors epoll reported ready are touched. Queued output is
+** flushed before reading, so a client that drained its backlog can be
+** read again in the same pass. Parsed requests are placed on the
+** request queue for MCP_INTERFACE_DispatchRequests.
+*/
+void MCP_INTERFACE_ProcessMCPClients(const struct epoll_event *events, int32 count)
+{
+    MCP_INTERFACE_Client_t *client;
+    uint32 slot;
+    uint32 generation;
+    int32 i;
+    char drain[32];
+
+    for (i = 0; i < count; i++)
+    {
+        slot = (uint32)(events[i].data.u64 & 0xFFFFFFFFu);
+        generation = (uint32)(events[i].data.u64 >> 32);
+
+        if (slot == MCP_EPOLL_SERVER)
+        {
+            MCP_INTERFACE_AcceptClients();
+            continue;
+        }
+
+        if (slot == MCP_EPOLL_WAKE)
+        {
+            /* Only the wakeup matters; telemetry and completions are handled after every pass */
+            while (read(MCP_INTERFACE_AppData.WakePipe[0], drain, sizeof(drain)) > 0)
+            {
+            }
+            continue;
+        }
+
+        /* Skip events for a connection closed earlier in this batch */
+        client = &MCP_INTERFACE_AppData.Clients[slot];
+        if (client->Socket < 0 || client->Generation != generation)
+        {
+            continue;
+        }
+
+        if (events[i].events & EPOLLOUT)
+        {
+            MCP_INTERFACE_FlushClient((int32)slot);
+        }
+
+        /* Flushing may have resumed framing, which can close the client */
+        if ((events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) && client->Socket >= 0)
+        {
+            MCP_INTERFACE_ReadClient((int32)slot);
+        }
+    }
+
+} /* End MCP_INTERFACE_ProcessMCPClients */
+
+/*
+** Execute every queued request
+**
+** Requests on a connection carry their own id and may complete in any
+** order, so cheap requests are executed ahead of slow ones that were
+** queued in front of them, and I/O bound requests are handed to the
+** worker pool.
+*/
+void MCP_INTERFACE_DispatchRequests(void)
+{
+    MCP_INTERFACE_RequestQueue_t *queue = &MCP_INTERFACE_AppData.RequestQueue;
+    MCP_INTERFACE_QueuedRequest_t *entry;
+    uint32 pass;
+    uint32 i;
+
+    /* Cheap requests on pass 0, slow ones on pass 1 */
+    for (pass = 0; pass < 2; pass++)
+    {
+        for (i = 0; i < queue->Count; i++)
+        {
+            entry = &queue->Entries[(queue->Head + i) % MCP_REQUEST_QUEUE_DEPTH];
+
+            if (entry->ClientSlot < 0 ||
+                MCP_INTERFACE_IsSlowRequest(entry->Request.type) != (pass == 1))
+            {
+                continue;
+            }
+
+            /* File system work goes to the workers while a job is free */
+            if (!MCP_INTERFACE_IsIoBoundRequest(entry->Request.type) ||
+                !MCP_INTERFACE_SubmitRequest(entry->ClientSlot, &entry->Request))
+            {
+                OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+                MCP_INTERFACE_RecordLatency(MCP_INTERFACE_AppData.Metrics.QueueLatency,
+                                            MCP_INTERFACE_MetricsNowUs() -
+                                            entry->Request.stage_us[MCP_TRACE_PARSED]);
+                MCP_INTERFACE_HandleMCPRequest(entry->ClientSlot, &entry->Request);
+                OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+            }
+
+            entry->ClientSlot = -1;
+        }
+    }
+
+    queue->Head = (queue->Head + queue->Count) % MCP_REQUEST_QUEUE_DEPTH;
+    queue->Count = 0;
+
+} /* End MCP_INTERFACE_DispatchRequests */
+
+/*
+** Send data to a client, queueing whatever the socket cannot take now
+**
+** Output is only written on the socket task, so the queue needs no
+** lock. When nothing is queued the data is sent straight from the
+** caller's buffer and only the remainder is copied. A client whose
+** queue overflows or whose socket fails is shut down; its slot is
+** freed once the read side sees the hangup. Output queued behind a file
+** stream waits for the stream to finish.
+*/
+int32 MCP_INTERFACE_QueueClientOutput(int32 slot, const char *data, uint32 length)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+    ssize_t bytes_sent = 0;
+
+    if (client->Socket < 0)
+    {
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    if (client->TxLength == client->TxStart && client->StreamFd < 0)
+    {
+        client->TxStart = 0;
+        client->TxLength = 0;
+
+        bytes_sent = send(client->Socket, data, length, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (bytes_sent < 0)
+        {
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                                 CFE_EVS_ERROR,
+                                 "MCP_INTERFACE: Failed to send response to client (slot %d)", slot);
+                MCP_INTERFACE_ShutdownClient(slot);
+                return CFE_ES_ERR_APPNAME;
+            }
+            bytes_sent = 0;
+        }
+
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.BytesOut, (uint32)bytes_sent);
+        if ((uint32)bytes_sent == length)
+        {
+            return CFE_SUCCESS;
+        }
+    }
+
+    data += bytes_sent;
+    length -= (uint32)bytes_sent;
+
+    /* Reclaim the space of output already sent */
+    if (client->TxLength + length > MCP_CLIENT_TX_BUFFER_SIZE && client->TxStart > 0)
+    {
+        memmove(client->TxBuffer, &client->TxBuffer[client->TxStart],
+                client->TxLength - client->TxStart);
+        client->TxLength -= client->TxStart;
+        if (client->StreamFd >= 0)
+        {
+            client->StreamAt -= client->TxStart;
+        }
+        client->TxStart = 0;
+    }
+
+    if (client->TxLength + length > MCP_CLIENT_TX_BUFFER_SIZE)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Output queue full, closing client (slot %d)", slot);
+        MCP_INTERFACE_ShutdownClient(slot);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    memcpy(&client->TxBuffer[client->TxLength], data, length);
+    client->TxLength += length;
+    MCP_INTERFACE_UpdateInterest(slot);
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_QueueClientOutput */
+
+/*
+** Send part of a file to a client after the output queued so far
+**
+** The file is sent from the socket task as the socket drains, straight
+** from the file rather than through the output queue, and closed once
+** "length" bytes are out or the client goes away. The stream takes over
+** the descriptor, closing it on failure too.
+*/
+int32 MCP_INTERFACE_QueueClientStream(int32 slot, int32 fd, uint32 offset, uint32 length)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+
+    if (client->Socket < 0 || client->StreamFd >= 0)
+    {
+        close(fd);
+        return CFE_ES_ERR_APPNAME;
+    }
+
+    client->StreamFd = fd;
+    client->StreamAt = client->TxLength;
+    client->StreamOffset = offset;
+    client->StreamRemaining = length;
+    MCP_INTERFACE_UpdateInterest(slot);
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_QueueClientStream */
+
+/*
+** Check whether a client has reached the output high-water mark
+**
+** A client is held at the mark for as long as a file stream is running.
+*/
+boolean MCP_INTERFACE_ClientBacklogged(int32 slot)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+
+    return (client->StreamFd >= 0 ||
+            client->TxLength - client->TxStart >= MCP_CLIENT_TX_HIGH_WATER);
+
+} /* End MCP_INTERFACE_ClientBacklogged */
+
+/*
+** Accept every pending connection into free client slots
+**
+** Any failure other than no pending connection, such as running out of
+** descriptors, leaves the connection queued and the server socket still
+** readable. The socket is then taken out of the epoll set for
+** MCP_INTERFACE_ACCEPT_BACKOFF_MS, rather than waking the socket task
+** again at once, and MCP_INTERFACE_ResumeAccept puts it back.
+*/
+static void MCP_INTERFACE_AcceptClients(void)
+{
+    MCP_INTERFACE_Client_t *client;
+    struct epoll_event event;
+    int32 new_client;
+    int32 i;
+    uint32 rejected = 0;
+
+    while ((new_client = accept(MCP_INTERFACE_AppData.ServerSocket, NULL, NULL)) >= 0)
+    {
+        if (MCP_INTERFACE_AppData.ActiveClients >= MCP_MAX_CLIENTS)
+        {
+            close(new_client);
+            rejected++;
+            continue;
+        }
+
+        /* A slot is free, as fewer than MCP_MAX_CLIENTS are connected */
+        for (i = 0; MCP_INTERFACE_AppData.Clients[i].Socket != -1; i++)
+        {
+        }
+
+        client = &MCP_INTERFACE_AppData.Clients[i];
+        client->Generation++;
+        client->PollEvents = 0;
+        if (MCP_INTERFACE_WatchDescriptor(new_client, (uint32)i) != CFE_SUCCESS)
+        {
+            close(new_client);
+            rejected++;
+            continue;
+        }
+
+        /* File streams are written with sendfile(), which has no MSG_DONTWAIT */
+        fcntl(new_client, F_SETFL, O_NONBLOCK);
+
+        client->Socket = new_client;
+        client->PollEvents = EPOLLIN;
+        client->AcceptedUs = MCP_INTERFACE_MetricsNowUs();
+        client->Framing = MCP_FRAMING_UNKNOWN;
+        client->ScanInString = FALSE;
+        client->ScanEscape = FALSE;
+        client->ScanDepth = 0;
+        client->ScanOffset = 0;
+        client->RxStart = 0;
+        client->RxLength = 0;
+        client->TxStart = 0;
+        client->TxLength = 0;
+        memset(&client->Subscription, 0, sizeof(client->Subscription));
+
+        /* The main task walks the active list when remapping subscriptions */
+        OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+        client->ActiveIndex = MCP_INTERFACE_AppData.ActiveClients;
+        MCP_INTERFACE_AppData.ActiveSlots[MCP_INTERFACE_AppData.ActiveClients] = (uint16)i;
+        MCP_INTERFACE_AppData.ActiveClients++;
+        OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+
+        CFE_EVS_SendEvent(MCP_INTERFACE_CLIENT_CONNECT_INF_EID,
+                        CFE_EVS_INFORMATION,
+                        "MCP_INTERFACE: New client connected (slot %d)", i);
+    }
+
+    if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+    {
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.AcceptErrors, 1);
+        CFE_EVS_SendEvent(MCP_INTERFACE_SOCKET_ERR_EID,
+                        CFE_EVS_ERROR,
+                        "MCP_INTERFACE: accept failed, errno = %d, pausing for %d ms",
+                        errno, MCP_INTERFACE_ACCEPT_BACKOFF_MS);
+
+        event.events = 0;
+        event.data.u64 = MCP_EPOLL_SERVER;
+        epoll_ctl(MCP_INTERFACE_AppData.EpollFd, EPOLL_CTL_MOD,
+                  MCP_INTERFACE_AppData.ServerSocket, &event);
+        MCP_INTERFACE_AppData.AcceptPaused = TRUE;
+        MCP_INTERFACE_AppData.AcceptResumeMs = MCP_INTERFACE_MetricsNowMs() +
+                                               MCP_INTERFACE_ACCEPT_BACKOFF_MS;
+    }
+
+    if (rejected > 0)
+    {
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.RejectedConnections, rejected);
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                        CFE_EVS_ERROR,
+                        "MCP_INTERFACE: Maximum clients (%d) reached, %u connection(s) rejected",
+                        MCP_MAX_CLIENTS, (unsigned int)rejected);
+    }
+
+} /* End MCP_INTERFACE_AcceptClients */
+
+/*
+** Watch the server socket again once an accept back-off has passed
+**
+** Returns the milliseconds until the back-off ends, or the poll timeout
+** when accepting is not paused.
+*/
+static int32 MCP_INTERFACE_ResumeAccept(void)
+{
+    struct epoll_event event;
+    int32 remaining;
+
+    if (!MCP_INTERFACE_AppData.AcceptPaused)
+    {
+        return MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+    }
+
+    remaining = (int32)(MCP_INTERFACE_AppData.AcceptResumeMs - MCP_INTERFACE_MetricsNowMs());
+    if (remaining > 0)
+    {
+        return remaining;
+    }
+
+    event.events = EPOLLIN;
+    event.data.u64 = MCP_EPOLL_SERVER;
+    epoll_ctl(MCP_INTERFACE_AppData.EpollFd, EPOLL_CTL_MOD,
+              MCP_INTERFACE_AppData.ServerSocket, &event);
+    MCP_INTERFACE_AppData.AcceptPaused = FALSE;
+
+    return MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+
+} /* End MCP_INTERFACE_ResumeAccept */
+
+/*
+** Append whatever a ready client has sent to its reassembly buffer
+*/
+static void MCP_INTERFACE_ReadClient(int32 slot)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+    ssize_t bytes_received;
+
+    /* Reclaim consumed frames once no queued request still points at them */
+    if (client->RxStart > 0)
+    {
+        if (MCP_INTERFACE_HasQueuedRequests(slot))
+        {
+            MCP_INTERFACE_DispatchRequests();
+        }
+
+        memmove(client->RxBuffer, &client->RxBuffer[client->RxStart],
+                client->RxLength - client->RxStart);
+        client->RxLength -= client->RxStart;
+        client->RxStart = 0;
+    }
+
+    bytes_received = recv(client->Socket,
+                          &client->RxBuffer[client->RxLength],
+                          MCP_CLIENT_RX_BUFFER_SIZE - client->RxLength,
+                          MSG_DONTWAIT);
+
+    if (bytes_received > 0)
+    {
+        MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.BytesIn, (uint32)bytes_received);
+        client->ReceivedUs = MCP_INTERFACE_MetricsNowUs();
+        client->RxLength += (uint32)bytes_received;
+        MCP_INTERFACE_ExtractFrames(slot);
+    }
+    else if (bytes_received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK))
+    {
+        /* Client disconnected or error */
+        MCP_INTERFACE_CloseClient(slot);
+    }
+
+} /* End MCP_INTERFACE_ReadClient */
+
+/*
+** Queue every complete frame held in a client's reassembly buffer
+**
+** Stops early while the client is backlogged; the remaining frames are
+** picked up by MCP_INTERFACE_FlushClient once its output drains.
+*/
+static void MCP_INTERFACE_ExtractFrames(int32 slot)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+    uint32 frame_start;
+    uint32 frame_len;
+    uint32 consumed;
+
+    if (!MCP_INTERFACE_Negotiate(slot))
+    {
+        return;
+    }
+
+    while (client->Socket != -1 &&
+           !MCP_INTERFACE_ClientBacklogged(slot) &&
+           MCP_INTERFACE_NextFrame(client, &frame_start, &frame_len, &consumed))
+    {
+        /* Make room rather than stalling the rest of the buffer */
+        if (MCP_INTERFACE_AppData.RequestQueue.Count >= MCP_REQUEST_QUEUE_DEPTH)
+        {
+            MCP_INTERFACE_DispatchRequests();
+        }
+
+        /* Queued requests refer into the buffer, so frames stay where they are */
+        MCP_INTERFACE_QueueFrame(slot, &client->RxBuffer[client->RxStart + frame_start], frame_len);
+        client->RxStart += consumed;
+    }
+
+    if (client->Socket != -1 && client->RxStart == 0 &&
+        client->RxLength >= MCP_CLIENT_RX_BUFFER_SIZE &&
+        !MCP_INTERFACE_ClientBacklogged(slot))
+    {
+        /* Buffer full without a complete frame - the frame can never fit */
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                        CFE_EVS_ERROR,
+                        "MCP_INTERFACE: Request exceeds %d bytes, closing client (slot %d)",
+                        MCP_MAX_FRAME_SIZE, slot);
+        MCP_INTERFACE_CloseClient(slot);
+    }
+
+} /* End MCP_INTERFACE_ExtractFrames */
+
+/*
+** Accept the binary handshake if a new connection opens with one
+**
+** Returns FALSE when no frames can be extracted yet, either because
+** the handshake is incomplete or because it was refused.
+*/
+static boolean MCP_INTERFACE_Negotiate(int32 slot)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+    const char *buf = &client->RxBuffer[client->RxStart];
+    uint32 avail = client->RxLength - client->RxStart;
+    char ack[MCP_BINARY_HANDSHAKE_SIZE];
+
+    /* A valid length prefix never starts with the magic byte */
+    if (client->Framing != MCP_FRAMING_UNKNOWN ||
+        avail == 0 ||
+        buf[0] != MCP_BINARY_MAGIC[0])
+    {
+        return TRUE;
+    }
+
+    if (avail < MCP_BINARY_HANDSHAKE_SIZE)
+    {
+        return FALSE;
+    }
+
+    if (memcmp(buf, MCP_BINARY_MAGIC, MCP_BINARY_HANDSHAKE_SIZE - 1) != 0 ||
+        (uint8)buf[MCP_BINARY_HANDSHAKE_SIZE - 1] != MCP_BINARY_VERSION)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                        CFE_EVS_ERROR,
+                        "MCP_INTERFACE: Unsupported handshake, closing client (slot %d)", slot);
+        MCP_INTERFACE_CloseClient(slot);
+        return FALSE;
+    }
+
+    memcpy(ack, MCP_BINARY_MAGIC, MCP_BINARY_HANDSHAKE_SIZE - 1);
+    ack[MCP_BINARY_HANDSHAKE_SIZE - 1] = (char)MCP_BINARY_VERSION;
+    if (MCP_INTERFACE_QueueClientOutput(slot, ack, sizeof(ack)) != CFE_SUCCESS)
+    {
+        MCP_INTERFACE_CloseClient(slot);
+        return FALSE;
+    }
+
+    client->Framing = MCP_FRAMING_BINARY;
+    client->RxStart += MCP_BINARY_HANDSHAKE_SIZE;
+
+    return TRUE;
+
+} /* End MCP_INTERFACE_Negotiate */
+
+/*
+** Locate the next complete frame at the front of the reassembly buffer
+**
+** Returns TRUE with the frame bounds and the number of buffer bytes it
+** occupies (including framing), relative to RxStart, when a complete
+** frame is available; partial JSON scan state is kept in the client so
+** data is never rescanned across reads.
+*/
+static boolean MCP_INTERFACE_NextFrame(MCP_INTERFACE_Client_t *client,
+                                       uint32 *frame_start, uint32 *frame_len,
+                                       uint32 *consumed)
+{
+    char *buf = &client->RxBuffer[client->RxStart];
+    uint32 avail = client->RxLength - client->RxStart;
+    uint32 skip = 0;
+    uint32 i;
+    uint32 length;
+    char c;
+
+    if (client->Framing == MCP_FRAMING_BINARY)
+    {
+        if (avail < MCP_BINARY_LENGTH_SIZE)
+        {
+            return FALSE;
+        }
+
+        length = (uint32)(uint8)buf[0] |
+                 ((uint32)(uint8)buf[1] << 8);
+
+        if (length < MCP_BINARY_HEADER_SIZE || length > MCP_MAX_FRAME_SIZE)
+        {
+            /* Cannot resynchronize a corrupt length - force buffer-full handling */
+            client->RxStart = 0;
+            client->RxLength = MCP_CLIENT_RX_BUFFER_SIZE;
+            return FALSE;
+        }
+
+        if (avail < MCP_BINARY_LENGTH_SIZE + length)
+        {
+            return FALSE;
+        }
+
+        *frame_start = MCP_BINARY_LENGTH_SIZE;
+        *frame_len = length;
+        *consumed = MCP_BINARY_LENGTH_SIZE + length;
+        return TRUE;
+    }
+
+    if (client->Framing != MCP_FRAMING_LENGTH_PREFIX)
+    {
+        /* Whitespace between JSON documents carries no data */
+        while (skip < avail &&
+               (buf[skip] == ' ' || buf[skip] == '\t' ||
+                buf[skip] == '\r' || buf[skip] == '\n'))
+        {
+            skip++;
+        }
+
+        client->RxStart += skip;
+        buf += skip;
+        avail -= skip;
+
+        if (avail == 0)
+        {
+            return FALSE;
+        }
+
+        if (client->Framing == MCP_FRAMING_UNKNOWN)
+        {
+            client->Framing = (buf[0] == '{') ?
+                              MCP_FRAMING_JSON : MCP_FRAMING_LENGTH_PREFIX;
+        }
+    }
+
+    if (client->Framing == MCP_FRAMING_LENGTH_PREFIX)
+    {
+        if (avail < MCP_FRAME_HEADER_SIZE)
+        {
+            return FALSE;
+        }
+
+        length = ((uint32)(uint8)buf[0] << 24) |
+                 ((uint32)(uint8)buf[1] << 16) |
+                 ((uint32)(uint8)buf[2] << 8) |
+                 ((uint32)(uint8)buf[3]);
+
+        if (length == 0 || length > MCP_MAX_FRAME_SIZE)
+        {
+            /* Cannot resynchronize a corrupt length - force buffer-full handling */
+            client->RxStart = 0;
+            client->RxLength = MCP_CLIENT_RX_BUFFER_SIZE;
+            return FALSE;
+        }
+
+        if (avail < MCP_FRAME_HEADER_SIZE + length)
+        {
+            return FALSE;
+        }
+
+        *frame_start = MCP_FRAME_HEADER_SIZE;
+        *frame_len = length;
+        *consumed = MCP_FRAME_HEADER_SIZE + length;
+        return TRUE;
+    }
+
+    /* JSON framing: the frame ends where the top-level object closes */
+    if (buf[0] != '{')
+    {
+        /* Not a JSON object - let the parser report it and drop the byte run */
+        for (i = 0; i < avail && buf[i] != '\n'; i++)
+        {
+        }
+        *frame_start = 0;
+        *frame_len = i;
+        *consumed = (i < avail) ? i + 1 : i;
+        return TRUE;
+    }
+
+    for (i = client->ScanOffset; i < avail; i++)
+    {
+        c = buf[i];
+
+        if (client->ScanInString)
+        {
+            if (client->ScanEscape)
+            {
+                client->ScanEscape = FALSE;
+            }
+            else if (c == '\\')
+            {
+                client->ScanEscape = TRUE;
+            }
+            else if (c == '"')
+            {
+                client->ScanInString = FALSE;
+            }
+        }
+        else if (c == '"')
+        {
+            client->ScanInString = TRUE;
+        }
+        else if (c == '{' || c == '[')
+        {
+            client->ScanDepth++;
+        }
+        else if ((c == '}' || c == ']') && --client->ScanDepth == 0)
+        {
+            client->ScanOffset = 0;
+            *frame_start = 0;
+            *frame_len = i + 1;
+            *consumed = i + 1;
+            return TRUE;
+        }
+    }
+
+    client->ScanOffset = avail;
+    return FALSE;
+
+} /* End MCP_INTERFACE_NextFrame */
+
+/*
+** Parse one frame and place it on the request queue
+*/
+static void MCP_INTERFACE_QueueFrame(int32 slot, char *frame, uint32 frame_len)
+{
+    MCP_INTERFACE_RequestQueue_t *queue = &MCP_INTERFACE_AppData.RequestQueue;
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+    MCP_INTERFACE_QueuedRequest_t *entry;
+    uint32 *stage_us;
+    int32 status;
+    uint32 start_us = MCP_INTERFACE_MetricsNowUs();
+
+    entry = &queue->Entries[(queue->Head + queue->Count) % MCP_REQUEST_QUEUE_DEPTH];
+    if (client->Framing == MCP_FRAMING_BINARY)
+    {
+        status = MCP_INTERFACE_ParseBinaryRequest(frame, frame_len, &entry->Request);
+    }
+    else
+    {
+        status = MCP_INTERFACE_ParseJSONRequest(frame, frame_len, &entry->Request);
+    }
+
+    stage_us = entry->Request.stage_us;
+    memset(stage_us, 0, sizeof(entry->Request.stage_us));
+    stage_us[MCP_TRACE_ACCEPTED] = client->AcceptedUs;
+    stage_us[MCP_TRACE_RECEIVED] = client->ReceivedUs;
+    stage_us[MCP_TRACE_PARSED] = MCP_INTERFACE_MetricsNowUs();
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.ParseTimeUs,
+                              stage_us[MCP_TRACE_PARSED] - start_us);
+
+    if (status == CFE_SUCCESS)
+    {
+        entry->ClientSlot = slot;
+        entry->Request.client_slot = slot;
+        queue->Count++;
+    }
+    else
+    {
+        /* Send error response for an unparseable request, tagged with the id if it was read */
+        MCP_INTERFACE_SendErrorResponse(slot, entry->Request.id, "Invalid JSON request");
+    }
+
+} /* End MCP_INTERFACE_QueueFrame */
+
+/*
+** Check whether a client still has requests waiting on the queue
+*/
+static boolean MCP_INTERFACE_HasQueuedRequests(int32 slot)
+{
+    MCP_INTERFACE_RequestQueue_t *queue = &MCP_INTERFACE_AppData.RequestQueue;
+    uint32 i;
+
+    for (i = 0; i < queue->Count; i++)
+    {
+        if (queue->Entries[(queue->Head + i) % MCP_REQUEST_QUEUE_DEPTH].ClientSlot == slot)
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+
+} /* End MCP_INTERFACE_HasQueuedRequests */
+
+/*
+** Send queued output to a client whose socket became writable
+**
+** Queued output is sent up to where a file stream was queued, then the
+** file, then the output queued behind it.
+*/
+static void MCP_INTERFACE_FlushClient(int32 slot)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+    uint32 end = client->TxLength;
+    ssize_t bytes_sent;
+
+    if (client->StreamFd >= 0 && client->TxStart == client->StreamAt)
+    {
+        bytes_sent = MCP_INTERFACE_SendStream(client);
+        if (bytes_sent == 0)
+        {
+            /* The file shrank under the stream; the client cannot resynchronize */
+            CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                             CFE_EVS_ERROR,
+                             "MCP_INTERFACE: File stream ended early, closing client (slot %d)", slot);
+            MCP_INTERFACE_ShutdownClient(slot);
+            return;
+        }
+    }
+    else
+    {
+        if (client->StreamFd >= 0)
+        {
+            end = client->StreamAt;
+        }
+
+        bytes_sent = send(client->Socket,
+                          &client->TxBuffer[client->TxStart],
+                          end - client->TxStart,
+                          MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (bytes_sent > 0)
+        {
+            client->TxStart += (uint32)bytes_sent;
+        }
+    }
+
+    if (bytes_sent < 0)
+    {
+        if (errno != EAGAIN && errno != EWOULDBLOCK)
+        {
+            MCP_INTERFACE_ShutdownClient(slot);
+        }
+        return;
+    }
+    MCP_INTERFACE_CountMetric(&MCP_INTERFACE_AppData.Metrics.BytesOut, (uint32)bytes_sent);
+
+    if (client->TxStart == client->TxLength)
+    {
+        client->TxStart = 0;
+        client->TxLength = 0;
+        client->StreamAt = 0;
+    }
+    MCP_INTERFACE_UpdateInterest(slot);
+
+    /* Frames held back while the client was backlogged can go now */
+    if (!MCP_INTERFACE_ClientBacklogged(slot) && client->RxStart < client->RxLength)
+    {
+        MCP_INTERFACE_ExtractFrames(slot);
+    }
+
+} /* End MCP_INTERFACE_FlushClient */
+
+/*
+** Send the next part of a client's file stream
+**
+** Returns the bytes sent, 0 if the file ended early or -1 with errno
+** set. The file is closed once the stream is complete.
+*/
+static ssize_t MCP_INTERFACE_SendStream(MCP_INTERFACE_Client_t *client)
+{
+    ssize_t bytes_sent;
+#ifdef __linux__
+    off_t offset = (off_t)client->StreamOffset;
+
+    /* The kernel copies from the page cache to the socket */
+    bytes_sent = sendfile(client->Socket, client->StreamFd, &offset, client->StreamRemaining);
+#else
+    char chunk[MCP_RESPONSE_FRAME_SIZE];
+    size_t length = client->StreamRemaining;
+
+    if (length > sizeof(chunk))
+    {
+        length = sizeof(chunk);
+    }
+
+    bytes_sent = pread(client->StreamFd, chunk, length, (off_t)client->StreamOffset);
+    if (bytes_sent > 0)
+    {
+        bytes_sent = send(client->Socket, chunk, (size_t)bytes_sent, MSG_DONTWAIT | MSG_NOSIGNAL);
+    }
+#endif
+
+    if (bytes_sent > 0)
+    {
+        client->StreamOffset += (uint32)bytes_sent;
+        client->StreamRemaining -= (uint32)bytes_sent;
+        if (client->StreamRemaining == 0)
+        {
+            close(client->StreamFd);
+            client->StreamFd = -1;
+        }
+    }
+
+    return bytes_sent;
+
+} /* End MCP_INTERFACE_SendStream */
+
+/*
+** Stop all traffic on a failed client
+**
+** Queued output is dropped and the socket shut down rather than closed,
+** so the slot is not freed under a request still being executed for
+** it. The hangup is then seen by poll() and the client closed by
+** MCP_INTERFACE_ReadClient.
+*/
+static void MCP_INTERFACE_ShutdownClient(int32 slot)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+
+    client->TxStart = 0;
+    client->TxLength = 0;
+    if (client->StreamFd >= 0)
+    {
+        close(client->StreamFd);
+        client->StreamFd = -1;
+    }
+    shutdown(client->Socket, SHUT_RDWR);
+    MCP_INTERFACE_UpdateInterest(slot);
+
+} /* End MCP_INTERFACE_ShutdownClient */
+
+/*
+** Match the epoll events watched on a client to its queue state
+*/
+static void MCP_INTERFACE_UpdateInterest(int32 slot)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+    struct epoll_event event;
+    uint32 wanted = 0;
+
+    if (!MCP_INTERFACE_ClientBacklogged(slot))
+    {
+        wanted |= EPOLLIN;
+    }
+    if (client->TxLength > client->TxStart || client->StreamFd >= 0)
+    {
+        wanted |= EPOLLOUT;
+    }
+
+    if (wanted != client->PollEvents)
+    {
+        event.events = wanted;
+        event.data.u64 = ((uint64)client->Generation << 32) | (uint32)slot;
+        epoll_ctl(MCP_INTERFACE_AppData.EpollFd, EPOLL_CTL_MOD, client->Socket, &event);
+        client->PollEvents = wanted;
+    }
+
+} /* End MCP_INTERFACE_UpdateInterest */
+
+/*
+** Add a descriptor to the epoll set, watched for input
+**
+** The tag is a client slot, MCP_EPOLL_SERVER or MCP_EPOLL_WAKE. Client
+** tags carry the slot's current generation.
+*/
+static int32 MCP_INTERFACE_WatchDescriptor(int32 fd, uint32 tag)
+{
+    struct epoll_event event;
+    uint64 generation = 0;
+
+    if (tag < MCP_MAX_CLIENTS)
+    {
+        generation = MCP_INTERFACE_AppData.Clients[tag].Generation;
+    }
+
+    event.events = EPOLLIN;
+    event.data.u64 = (generation << 32) | tag;
+
+    if (epoll_ctl(MCP_INTERFACE_AppData.EpollFd, EPOLL_CTL_ADD, fd, &event) < 0)
+    {
+        return CFE_ES_ERR_APP_CREATE;
+    }
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_WatchDescriptor */
+
+/*
+** Close a client connection and free its slot
+*/
+static void MCP_INTERFACE_CloseClient(int32 slot)
+{
+    MCP_INTERFACE_Client_t *client = &MCP_INTERFACE_AppData.Clients[slot];
+    MCP_INTERFACE_RequestQueue_t *queue = &MCP_INTERFACE_AppData.RequestQueue;
+    uint16 last;
+    uint32 i;
+
+    /* Nobody is left to answer, so drop what the client still has queued */
+    for (i = 0; i < queue->Count; i++)
+    {
+        if (queue->Entries[(queue->Head + i) % MCP_REQUEST_QUEUE_DEPTH].ClientSlot == slot)
+        {
+            queue->Entries[(queue->Head + i) % MCP_REQUEST_QUEUE_DEPTH].ClientSlot = -1;
+        }
+    }
+
+    /* Closing the socket also removes it from the epoll set */
+    close(client->Socket);
+    client->Socket = -1;
+    client->RxStart = 0;
+    client->RxLength = 0;
+    client->TxStart = 0;
+    client->TxLength = 0;
+    if (client->StreamFd >= 0)
+    {
+        close(client->StreamFd);
+        client->StreamFd = -1;
+    }
+
+    /* Move the last active slot into the hole this one leaves */
+    OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+    last = MCP_INTERFACE_AppData.ActiveSlots[--MCP_INTERFACE_AppData.ActiveClients];
+    MCP_INTERFACE_AppData.ActiveSlots[client->ActiveIndex] = last;
+    MCP_INTERFACE_AppData.Clients[last].ActiveIndex = client->ActiveIndex;
+
+    if (client->Subscription.AppMask != 0)
+    {
+        client->Subscription.AppMask = 0;
+        MCP_INTERFACE_UpdateTlmSubscribers();
+    }
+    OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+
+    CFE_EVS_SendEvent(MCP_INTERFACE_CLIENT_DISCONNECT_INF_EID,
+                    CFE_EVS_INFORMATION,
+                    "MCP_INTERFACE: Client disconnected (slot %d)", slot);
+
+} /* End MCP_INTERFACE_CloseClient */
@@ -0,0 +1,193 @@
+/*
+** MCP Interface System Snapshot
+**
+** This file contains the samples of every registered application and of
+** the OS heap behind get_system_status. ES app IDs are indexes into its
+** application table, so the main task walks them a slice at a time on
+** each housekeeping request and a status request reads the samples
+** instead of making one ES call per app. Samples are written and read
+** with the data mutex held.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+
+/*
+** Local function prototypes
+*/
+static void MCP_INTERFACE_SampleApp(uint32 app_id, uint32 now_us);
+
+/*
+** Take a first sample of every app at startup
+*/
+void MCP_INTERFACE_InitSystemSnapshot(void)
+{
+    uint32 i;
+
+    memset(&MCP_INTERFACE_AppData.SystemSnapshot, 0, sizeof(MCP_INTERFACE_AppData.SystemSnapshot));
+
+    for (i = 0; i < MCP_SNAPSHOT_MAX_APPS; i += MCP_SNAPSHOT_APPS_PER_PASS)
+    {
+        MCP_INTERFACE_UpdateSystemSnapshot();
+    }
+
+} /* End MCP_INTERFACE_InitSystemSnapshot */
+
+/*
+** Sample the next slice of app IDs and the heap
+**
+** Called by the main task on every housekeeping request.
+*/
+void MCP_INTERFACE_UpdateSystemSnapshot(void)
+{
+    MCP_INTERFACE_SystemSnapshot_t *snapshot = &MCP_INTERFACE_AppData.SystemSnapshot;
+    uint32 now_us = MCP_INTERFACE_MetricsNowUs();
+    uint32 i;
+
+    for (i = 0; i < MCP_SNAPSHOT_APPS_PER_PASS; i++)
+    {
+        MCP_INTERFACE_SampleApp(snapshot->NextAppId, now_us);
+        snapshot->NextAppId = (snapshot->NextAppId + 1) % MCP_SNAPSHOT_MAX_APPS;
+    }
+
+    snapshot->HeapValid = (OS_HeapGetInfo(&snapshot->Heap) == OS_SUCCESS);
+    snapshot->SampledUs = now_us;
+    snapshot->Passes++;
+
+} /* End MCP_INTERFACE_UpdateSystemSnapshot */
+
+/*
+** Write the memory and task status members of a system status result
+**
+** With apps set, the samples of registered apps from ID start on follow
+** as an apps array, as many as fit the response, then next_app_id (the
+** start of the next page) and more.
+*/
+void MCP_INTERFACE_WriteSystemSnapshot(MCP_JSON_Writer_t *json, boolean apps, uint32 start)
+{
+    const MCP_INTERFACE_SystemSnapshot_t *snapshot = &MCP_INTERFACE_AppData.SystemSnapshot;
+    const MCP_INTERFACE_AppSample_t *sample;
+    MCP_JSON_Mark_t mark;
+    uint32 registered = 0;
+    uint32 active = 0;
+    uint32 tasks = 0;
+    uint32 app_id;
+
+    for (app_id = 0; app_id < MCP_SNAPSHOT_MAX_APPS; app_id++)
+    {
+        sample = &snapshot->Apps[app_id];
+        if (sample->Registered)
+        {
+            registered++;
+            tasks += 1 + sample->NumOfChildTasks;
+            if (sample->ExecRate > 0)
+            {
+                active++;
+            }
+        }
+    }
+
+    MCP_JSON_Key(json, "memory_status");
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyBool(json, "available", snapshot->HeapValid);
+    if (snapshot->HeapValid)
+    {
+        MCP_JSON_KeyUint(json, "heap_free_bytes", snapshot->Heap.free_bytes);
+        MCP_JSON_KeyUint(json, "heap_free_blocks", snapshot->Heap.free_blocks);
+        MCP_JSON_KeyUint(json, "largest_free_block", snapshot->Heap.largest_free_block);
+    }
+    MCP_JSON_EndObject(json);
+
+    MCP_JSON_Key(json, "task_status");
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_KeyUint(json, "registered_apps", registered);
+    MCP_JSON_KeyUint(json, "active_apps", active);
+    MCP_JSON_KeyUint(json, "total_tasks", tasks);
+    MCP_JSON_KeyUint(json, "sample_age_ms", (MCP_INTERFACE_MetricsNowUs() - snapshot->SampledUs) / 1000);
+    MCP_JSON_EndObject(json);
+
+    if (!apps)
+    {
+        return;
+    }
+
+    MCP_JSON_Key(json, "apps");
+    MCP_JSON_BeginArray(json);
+
+    for (app_id = start; app_id < MCP_SNAPSHOT_MAX_APPS; app_id++)
+    {
+        sample = &snapshot->Apps[app_id];
+        if (!sample->Registered)
+        {
+            continue;
+        }
+
+        mark = MCP_JSON_GetMark(json);
+
+        MCP_JSON_BeginObject(json);
+        MCP_JSON_KeyString(json, "name", sample->Name);
+        MCP_JSON_KeyUint(json, "app_id", app_id);
+        MCP_JSON_KeyUint(json, "type", sample->Type);
+        MCP_JSON_KeyUint(json, "app_state", sample->AppState);
+        MCP_JSON_KeyUint(json, "priority", sample->Priority);
+        MCP_JSON_KeyUint(json, "main_task_id", sample->MainTaskId);
+        MCP_JSON_KeyUint(json, "child_tasks", sample->NumOfChildTasks);
+        MCP_JSON_KeyUint(json, "stack_size", sample->StackSize);
+        MCP_JSON_KeyUint(json, "execution_counter", sample->ExecutionCounter);
+        MCP_JSON_KeyUint(json, "executions_per_s", sample->ExecRate);
+        MCP_JSON_EndObject(json);
+
+        /* Stop at the first app that would not leave room for the rest */
+        if (!MCP_JSON_Ok(json) || json->Length + MCP_SNAPSHOT_RESERVE > json->Size)
+        {
+            MCP_JSON_Rewind(json, &mark);
+            break;
+        }
+    }
+
+    MCP_JSON_EndArray(json);
+    MCP_JSON_KeyUint(json, "next_app_id", app_id);
+    MCP_JSON_KeyBool(json, "more", app_id < MCP_SNAPSHOT_MAX_APPS);
+
+} /* End MCP_INTERFACE_WriteSystemSnapshot */
+
+/*
+** Sample one app ID
+**
+** The rate is only computed against an earlier sample of the same app,
+** so an ID reused by a restarted app starts again from zero.
+*/
+static void MCP_INTERFACE_SampleApp(uint32 app_id, uint32 now_us)
+{
+    MCP_INTERFACE_AppSample_t *sample = &MCP_INTERFACE_AppData.SystemSnapshot.Apps[app_id];
+    CFE_ES_AppInfo_t app_info;
+    boolean same_app;
+
+    if (CFE_ES_GetAppInfo(&app_info, app_id) != CFE_SUCCESS)
+    {
+        sample->Registered = FALSE;
+        return;
+    }
+
+    app_info.Name[sizeof(app_info.Name) - 1] = '\0';
+    same_app = sample->Registered && strcmp(sample->Name, app_info.Name) == 0 &&
+               now_us != sample->SampledUs;
+
+    sample->ExecRate = same_app ?
+        (uint32)((uint64)(app_info.ExecutionCounter - sample->ExecutionCounter) * 1000000 /
+                 (now_us - sample->SampledUs)) : 0;
+
+    sample->Registered = TRUE;
+    sample->Type = app_info.Type;
+    sample->AppState = app_info.AppState;
+    sample->Priority = app_info.Priority;
+    sample->MainTaskId = app_info.MainTaskId;
+    sample->NumOfChildTasks = app_info.NumOfChildTasks;
+    sample->StackSize = app_info.StackSize;
+    sample->ExecutionCounter = app_info.ExecutionCounter;
+    sample->SampledUs = now_us;
+    memcpy(sample->Name, app_info.Name, sizeof(sample->Name));
+
+} /* End MCP_INTERFACE_SampleApp */
@@ -0,0 +1,401 @@
+/*
+** MCP Interface Telemetry Cache
+**
+** This file contains the cache of housekeeping telemetry from the apps
+** listed in the command dictionary. The app pipe is subscribed to their
+** telemetry message IDs and every packet received replaces the previous
+** snapshot, so telemetry requests never wait on the software bus.
+**
+** Clients can also subscribe to cache slots. The main task wakes the
+** socket task when a subscribed slot is updated, and the socket task
+** pushes the new snapshot to every client whose rate limit and change
+** filter allow it.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+
+/*
+** Local function prototypes
+*/
+static void MCP_INTERFACE_RemapSubscriptions(char old_names[][MCP_MAX_APP_NAME_LEN]);
+static boolean MCP_INTERFACE_PushTelemetry(int32 slot, uint32 index, uint32 current_time);
+
+/*
+** Subscribe to the telemetry listed in the command dictionary
+**
+** Called with the data mutex held whenever a new command table is
+** loaded. Snapshots of the previous table are dropped; client
+** subscriptions follow their apps to the new slots.
+*/
+void MCP_INTERFACE_SubscribeTelemetry(void)
+{
+    char old_names[MCP_TLM_CACHE_MAX_ENTRIES][MCP_MAX_APP_NAME_LEN];
+    MCP_INTERFACE_TlmSnapshot_t *snapshot;
+    const MCP_INTERFACE_TlmEntry_t *entry;
+    int32 status;
+    uint32 i;
+
+    for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+    {
+        snapshot = &MCP_INTERFACE_AppData.TlmCache[i];
+        memcpy(old_names[i], snapshot->AppName, MCP_MAX_APP_NAME_LEN);
+        if (snapshot->MsgId != 0)
+        {
+            CFE_SB_Unsubscribe(snapshot->MsgId, MCP_INTERFACE_AppData.CommandPipe);
+        }
+    }
+
+    memset(MCP_INTERFACE_AppData.TlmCache, 0, sizeof(MCP_INTERFACE_AppData.TlmCache));
+    MCP_INTERFACE_FlushResponseCache();
+
+    for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+    {
+        entry = &MCP_INTERFACE_AppData.CmdTblPtr->Telemetry[i];
+        if (entry->AppName[0] == '\0')
+        {
+            continue;
+        }
+
+        status = CFE_SB_Subscribe(entry->MsgId, MCP_INTERFACE_AppData.CommandPipe);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_EVS_SendEvent(MCP_INTERFACE_TABLE_ERR_EID,
+                             CFE_EVS_ERROR,
+                             "MCP_INTERFACE: Error subscribing to %s telemetry 0x%04X, RC = 0x%08X",
+                             entry->AppName, (unsigned int)entry->MsgId, status);
+            continue;
+        }
+
+        snapshot = &MCP_INTERFACE_AppData.TlmCache[i];
+        strncpy(snapshot->AppName, entry->AppName, sizeof(snapshot->AppName) - 1);
+        snapshot->MsgId = entry->MsgId;
+    }
+
+    /* Readers see the new table's apps, with nothing received yet */
+    for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+    {
+        MCP_INTERFACE_ShareTelemetry(i);
+    }
+
+    MCP_INTERFACE_RemapSubscriptions(old_names);
+
+} /* End MCP_INTERFACE_SubscribeTelemetry */
+
+/*
+** Store a received packet if it is cached telemetry
+**
+** Returns FALSE if the message ID is not cached.
+*/
+boolean MCP_INTERFACE_CacheTelemetry(CFE_SB_MsgPtr_t msg)
+{
+    MCP_INTERFACE_TlmSnapshot_t *snapshot;
+    CFE_SB_MsgId_t msg_id;
+    uint16 length;
+    uint32 hash;
+    uint32 i;
+    uint32 j;
+
+    msg_id = CFE_SB_GetMsgId(msg);
+
+    for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+    {
+        snapshot = &MCP_INTERFACE_AppData.TlmCache[i];
+        if (snapshot->MsgId != msg_id)
+        {
+            continue;
+        }
+
+        length = CFE_SB_GetTotalMsgLength(msg);
+
+        snapshot->TotalLength = length;
+        snapshot->Length = (length > MCP_TLM_CACHE_MAX_PKT_LEN) ? MCP_TLM_CACHE_MAX_PKT_LEN : length;
+        snapshot->Received = CFE_TIME_GetTime();
+        snapshot->Count++;
+        memcpy(snapshot->Packet, msg, snapshot->Length);
+
+        /* The header time stamp changes every packet, so leave it out */
+        hash = 2166136261u;
+        for (j = CFE_SB_TLM_HDR_SIZE; j < snapshot->Length; j++)
+        {
+            hash = (hash ^ snapshot->Packet[j]) * 16777619u;
+        }
+        snapshot->DataHash = hash;
+
+        MCP_INTERFACE_InvalidateResponses(i);
+        MCP_INTERFACE_ShareTelemetry(i);
+
+        /* A full pipe means a wakeup is already pending */
+        if ((MCP_INTERFACE_AppData.TlmSubscribers | MCP_INTERFACE_AppData.Sequences.WatchedSlots) & (1u << i))
+        {
+            (void)write(MCP_INTERFACE_AppData.WakePipe[1], "", 1);
+        }
+
+        return TRUE;
+    }
+
+    return FALSE;
+
+} /* End MCP_INTERFACE_CacheTelemetry */
+
+/*
+** Snapshot of an app's housekeeping telemetry, or NULL if not cached
+*/
+const MCP_INTERFACE_TlmSnapshot_t *MCP_INTERFACE_FindTelemetry(const char *app_name)
+{
+    uint32 i;
+
+    for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+    {
+        if (MCP_INTERFACE_AppData.TlmCache[i].MsgId != 0 &&
+            strcmp(MCP_INTERFACE_AppData.TlmCache[i].AppName, app_name) == 0)
+        {
+            return &MCP_INTERFACE_AppData.TlmCache[i];
+        }
+    }
+
+    return NULL;
+
+} /* End MCP_INTERFACE_FindTelemetry */
+
+/*
+** Write the members describing a snapshot into an open object
+*/
+void MCP_INTERFACE_WriteTelemetry(MCP_JSON_Writer_t *json, const MCP_INTERFACE_TlmSnapshot_t *snapshot,
+                                  uint32 current_time)
+{
+    char msg_id_str[8];
+
+    snprintf(msg_id_str, sizeof(msg_id_str), "0x%04X", snapshot->MsgId);
+    MCP_JSON_KeyString(json, "msg_id", msg_id_str);
+
+    if (snapshot->Count == 0)
+    {
+        MCP_JSON_KeyString(json, "status", "telemetry_not_received");
+        return;
+    }
+
+    MCP_JSON_KeyString(json, "status", "ok");
+    MCP_JSON_KeyUint(json, "received", snapshot->Received.Seconds);
+    MCP_JSON_KeyUint(json, "age_seconds", current_time - snapshot->Received.Seconds);
+    MCP_JSON_KeyUint(json, "packet_count", snapshot->Count);
+    MCP_JSON_KeyUint(json, "length", snapshot->TotalLength);
+    MCP_JSON_KeyBool(json, "truncated", snapshot->Length < snapshot->TotalLength);
+    MCP_JSON_Key(json, "packet");
+    MCP_JSON_Bytes(json, snapshot->Packet, snapshot->Length);
+
+} /* End MCP_INTERFACE_WriteTelemetry */
+
+/*
+** Recompute which cache slots have subscribers
+**
+** Called with the data mutex held after any subscription changes.
+*/
+void MCP_INTERFACE_UpdateTlmSubscribers(void)
+{
+    uint32 mask = 0;
+    uint32 i;
+
+    for (i = 0; i < MCP_INTERFACE_AppData.ActiveClients; i++)
+    {
+        mask |= MCP_INTERFACE_AppData.Clients[MCP_INTERFACE_AppData.ActiveSlots[i]].Subscription.AppMask;
+    }
+
+    MCP_INTERFACE_AppData.TlmSubscribers = mask;
+
+} /* End MCP_INTERFACE_UpdateTlmSubscribers */
+
+/*
+** Push due telemetry updates to subscribed clients
+**
+** Runs on the socket task after every wakeup. Returns how long the
+** socket task may sleep before an update held back now becomes due.
+*/
+int32 MCP_INTERFACE_PublishTelemetry(void)
+{
+    MCP_INTERFACE_TlmSubscription_t *sub;
+    const MCP_INTERFACE_TlmSnapshot_t *snapshot;
+    int32 wait = MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS;
+    uint32 current_time;
+    uint32 now;
+    uint32 elapsed;
+    uint32 pending;
+    uint32 active;
+    uint32 slot;
+    uint32 i;
+
+    /* Subscriptions are only added on this task, so a zero here is never stale */
+    if (MCP_INTERFACE_AppData.TlmSubscribers == 0)
+    {
+        return wait;
+    }
+
+    OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+
+    now = MCP_INTERFACE_MetricsNowMs();
+    current_time = CFE_TIME_GetTime().Seconds;
+
+    for (active = 0; active < MCP_INTERFACE_AppData.ActiveClients; active++)
+    {
+        slot = MCP_INTERFACE_AppData.ActiveSlots[active];
+        sub = &MCP_INTERFACE_AppData.Clients[slot].Subscription;
+        if (sub->AppMask == 0)
+        {
+            continue;
+        }
+
+        /* Collect the slots with a packet this client has not seen */
+        pending = 0;
+        for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+        {
+            snapshot = &MCP_INTERFACE_AppData.TlmCache[i];
+            if ((sub->AppMask & (1u << i)) == 0 || snapshot->Count == sub->SentCount[i])
+            {
+                continue;
+            }
+
+            if (sub->OnChange && sub->SentCount[i] != 0 && snapshot->DataHash == sub->SentHash[i])
+            {
+                sub->SentCount[i] = snapshot->Count;
+                continue;
+            }
+
+            elapsed = now - sub->SentTimeMs[i];
+            if (sub->SentCount[i] != 0 && elapsed < sub->MinIntervalMs)
+            {
+                if ((int32)(sub->MinIntervalMs - elapsed) < wait)
+                {
+                    wait = (int32)(sub->MinIntervalMs - elapsed);
+                }
+                continue;
+            }
+
+            pending |= (1u << i);
+        }
+
+        if (pending == 0)
+        {
+            continue;
+        }
+
+        /*
+        ** A backlogged client gets the latest packets once its output
+        ** drains, which wakes the socket task again
+        */
+        for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+        {
+            if ((pending & (1u << i)) == 0)
+            {
+                continue;
+            }
+
+            if (MCP_INTERFACE_ClientBacklogged((int32)slot))
+            {
+                break;
+            }
+
+            if (!MCP_INTERFACE_PushTelemetry((int32)slot, i, current_time))
+            {
+                break;
+            }
+
+            snapshot = &MCP_INTERFACE_AppData.TlmCache[i];
+            sub->SentCount[i] = snapshot->Count;
+            sub->SentHash[i] = snapshot->DataHash;
+            sub->SentTimeMs[i] = now;
+        }
+    }
+
+    OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+
+    return wait;
+
+} /* End MCP_INTERFACE_PublishTelemetry */
+
+/*
+** Move client subscriptions to the slots their apps occupy after a
+** command table load
+*/
+static void MCP_INTERFACE_RemapSubscriptions(char old_names[][MCP_MAX_APP_NAME_LEN])
+{
+    MCP_INTERFACE_TlmSubscription_t *sub;
+    uint32 mask;
+    uint32 slot;
+    uint32 i;
+    uint32 j;
+
+    for (slot = 0; slot < MCP_MAX_CLIENTS; slot++)
+    {
+        sub = &MCP_INTERFACE_AppData.Clients[slot].Subscription;
+        if (sub->AppMask == 0)
+        {
+            continue;
+        }
+
+        mask = 0;
+        for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+        {
+            if ((sub->AppMask & (1u << i)) == 0)
+            {
+                continue;
+            }
+
+            for (j = 0; j < MCP_TLM_CACHE_MAX_ENTRIES; j++)
+            {
+                if (MCP_INTERFACE_AppData.TlmCache[j].MsgId != 0 &&
+                    strcmp(MCP_INTERFACE_AppData.TlmCache[j].AppName, old_names[i]) == 0)
+                {
+                    mask |= (1u << j);
+                }
+            }
+        }
+
+        sub->AppMask = mask;
+        memset(sub->SentCount, 0, sizeof(sub->SentCount));
+        memset(sub->SentTimeMs, 0, sizeof(sub->SentTimeMs));
+    }
+
+    MCP_INTERFACE_UpdateTlmSubscribers();
+
+} /* End MCP_INTERFACE_RemapSubscriptions */
+
+/*
+** Send one telemetry update to a client
+*/
+static boolean MCP_INTERFACE_PushTelemetry(int32 slot, uint32 index, uint32 current_time)
+{
+    const MCP_INTERFACE_TlmSnapshot_t *snapshot = &MCP_INTERFACE_AppData.TlmCache[index];
+    MCP_JSON_Writer_t json;
+    char *frame;
+    int32 status;
+
+    frame = MCP_INTERFACE_AcquireOutputBuffer();
+    if (frame == NULL)
+    {
+        return FALSE;
+    }
+
+    /* Same envelope as a response, marked as a push for the subscription */
+    MCP_INTERFACE_InitResponseWriter(&json, frame, slot);
+    MCP_JSON_BeginObject(&json);
+    MCP_JSON_KeyUint(&json, "id", MCP_INTERFACE_AppData.Clients[slot].Subscription.Id);
+    MCP_JSON_KeyString(&json, "push", "telemetry");
+    MCP_JSON_Key(&json, "result");
+    MCP_JSON_BeginObject(&json);
+    MCP_JSON_KeyString(&json, "app_name", snapshot->AppName);
+    MCP_JSON_KeyUint(&json, "timestamp", current_time);
+    MCP_INTERFACE_WriteTelemetry(&json, snapshot, current_time);
+    MCP_JSON_EndObject(&json);
+    MCP_JSON_KeyInt(&json, "status", 0);
+    MCP_JSON_KeyUint(&json, "timestamp", current_time);
+    MCP_JSON_EndObject(&json);
+
+    status = MCP_INTERFACE_SendMCPResponse(slot, &json);
+
+    MCP_INTERFACE_ReleaseOutputBuffer(frame);
+
+    return (status == CFE_SUCCESS);
+
+} /* End MCP_INTERFACE_PushTelemetry */
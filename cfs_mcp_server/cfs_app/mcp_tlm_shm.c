@@ -0,0 +1,206 @@
+/*
+** MCP Interface Telemetry Shared Memory
+**
+** This file contains the publishing of telemetry into a POSIX shared
+** memory region for co-located readers. The main task is the only
+** writer: it copies each cached packet into its record as the packet is
+** cached, and the app's housekeeping packet as it is sent, so readers
+** polling the region cost the app nothing. A record's count is made
+** odd before and even again after the record is written, which lets a
+** reader detect and retry a copy torn by a write. Without
+** MCP_TLM_SHM_NAME no region is created and publishing does nothing.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+
+#ifdef MCP_TLM_SHM_NAME
+#include <fcntl.h>
+#include <sys/mman.h>
+#endif
+
+/*
+** Local function prototypes
+*/
+static MCP_INTERFACE_TlmShmRecord_t *MCP_INTERFACE_BeginShmRecord(uint32 record);
+static void MCP_INTERFACE_EndShmRecord(MCP_INTERFACE_TlmShmRecord_t *rec);
+
+/*
+** Records are padded to whole cache lines so no two share one
+*/
+#define MCP_TLM_SHM_STRIDE \
+    ((sizeof(MCP_INTERFACE_TlmShmRecord_t) + MCP_TLM_SHM_LINE_SIZE - 1) & ~(MCP_TLM_SHM_LINE_SIZE - 1))
+#define MCP_TLM_SHM_OFFSET \
+    ((sizeof(MCP_INTERFACE_TlmShmHeader_t) + MCP_TLM_SHM_LINE_SIZE - 1) & ~(MCP_TLM_SHM_LINE_SIZE - 1))
+#define MCP_TLM_SHM_SIZE                      (MCP_TLM_SHM_OFFSET + MCP_TLM_SHM_RECORDS * MCP_TLM_SHM_STRIDE)
+
+/*
+** Create the region and publish what is cached so far
+**
+** A region left by an earlier run is replaced. Failing to create it
+** only costs the readers their telemetry, so the app runs on without.
+*/
+void MCP_INTERFACE_InitTlmShm(void)
+{
+#ifdef MCP_TLM_SHM_NAME
+    MCP_INTERFACE_TlmShmHeader_t *header;
+    MCP_INTERFACE_TlmShmRecord_t *rec;
+    void *base;
+    int fd;
+    uint32 i;
+
+    MCP_INTERFACE_AppData.TlmShm = NULL;
+
+    (void)shm_unlink(MCP_TLM_SHM_NAME);
+
+    fd = shm_open(MCP_TLM_SHM_NAME, O_RDWR | O_CREAT | O_EXCL, 0644);
+    if (fd < 0)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_TELEMETRY_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Telemetry region %s not created, errno = %d",
+                         MCP_TLM_SHM_NAME, errno);
+        return;
+    }
+
+    if (ftruncate(fd, MCP_TLM_SHM_SIZE) != 0)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_TELEMETRY_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Telemetry region %s not sized, errno = %d",
+                         MCP_TLM_SHM_NAME, errno);
+        close(fd);
+        (void)shm_unlink(MCP_TLM_SHM_NAME);
+        return;
+    }
+
+    base = mmap(NULL, MCP_TLM_SHM_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (base == MAP_FAILED)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_TELEMETRY_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Telemetry region %s not mapped, errno = %d",
+                         MCP_TLM_SHM_NAME, errno);
+        (void)shm_unlink(MCP_TLM_SHM_NAME);
+        return;
+    }
+
+    /* A new region reads as zero, so every record starts empty and even */
+    MCP_INTERFACE_AppData.TlmShm = (uint8 *)base;
+
+    rec = MCP_INTERFACE_BeginShmRecord(0);
+    strncpy(rec->AppName, "MCP_INTERFACE", sizeof(rec->AppName) - 1);
+    rec->MsgId = MCP_INTERFACE_HK_TLM_MID;
+    MCP_INTERFACE_EndShmRecord(rec);
+
+    for (i = 0; i < MCP_TLM_CACHE_MAX_ENTRIES; i++)
+    {
+        MCP_INTERFACE_ShareTelemetry(i);
+    }
+
+    header = (MCP_INTERFACE_TlmShmHeader_t *)base;
+    header->Version = MCP_TLM_SHM_VERSION;
+    header->Size = MCP_TLM_SHM_SIZE;
+    header->RecordOffset = MCP_TLM_SHM_OFFSET;
+    header->RecordStride = MCP_TLM_SHM_STRIDE;
+    header->RecordCount = MCP_TLM_SHM_RECORDS;
+    header->PacketSize = MCP_TLM_CACHE_MAX_PKT_LEN;
+
+    /* Readers wait for the magic, so it goes in once the rest is there */
+    __atomic_store_n(&header->Magic, MCP_TLM_SHM_MAGIC, __ATOMIC_RELEASE);
+
+    CFE_EVS_SendEvent(MCP_INTERFACE_TELEMETRY_INF_EID,
+                     CFE_EVS_INFORMATION,
+                     "MCP_INTERFACE: Publishing telemetry to %s, %u bytes",
+                     MCP_TLM_SHM_NAME, (unsigned int)MCP_TLM_SHM_SIZE);
+#else
+    MCP_INTERFACE_AppData.TlmShm = NULL;
+#endif
+
+} /* End MCP_INTERFACE_InitTlmShm */
+
+/*
+** Publish a cache slot into its record
+**
+** Called by the main task whenever the slot changes.
+*/
+void MCP_INTERFACE_ShareTelemetry(uint32 index)
+{
+    const MCP_INTERFACE_TlmSnapshot_t *snapshot = &MCP_INTERFACE_AppData.TlmCache[index];
+    MCP_INTERFACE_TlmShmRecord_t *rec;
+
+    if (MCP_INTERFACE_AppData.TlmShm == NULL)
+    {
+        return;
+    }
+
+    rec = MCP_INTERFACE_BeginShmRecord(1 + index);
+    memcpy(rec->AppName, snapshot->AppName, sizeof(rec->AppName));
+    rec->MsgId = snapshot->MsgId;
+    rec->Length = snapshot->Length;
+    rec->TotalLength = snapshot->TotalLength;
+    rec->Count = snapshot->Count;
+    rec->DataHash = snapshot->DataHash;
+    rec->Seconds = snapshot->Received.Seconds;
+    rec->Subseconds = snapshot->Received.Subseconds;
+    memcpy(rec->Packet, snapshot->Packet, snapshot->Length);
+    MCP_INTERFACE_EndShmRecord(rec);
+
+} /* End MCP_INTERFACE_ShareTelemetry */
+
+/*
+** Publish the housekeeping packet just sent into record 0
+*/
+void MCP_INTERFACE_ShareHousekeeping(void)
+{
+    MCP_INTERFACE_TlmShmRecord_t *rec;
+    CFE_TIME_SysTime_t sent;
+    uint16 length = sizeof(MCP_INTERFACE_AppData.HkTlm);
+
+    if (MCP_INTERFACE_AppData.TlmShm == NULL)
+    {
+        return;
+    }
+
+    sent = CFE_SB_GetMsgTime((CFE_SB_Msg_t *)&MCP_INTERFACE_AppData.HkTlm);
+
+    rec = MCP_INTERFACE_BeginShmRecord(0);
+    rec->TotalLength = length;
+    rec->Length = (length > MCP_TLM_CACHE_MAX_PKT_LEN) ? MCP_TLM_CACHE_MAX_PKT_LEN : length;
+    rec->Count++;
+    rec->Seconds = sent.Seconds;
+    rec->Subseconds = sent.Subseconds;
+    memcpy(rec->Packet, &MCP_INTERFACE_AppData.HkTlm, rec->Length);
+    MCP_INTERFACE_EndShmRecord(rec);
+
+} /* End MCP_INTERFACE_ShareHousekeeping */
+
+/*
+** Mark a record as being written; its count is odd until it is ended
+*/
+static MCP_INTERFACE_TlmShmRecord_t *MCP_INTERFACE_BeginShmRecord(uint32 record)
+{
+    MCP_INTERFACE_TlmShmRecord_t *rec;
+
+    rec = (MCP_INTERFACE_TlmShmRecord_t *)(MCP_INTERFACE_AppData.TlmShm + MCP_TLM_SHM_OFFSET +
+                                           record * MCP_TLM_SHM_STRIDE);
+
+    /* Only this task writes the count, so a plain read of it is current */
+    __atomic_store_n(&rec->Seq, rec->Seq + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+
+    return rec;
+
+} /* End MCP_INTERFACE_BeginShmRecord */
+
+/*
+** Publish a record written since it was begun
+*/
+static void MCP_INTERFACE_EndShmRecord(MCP_INTERFACE_TlmShmRecord_t *rec)
+{
+    __atomic_store_n(&rec->Seq, rec->Seq + 1, __ATOMIC_RELEASE);
+
+} /* End MCP_INTERFACE_EndShmRecord */
@@ -0,0 +1,216 @@
+/*
+** MCP Interface Request Trace
+**
+** This file contains the ring of request traces. A request carries the
+** time it reached each stage of the request path, and once its
+** response has been handed to the socket the socket task copies those
+** times into the ring. Both the socket task and the readers of the ring
+** (GET_TRACE and the dump ground command) hold the data mutex. Recording
+** costs a clock read per stage, so tracing is always on; debug mode adds
+** the start of each response to its record.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+
+/*
+** Stage names, as reported by GET_TRACE
+*/
+static const char *const MCP_INTERFACE_TraceStageNames[MCP_TRACE_STAGE_COUNT] = {
+    [MCP_TRACE_ACCEPTED]       = "accepted",
+    [MCP_TRACE_RECEIVED]       = "received",
+    [MCP_TRACE_PARSED]         = "parsed",
+    [MCP_TRACE_VALIDATED]      = "validated",
+    [MCP_TRACE_SAFETY_CHECKED] = "safety_checked",
+    [MCP_TRACE_HANDLER_START]  = "handler_start",
+    [MCP_TRACE_HANDLER_END]    = "handler_end",
+    [MCP_TRACE_FORMATTED]      = "formatted",
+    [MCP_TRACE_SENT]           = "sent"
+};
+
+/*
+** Record the trace of a request whose response was just sent
+**
+** Called with the data mutex held.
+*/
+void MCP_INTERFACE_RecordTrace(const MCP_Request_t *request, const MCP_Response_t *response)
+{
+    MCP_INTERFACE_TraceLog_t *log = &MCP_INTERFACE_AppData.TraceLog;
+    MCP_INTERFACE_TraceRecord_t *record;
+    const MCP_JSON_Writer_t *json = response->result;
+    uint32 length = 0;
+
+    record = &log->Records[log->NextSeq % MCP_TRACE_DEPTH];
+    record->Seq = log->NextSeq++;
+    record->RequestId = request->id;
+    memcpy(record->StageUs, request->stage_us, sizeof(record->StageUs));
+    record->StageUs[MCP_TRACE_SENT] = MCP_INTERFACE_MetricsNowUs();
+    record->ResponseLength = json->Length;
+    record->ClientSlot = (uint16)request->client_slot;
+    record->Type = (uint8)request->type;
+    record->Status = (int8)response->status;
+
+    /* A binary response has no readable start */
+    if (MCP_INTERFACE_AppData.DebugMode && json->Format != MCP_JSON_FORMAT_CBOR)
+    {
+        length = json->Length;
+        if (length > MCP_TRACE_SNIPPET_LEN - 1)
+        {
+            length = MCP_TRACE_SNIPPET_LEN - 1;
+        }
+        memcpy(record->Snippet, json->Buffer, length);
+    }
+    record->Snippet[length] = '\0';
+
+} /* End MCP_INTERFACE_RecordTrace */
+
+/*
+** Write the traces after since_seq, oldest first
+**
+** The result has the stage names, the traces, first_seq (the oldest
+** trace still in the ring), lost (traces after since_seq overwritten
+** before they could be fetched), next_seq and more, as for the event
+** log. Each trace has its stage times in the order of the stage names.
+** Called with the data mutex held.
+*/
+void MCP_INTERFACE_WriteTrace(MCP_JSON_Writer_t *json, uint32 since_seq, uint32 max)
+{
+    const MCP_INTERFACE_TraceLog_t *log = &MCP_INTERFACE_AppData.TraceLog;
+    const MCP_INTERFACE_TraceRecord_t *record;
+    MCP_JSON_Mark_t mark;
+    uint32 first_seq;
+    uint32 seq;
+    uint32 lost = 0;
+    uint32 count = 0;
+    uint32 i;
+
+    first_seq = (log->NextSeq > MCP_TRACE_DEPTH) ? log->NextSeq - MCP_TRACE_DEPTH : 1;
+
+    if (since_seq >= log->NextSeq)
+    {
+        since_seq = 0;
+    }
+    if (since_seq + 1 < first_seq)
+    {
+        lost = first_seq - since_seq - 1;
+        since_seq = first_seq - 1;
+    }
+
+    MCP_JSON_BeginObject(json);
+    MCP_JSON_Key(json, "stages");
+    MCP_JSON_BeginArray(json);
+    for (i = 0; i < MCP_TRACE_STAGE_COUNT; i++)
+    {
+        MCP_JSON_String(json, MCP_INTERFACE_TraceStageNames[i]);
+    }
+    MCP_JSON_EndArray(json);
+
+    MCP_JSON_Key(json, "traces");
+    MCP_JSON_BeginArray(json);
+
+    for (seq = since_seq + 1; seq < log->NextSeq && count < max; seq++)
+    {
+        record = &log->Records[seq % MCP_TRACE_DEPTH];
+        mark = MCP_JSON_GetMark(json);
+
+        MCP_JSON_BeginObject(json);
+        MCP_JSON_KeyUint(json, "seq", record->Seq);
+        MCP_JSON_KeyUint(json, "id", record->RequestId);
+        MCP_JSON_KeyUint(json, "type", record->Type);
+        MCP_JSON_KeyUint(json, "slot", record->ClientSlot);
+        MCP_JSON_KeyInt(json, "status", record->Status);
+        MCP_JSON_KeyUint(json, "length", record->ResponseLength);
+        MCP_JSON_Key(json, "stages_us");
+        MCP_JSON_BeginArray(json);
+        for (i = 0; i < MCP_TRACE_STAGE_COUNT; i++)
+        {
+            MCP_JSON_Uint(json, record->StageUs[i]);
+        }
+        MCP_JSON_EndArray(json);
+        if (record->Snippet[0] != '\0')
+        {
+            MCP_JSON_KeyString(json, "response", record->Snippet);
+        }
+        MCP_JSON_EndObject(json);
+
+        /* Stop at the first trace that would not leave room for the rest */
+        if (!MCP_JSON_Ok(json) || json->Length + MCP_TRACE_RESERVE > json->Size)
+        {
+            MCP_JSON_Rewind(json, &mark);
+            break;
+        }
+
+        count++;
+    }
+
+    MCP_JSON_EndArray(json);
+    MCP_JSON_KeyUint(json, "first_seq", first_seq);
+    MCP_JSON_KeyUint(json, "lost", lost);
+    MCP_JSON_KeyUint(json, "next_seq", seq - 1);
+    MCP_JSON_KeyBool(json, "more", seq < log->NextSeq);
+    MCP_JSON_EndObject(json);
+
+} /* End MCP_INTERFACE_WriteTrace */
+
+/*
+** Write the trace ring to a file, oldest trace first
+**
+** The file is a cFE file header followed by the records as
+** MCP_INTERFACE_TraceRecord_t. Called with the data mutex held.
+*/
+int32 MCP_INTERFACE_DumpTrace(const char *filename)
+{
+    const MCP_INTERFACE_TraceLog_t *log = &MCP_INTERFACE_AppData.TraceLog;
+    CFE_FS_Header_t header;
+    int32 fd;
+    int32 status = CFE_SUCCESS;
+    uint32 first_seq;
+    uint32 seq;
+
+    fd = OS_creat(filename, OS_WRITE_ONLY);
+    if (fd < 0)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Failed to create trace file %s, RC = 0x%08X",
+                         filename, (unsigned int)fd);
+        return fd;
+    }
+
+    CFE_FS_InitHeader(&header, "MCP interface request trace", MCP_TRACE_FILE_SUBTYPE);
+    if (CFE_FS_WriteHeader(fd, &header) != sizeof(header))
+    {
+        status = OS_FS_ERROR;
+    }
+
+    first_seq = (log->NextSeq > MCP_TRACE_DEPTH) ? log->NextSeq - MCP_TRACE_DEPTH : 1;
+
+    for (seq = first_seq; seq < log->NextSeq && status == CFE_SUCCESS; seq++)
+    {
+        if (OS_write(fd, (void *)&log->Records[seq % MCP_TRACE_DEPTH],
+                     sizeof(MCP_INTERFACE_TraceRecord_t)) != sizeof(MCP_INTERFACE_TraceRecord_t))
+        {
+            status = OS_FS_ERROR;
+        }
+    }
+
+    OS_close(fd);
+
+    if (status != CFE_SUCCESS)
+    {
+        CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_ERR_EID,
+                         CFE_EVS_ERROR,
+                         "MCP_INTERFACE: Failed to write trace file %s", filename);
+        return status;
+    }
+
+    CFE_EVS_SendEvent(MCP_INTERFACE_COMMAND_SUCCESS_INF_EID,
+                     CFE_EVS_INFORMATION,
+                     "MCP_INTERFACE: %u request traces written to %s",
+                     (unsigned int)(log->NextSeq - first_seq), filename);
+
+    return CFE_SUCCESS;
+
+} /* End MCP_INTERFACE_DumpTrace */
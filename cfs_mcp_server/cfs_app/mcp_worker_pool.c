@@ -0,0 +1,234 @@
+/*
+** MCP Interface Worker Pool
+**
+** Requests whose handlers block on the file system are executed by a
+** small pool of child tasks, so a slow device holds up neither the
+** socket task nor the data mutex. The socket task admits such a
+** request, copies it into a free job and posts the job on the
+** submission ring. A worker runs the handler into the job's own
+** response frame, posts the job on the completion ring and wakes the
+** socket task, which sends the response through the client's output
+** queue and frees the job.
+**
+** Neither ring needs a lock: each job is on at most one ring at a time
+** and each ring has a slot per job, so neither can overflow, and
+** positions are claimed with atomic increments.
+*/
+
+/*
+** Include Files
+*/
+#include "mcp_interface_app.h"
+#include <stdio.h>
+
+/*
+** Create the worker tasks and the semaphore they wait on
+*/
+int32 MCP_INTERFACE_StartWorkers(void)
+{
+    MCP_INTERFACE_WorkerPool_t *pool = &MCP_INTERFACE_AppData.WorkerPool;
+    char name[OS_MAX_API_NAME];
+    int32 status;
+    uint32 i;
+
+    pool->FreeCount = MCP_WORKER_JOB_COUNT;
+    for (i = 0; i < MCP_WORKER_JOB_COUNT; i++)
+    {
+        pool->FreeJobs[i] = (uint8)i;
+        pool->Completed[i] = 0;
+    }
+    pool->SubmitHead = 0;
+    pool->SubmitTail = 0;
+    pool->CompleteHead = 0;
+    pool->CompleteTail = 0;
+
+    status = OS_CountSemCreate(&pool->SemId, MCP_WORKER_SEM_NAME, 0, 0);
+    if (status != OS_SUCCESS)
+    {
+        CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to create worker semaphore, RC = 0x%08X\n",
+                           status);
+        return (status);
+    }
+
+    for (i = 0; i < MCP_WORKER_COUNT; i++)
+    {
+        snprintf(name, sizeof(name), "%s_%u", MCP_WORKER_TASK_NAME, (unsigned int)i);
+
+        status = CFE_ES_CreateChildTask(&pool->TaskIds[i],
+                                        name,
+                                        MCP_INTERFACE_WorkerTask,
+                                        NULL,
+                                        MCP_WORKER_TASK_STACK_SIZE,
+                                        MCP_WORKER_TASK_PRIORITY,
+                                        0);
+        if (status != CFE_SUCCESS)
+        {
+            CFE_ES_WriteToSysLog("MCP_INTERFACE: Failed to create worker task %u, RC = 0x%08X\n",
+                               (unsigned int)i, status);
+            return (status);
+        }
+    }
+
+    return (CFE_SUCCESS);
+
+} /* End MCP_INTERFACE_StartWorkers */
+
+/*
+** Worker child task
+**
+** Runs submitted jobs until the app stops. The timed wait bounds how
+** long shutdown takes to be noticed.
+*/
+void MCP_INTERFACE_WorkerTask(void)
+{
+    MCP_INTERFACE_WorkerPool_t *pool = &MCP_INTERFACE_AppData.WorkerPool;
+    MCP_INTERFACE_WorkerJob_t *job;
+    uint32 pos;
+    uint8 index;
+    char wake = 0;
+
+    if (CFE_ES_RegisterChildTask() != CFE_SUCCESS)
+    {
+        CFE_ES_ExitChildTask();
+        return;
+    }
+
+    while (MCP_INTERFACE_AppData.RunStatus == CFE_ES_APP_RUN)
+    {
+        if (OS_CountSemTimedWait(pool->SemId, MCP_INTERFACE_SOCKET_POLL_TIMEOUT_MS) != OS_SUCCESS)
+        {
+            continue;
+        }
+
+        /* Every semaphore count stands for one posted job */
+        pos = __atomic_fetch_add(&pool->SubmitHead, 1, __ATOMIC_ACQ_REL);
+        index = __atomic_load_n(&pool->Submitted[pos % MCP_WORKER_JOB_COUNT], __ATOMIC_ACQUIRE);
+        job = &pool->Jobs[index];
+
+        MCP_INTERFACE_RecordLatency(MCP_INTERFACE_AppData.Metrics.QueueLatency,
+                                    MCP_INTERFACE_MetricsNowUs() -
+                                    job->Request.stage_us[MCP_TRACE_PARSED]);
+        job->Result = MCP_INTERFACE_ExecuteRequest(&job->Request, &job->Response);
+        MCP_INTERFACE_EndJSONResponse(&job->Response);
+        job->Request.stage_us[MCP_TRACE_FORMATTED] = MCP_INTERFACE_MetricsNowUs();
+
+        pos = __atomic_fetch_add(&pool->CompleteTail, 1, __ATOMIC_ACQ_REL);
+        __atomic_store_n(&pool->Completed[pos % MCP_WORKER_JOB_COUNT], (uint8)(index + 1),
+                         __ATOMIC_RELEASE);
+
+        /* A full pipe already holds a wakeup */
+        (void)write(MCP_INTERFACE_AppData.WakePipe[1], &wake, 1);
+    }
+
+    CFE_ES_ExitChildTask();
+
+} /* End MCP_INTERFACE_WorkerTask */
+
+/*
+** Hand an I/O bound request to the worker pool
+**
+** Runs on the socket task. The request is admitted here, under the data
+** mutex, so a worker only ever executes the handler; a rejected request
+** is answered at once. Returns FALSE, leaving the request untouched,
+** when every job is busy.
+*/
+boolean MCP_INTERFACE_SubmitRequest(int32 client_slot, const MCP_Request_t *request)
+{
+    MCP_INTERFACE_WorkerPool_t *pool = &MCP_INTERFACE_AppData.WorkerPool;
+    MCP_INTERFACE_WorkerJob_t *job;
+    uint8 index;
+    boolean admitted;
+
+    if (pool->FreeCount == 0)
+    {
+        return FALSE;
+    }
+
+    index = pool->FreeJobs[--pool->FreeCount];
+    job = &pool->Jobs[index];
+    job->ClientSlot = client_slot;
+    job->Generation = MCP_INTERFACE_AppData.Clients[client_slot].Generation;
+    job->Request = *request;
+
+    MCP_INTERFACE_InitResponseWriter(&job->Json, job->Frame, client_slot);
+    MCP_INTERFACE_BeginJSONResponse(&job->Response, &job->Json, request->id);
+
+    OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+    admitted = MCP_INTERFACE_AdmitRequest(&job->Request, &job->Response);
+    if (!admitted)
+    {
+        MCP_INTERFACE_EndJSONResponse(&job->Response);
+        job->Request.stage_us[MCP_TRACE_FORMATTED] = MCP_INTERFACE_MetricsNowUs();
+        MCP_INTERFACE_SendMCPResponse(client_slot, &job->Json);
+        MCP_INTERFACE_RecordTrace(&job->Request, &job->Response);
+    }
+    OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+
+    if (!admitted)
+    {
+        pool->FreeJobs[pool->FreeCount++] = index;
+        return TRUE;
+    }
+
+    /* The params point into the client's receive buffer, which moves on */
+    memcpy(job->Params, request->params, request->params_len);
+    job->Params[request->params_len] = '\0';
+    job->Request.params = job->Params;
+
+    __atomic_store_n(&pool->Submitted[pool->SubmitTail % MCP_WORKER_JOB_COUNT], index,
+                     __ATOMIC_RELEASE);
+    pool->SubmitTail++;
+    OS_CountSemGive(pool->SemId);
+
+    return TRUE;
+
+} /* End MCP_INTERFACE_SubmitRequest */
+
+/*
+** Send the responses of completed jobs and free the jobs
+**
+** Runs on the socket task after every wakeup. Completions are taken in
+** ring order, so one still being posted holds back the ones after it
+** until its worker's wakeup arrives.
+*/
+void MCP_INTERFACE_CollectCompletions(void)
+{
+    MCP_INTERFACE_WorkerPool_t *pool = &MCP_INTERFACE_AppData.WorkerPool;
+    MCP_INTERFACE_WorkerJob_t *job;
+    MCP_INTERFACE_Client_t *client;
+    uint8 *slot;
+    uint8 entry;
+
+    for (;;)
+    {
+        slot = &pool->Completed[pool->CompleteHead % MCP_WORKER_JOB_COUNT];
+        entry = __atomic_load_n(slot, __ATOMIC_ACQUIRE);
+        if (entry == 0)
+        {
+            break;
+        }
+
+        *slot = 0;
+        pool->CompleteHead++;
+        job = &pool->Jobs[entry - 1];
+
+        /* Nobody is left to answer if the client went away meanwhile */
+        client = &MCP_INTERFACE_AppData.Clients[job->ClientSlot];
+        if (client->Socket >= 0 && client->Generation == job->Generation)
+        {
+            MCP_INTERFACE_SendResponseStream(job->ClientSlot, &job->Response);
+        }
+        else if (job->Response.stream_fd >= 0)
+        {
+            close(job->Response.stream_fd);
+        }
+
+        OS_MutSemTake(MCP_INTERFACE_AppData.DataMutex);
+        MCP_INTERFACE_CountResult(&job->Request, job->Result, &job->Response);
+        MCP_INTERFACE_RecordTrace(&job->Request, &job->Response);
+        OS_MutSemGive(MCP_INTERFACE_AppData.DataMutex);
+
+        pool->FreeJobs[pool->FreeCount++] = (uint8)(entry - 1);
+    }
+
+} /* End MCP_INTERFACE_CollectCompletions */
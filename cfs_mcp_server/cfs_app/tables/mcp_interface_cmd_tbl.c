@@ -0,0 +1,98 @@
+/*
+** MCP Interface Command Dictionary Table
+**
+** Default contents of the command dictionary, mirroring the
+** cfs_applications section of config/cfs_config.json. Load a new
+** table image to add or change commands. Payload lengths follow the
+** argument structures of the target apps: an app name is
+** OS_MAX_API_NAME (20) bytes and a path OS_MAX_PATH_LEN (64) bytes.
+** Each app gets its own bucket in every rate class: three critical
+** commands may go at once, then one more every 5 seconds.
+*/
+
+/*
+** Include Files
+*/
+#include "cfe.h"
+#include "cfe_tbl_filedef.h"
+#include "mcp_interface_app.h"
+
+/*
+** Table contents
+*/
+MCP_INTERFACE_CmdTbl_t MCP_INTERFACE_CmdTbl =
+{
+    /*
+    ** Commands: AppName, CommandName, MsgId, CommandCode, Flags, PayloadLength
+    */
+    {
+        /* Executive Services */
+        { "CFE_ES", "NOOP", 0x1806, 0, 0, 0 },
+        { "CFE_ES", "RESET_COUNTERS", 0x1806, 1, 0, 0 },
+        { "CFE_ES", "RESTART_APP", 0x1806, 4, MCP_CMD_FLAG_CRITICAL, 20 },
+        { "CFE_ES", "STOP_APP", 0x1806, 5, MCP_CMD_FLAG_CRITICAL, 20 },
+
+        /* Event Services */
+        { "CFE_EVS", "NOOP", 0x1801, 0, 0, 0 },
+        { "CFE_EVS", "RESET_COUNTERS", 0x1801, 1, 0, 0 },
+
+        /* File Manager */
+        { "FM", "NOOP", 0x188C, 0, 0, 0 },
+        { "FM", "GET_DIR_LIST", 0x188C, 1, 0, 132 },
+        { "FM", "COPY_FILE", 0x188C, 3, MCP_CMD_FLAG_CRITICAL, 130 },
+        { "FM", "DELETE_FILE", 0x188C, 4, MCP_CMD_FLAG_CRITICAL, 64 },
+
+        /* Housekeeping */
+        { "HK", "NOOP", 0x189A, 0, 0, 0 },
+        { "HK", "RESET_COUNTERS", 0x189A, 1, 0, 0 },
+
+        /* MCP Interface Application */
+        { "MCP_INTERFACE", "NOOP", 0x1882, 0, 0, 0 },
+        { "MCP_INTERFACE", "RESET_COUNTERS", 0x1882, 1, 0, 0 },
+        { "MCP_INTERFACE", "ENABLE_DEBUG", 0x1882, 2, 0, 0 },
+        { "MCP_INTERFACE", "DISABLE_DEBUG", 0x1882, 3, 0, 0 },
+
+        /* Attitude Determination and Control System */
+        { "ADCS_APP", "NOOP", 0x1890, 0, 0, 0 },
+        { "ADCS_APP", "SET_ATTITUDE_MODE", 0x1890, 1, MCP_CMD_FLAG_CRITICAL, 0 },
+        { "ADCS_APP", "GET_ATTITUDE_DATA", 0x1890, 2, 0, 0 },
+        { "ADCS_APP", "CALIBRATE_SENSORS", 0x1890, 3, MCP_CMD_FLAG_CRITICAL, 0 },
+        { "ADCS_APP", "SAFE_MODE", 0x1890, 4, MCP_CMD_FLAG_CRITICAL, 0 },
+
+        /* Reaction Wheel Assembly */
+        { "RWA_APP", "NOOP", 0x1891, 0, 0, 0 },
+        { "RWA_APP", "SET_WHEEL_SPEED", 0x1891, 1, MCP_CMD_FLAG_CRITICAL, 0 },
+        { "RWA_APP", "GET_WHEEL_STATUS", 0x1891, 2, 0, 0 },
+        { "RWA_APP", "WHEEL_DESPIN", 0x1891, 3, MCP_CMD_FLAG_CRITICAL, 0 },
+
+        /* Thruster Control System */
+        { "THRUSTER_APP", "NOOP", 0x1892, 0, 0, 0 },
+        { "THRUSTER_APP", "FIRE_THRUSTERS", 0x1892, 1, MCP_CMD_FLAG_CRITICAL | MCP_CMD_FLAG_CLASS(2), 0 },
+        { "THRUSTER_APP", "GET_THRUSTER_STATUS", 0x1892, 2, 0, 0 },
+        { "THRUSTER_APP", "THRUSTER_TEST", 0x1892, 3, MCP_CMD_FLAG_CRITICAL | MCP_CMD_FLAG_CLASS(2), 0 },
+    },
+
+    /*
+    ** Housekeeping telemetry to cache: AppName, MsgId, Spare
+    */
+    {
+        { "CFE_ES", 0x0800, 0 },
+        { "CFE_EVS", 0x0801, 0 },
+        { "FM", 0x088A, 0 },
+        { "HK", 0x089B, 0 },
+        { "ADCS_APP", 0x0890, 0 },
+        { "RWA_APP", 0x0891, 0 },
+        { "THRUSTER_APP", 0x0892, 0 },
+    },
+
+    /*
+    ** Rate classes: Burst, RefillMs, MaxWaitMs, Spare
+    */
+    {
+        { 0, 0, 0, 0 },                 /* 0: routine commands, not limited */
+        { 3, 5000, 10000, 0 },          /* 1: critical commands */
+        { 1, 10000, 10000, 0 },         /* 2: propulsion */
+    }
+};
+
+CFE_TBL_FILEDEF(MCP_INTERFACE_CmdTbl, MCP_INTERFACE.CmdTbl, MCP Command Dictionary, mcp_cmd_tbl.tbl)
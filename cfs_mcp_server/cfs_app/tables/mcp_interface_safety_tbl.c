@@ -0,0 +1,54 @@
+/*
+** MCP Interface Safety Rule Table
+**
+** Default safety rules. Command, path and action patterns match
+** anywhere in their field; app patterns match the whole app name.
+** All matching ignores case.
+*/
+
+/*
+** Include Files
+*/
+#include "cfe.h"
+#include "cfe_tbl_filedef.h"
+#include "mcp_interface_app.h"
+
+/*
+** Table contents: Pattern, Kind, Spare
+*/
+MCP_INTERFACE_SafetyTbl_t MCP_INTERFACE_SafetyTbl =
+{
+    {
+        /* Commands that require confirmation */
+        { "RESET", MCP_SAFETY_RULE_COMMAND, { 0 } },
+        { "RESTART", MCP_SAFETY_RULE_COMMAND, { 0 } },
+        { "STOP", MCP_SAFETY_RULE_COMMAND, { 0 } },
+        { "START", MCP_SAFETY_RULE_COMMAND, { 0 } },
+        { "DELETE", MCP_SAFETY_RULE_COMMAND, { 0 } },
+        { "FORMAT", MCP_SAFETY_RULE_COMMAND, { 0 } },
+        { "POWER_OFF", MCP_SAFETY_RULE_COMMAND, { 0 } },
+        { "REBOOT", MCP_SAFETY_RULE_COMMAND, { 0 } },
+
+        /* Apps critical to system operation */
+        { "CFE_ES", MCP_SAFETY_RULE_APP, { 0 } },
+        { "CFE_EVS", MCP_SAFETY_RULE_APP, { 0 } },
+        { "CFE_SB", MCP_SAFETY_RULE_APP, { 0 } },
+        { "CFE_TIME", MCP_SAFETY_RULE_APP, { 0 } },
+        { "CFE_TBL", MCP_SAFETY_RULE_APP, { 0 } },
+        { "SCH_LAB", MCP_SAFETY_RULE_APP, { 0 } },
+
+        /* System directories closed to file operations */
+        { "/boot", MCP_SAFETY_RULE_PATH, { 0 } },
+        { "/etc", MCP_SAFETY_RULE_PATH, { 0 } },
+        { "/sys", MCP_SAFETY_RULE_PATH, { 0 } },
+        { "/proc", MCP_SAFETY_RULE_PATH, { 0 } },
+        { "/dev", MCP_SAFETY_RULE_PATH, { 0 } },
+
+        /* App management actions that require confirmation */
+        { "start", MCP_SAFETY_RULE_ACTION, { 0 } },
+        { "stop", MCP_SAFETY_RULE_ACTION, { 0 } },
+        { "restart", MCP_SAFETY_RULE_ACTION, { 0 } },
+    }
+};
+
+CFE_TBL_FILEDEF(MCP_INTERFACE_SafetyTbl, MCP_INTERFACE.SafetyTbl, MCP Safety Rules, mcp_safety_tbl.tbl)
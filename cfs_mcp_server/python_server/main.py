@@ -10,11 +10,13 @@ Designed for onboard spacecraft deployment with astronaut interaction.
 """
 
 import asyncio
+import base64
 import json
-import socket
 import os
 import sys
 import logging
+import mmap
+import struct
 from typing import Dict, Any, Optional, List
 import time
 
@@ -35,12 +37,101 @@ logging.basicConfig(
 )
 logger = logging.getLogger(__name__)
 
+class TelemetryRegion:
+    """
+    Reader of the shared memory region the cFS app publishes telemetry
+    into when built with MCP_TLM_SHM_NAME.
+    
+    Each record is guarded by a count that is odd while the app writes
+    it; a copy is only used when the count is even and unchanged across
+    it. Reading costs no request and no system call once mapped; the
+    region is checked for having been replaced by a restarted app at
+    most once per CHECK_INTERVAL seconds.
+    """
+    
+    MAGIC = 0x4D435054
+    VERSION = 1
+    HEADER = struct.Struct('=8I')
+    RECORD = struct.Struct('=I20sHHHHIIII')
+    RETRIES = 100
+    CHECK_INTERVAL = 1.0
+    
+    def __init__(self, name: str):
+        self._path = os.path.join('/dev/shm', name.lstrip('/'))
+        with open(self._path, 'rb') as f:
+            self._inode = os.fstat(f.fileno()).st_ino
+            self._map = mmap.mmap(f.fileno(), 0, prot=mmap.PROT_READ)
+        self._checked = time.monotonic()
+        (magic, version, size, self._offset, self._stride, self._count,
+         self._packet_size, _) = self.HEADER.unpack_from(self._map, 0)
+        if magic != self.MAGIC or version != self.VERSION or size > len(self._map):
+            self._map.close()
+            raise ValueError(f"{name} is not a telemetry region")
+    
+    def close(self):
+        self._map.close()
+    
+    def replaced(self) -> bool:
+        """Whether the app has since created a new region under the name"""
+        now = time.monotonic()
+        if now - self._checked < self.CHECK_INTERVAL:
+            return False
+        self._checked = now
+        try:
+            return os.stat(self._path).st_ino != self._inode
+        except OSError:
+            return True
+    
+    def read(self, app_name: str) -> Optional[Dict[str, Any]]:
+        """Latest packet of an app, or None if the region does not list it"""
+        for index in range(self._count):
+            record = self._read_record(index)
+            if record is not None and record['app_name'] == app_name and record['msg_id'] != 0:
+                return record
+        return None
+    
+    def _read_record(self, index: int) -> Optional[Dict[str, Any]]:
+        start = self._offset + index * self._stride
+        for _ in range(self.RETRIES):
+            seq = struct.unpack_from('=I', self._map, start)[0]
+            if seq & 1:
+                continue
+            data = self._map[start:start + self.RECORD.size + self._packet_size]
+            if struct.unpack_from('=I', self._map, start)[0] != seq:
+                continue
+            (_, name, msg_id, length, total_length, _, count, _,
+             seconds, _) = self.RECORD.unpack_from(data, 0)
+            packet = data[self.RECORD.size:self.RECORD.size + length]
+            return {
+                'app_name': name.split(b'\0', 1)[0].decode(),
+                'msg_id': msg_id,
+                'received': seconds,
+                'packet_count': count,
+                'length': total_length,
+                'truncated': length < total_length,
+                'packet': packet.hex()
+            }
+        return None
+
 class CFSMCPServer:
     """MCP Server for cFS Interface"""
     
-    def __init__(self, socket_path: str = "/tmp/cfs_mcp.sock"):
+    REQUEST_TIMEOUT = 5.0       # seconds to wait for a response
+    MAX_FRAME_SIZE = 64 * 1024  # bytes buffered for one response line
+    
+    def __init__(self, socket_path: str = "/tmp/cfs_mcp.sock", tlm_shm_name: str = ""):
         self.socket_path = socket_path
-        self.cfs_socket: Optional[socket.socket] = None
+        self.tlm_shm_name = tlm_shm_name
+        self._tlm_region: Optional[TelemetryRegion] = None
+        self._reader: Optional[asyncio.StreamReader] = None
+        self._writer: Optional[asyncio.StreamWriter] = None
+        self._reader_task: Optional[asyncio.Task] = None
+        self._pending: Dict[int, asyncio.Future] = {}
+        self._subscribed_apps: List[str] = []
+        self._pushed_telemetry: Dict[str, Dict[str, Any]] = {}
+        self._sequence_progress: Dict[int, List[Dict[str, Any]]] = {}
+        self._event_seq = 0
+        self._trace_seq = 0
         self.request_id = 1
         self.server = McpServer("cfs-mcp-server")
         
@@ -56,7 +147,8 @@ class CFSMCPServer:
             command: str,
             params: str = "",
             require_confirmation: bool = False,
-            is_critical: bool = False
+            is_critical: bool = False,
+            prepare: bool = False
         ) -> List[TextContentType]:
             """
             Send a command to a cFS application.
@@ -67,6 +159,8 @@ class CFSMCPServer:
                 params: Command parameters as JSON string (optional)
                 require_confirmation: Whether this command requires astronaut confirmation
                 is_critical: Whether this is a critical command that affects safety
+                prepare: Check and build the command without sending it; the
+                    result carries a token for cfs_confirm_command
             
             Returns:
                 Command execution result
@@ -79,12 +173,13 @@ class CFSMCPServer:
                     "command": command,
                     "params": params,
                     "require_confirmation": require_confirmation,
-                    "is_critical": is_critical
+                    "is_critical": is_critical,
+                    "prepare": prepare
                 })
                 
                 return [TextContent(
                     type="text",
-                    text=f"Command sent successfully:\n{json.dumps(result, indent=2)}"
+                    text=f"Command {'prepared' if prepare else 'sent'} successfully:\n{json.dumps(result, indent=2)}"
                 )]
                 
             except Exception as e:
@@ -94,6 +189,42 @@ class CFSMCPServer:
                     text=f"Error sending command: {str(e)}"
                 )]
         
+        @self.server.tool("cfs_confirm_command")
+        async def confirm_command(token: str) -> List[TextContentType]:
+            """
+            Send a command prepared with cfs_send_command(prepare=True).
+            
+            The command was checked and built when it was prepared, so it
+            goes out as soon as the token arrives. A token works once and
+            expires after 30 seconds.
+            
+            Args:
+                token: Token returned when the command was prepared
+            
+            Returns:
+                Command execution result
+            """
+            try:
+                result = await self._send_cfs_request({
+                    "id": self._get_request_id(),
+                    "type": 15,  # MCP_CMD_CONFIRM
+                    "app_name": "",
+                    "command": "",
+                    "params": token
+                })
+                
+                return [TextContent(
+                    type="text",
+                    text=f"Command confirmed:\n{json.dumps(result, indent=2)}"
+                )]
+                
+            except Exception as e:
+                logger.error(f"Error confirming command: {e}")
+                return [TextContent(
+                    type="text",
+                    text=f"Error confirming command: {str(e)}"
+                )]
+        
         @self.server.tool("cfs_get_telemetry")
         async def get_telemetry(
             app_name: str = "MCP_INTERFACE"
@@ -107,6 +238,20 @@ class CFSMCPServer:
             Returns:
                 Telemetry data in JSON format
             """
+            pushed = self._pushed_telemetry.get(app_name)
+            if pushed is not None:
+                return [TextContent(
+                    type="text",
+                    text=f"Telemetry data:\n{json.dumps(pushed, indent=2)}"
+                )]
+            
+            shared = self._read_shared_telemetry(app_name)
+            if shared is not None:
+                return [TextContent(
+                    type="text",
+                    text=f"Telemetry data:\n{json.dumps(shared, indent=2)}"
+                )]
+            
             try:
                 result = await self._send_cfs_request({
                     "id": self._get_request_id(),
@@ -129,21 +274,38 @@ class CFSMCPServer:
                 )]
         
         @self.server.tool("cfs_get_system_status")
-        async def get_system_status() -> List[TextContentType]:
+        async def get_system_status(include_apps: bool = False) -> List[TextContentType]:
             """
             Get overall cFS system status and health information.
             
+            Args:
+                include_apps: Also list every registered application with
+                    its state, tasks and execution rate
+            
             Returns:
-                System status including memory usage, active tasks, and application states
+                System status including heap usage, task counts and, with
+                include_apps, the state of every application
             """
             try:
-                result = await self._send_cfs_request({
+                request: Dict[str, Any] = {
                     "id": self._get_request_id(),
                     "type": 2,  # MCP_CMD_GET_SYSTEM_STATUS
                     "app_name": "",
                     "command": "",
-                    "params": ""
-                })
+                    "params": json.dumps({"apps": True}) if include_apps else ""
+                }
+                result = await self._send_cfs_request(request)
+                
+                # The app list is paged to fit a response; gather the rest
+                status = result.get('system_status', {})
+                page = status
+                while include_apps and page.get('more'):
+                    request["id"] = self._get_request_id()
+                    request["params"] = json.dumps({"apps": True, "start": page['next_app_id']})
+                    page = (await self._send_cfs_request(request)).get('system_status', {})
+                    status['apps'].extend(page.get('apps', []))
+                status.pop('next_app_id', None)
+                status.pop('more', None)
                 
                 return [TextContent(
                     type="text",
@@ -198,24 +360,43 @@ class CFSMCPServer:
         
         @self.server.tool("cfs_list_files")
         async def list_files(
-            directory: str = "/cf"
+            directory: str = "/cf",
+            cursor: int = 0,
+            limit: int = 0,
+            entry_type: str = "",
+            glob: str = "",
+            details: bool = True
         ) -> List[TextContentType]:
             """
-            List files in a cFS filesystem directory.
+            List one page of a cFS filesystem directory.
             
             Args:
                 directory: Directory path to list (default: /cf)
+                cursor: Position to start at, the next_cursor of the previous page
+                limit: Maximum entries in the page (0 for the most that fit)
+                entry_type: "file" or "directory" to list only that type
+                glob: Shell pattern the names must match, e.g. "*.tbl"
+                details: Include size and modification time of each entry
             
             Returns:
-                List of files and directories with their properties
+                Files and directories with their properties, next_cursor
+                and an eof flag
             """
             try:
+                params = {"path": directory, "cursor": cursor, "details": details}
+                if limit > 0:
+                    params["limit"] = limit
+                if entry_type:
+                    params["type"] = entry_type
+                if glob:
+                    params["glob"] = glob
+                
                 result = await self._send_cfs_request({
                     "id": self._get_request_id(),
                     "type": 4,  # MCP_CMD_GET_FILE_LIST
                     "app_name": "",
                     "command": "",
-                    "params": f'"{directory}"'
+                    "params": json.dumps(params)
                 })
                 
                 return [TextContent(
@@ -232,26 +413,42 @@ class CFSMCPServer:
         
         @self.server.tool("cfs_read_file")
         async def read_file(
-            file_path: str
+            file_path: str,
+            offset: int = 0,
+            length: int = 0,
+            encoding: str = "text"
         ) -> List[TextContentType]:
             """
-            Read contents of a file from the cFS filesystem.
+            Read one chunk of a file from the cFS filesystem.
             
             Args:
                 file_path: Full path to the file to read
+                offset: Byte offset to start reading at
+                length: Bytes to read (0 for the largest chunk allowed)
+                encoding: "text" (up to 512 bytes), "base64" (up to 2 KB)
+                    or "raw" (up to 16 MB, returned base64 encoded)
             
             Returns:
-                File contents (limited size for safety)
+                The chunk with its offset and length, the file size and an
+                eof flag; continue at offset + length until eof is true
             """
             try:
+                params = {"path": file_path, "offset": offset, "encoding": encoding}
+                if length > 0:
+                    params["length"] = length
+                
                 result = await self._send_cfs_request({
                     "id": self._get_request_id(),
                     "type": 5,  # MCP_CMD_READ_FILE
                     "app_name": "",
                     "command": "",
-                    "params": f'"{file_path}"'
+                    "params": json.dumps(params)
                 })
                 
+                data = result.pop('data', None)
+                if data is not None:
+                    result['content'] = base64.b64encode(data).decode('ascii')
+                
                 return [TextContent(
                     type="text",
                     text=f"File contents:\n{json.dumps(result, indent=2)}"
@@ -265,21 +462,46 @@ class CFSMCPServer:
                 )]
         
         @self.server.tool("cfs_get_event_log")
-        async def get_event_log() -> List[TextContentType]:
+        async def get_event_log(
+            since_seq: Optional[int] = None,
+            max_events: int = 0,
+            severity: str = "",
+            app_name: str = ""
+        ) -> List[TextContentType]:
             """
-            Get recent events from the cFS Event Services log.
+            Get cFS Event Services events recorded since the last call.
+            
+            Args:
+                since_seq: Return events after this sequence number instead
+                    of after the last one already fetched (0 for all)
+                max_events: Maximum events to return (0 for the default)
+                severity: Least severe type to return: DEBUG, INFO,
+                    ERROR or CRITICAL
+                app_name: Only return events from this app
             
             Returns:
-                Recent system events and messages
+                Events oldest first, with next_seq, lost (events overwritten
+                before they were fetched) and more (further events waiting)
             """
             try:
+                params: Dict[str, Any] = {
+                    "since_seq": self._event_seq if since_seq is None else since_seq
+                }
+                if max_events > 0:
+                    params["max"] = max_events
+                if severity:
+                    params["severity"] = severity
+                if app_name:
+                    params["app"] = app_name
+                
                 result = await self._send_cfs_request({
                     "id": self._get_request_id(),
                     "type": 7,  # MCP_CMD_GET_EVENT_LOG
                     "app_name": "",
                     "command": "",
-                    "params": ""
+                    "params": json.dumps(params)
                 })
+                self._event_seq = result.get('next_seq', self._event_seq)
                 
                 return [TextContent(
                     type="text",
@@ -293,6 +515,87 @@ class CFSMCPServer:
                     text=f"Error getting event log: {str(e)}"
                 )]
         
+        @self.server.tool("cfs_get_metrics")
+        async def get_metrics() -> List[TextContentType]:
+            """
+            Get the MCP interface's own request metrics.
+            
+            Returns:
+                Request and error counts per request type, queueing and
+                execution latency histograms with p50/p99/p999, bytes in
+                and out, parse and format time, rejected connections and
+                safety blocks
+            """
+            try:
+                result = await self._send_cfs_request({
+                    "id": self._get_request_id(),
+                    "type": 12,  # MCP_CMD_GET_METRICS
+                    "app_name": "",
+                    "command": "",
+                    "params": ""
+                })
+                
+                return [TextContent(
+                    type="text",
+                    text=f"MCP interface metrics:\n{json.dumps(result, indent=2)}"
+                )]
+                
+            except Exception as e:
+                logger.error(f"Error getting metrics: {e}")
+                return [TextContent(
+                    type="text",
+                    text=f"Error getting metrics: {str(e)}"
+                )]
+        
+        @self.server.tool("cfs_get_trace")
+        async def get_trace(
+            since_seq: Optional[int] = None,
+            max_traces: int = 0
+        ) -> List[TextContentType]:
+            """
+            Get the per-stage timing of recent MCP requests.
+            
+            By default only requests traced since the previous call are
+            returned.
+            
+            Args:
+                since_seq: Return traces after this sequence number instead
+                    of after the last one already fetched (0 for all)
+                max_traces: Maximum traces to return (0 for the default)
+            
+            Returns:
+                Traces oldest first, each with the time in microseconds at
+                which its request reached every stage (0 if it never did),
+                with next_seq, lost and more as for the event log
+            """
+            try:
+                params: Dict[str, Any] = {
+                    "since_seq": self._trace_seq if since_seq is None else since_seq
+                }
+                if max_traces > 0:
+                    params["max"] = max_traces
+                
+                result = await self._send_cfs_request({
+                    "id": self._get_request_id(),
+                    "type": 13,  # MCP_CMD_GET_TRACE
+                    "app_name": "",
+                    "command": "",
+                    "params": json.dumps(params)
+                })
+                self._trace_seq = result.get('next_seq', self._trace_seq)
+                
+                return [TextContent(
+                    type="text",
+                    text=f"Request trace:\n{json.dumps(result, indent=2)}"
+                )]
+                
+            except Exception as e:
+                logger.error(f"Error getting request trace: {e}")
+                return [TextContent(
+                    type="text",
+                    text=f"Error getting request trace: {str(e)}"
+                )]
+        
         @self.server.tool("cfs_emergency_stop")
         async def emergency_stop(
             confirmation: str = ""
@@ -336,6 +639,186 @@ class CFSMCPServer:
                     type="text",
                     text=f"Error executing emergency stop: {str(e)}"
                 )]
+        
+        @self.server.tool("cfs_batch")
+        async def batch(
+            requests: List[Dict[str, Any]]
+        ) -> List[TextContentType]:
+            """
+            Execute several cFS requests in one round trip.
+            
+            Each element is checked by the cFS safety system exactly as if
+            it were sent on its own.
+            
+            Args:
+                requests: Up to 16 request objects, each with "type" and the
+                    fields that type needs ("app_name", "command", "params",
+                    "require_confirmation", "is_critical")
+            
+            Returns:
+                One result per request, each with its own status
+            """
+            try:
+                items = []
+                for index, item in enumerate(requests, start=1):
+                    items.append({"id": index, **item})
+                
+                result = await self._send_cfs_request({
+                    "id": self._get_request_id(),
+                    "type": 9,  # MCP_CMD_BATCH
+                    "app_name": "",
+                    "command": "",
+                    "params": "",
+                    "requests": items
+                })
+                
+                return [TextContent(
+                    type="text",
+                    text=f"Batch results:\n{json.dumps(result, indent=2)}"
+                )]
+                
+            except Exception as e:
+                logger.error(f"Error executing batch: {e}")
+                return [TextContent(
+                    type="text",
+                    text=f"Error executing batch: {str(e)}"
+                )]
+        
+        @self.server.tool("cfs_run_sequence")
+        async def run_sequence(
+            steps: Optional[List[Dict[str, Any]]] = None,
+            cancel: int = 0,
+            require_confirmation: bool = False,
+            is_critical: bool = False
+        ) -> List[TextContentType]:
+            """
+            Run a command sequence on board, or cancel a running one.
+            
+            Steps go out from cFS itself at their time tags, so a procedure
+            does not wait on a round trip per command. Follow the sequence
+            with cfs_get_sequence_progress.
+            
+            Args:
+                steps: Up to 16 steps, each {"app", "command", "payload"
+                    (hex, optional), "delay_ms" (after the previous step) or
+                    "at" (CFE seconds), "when" (optional condition on the
+                    app's housekeeping packet: {"app", "offset", "size" 1/2/4,
+                    "op" <,<=,==,!=,>=,>, "value", "timeout_ms"})}
+                cancel: ID of a running sequence to abort instead
+                require_confirmation: Confirms every critical step
+                is_critical: Marks every step as critical
+            
+            Returns:
+                The sequence ID and step count, or the cancelled sequence
+            """
+            try:
+                params = {"cancel": cancel} if cancel else {"steps": steps or []}
+                
+                result = await self._send_cfs_request({
+                    "id": self._get_request_id(),
+                    "type": 14,  # MCP_CMD_RUN_SEQUENCE
+                    "app_name": "",
+                    "command": "",
+                    "params": json.dumps(params),
+                    "require_confirmation": require_confirmation,
+                    "is_critical": is_critical
+                })
+                
+                return [TextContent(
+                    type="text",
+                    text=f"Sequence:\n{json.dumps(result, indent=2)}"
+                )]
+                
+            except Exception as e:
+                logger.error(f"Error running sequence: {e}")
+                return [TextContent(
+                    type="text",
+                    text=f"Error running sequence: {str(e)}"
+                )]
+        
+        @self.server.tool("cfs_get_sequence_progress")
+        async def get_sequence_progress(
+            sequence_id: int
+        ) -> List[TextContentType]:
+            """
+            Get the progress pushed so far by a sequence started with
+            cfs_run_sequence.
+            
+            Args:
+                sequence_id: ID returned when the sequence was started
+            
+            Returns:
+                The state of every step reached so far, ending with
+                "completed" or "aborted" once the sequence is over
+            """
+            progress = self._sequence_progress.get(sequence_id, [])
+            if progress and progress[-1].get('state') in ('completed', 'aborted'):
+                self._sequence_progress.pop(sequence_id, None)
+            
+            return [TextContent(
+                type="text",
+                text=f"Sequence {sequence_id} progress:\n{json.dumps(progress, indent=2)}"
+            )]
+        
+        @self.server.tool("cfs_subscribe_telemetry")
+        async def subscribe_telemetry(
+            apps: List[str],
+            max_hz: int = 0,
+            on_change: bool = False
+        ) -> List[TextContentType]:
+            """
+            Have cFS push housekeeping telemetry as it arrives.
+            
+            Once subscribed, cfs_get_telemetry answers for these apps from
+            the latest pushed packet without a round trip. Subscribing again
+            replaces the previous subscription; an empty list cancels it.
+            
+            Args:
+                apps: Names of the cFS applications to follow
+                max_hz: Highest push rate per app, at most 50 (0 for every packet)
+                on_change: Only push packets whose contents changed
+            
+            Returns:
+                The subscription now in effect
+            """
+            try:
+                if apps:
+                    request = {
+                        "id": self._get_request_id(),
+                        "type": 10,  # MCP_CMD_SUBSCRIBE
+                        "app_name": "",
+                        "command": "",
+                        "params": json.dumps({
+                            "apps": apps,
+                            "max_hz": max_hz,
+                            "on_change": on_change
+                        })
+                    }
+                else:
+                    request = {
+                        "id": self._get_request_id(),
+                        "type": 11,  # MCP_CMD_UNSUBSCRIBE
+                        "app_name": "",
+                        "command": "",
+                        "params": ""
+                    }
+                
+                result = await self._send_cfs_request(request)
+                if result.get('status') == 0:
+                    self._subscribed_apps = list(apps)
+                    self._pushed_telemetry.clear()
+                
+                return [TextContent(
+                    type="text",
+                    text=f"Telemetry subscription:\n{json.dumps(result, indent=2)}"
+                )]
+                
+            except Exception as e:
+                logger.error(f"Error subscribing to telemetry: {e}")
+                return [TextContent(
+                    type="text",
+                    text=f"Error subscribing to telemetry: {str(e)}"
+                )]
     
     def _get_request_id(self) -> int:
         """Get next request ID"""
@@ -346,17 +829,15 @@ class CFSMCPServer:
     async def _connect_to_cfs(self) -> bool:
         """Connect to cFS MCP Interface Application"""
         try:
-            if self.cfs_socket:
-                self.cfs_socket.close()
-            
-            self.cfs_socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
-            self.cfs_socket.settimeout(5.0)  # 5 second timeout
+            await self._close_cfs()
             
             # Wait for cFS socket to be available
             max_retries = 10
             for attempt in range(max_retries):
                 try:
-                    self.cfs_socket.connect(self.socket_path)
+                    self._reader, self._writer = await asyncio.open_unix_connection(
+                        self.socket_path, limit=self.MAX_FRAME_SIZE)
+                    self._reader_task = asyncio.create_task(self._read_responses())
                     logger.info(f"Connected to cFS at {self.socket_path}")
                     return True
                 except (ConnectionRefusedError, FileNotFoundError):
@@ -373,23 +854,120 @@ class CFSMCPServer:
         
         return False
     
+    async def _close_cfs(self):
+        """Close the cFS connection and fail any requests still in flight"""
+        if self._reader_task:
+            self._reader_task.cancel()
+            self._reader_task = None
+        if self._writer:
+            self._writer.close()
+            self._writer = None
+        self._reader = None
+        self._subscribed_apps = []
+        self._pushed_telemetry.clear()
+        self._fail_pending(Exception("Connection to cFS closed"))
+    
+    def _fail_pending(self, error: Exception):
+        """Complete every outstanding request with an error"""
+        for future in self._pending.values():
+            if not future.done():
+                future.set_exception(error)
+        self._pending.clear()
+    
+    async def _read_responses(self):
+        """Route newline-delimited responses to their requests by id"""
+        try:
+            while True:
+                line = await self._reader.readline()
+                if not line:
+                    raise Exception("No response from cFS")
+                
+                try:
+                    response = json.loads(line.decode('utf-8'))
+                except json.JSONDecodeError as e:
+                    logger.error(f"Invalid JSON response from cFS: {e}")
+                    continue
+                
+                # A raw file chunk follows its response unframed
+                result = response.get('result')
+                if (response.get('status') == 0 and isinstance(result, dict) and
+                        result.get('encoding') == 'raw' and 'file_path' in result):
+                    result['data'] = await self._reader.readexactly(result.get('length', 0))
+                
+                if 'push' in response:
+                    self._store_push(response)
+                    continue
+                
+                future = self._pending.pop(response.get('id'), None)
+                if future is None:
+                    logger.warning(f"Dropping response for unknown request id {response.get('id')}")
+                elif not future.done():
+                    future.set_result(response)
+        except asyncio.CancelledError:
+            raise
+        except Exception as e:
+            logger.error(f"Error communicating with cFS: {e}")
+            self._fail_pending(e)
+            self._subscribed_apps = []
+            self._pushed_telemetry.clear()
+            # Reconnect on next request
+            if self._writer:
+                self._writer.close()
+            self._reader = None
+            self._writer = None
+            self._reader_task = None
+    
+    def _read_shared_telemetry(self, app_name: str) -> Optional[Dict[str, Any]]:
+        """Received telemetry of an app from the shared memory region, if one is configured"""
+        if not self.tlm_shm_name:
+            return None
+        try:
+            if self._tlm_region is not None and self._tlm_region.replaced():
+                self._tlm_region.close()
+                self._tlm_region = None
+            if self._tlm_region is None:
+                self._tlm_region = TelemetryRegion(self.tlm_shm_name)
+            record = self._tlm_region.read(app_name)
+        except (OSError, ValueError) as e:
+            logger.debug(f"Telemetry region unavailable: {e}")
+            self._tlm_region = None
+            return None
+        if record is None or record['packet_count'] == 0:
+            return None
+        record['msg_id'] = f"0x{record['msg_id']:04X}"
+        record['status'] = 'ok'
+        return record
+    
+    def _store_push(self, message: Dict[str, Any]):
+        """Keep the latest pushed telemetry of each subscribed app and sequence progress"""
+        result = message.get('result') or {}
+        app_name = result.get('app_name')
+        if message.get('push') == 'telemetry' and app_name in self._subscribed_apps:
+            self._pushed_telemetry[app_name] = message
+        elif message.get('push') == 'sequence':
+            self._sequence_progress.setdefault(result.get('sequence_id', 0), []).append(result)
+    
     async def _send_cfs_request(self, request: Dict[str, Any]) -> Dict[str, Any]:
-        """Send request to cFS and get response"""
-        if not self.cfs_socket:
+        """
+        Send request to cFS and wait for its response.
+        
+        Requests are pipelined on one connection: any number may be in
+        flight and responses are matched by id in whatever order cFS
+        completes them.
+        """
+        if not self._writer:
             if not await self._connect_to_cfs():
                 raise Exception("Cannot connect to cFS MCP Interface")
         
+        future = asyncio.get_running_loop().create_future()
+        self._pending[request['id']] = future
+        
         try:
-            # Send request
-            request_json = json.dumps(request)
-            self.cfs_socket.send(request_json.encode('utf-8'))
-            
-            # Receive response
-            response_data = self.cfs_socket.recv(4096)
-            if not response_data:
-                raise Exception("No response from cFS")
+            # Send request (newline-delimited JSON framing)
+            self._writer.write((json.dumps(request) + "\n").encode('utf-8'))
+            await self._writer.drain()
             
-            response = json.loads(response_data.decode('utf-8'))
+            response = await asyncio.wait_for(future, timeout=self.REQUEST_TIMEOUT)
             
             if response.get('status', -1) != 0:
                 error_msg = response.get('error', 'Unknown error')
@@ -397,19 +975,11 @@ class CFSMCPServer:
             
             return response.get('result', {})
             
-        except socket.timeout:
+        except asyncio.TimeoutError:
             logger.error("Timeout waiting for cFS response")
             raise Exception("Timeout waiting for cFS response")
-        except json.JSONDecodeError as e:
-            logger.error(f"Invalid JSON response from cFS: {e}")
-            raise Exception("Invalid response from cFS")
-        except Exception as e:
-            logger.error(f"Error communicating with cFS: {e}")
-            # Try to reconnect on next request
-            if self.cfs_socket:
-                self.cfs_socket.close()
-                self.cfs_socket = None
-            raise
+        finally:
+            self._pending.pop(request['id'], None)
     
     async def run(self):
         """Run the MCP server"""
@@ -433,16 +1003,16 @@ class CFSMCPServer:
             logger.error(f"Server error: {e}")
             raise
         finally:
-            if self.cfs_socket:
-                self.cfs_socket.close()
+            await self._close_cfs()
 
 def main():
     """Main entry point"""
     # Get socket path from environment or use default
     socket_path = os.environ.get('CFS_SOCKET_PATH', '/tmp/cfs_mcp.sock')
+    tlm_shm_name = os.environ.get('CFS_TLM_SHM_NAME', '')
     
     # Create and run server
-    server = CFSMCPServer(socket_path)
+    server = CFSMCPServer(socket_path, tlm_shm_name)
     
     try:
         asyncio.run(server.run())